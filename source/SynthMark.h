@@ -41,7 +41,32 @@
 // #define SYNTHMARK_MINOR_VERSION        24  /* Add real-time audio output using AAudio, -a2 */
 // #define SYNTHMARK_MINOR_VERSION        25  /* Add ADPF support, -z1 */
 // #define SYNTHMARK_MINOR_VERSION        26  /* Optimize LatencyMark, one pass, use depth of underflow */
-#define SYNTHMARK_MINOR_VERSION        27  /* Move from sonodroid to mobileer. Add CANCEL button. */
+// #define SYNTHMARK_MINOR_VERSION        27  /* Move from sonodroid to mobileer. Add CANCEL button. */
+// #define SYNTHMARK_MINOR_VERSION        28  /* Add PolyBLEP oscillators, -V, OscillatorMark -to */
+// #define SYNTHMARK_MINOR_VERSION        29  /* Add oversampled voices with half-band decimation, -O */
+// #define SYNTHMARK_MINOR_VERSION        30  /* Add chorus and reverb effects bus, -e1 */
+// #define SYNTHMARK_MINOR_VERSION        31  /* Add pipelined render on worker threads, -P */
+// #define SYNTHMARK_MINOR_VERSION        32  /* Add load shedding, -g1, GracefulMark -tg */
+// #define SYNTHMARK_MINOR_VERSION        33  /* Add absolute deadline sleep modes -S, timer slack -L */
+// #define SYNTHMARK_MINOR_VERSION        34  /* Add simulated DMA thread, -D1 */
+// #define SYNTHMARK_MINOR_VERSION        35  /* Add FileAudioSink, -F{path}, -W1 */
+// #define SYNTHMARK_MINOR_VERSION        36  /* Add GoldenRender -tr with reference -G{path} */
+// #define SYNTHMARK_MINOR_VERSION        37  /* Add LatencySearch -tb with a glitch probability bound */
+// #define SYNTHMARK_MINOR_VERSION        38  /* Measure each CPU frequency domain in AutomatedTestSuite */
+// #define SYNTHMARK_MINOR_VERSION        39  /* Add CPU clock and thermal telemetry -T{msec} */
+// #define SYNTHMARK_MINOR_VERSION        40  /* Add SysfsHostCpuManager, -w3 and -w4 */
+// #define SYNTHMARK_MINOR_VERSION        41  /* Add SCHED_DEADLINE bandwidth controllers, -C{controller} */
+// #define SYNTHMARK_MINOR_VERSION        42  /* Add feed forward utilClamp policy, -U{policy} */
+// #define SYNTHMARK_MINOR_VERSION        43  /* Add structured JSON Lines and CSV results, -E{format} */
+// #define SYNTHMARK_MINOR_VERSION        44  /* Add Sweep -tw with grid -X{grid} and checkpoint -Q{path} */
+// #define SYNTHMARK_MINOR_VERSION        45  /* Add RepeatedTestHarness, -R{trials} */
+// #define SYNTHMARK_MINOR_VERSION        46  /* Add Soak -tk with one second windows sent to -K{path} */
+// #define SYNTHMARK_MINOR_VERSION        47  /* Add InterferenceMark -ti with antagonists -I{antagonists} */
+// #define SYNTHMARK_MINOR_VERSION        48  /* Add CacheSweep -tx over voice state size and voices */
+// #define SYNTHMARK_MINOR_VERSION        49  /* Add HandoffMatrix -th of round trip wakeups between CPUs */
+// #define SYNTHMARK_MINOR_VERSION        50  /* Add WakeupMark -tq without rendering, split by schedstat */
+// #define SYNTHMARK_MINOR_VERSION        51  /* Add -q to sample schedstat and rusage of the audio thread */
+#define SYNTHMARK_MINOR_VERSION        52  /* Add -M to lock memory and prefault the audio thread */
 
 #define SYNTHMARK_STRINGIFY(x) #x
 #define SYNTHMARK_TOSTRING(x) SYNTHMARK_STRINGIFY(x)
@@ -61,13 +61,24 @@ public:
         return mQ;
     }
 
+    /**
+     * Calculate the coefficients once every N blocks instead of every block.
+     * This is cheaper but the filter sweeps will be less smooth.
+     */
+    void setCoefficientUpdateInterval(int32_t blocks) {
+        mCoefficientUpdateInterval = (blocks < 1) ? 1 : blocks;
+    }
+
     void generate(synth_float_t *input,
                   synth_float_t *frequencies,
                   int32_t numSamples) {
         synth_float_t xn, yn;
 
 #if RECALCULATE_PER_SAMPLE == 0
-        calculateCoefficients(frequencies[0], mQ);
+        if (--mBlocksUntilUpdate <= 0) {
+            calculateCoefficients(frequencies[0], mQ);
+            mBlocksUntilUpdate = mCoefficientUpdateInterval;
+        }
 #endif
         for (int i = 0; i < numSamples; i++) {
 #if RECALCULATE_PER_SAMPLE == 1
@@ -95,6 +106,8 @@ public:
 
 private:
     synth_float_t      mQ;
+    int32_t            mCoefficientUpdateInterval = 1;
+    int32_t            mBlocksUntilUpdate = 0;
 
     synth_float_t      xn1;    // delay lines
     synth_float_t      xn2;
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_CHORUS_H
+#define SYNTHMARK_CHORUS_H
+
+#include <cstdint>
+#include <math.h>
+#include "SynthMark.h"
+#include "DelayLine.h"
+#include "tools/SynthTools.h"
+
+/**
+ * Stereo chorus made from two delay lines modulated by a sine LFO.
+ * The right channel LFO is 90 degrees out of phase with the left.
+ */
+class Chorus
+{
+public:
+    Chorus() {}
+
+    virtual ~Chorus() = default;
+
+    /**
+     * Allocate the delay lines. This should not be called from the audio thread.
+     */
+    void setup(int32_t sampleRate) {
+        mCenterFrames = kCenterMillis * sampleRate / SYNTHMARK_MILLIS_PER_SECOND;
+        mDepthFrames = kDepthMillis * sampleRate / SYNTHMARK_MILLIS_PER_SECOND;
+        int32_t maxDelayFrames = (int32_t) (mCenterFrames + mDepthFrames) + 2;
+        mLeft.allocate(maxDelayFrames);
+        mRight.allocate(maxDelayFrames);
+        mPhaseIncrement = 2.0f * kRateHertz / sampleRate;
+        mPhase = 0.0f;
+    }
+
+    int32_t getSizeInBytes() const {
+        return mLeft.getSizeInBytes() + mRight.getSizeInBytes();
+    }
+
+    /**
+     * Process an interleaved stereo buffer in place.
+     */
+    void generate(float *stereo, int32_t numFrames) {
+        synth_float_t phase = mPhase;
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            // Phase is between -1.0 and +1.0 like the other oscillators.
+            synth_float_t phaseRight = phase + 0.5f;
+            if (phaseRight > 1.0f) {
+                phaseRight -= 2.0f;
+            }
+            synth_float_t delayLeft = mCenterFrames
+                    + (mDepthFrames * SynthTools::fastSine(phase * M_PI));
+            synth_float_t delayRight = mCenterFrames
+                    + (mDepthFrames * SynthTools::fastSine(phaseRight * M_PI));
+
+            mLeft.write(stereo[0]);
+            mRight.write(stereo[1]);
+            stereo[0] = (kDryGain * stereo[0]) + (kWetGain * mLeft.readInterpolated(delayLeft));
+            stereo[1] = (kDryGain * stereo[1]) + (kWetGain * mRight.readInterpolated(delayRight));
+            stereo += 2;
+
+            phase += mPhaseIncrement;
+            if (phase > 1.0f) {
+                phase -= 2.0f;
+            }
+        }
+        mPhase = phase;
+    }
+
+private:
+    static constexpr synth_float_t kCenterMillis = 15.0f;
+    static constexpr synth_float_t kDepthMillis = 5.0f;
+    static constexpr synth_float_t kRateHertz = 0.8f;
+    static constexpr synth_float_t kDryGain = 0.7f;
+    static constexpr synth_float_t kWetGain = 0.5f;
+
+    DelayLine     mLeft;
+    DelayLine     mRight;
+    synth_float_t mCenterFrames = 0.0f;
+    synth_float_t mDepthFrames = 0.0f;
+    synth_float_t mPhase = 0.0f;
+    synth_float_t mPhaseIncrement = 0.0f;
+};
+
+#endif // SYNTHMARK_CHORUS_H
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_DELAY_LINE_H
+#define SYNTHMARK_DELAY_LINE_H
+
+#include <cstdint>
+#include <string.h>
+#include "SynthMark.h"
+
+/**
+ * Circular delay line with preallocated memory.
+ * The size is rounded up to a power of two so the index can be wrapped with a mask.
+ */
+class DelayLine
+{
+public:
+    DelayLine() {}
+
+    virtual ~DelayLine() {
+        delete[] mBuffer;
+    }
+
+    /**
+     * Allocate and clear the memory. This should not be called from the audio thread.
+     * @param maxDelayFrames longest delay that will be read
+     */
+    void allocate(int32_t maxDelayFrames) {
+        int32_t size = 1;
+        while (size < (maxDelayFrames + 1)) {
+            size <<= 1;
+        }
+        delete[] mBuffer;
+        mBuffer = new synth_float_t[size];
+        memset(mBuffer, 0, size * sizeof(synth_float_t));
+        mMask = size - 1;
+        mWriteIndex = 0;
+    }
+
+    int32_t getSizeInBytes() const {
+        return (mBuffer == nullptr) ? 0 : (int32_t) ((mMask + 1) * sizeof(synth_float_t));
+    }
+
+    inline void write(synth_float_t value) {
+        mBuffer[mWriteIndex] = value;
+        mWriteIndex = (mWriteIndex + 1) & mMask;
+    }
+
+    /**
+     * @param delayFrames 1 reads the most recently written value
+     */
+    inline synth_float_t read(int32_t delayFrames) const {
+        return mBuffer[(mWriteIndex - delayFrames) & mMask];
+    }
+
+    /**
+     * Read between two samples using linear interpolation.
+     * @param delayFrames must be at least 1.0
+     */
+    inline synth_float_t readInterpolated(synth_float_t delayFrames) const {
+        int32_t whole = (int32_t) delayFrames;
+        synth_float_t fraction = delayFrames - whole;
+        synth_float_t a = read(whole);
+        synth_float_t b = read(whole + 1);
+        return a + (fraction * (b - a));
+    }
+
+private:
+    synth_float_t *mBuffer = nullptr;
+    int32_t        mMask = 0;
+    int32_t        mWriteIndex = 0;
+};
+
+#endif // SYNTHMARK_DELAY_LINE_H
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_EFFECTS_BUS_H
+#define SYNTHMARK_EFFECTS_BUS_H
+
+#include <cstdint>
+#include "SynthMark.h"
+#include "Chorus.h"
+#include "FdnReverb.h"
+
+/**
+ * Global effects that are applied after the voices are mixed.
+ * This adds a fixed cost per burst that does not depend on the number of voices.
+ * The effects run at the output sample rate, even when the voices are oversampled.
+ */
+class EffectsBus
+{
+public:
+    EffectsBus() {}
+
+    virtual ~EffectsBus() = default;
+
+    void setup(int32_t sampleRate) {
+        mChorus.setup(sampleRate);
+        mReverb.setup(sampleRate);
+    }
+
+    int32_t getSizeInBytes() const {
+        return mChorus.getSizeInBytes() + mReverb.getSizeInBytes();
+    }
+
+    /**
+     * Process an interleaved stereo buffer in place.
+     */
+    void generate(float *stereo, int32_t numFrames) {
+        mChorus.generate(stereo, numFrames);
+        mReverb.generate(stereo, numFrames);
+    }
+
+private:
+    Chorus    mChorus;
+    FdnReverb mReverb;
+};
+
+#endif // SYNTHMARK_EFFECTS_BUS_H
@@ -58,6 +58,14 @@ public:
         return mState == State::IDLE;
     }
 
+    bool isReleasing() {
+        return mState == State::RELEASING;
+    }
+
+    synth_float_t getLevel() {
+        return mLevel;
+    }
+
     /**
      * Time in seconds for the falling stage to go from 0 dB to -90 dB. The decay stage will stop at
      * the sustain level. But we calculate the time to fall to -90 dB so that the decay
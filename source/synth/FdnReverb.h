@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_FDN_REVERB_H
+#define SYNTHMARK_FDN_REVERB_H
+
+#include <cstdint>
+#include <math.h>
+#include "SynthMark.h"
+#include "DelayLine.h"
+
+/**
+ * Feedback delay network reverb with 8 lines and a Hadamard feedback matrix.
+ * Each line has a one-pole lowpass so the high frequencies decay faster.
+ *
+ * The delay lines are long enough to hold a large hall so the working set
+ * is a few hundred KB, which does not fit in the L1 cache of most cores.
+ */
+class FdnReverb
+{
+public:
+    static constexpr int32_t kNumLines = 8;
+
+    FdnReverb() {}
+
+    virtual ~FdnReverb() = default;
+
+    /**
+     * Allocate the delay lines. This should not be called from the audio thread.
+     */
+    void setup(int32_t sampleRate) {
+        // Mutually prime lengths in msec so the echoes do not line up.
+        const synth_float_t kLineMillis[kNumLines] = {
+                61.0f, 73.0f, 89.0f, 101.0f, 113.0f, 127.0f, 149.0f, 163.0f
+        };
+        for (int32_t i = 0; i < kNumLines; i++) {
+            mLengths[i] = (int32_t) (kLineMillis[i] * sampleRate / SYNTHMARK_MILLIS_PER_SECOND);
+            mLines[i].allocate(mLengths[i]);
+            // Gain per pass for a 60 dB decay in kDecaySeconds.
+            mFeedbackGains[i] = powf(10.0f, -3.0f * mLengths[i] / (kDecaySeconds * sampleRate));
+            mLowpassStates[i] = 0.0f;
+        }
+    }
+
+    int32_t getSizeInBytes() const {
+        int32_t total = 0;
+        for (int32_t i = 0; i < kNumLines; i++) {
+            total += mLines[i].getSizeInBytes();
+        }
+        return total;
+    }
+
+    /**
+     * Add the reverberated signal to an interleaved stereo buffer.
+     */
+    void generate(float *stereo, int32_t numFrames) {
+        synth_float_t taps[kNumLines];
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            synth_float_t input = 0.5f * (stereo[0] + stereo[1]);
+
+            for (int32_t i = 0; i < kNumLines; i++) {
+                synth_float_t delayed = mLines[i].read(mLengths[i]);
+                mLowpassStates[i] += kDamping * (delayed - mLowpassStates[i]);
+                taps[i] = mFeedbackGains[i] * mLowpassStates[i];
+            }
+
+            // Even lines go left, odd lines go right.
+            synth_float_t left = taps[0] + taps[2] + taps[4] + taps[6];
+            synth_float_t right = taps[1] + taps[3] + taps[5] + taps[7];
+            *stereo++ += kWetGain * left;
+            *stereo++ += kWetGain * right;
+
+            mixHadamard(taps);
+            for (int32_t i = 0; i < kNumLines; i++) {
+                mLines[i].write(input + taps[i]);
+            }
+        }
+
+        // Prevent arithmetic underflow when the input is silent.
+        for (int32_t i = 0; i < kNumLines; i++) {
+            mLowpassStates[i] += (synth_float_t) 1.0E-26;
+        }
+    }
+
+private:
+    static constexpr synth_float_t kDecaySeconds = 2.5f;
+    static constexpr synth_float_t kDamping = 0.6f; // 1.0 is no damping
+    static constexpr synth_float_t kWetGain = 0.15f;
+
+    /**
+     * Fast Walsh-Hadamard transform, scaled so it is lossless.
+     */
+    static inline void mixHadamard(synth_float_t *x) {
+        for (int32_t span = 1; span < kNumLines; span <<= 1) {
+            for (int32_t i = 0; i < kNumLines; i += (span << 1)) {
+                for (int32_t j = i; j < (i + span); j++) {
+                    synth_float_t a = x[j];
+                    synth_float_t b = x[j + span];
+                    x[j] = a + b;
+                    x[j + span] = a - b;
+                }
+            }
+        }
+        const synth_float_t kScaler = (synth_float_t) (1.0 / sqrt((double) kNumLines));
+        for (int32_t i = 0; i < kNumLines; i++) {
+            x[i] *= kScaler;
+        }
+    }
+
+    DelayLine     mLines[kNumLines];
+    int32_t       mLengths[kNumLines] = {};
+    synth_float_t mFeedbackGains[kNumLines] = {};
+    synth_float_t mLowpassStates[kNumLines] = {};
+};
+
+#endif // SYNTHMARK_FDN_REVERB_H
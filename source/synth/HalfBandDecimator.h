@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_HALF_BAND_DECIMATOR_H
+#define SYNTHMARK_HALF_BAND_DECIMATOR_H
+
+#include <cassert>
+#include <cstdint>
+#include <math.h>
+#include <string.h>
+#include "SynthMark.h"
+
+/**
+ * Decimate by two using a polyphase half-band FIR filter.
+ *
+ * In a half-band filter every other coefficient is zero, except the center tap,
+ * which is 0.5. So only the odd taps need to be multiplied.
+ * The filter is symmetric so each pair of odd taps shares one coefficient.
+ * The inner loop has a fixed length so the compiler can vectorize it.
+ */
+class HalfBandDecimator
+{
+public:
+    static constexpr int32_t kNumTaps = 31;
+    static constexpr int32_t kHalfLength = (kNumTaps - 1) / 2;
+    static constexpr int32_t kNumCoefficients = (kHalfLength + 1) / 2; // odd taps on one side
+    static constexpr int32_t kHistorySize = kNumTaps - 1;
+    static constexpr int32_t kMaxInputSamples = 4 * kSynthmarkFramesPerRender;
+
+    HalfBandDecimator() {
+        designCoefficients();
+        reset();
+    }
+
+    void reset() {
+        memset(mWork, 0, sizeof(mWork));
+    }
+
+    /**
+     * @param input array of (2 * numOutputSamples) samples
+     * @param output array of numOutputSamples samples, may be the same as input
+     */
+    void process(const synth_float_t *input, synth_float_t *output, int32_t numOutputSamples) {
+        int32_t numInputSamples = 2 * numOutputSamples;
+        assert(numInputSamples <= kMaxInputSamples);
+        // The history from the last call is already at the front of mWork.
+        memcpy(&mWork[kHistorySize], input, numInputSamples * sizeof(synth_float_t));
+        for (int32_t n = 0; n < numOutputSamples; n++) {
+            const synth_float_t *center = &mWork[kHistorySize + (2 * n) + 1 - kHalfLength];
+            synth_float_t sum = 0.5f * center[0];
+            for (int32_t i = 0; i < kNumCoefficients; i++) {
+                int32_t offset = (2 * i) + 1;
+                sum += mCoefficients[i] * (center[-offset] + center[offset]);
+            }
+            output[n] = sum;
+        }
+        // Save the newest input samples for the next call.
+        memmove(mWork, &mWork[numInputSamples], kHistorySize * sizeof(synth_float_t));
+    }
+
+private:
+    /**
+     * Blackman windowed sinc, normalized so the DC gain is 1.0.
+     */
+    void designCoefficients() {
+        synth_float_t sum = 0.0f;
+        for (int32_t i = 0; i < kNumCoefficients; i++) {
+            int32_t k = (2 * i) + 1;
+            double x = M_PI * k * 0.5;
+            double sinc = sin(x) / x;
+            double phase = (2.0 * M_PI * (k + kHalfLength)) / (kNumTaps - 1);
+            double window = 0.42 - (0.5 * cos(phase)) + (0.08 * cos(2.0 * phase));
+            mCoefficients[i] = (synth_float_t) (0.5 * sinc * window);
+            sum += 2.0f * mCoefficients[i];
+        }
+        // The odd taps must add up to 0.5 to match the center tap.
+        synth_float_t scaler = 0.5f / sum;
+        for (int32_t i = 0; i < kNumCoefficients; i++) {
+            mCoefficients[i] *= scaler;
+        }
+    }
+
+    synth_float_t mCoefficients[kNumCoefficients];
+    synth_float_t mWork[kHistorySize + kMaxInputSamples];
+};
+
+#endif // SYNTHMARK_HALF_BAND_DECIMATOR_H
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_OVERSAMPLED_VOICE_H
+#define SYNTHMARK_OVERSAMPLED_VOICE_H
+
+#include <cassert>
+#include <cstdint>
+#include <string.h>
+#include "SynthMark.h"
+#include "HalfBandDecimator.h"
+#include "VoiceBase.h"
+
+constexpr int32_t kSynthmarkMaxOversampleFactor = 4;
+
+/**
+ * Run a voice at 2x or 4x the output rate and then decimate it
+ * with one or two half-band stages.
+ *
+ * The Synthesizer sets UnitGenerator::setSampleRate() to the oversampled rate
+ * so the wrapped voice renders natively at that rate and there is
+ * nothing to upsample.
+ */
+template <class VOICE>
+class OversampledVoice : public VoiceBase
+{
+public:
+    OversampledVoice()
+    : VoiceBase()
+    , mOversampleFactor(2) {}
+
+    virtual ~OversampledVoice() = default;
+
+    /**
+     * @param factor 2 or 4
+     */
+    void setOversampleFactor(int32_t factor) {
+        assert(factor == 2 || factor == 4);
+        mOversampleFactor = factor;
+    }
+
+    int32_t getOversampleFactor() const {
+        return mOversampleFactor;
+    }
+
+    void noteOn(synth_float_t pitch, synth_float_t velocity) override {
+        VoiceBase::noteOn(pitch, velocity);
+        mVoice.noteOn(pitch, velocity);
+    }
+
+    void noteOff() override {
+        mVoice.noteOff();
+    }
+
+    bool isReleasing() override {
+        return mVoice.isReleasing();
+    }
+
+    synth_float_t getAmplitude() override {
+        return mVoice.getAmplitude();
+    }
+
+    void setDegradationLevel(int32_t level) override {
+        VoiceBase::setDegradationLevel(level);
+        mVoice.setDegradationLevel(level);
+    }
+
+    void generate(int32_t numFrames) override {
+        assert(numFrames <= kSynthmarkFramesPerRender);
+
+        // Render the voice at the high rate.
+        synth_float_t *highRate = mBuffer;
+        for (int32_t i = 0; i < mOversampleFactor; i++) {
+            mVoice.generate(numFrames);
+            memcpy(&highRate[i * numFrames], mVoice.output, numFrames * sizeof(synth_float_t));
+        }
+
+        if (mDegradationLevel >= kDegradationOversampling) {
+            // Drop samples instead of filtering. This will alias.
+            for (int32_t i = 0; i < numFrames; i++) {
+                output[i] = highRate[i * mOversampleFactor];
+            }
+        } else if (mOversampleFactor == 4) {
+            mStage1.process(highRate, highRate, 2 * numFrames);
+            mStage2.process(highRate, output, numFrames);
+        } else {
+            mStage1.process(highRate, output, numFrames);
+        }
+    }
+
+private:
+    VOICE             mVoice;
+    HalfBandDecimator mStage1;
+    HalfBandDecimator mStage2;
+    int32_t           mOversampleFactor;
+
+    synth_float_t mBuffer[kSynthmarkMaxOversampleFactor * kSynthmarkFramesPerRender];
+};
+
+#endif // SYNTHMARK_OVERSAMPLED_VOICE_H
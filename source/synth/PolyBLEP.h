@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_POLY_BLEP_H
+#define SYNTHMARK_POLY_BLEP_H
+
+#include <cstdint>
+#include "SynthMark.h"
+
+/**
+ * Polynomial approximations of the band-limited step (BLEP) and
+ * band-limited ramp (BLAMP) residuals.
+ *
+ * A naive waveform is corrected by adding a scaled residual in the
+ * two samples that surround each discontinuity.
+ * See Valimaki and Huovilainen, "Antialiasing Oscillators in Subtractive Synthesis".
+ *
+ * The phase "t" is normalized between 0.0 and 1.0 and
+ * "dt" is the phase increment per sample in the same units.
+ * The divide is only done near a discontinuity, which is
+ * about two samples per cycle.
+ */
+class PolyBLEP
+{
+public:
+    /**
+     * Residual for a rising step of height 2.0 at t == 0.
+     * Add it for a rising edge and subtract it for a falling edge.
+     */
+    static inline synth_float_t step(synth_float_t t, synth_float_t dt) {
+        if (t < dt) {
+            synth_float_t x = t / dt;
+            return x + x - (x * x) - 1.0f;
+        } else if (t > (1.0f - dt)) {
+            synth_float_t x = (t - 1.0f) / dt;
+            return (x * x) + x + x + 1.0f;
+        }
+        return 0.0f;
+    }
+
+    /**
+     * Residual for an increase in slope at t == 0.
+     * Scale the result by the change in slope per sample.
+     */
+    static inline synth_float_t ramp(synth_float_t t, synth_float_t dt) {
+        if (t < dt) {
+            synth_float_t x = (t / dt) - 1.0f;
+            return (x * x * x) * (-1.0f / 3.0f);
+        } else if (t > (1.0f - dt)) {
+            synth_float_t x = ((t - 1.0f) / dt) + 1.0f;
+            return (x * x * x) * (1.0f / 3.0f);
+        }
+        return 0.0f;
+    }
+
+    /**
+     * Wrap a phase that has been offset so it is between 0.0 and 1.0.
+     */
+    static inline synth_float_t wrap(synth_float_t t) {
+        return (t >= 1.0f) ? (t - 1.0f) : t;
+    }
+};
+
+#endif // SYNTHMARK_POLY_BLEP_H
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_PULSE_OSCILLATOR_POLY_BLEP_H
+#define SYNTHMARK_PULSE_OSCILLATOR_POLY_BLEP_H
+
+#include <cstdint>
+#include "SynthMark.h"
+#include "UnitGenerator.h"
+#include "PolyBLEP.h"
+
+/**
+ * Band limited pulse oscillator using a PolyBLEP correction
+ * on the rising and falling edges.
+ * The width is the fraction of the cycle that the output is high.
+ * It can be modulated per sample for PWM.
+ */
+class PulseOscillatorPolyBLEP : public UnitGenerator
+{
+public:
+    PulseOscillatorPolyBLEP()
+    : mPhase(0.0)
+    , mWidth(0.5) {}
+
+    virtual ~PulseOscillatorPolyBLEP() = default;
+
+    /**
+     * @param width between 0.0 and 1.0, 0.5 is a square wave
+     */
+    void setWidth(synth_float_t width) {
+        mWidth = clipWidth(width);
+    }
+
+    synth_float_t getWidth() const {
+        return mWidth;
+    }
+
+    void generate(synth_float_t frequency, int32_t numSamples) {
+        synth_float_t phase = mPhase;
+        synth_float_t phaseIncrement = frequency * mSamplePeriod;
+        for (int i = 0; i < numSamples; i++) {
+            output[i] = nextPulse(phase, phaseIncrement, mWidth);
+            phase = PolyBLEP::wrap(phase + phaseIncrement);
+        }
+        mPhase = phase;
+    }
+
+    void generate(synth_float_t *frequencies, int32_t numSamples) {
+        synth_float_t phase = mPhase;
+        for (int i = 0; i < numSamples; i++) {
+            synth_float_t phaseIncrement = frequencies[i] * mSamplePeriod;
+            output[i] = nextPulse(phase, phaseIncrement, mWidth);
+            phase = PolyBLEP::wrap(phase + phaseIncrement);
+        }
+        mPhase = phase;
+    }
+
+    /**
+     * Generate with a width that is modulated per sample.
+     */
+    void generate(synth_float_t *frequencies, synth_float_t *widths, int32_t numSamples) {
+        synth_float_t phase = mPhase;
+        for (int i = 0; i < numSamples; i++) {
+            synth_float_t phaseIncrement = frequencies[i] * mSamplePeriod;
+            output[i] = nextPulse(phase, phaseIncrement, clipWidth(widths[i]));
+            phase = PolyBLEP::wrap(phase + phaseIncrement);
+        }
+        mPhase = phase;
+    }
+
+private:
+    static inline synth_float_t clipWidth(synth_float_t width) {
+        // Keep both edges apart so the corrections do not overlap too much.
+        const synth_float_t kMinWidth = 0.01f;
+        if (width < kMinWidth) return kMinWidth;
+        if (width > (1.0f - kMinWidth)) return 1.0f - kMinWidth;
+        return width;
+    }
+
+    static inline synth_float_t nextPulse(synth_float_t phase,
+                                          synth_float_t phaseIncrement,
+                                          synth_float_t width) {
+        synth_float_t value = (phase < width) ? 1.0f : -1.0f;
+        value += PolyBLEP::step(phase, phaseIncrement); // rising edge at 0.0
+        value -= PolyBLEP::step(PolyBLEP::wrap(phase + 1.0f - width),
+                                phaseIncrement); // falling edge at width
+        return value;
+    }
+
+    synth_float_t mPhase; // between 0.0 and 1.0
+    synth_float_t mWidth;
+};
+
+#endif // SYNTHMARK_PULSE_OSCILLATOR_POLY_BLEP_H
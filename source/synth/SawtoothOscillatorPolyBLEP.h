@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_SAWTOOTH_OSCILLATOR_POLY_BLEP_H
+#define SYNTHMARK_SAWTOOTH_OSCILLATOR_POLY_BLEP_H
+
+#include <cstdint>
+#include "SynthMark.h"
+#include "UnitGenerator.h"
+#include "PolyBLEP.h"
+
+/**
+ * Band limited sawtooth oscillator using a PolyBLEP correction.
+ * This is an alternative to SawtoothOscillatorDPW that avoids the
+ * divide per sample. The whole block is rendered in one loop
+ * without any virtual calls.
+ */
+class SawtoothOscillatorPolyBLEP : public UnitGenerator
+{
+public:
+    SawtoothOscillatorPolyBLEP()
+    : mPhase(0.5) {}
+
+    virtual ~SawtoothOscillatorPolyBLEP() = default;
+
+    void generate(synth_float_t frequency, int32_t numSamples) {
+        synth_float_t phase = mPhase;
+        synth_float_t phaseIncrement = frequency * mSamplePeriod;
+        for (int i = 0; i < numSamples; i++) {
+            output[i] = (2.0f * phase) - 1.0f - PolyBLEP::step(phase, phaseIncrement);
+            phase = PolyBLEP::wrap(phase + phaseIncrement);
+        }
+        mPhase = phase;
+    }
+
+    void generate(synth_float_t *frequencies, int32_t numSamples) {
+        synth_float_t phase = mPhase;
+        for (int i = 0; i < numSamples; i++) {
+            synth_float_t phaseIncrement = frequencies[i] * mSamplePeriod;
+            output[i] = (2.0f * phase) - 1.0f - PolyBLEP::step(phase, phaseIncrement);
+            phase = PolyBLEP::wrap(phase + phaseIncrement);
+        }
+        mPhase = phase;
+    }
+
+private:
+    synth_float_t mPhase; // between 0.0 and 1.0
+};
+
+#endif // SYNTHMARK_SAWTOOTH_OSCILLATOR_POLY_BLEP_H
@@ -24,6 +24,8 @@
 #include "SawtoothOscillator.h"
 #include "SawtoothOscillatorDPW.h"
 #include "SquareOscillatorDPW.h"
+#include "SawtoothOscillatorPolyBLEP.h"
+#include "SquareOscillatorPolyBLEP.h"
 #include "SineOscillator.h"
 #include "EnvelopeADSR.h"
 #include "PitchToFrequency.h"
@@ -32,11 +34,15 @@
 /**
  * Classic subtractive synthesizer voice with
  * 2 LFOs, 2 audio oscillators, filter and envelopes.
+ * The oscillator classes are template parameters so that
+ * different anti-aliasing methods can be compared without
+ * adding a virtual call per sample.
  */
-class SimpleVoice : public VoiceBase
+template <class SAWTOOTH, class SQUARE>
+class SubtractiveVoice : public VoiceBase
 {
 public:
-    SimpleVoice()
+    SubtractiveVoice()
     : VoiceBase()
     , mLfo1()
     , mOsc1()
@@ -60,24 +66,37 @@ public:
         mAmplitudeEnvelope.setDecayTime(1.0 + (0.2 * SynthTools::nextRandomDouble()));
     }
 
-    virtual ~SimpleVoice() = default;
+    virtual ~SubtractiveVoice() = default;
 
     void setPitch(synth_float_t pitch) {
         mPitch = pitch;
     }
 
-    void noteOn(synth_float_t pitch, synth_float_t velocity) {
+    void noteOn(synth_float_t pitch, synth_float_t velocity) override {
         VoiceBase::noteOn(pitch, velocity);
         mFilterEnvelope.setGate(true);
         mAmplitudeEnvelope.setGate(true);
     }
 
-    void noteOff() {
+    void noteOff() override {
         mFilterEnvelope.setGate(false);
         mAmplitudeEnvelope.setGate(false);
     }
 
-    void generate(int32_t numFrames) {
+    bool isReleasing() override {
+        return mAmplitudeEnvelope.isReleasing();
+    }
+
+    synth_float_t getAmplitude() override {
+        return mAmplitudeEnvelope.getLevel();
+    }
+
+    void setDegradationLevel(int32_t level) override {
+        VoiceBase::setDegradationLevel(level);
+        mFilter.setCoefficientUpdateInterval((level >= kDegradationFilterRate) ? 2 : 1);
+    }
+
+    void generate(int32_t numFrames) override {
         assert(numFrames <= kSynthmarkFramesPerRender);
 
         // LFO #1 - vibrato
@@ -114,8 +133,8 @@ public:
 
 private:
     SineOscillator mLfo1;
-    SawtoothOscillatorDPW mOsc1;
-    SquareOscillatorDPW mOsc2;
+    SAWTOOTH mOsc1;
+    SQUARE mOsc2;
     PitchToFrequency mPitchToFrequency;
     BiquadFilter mFilter;
     EnvelopeADSR mFilterEnvelope;
@@ -132,4 +151,14 @@ private:
     synth_float_t mBuffer2[kSynthmarkFramesPerRender];
 };
 
+/**
+ * The original voice, using DPW oscillators.
+ */
+typedef SubtractiveVoice<SawtoothOscillatorDPW, SquareOscillatorDPW> SimpleVoice;
+
+/**
+ * Same voice but with PolyBLEP oscillators, which avoid the divide per sample.
+ */
+typedef SubtractiveVoice<SawtoothOscillatorPolyBLEP, SquareOscillatorPolyBLEP> SimpleVoicePolyBLEP;
+
 #endif // SYNTHMARK_SIMPLE_VOICE_H
@@ -50,7 +50,7 @@ public:
         synth_float_t phase2 = phase1 + 1.0; /* 180 degrees out of phase. */
         if (phase2 >= 1.0)
             phase2 -= 2.0;
-        synth_float_t val2 = dpw1.next(phase2, phaseIncrement);
+        synth_float_t val2 = dpw2.next(phase2, phaseIncrement);
 
         /*
          * Need to adjust amplitude based on positive phaseInc. little less than half at
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_SQUARE_OSCILLATOR_POLY_BLEP_H
+#define SYNTHMARK_SQUARE_OSCILLATOR_POLY_BLEP_H
+
+#include <cstdint>
+#include "SynthMark.h"
+#include "PulseOscillatorPolyBLEP.h"
+
+/**
+ * Band limited square wave, which is a pulse with a fixed width of 0.5.
+ * Unlike SquareOscillatorDPW, it does not need two sawtooth evaluations per sample.
+ */
+class SquareOscillatorPolyBLEP : public PulseOscillatorPolyBLEP
+{
+public:
+    SquareOscillatorPolyBLEP()
+    : PulseOscillatorPolyBLEP() {
+        setWidth(0.5);
+    }
+
+    virtual ~SquareOscillatorPolyBLEP() = default;
+};
+
+#endif // SYNTHMARK_SQUARE_OSCILLATOR_POLY_BLEP_H
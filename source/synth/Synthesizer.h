@@ -21,13 +21,29 @@
 #include <math.h>
 #include <memory>
 #include <string.h>
+#include <algorithm>
 #include <cassert>
+#include <vector>
 #include "SynthMark.h"
+#include "EffectsBus.h"
 #include "VoiceBase.h"
 #include "SimpleVoice.h"
+#include "VoiceRegistry.h"
 
 #define SAMPLES_PER_FRAME   2
 
+/**
+ * Options that change the work done by the synthesizer.
+ */
+struct SynthesizerSettings {
+    VoiceType voiceType = VoiceType::SimpleDPW;
+    int32_t   oversampleFactor = 1; // 1, 2 or 4
+    bool      effectsEnabled = false; // chorus and reverb after the voice mix
+    int32_t   pipelineWorkers = 0; // render voices one burst ahead on worker threads, 0 = off
+    bool      degradationEnabled = false; // shed load when a burst is close to its deadline
+    int32_t   voiceStateBytes = 0; // extra state read by each voice to study the caches, 0 = none
+};
+
 /**
  * Manage an array of voices.
  * Note that this is not a fully featured general purpose synthesizer.
@@ -39,18 +55,50 @@ public:
     Synthesizer()
     : mMaxVoices(0)
     , mActiveVoiceCount(0)
-    , mVoices(NULL)
     {}
 
-    virtual ~Synthesizer() {
-        delete[] mVoices;
-    };
+    virtual ~Synthesizer() = default;
 
-    int32_t setup(int32_t sampleRate, int32_t maxVoices) {
+    int32_t setup(int32_t sampleRate, int32_t maxVoices,
+                  const SynthesizerSettings &settings = SynthesizerSettings()) {
         mMaxVoices = maxVoices;
-        UnitGenerator::setSampleRate(sampleRate);
-        mVoices = new SimpleVoice[mMaxVoices];
-        return (mVoices == NULL) ? -1 : 0;
+        mActiveVoiceCount = 0;
+        mSettings = settings;
+        // Oversampled voices run at the higher rate and decimate down to sampleRate.
+        UnitGenerator::setSampleRate(sampleRate * settings.oversampleFactor);
+        // Replace any voices from a previous setup.
+        mVoices.reset(VoiceRegistry::createVoices(settings.voiceType, mMaxVoices,
+                                                  settings.oversampleFactor));
+        mShedVoices.assign(mMaxVoices, false);
+        mShedCandidates.reserve(mMaxVoices); // avoid allocating in the audio thread
+        mDegradationLevel = kDegradationNone;
+        setupVoiceState(settings.voiceStateBytes);
+        if (settings.effectsEnabled) {
+            mEffects = std::make_unique<EffectsBus>();
+            mEffects->setup(sampleRate);
+        } else {
+            mEffects.reset();
+        }
+        return (mVoices == nullptr) ? -1 : 0;
+    }
+
+    bool areEffectsEnabled() const {
+        return mEffects != nullptr;
+    }
+
+    int32_t getEffectsSizeInBytes() const {
+        return (mEffects == nullptr) ? 0 : mEffects->getSizeInBytes();
+    }
+
+    const SynthesizerSettings &getSettings() const {
+        return mSettings;
+    }
+
+    /**
+     * @return extra state per voice after rounding down to a power of two number of lines
+     */
+    int32_t getVoiceStateBytes() const {
+        return mVoiceStateLines * kVoiceStateFloatsPerLine * (int32_t) sizeof(float);
     }
 
     void allNotesOn() {
@@ -68,34 +116,52 @@ public:
         int pitchIndex = 0;
         synth_float_t pitches[] = {60.0, 64.0, 67.0, 69.0};
         for(int iv = 0; iv < mActiveVoiceCount; iv++ ) {
-            SimpleVoice *voice = &mVoices[iv];
+            VoiceBase *voice = mVoices->get(iv);
             // Randomize pitches by a few cents to smooth out the CPU load.
             float pitchOffset = 0.03f * (float) SynthTools::nextRandomDouble();
             synth_float_t pitch = pitches[pitchIndex++] + pitchOffset;
             if (pitchIndex > 3) pitchIndex = 0;
             voice->noteOn(pitch, 1.0);
+            mShedVoices[iv] = false;
         }
         return 0;
     }
 
     void allNotesOff() {
         for(int iv = 0; iv < mActiveVoiceCount; iv++ ) {
-            SimpleVoice *voice = &mVoices[iv];
+            VoiceBase *voice = mVoices->get(iv);
             voice->noteOff();
         }
     }
 
     void renderStereo(float *output, int32_t numFrames) {
+        renderVoices(0, mActiveVoiceCount, output, numFrames);
+        mFrameCounter += numFrames;
+    }
+
+    /**
+     * Mix a range of the active voices into an interleaved stereo buffer.
+     * Different ranges may be rendered at the same time on different threads.
+     */
+    void renderVoices(int32_t firstVoice, int32_t numVoices, float *output, int32_t numFrames) {
         int32_t framesLeft = numFrames;
         float *renderBuffer = output;
+        int32_t endVoice = firstVoice + numVoices;
+        assert(endVoice <= mActiveVoiceCount);
 
         // Clear mixing buffer.
         memset(output, 0, numFrames * SAMPLES_PER_FRAME * sizeof(float));
 
         while (framesLeft >= kSynthmarkFramesPerRender) {
-            for(int iv = 0; iv < mActiveVoiceCount; iv++ ) {
-                SimpleVoice *voice = &mVoices[iv];
+            for(int iv = firstVoice; iv < endVoice; iv++ ) {
+                if (mShedVoices[iv]) {
+                    continue;
+                }
+                VoiceBase *voice = mVoices->get(iv);
                 voice->generate(kSynthmarkFramesPerRender);
+                if (mVoiceStateLines > 0) {
+                    readVoiceState(iv, voice->output);
+                }
                 float *mix = renderBuffer;
 
                 synth_float_t leftGain = mVoiceAmplitude;
@@ -112,22 +178,122 @@ public:
                 }
             }
             framesLeft -= kSynthmarkFramesPerRender;
-            mFrameCounter += kSynthmarkFramesPerRender;
             renderBuffer += kSynthmarkFramesPerRender * SAMPLES_PER_FRAME;
         }
         assert(framesLeft == 0);
     }
 
+    /**
+     * Apply the global effects to the output of renderStereo().
+     * This is separate so that its cost can be measured on its own.
+     */
+    void renderEffects(float *output, int32_t numFrames) {
+        if (mEffects != nullptr) {
+            mEffects->generate(output, numFrames);
+        }
+    }
+
+    /**
+     * Make every voice cheaper, or restore full quality with kDegradationNone.
+     */
+    void setDegradationLevel(int32_t level) {
+        if (level == mDegradationLevel) {
+            return;
+        }
+        mDegradationLevel = level;
+        for (int iv = 0; iv < mMaxVoices; iv++) {
+            mVoices->get(iv)->setDegradationLevel(level);
+        }
+    }
+
+    int32_t getDegradationLevel() const {
+        return mDegradationLevel;
+    }
+
+    /**
+     * Stop rendering the quietest voices that are in their release stage.
+     * They will be rendered again at the next note on.
+     *
+     * @param maxVoices maximum number of voices to stop
+     * @return number of voices stopped
+     */
+    int32_t shedQuietestReleasingVoices(int32_t maxVoices) {
+        mShedCandidates.clear();
+        for (int iv = 0; iv < mActiveVoiceCount; iv++) {
+            VoiceBase *voice = mVoices->get(iv);
+            if (!mShedVoices[iv] && voice->isReleasing()) {
+                mShedCandidates.push_back(iv);
+            }
+        }
+        int32_t numToShed = std::min(maxVoices, (int32_t) mShedCandidates.size());
+        std::partial_sort(mShedCandidates.begin(),
+                          mShedCandidates.begin() + numToShed,
+                          mShedCandidates.end(),
+                          [this](int32_t a, int32_t b) {
+                              return mVoices->get(a)->getAmplitude()
+                                      < mVoices->get(b)->getAmplitude();
+                          });
+        for (int32_t i = 0; i < numToShed; i++) {
+            mShedVoices[mShedCandidates[i]] = true;
+        }
+        return numToShed;
+    }
+
     int32_t getActiveVoiceCount() {
         return mActiveVoiceCount;
     }
 
 private:
+    static constexpr int32_t kVoiceStateFloatsPerLine = 64 / sizeof(float);
+    static constexpr uint32_t kVoiceStateStrideLines = 1031; // odd so every line is visited
+
+    /**
+     * Give each voice a table that it reads one cache line of for every sample.
+     * The lines are visited in a scattered order so the prefetcher cannot hide a miss.
+     * The cost per sample does not depend on the size, only on whether
+     * the tables of all the active voices still fit in a cache.
+     * The table is filled with 1.0 so the sound does not change.
+     */
+    void setupVoiceState(int32_t numBytes) {
+        int32_t bytesPerLine = kVoiceStateFloatsPerLine * sizeof(float);
+        mVoiceStateLines = 0;
+        if (numBytes >= bytesPerLine) {
+            mVoiceStateLines = 1;
+            while (mVoiceStateLines * 2 * bytesPerLine <= numBytes) {
+                mVoiceStateLines *= 2;
+            }
+        }
+        mVoiceState.assign((size_t) mMaxVoices * mVoiceStateLines * kVoiceStateFloatsPerLine,
+                           1.0f);
+        mVoiceState.shrink_to_fit();
+        mVoiceStatePositions.assign(mVoiceStateLines > 0 ? mMaxVoices : 0, 0);
+    }
+
+    void readVoiceState(int32_t voiceIndex, synth_float_t *samples) {
+        const float *state = &mVoiceState[(size_t) voiceIndex * mVoiceStateLines
+                                          * kVoiceStateFloatsPerLine];
+        uint32_t lineMask = mVoiceStateLines - 1;
+        uint32_t line = mVoiceStatePositions[voiceIndex];
+        for (int n = 0; n < kSynthmarkFramesPerRender; n++) {
+            samples[n] *= state[line * kVoiceStateFloatsPerLine];
+            line = (line + kVoiceStateStrideLines) & lineMask;
+        }
+        mVoiceStatePositions[voiceIndex] = line;
+    }
+
     int32_t mMaxVoices;
     int32_t mActiveVoiceCount;
-    int64_t mFrameCounter;
-    SimpleVoice *mVoices;
+    int64_t mFrameCounter = 0;
+    std::unique_ptr<VoiceArray> mVoices;
+    SynthesizerSettings mSettings;
+    std::unique_ptr<EffectsBus> mEffects;
+    int32_t mDegradationLevel = kDegradationNone;
+    std::vector<bool> mShedVoices;
+    std::vector<int32_t> mShedCandidates;
     synth_float_t mVoiceAmplitude = 1.0;
+    std::vector<float> mVoiceState;
+    std::vector<uint32_t> mVoiceStatePositions;
+    int32_t mVoiceStateLines = 0; // per voice, a power of two
 };
 
 #endif // SYNTHMARK_SYNTHESIZER_H
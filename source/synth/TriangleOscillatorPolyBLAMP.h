@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_TRIANGLE_OSCILLATOR_POLY_BLAMP_H
+#define SYNTHMARK_TRIANGLE_OSCILLATOR_POLY_BLAMP_H
+
+#include <cstdint>
+#include "SynthMark.h"
+#include "UnitGenerator.h"
+#include "PolyBLEP.h"
+
+/**
+ * Band limited triangle oscillator using a PolyBLAMP correction at the two corners.
+ * The slope changes by 8.0 per cycle at each corner.
+ * PolyBLEP::ramp() is scaled for a slope change of 2.0 per sample,
+ * so the correction is scaled by 4.0 times the phase increment.
+ */
+class TriangleOscillatorPolyBLAMP : public UnitGenerator
+{
+public:
+    TriangleOscillatorPolyBLAMP()
+    : mPhase(0.0) {}
+
+    virtual ~TriangleOscillatorPolyBLAMP() = default;
+
+    void generate(synth_float_t frequency, int32_t numSamples) {
+        synth_float_t phase = mPhase;
+        synth_float_t phaseIncrement = frequency * mSamplePeriod;
+        for (int i = 0; i < numSamples; i++) {
+            output[i] = nextTriangle(phase, phaseIncrement);
+            phase = PolyBLEP::wrap(phase + phaseIncrement);
+        }
+        mPhase = phase;
+    }
+
+    void generate(synth_float_t *frequencies, int32_t numSamples) {
+        synth_float_t phase = mPhase;
+        for (int i = 0; i < numSamples; i++) {
+            synth_float_t phaseIncrement = frequencies[i] * mSamplePeriod;
+            output[i] = nextTriangle(phase, phaseIncrement);
+            phase = PolyBLEP::wrap(phase + phaseIncrement);
+        }
+        mPhase = phase;
+    }
+
+private:
+    static inline synth_float_t nextTriangle(synth_float_t phase, synth_float_t phaseIncrement) {
+        synth_float_t value = (phase < 0.5f)
+                ? ((4.0f * phase) - 1.0f)
+                : (3.0f - (4.0f * phase));
+        synth_float_t slopeScale = 4.0f * phaseIncrement;
+        value += slopeScale * PolyBLEP::ramp(phase, phaseIncrement); // bottom corner at 0.0
+        value -= slopeScale * PolyBLEP::ramp(PolyBLEP::wrap(phase + 0.5f),
+                                             phaseIncrement); // top corner at 0.5
+        return value;
+    }
+
+    synth_float_t mPhase; // between 0.0 and 1.0
+};
+
+#endif // SYNTHMARK_TRIANGLE_OSCILLATOR_POLY_BLAMP_H
@@ -21,6 +21,16 @@
 #include "SynthMark.h"
 #include "UnitGenerator.h"
 
+/**
+ * Levels for reducing the cost of a voice when the CPU cannot keep up.
+ * Each level includes the ones below it.
+ */
+constexpr int32_t kDegradationNone          = 0;
+constexpr int32_t kDegradationFilterRate    = 1; // update filter coefficients half as often
+constexpr int32_t kDegradationOversampling  = 2; // decimate without the FIR filter
+constexpr int32_t kDegradationShedVoices    = 3; // stop the quietest releasing voices
+constexpr int32_t kDegradationMax           = kDegradationShedVoices;
+
 /**
  * Base class for building synthesizers.
  */
@@ -39,12 +49,31 @@ public:
         mPitch = pitch;
     }
 
-    void noteOn(synth_float_t pitch, synth_float_t velocity) {
+    virtual void noteOn(synth_float_t pitch, synth_float_t velocity) {
         mPitch = pitch;
         mVelocity = velocity;
     }
 
-    void noteOff() {
+    virtual void noteOff() {
+    }
+
+    virtual bool isReleasing() {
+        return false;
+    }
+
+    /**
+     * @return current amplitude, used to find the quietest voices
+     */
+    virtual synth_float_t getAmplitude() {
+        return 0.0;
+    }
+
+    virtual void setDegradationLevel(int32_t level) {
+        mDegradationLevel = level;
+    }
+
+    int32_t getDegradationLevel() const {
+        return mDegradationLevel;
     }
 
     virtual void generate(int32_t numFrames) = 0;
@@ -52,6 +81,7 @@ public:
 protected:
     synth_float_t mPitch;
     synth_float_t mVelocity;
+    int32_t       mDegradationLevel = kDegradationNone;
 };
 
 #endif // SYNTHMARK_VOICE_BASE_H
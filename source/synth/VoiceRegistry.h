@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_VOICE_REGISTRY_H
+#define SYNTHMARK_VOICE_REGISTRY_H
+
+#include <cstdint>
+#include <vector>
+#include "SynthMark.h"
+#include "VoiceBase.h"
+#include "SimpleVoice.h"
+#include "OversampledVoice.h"
+
+/**
+ * Voice implementations that can be selected for a benchmark.
+ */
+enum class VoiceType : int32_t {
+    SimpleDPW = 0,
+    SimplePolyBLEP = 1,
+    Count // must be last
+};
+
+/**
+ * Owns a set of voices of one type.
+ * The voices are allocated as one contiguous array so that
+ * the memory layout matches a synthesizer with a single voice class.
+ */
+class VoiceArray
+{
+public:
+    virtual ~VoiceArray() = default;
+
+    VoiceBase *get(int32_t index) const {
+        return mPointers[index];
+    }
+
+    int32_t size() const {
+        return (int32_t) mPointers.size();
+    }
+
+protected:
+    std::vector<VoiceBase *> mPointers;
+};
+
+template <class VOICE>
+class TypedVoiceArray : public VoiceArray
+{
+public:
+    explicit TypedVoiceArray(int32_t numVoices)
+    : mVoices(new VOICE[numVoices]) {
+        mPointers.reserve(numVoices);
+        for (int32_t i = 0; i < numVoices; i++) {
+            mPointers.push_back(&mVoices[i]);
+        }
+    }
+
+    virtual ~TypedVoiceArray() {
+        delete[] mVoices;
+    }
+
+    VOICE *getVoice(int32_t index) const {
+        return &mVoices[index];
+    }
+
+private:
+    VOICE *mVoices;
+};
+
+class VoiceRegistry
+{
+public:
+    static bool isValid(int32_t type) {
+        return type >= 0 && type < (int32_t) VoiceType::Count;
+    }
+
+    static const char *getName(VoiceType type) {
+        switch (type) {
+            case VoiceType::SimpleDPW:
+                return "SimpleDPW";
+            case VoiceType::SimplePolyBLEP:
+                return "SimplePolyBLEP";
+            default:
+                return "Unknown";
+        }
+    }
+
+    static bool isValidOversampleFactor(int32_t factor) {
+        return factor == 1 || factor == 2 || factor == 4;
+    }
+
+    /**
+     * @param oversampleFactor 1, 2 or 4
+     * @return new array of voices or nullptr if the type or factor is not valid
+     */
+    static VoiceArray *createVoices(VoiceType type, int32_t numVoices,
+                                    int32_t oversampleFactor = 1) {
+        if (!isValidOversampleFactor(oversampleFactor)) {
+            return nullptr;
+        }
+        switch (type) {
+            case VoiceType::SimpleDPW:
+                return createTypedVoices<SimpleVoice>(numVoices, oversampleFactor);
+            case VoiceType::SimplePolyBLEP:
+                return createTypedVoices<SimpleVoicePolyBLEP>(numVoices, oversampleFactor);
+            default:
+                return nullptr;
+        }
+    }
+
+private:
+    template <class VOICE>
+    static VoiceArray *createTypedVoices(int32_t numVoices, int32_t oversampleFactor) {
+        if (oversampleFactor == 1) {
+            return new TypedVoiceArray<VOICE>(numVoices);
+        }
+        auto *voices = new TypedVoiceArray<OversampledVoice<VOICE>>(numVoices);
+        for (int32_t i = 0; i < numVoices; i++) {
+            voices->getVoice(i)->setOversampleFactor(oversampleFactor);
+        }
+        return voices;
+    }
+};
+
+#endif // SYNTHMARK_VOICE_REGISTRY_H
@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SYNTHMARK_ANTAGONIST_H
+#define SYNTHMARK_ANTAGONIST_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <vector>
+
+#include "AudioSinkBase.h"
+#include "HostThreadFactory.h"
+#include "HostTools.h"
+#include "SynthMark.h"
+
+/**
+ * A background thread that competes with the audio thread for the machine.
+ *
+ * TYPE_MEMORY_STREAM copies a buffer much larger than the last level cache
+ *     to use memory bandwidth.
+ * TYPE_CACHE_THRASH writes to cache lines of a buffer the size of the last level cache
+ *     in a scattered order so that the lines used by the audio thread are evicted.
+ * TYPE_SPIN is a SCHED_OTHER busy loop that competes for CPU time.
+ * TYPE_FIFO is a SCHED_FIFO thread that is busy for kFifoBusyNanos of every kFifoPeriodNanos.
+ *     It does not run all the time so it cannot lock up the CPU it runs on.
+ *
+ * The buffers are allocated and touched by start() so page faults
+ * do not happen during the measurement.
+ */
+class Antagonist
+{
+public:
+    enum Type : int32_t {
+        TYPE_MEMORY_STREAM,
+        TYPE_CACHE_THRASH,
+        TYPE_SPIN,
+        TYPE_FIFO,
+        TYPE_COUNT
+    };
+
+    static constexpr int64_t kFifoBusyNanos = SYNTHMARK_NANOS_PER_MILLISECOND;
+    static constexpr int64_t kFifoPeriodNanos = 5 * SYNTHMARK_NANOS_PER_MILLISECOND;
+
+    static const char *getTypeName(int32_t type) {
+        switch (type) {
+            case TYPE_MEMORY_STREAM: return "memory.stream";
+            case TYPE_CACHE_THRASH: return "cache.thrash";
+            case TYPE_SPIN: return "spin";
+            case TYPE_FIFO: return "fifo";
+            default: return "unknown";
+        }
+    }
+
+    static bool usesMemory(int32_t type) {
+        return type == TYPE_MEMORY_STREAM || type == TYPE_CACHE_THRASH;
+    }
+
+    ~Antagonist() {
+        stop();
+    }
+
+    /**
+     * @param type TYPE_MEMORY_STREAM, etc.
+     * @param cpu to run on or SYNTHMARK_CPU_UNSPECIFIED
+     * @param fifoPriority for TYPE_FIFO
+     * @param bufferBytes for the memory types
+     * @return 0 or a negative error
+     */
+    int32_t start(int32_t type, int cpu, int fifoPriority, size_t bufferBytes) {
+        stop();
+        mType = type;
+        mCpu = cpu;
+        mFifoPriority = fifoPriority;
+        mBytesTouched = 0;
+        mCpuNanos = 0;
+        mPromoteResult = -1;
+        if (type == TYPE_CACHE_THRASH) {
+            // Use a power of two number of lines so any odd stride visits all of them.
+            size_t numLines = 1;
+            while (numLines * 2 * kCacheLineBytes <= bufferBytes) {
+                numLines *= 2;
+            }
+            mBuffer.assign(numLines * kCacheLineBytes, 1);
+        } else if (type == TYPE_MEMORY_STREAM) {
+            mBuffer.assign(std::max(bufferBytes, 2 * kStreamChunkBytes), 1);
+        } else {
+            mBuffer.clear();
+        }
+        mQuit.store(false);
+        mThread.reset(HostThreadFactory::createThread(HostThreadFactory::ThreadType::Default));
+        int err = mThread->start(threadProc, this);
+        if (err) {
+            mThread.reset();
+            return -1;
+        }
+        return 0;
+    }
+
+    void stop() {
+        if (mThread) {
+            mQuit.store(true);
+            mThread->join();
+            mThread.reset();
+        }
+    }
+
+    /**
+     * @return CPU time used by the thread, valid after stop()
+     */
+    double getCpuSeconds() const {
+        return (double) mCpuNanos / SYNTHMARK_NANOS_PER_SECOND;
+    }
+
+    /**
+     * @return bytes read plus bytes written by the memory types, valid after stop()
+     */
+    int64_t getBytesTouched() const {
+        return mBytesTouched;
+    }
+
+    /**
+     * @return true if a TYPE_FIFO thread got SCHED_FIFO
+     */
+    bool wasPromoted() const {
+        return mPromoteResult == 0;
+    }
+
+private:
+    static constexpr size_t kCacheLineBytes = 64;
+    static constexpr size_t kStreamChunkBytes = 1024 * 1024;
+    static constexpr size_t kThrashStrideLines = 1031; // odd so every line is visited
+    static constexpr int32_t kThrashLinesPerCheck = 4096;
+
+    static void *threadProc(void *arg) {
+        ((Antagonist *) arg)->run();
+        return nullptr;
+    }
+
+    void run() {
+        if (mCpu != SYNTHMARK_CPU_UNSPECIFIED) {
+            (void) HostThread::setCpuAffinity(mCpu);
+        }
+        switch (mType) {
+            case TYPE_MEMORY_STREAM:
+                streamMemory();
+                break;
+            case TYPE_CACHE_THRASH:
+                thrashCache();
+                break;
+            case TYPE_SPIN:
+                spin();
+                break;
+            case TYPE_FIFO:
+                mPromoteResult = mThread->promote(mFifoPriority);
+                runPeriodicBurst();
+                break;
+            default:
+                break;
+        }
+        struct timespec cpuTime;
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuTime) == 0) {
+            mCpuNanos = (cpuTime.tv_sec * SYNTHMARK_NANOS_PER_SECOND) + cpuTime.tv_nsec;
+        }
+    }
+
+    // Copy the first half of the buffer to the second half, one chunk at a time.
+    void streamMemory() {
+        size_t halfBytes = mBuffer.size() / 2;
+        uint8_t *source = mBuffer.data();
+        uint8_t *destination = source + halfBytes;
+        size_t offset = 0;
+        while (!mQuit.load(std::memory_order_relaxed)) {
+            size_t numBytes = std::min((size_t) kStreamChunkBytes, halfBytes - offset);
+            memcpy(destination + offset, source + offset, numBytes);
+            mBytesTouched += 2 * numBytes;
+            offset += numBytes;
+            if (offset >= halfBytes) {
+                offset = 0;
+                std::swap(source, destination);
+            }
+        }
+    }
+
+    void thrashCache() {
+        size_t numLines = mBuffer.size() / kCacheLineBytes;
+        size_t lineMask = numLines - 1;
+        size_t lineIndex = 0;
+        uint8_t *data = mBuffer.data();
+        while (!mQuit.load(std::memory_order_relaxed)) {
+            for (int32_t i = 0; i < kThrashLinesPerCheck; i++) {
+                data[lineIndex * kCacheLineBytes]++; // read and write the whole line
+                lineIndex = (lineIndex + kThrashStrideLines) & lineMask;
+            }
+            mBytesTouched += 2 * kThrashLinesPerCheck * kCacheLineBytes;
+        }
+    }
+
+    void spin() {
+        volatile int64_t counter = 0;
+        while (!mQuit.load(std::memory_order_relaxed)) {
+            counter = counter + 1;
+        }
+    }
+
+    void runPeriodicBurst() {
+        volatile int64_t counter = 0;
+        int64_t nextTime = HostTools::getNanoTime();
+        while (!mQuit.load(std::memory_order_relaxed)) {
+            int64_t endBusy = nextTime + kFifoBusyNanos;
+            while (HostTools::getNanoTime() < endBusy
+                    && !mQuit.load(std::memory_order_relaxed)) {
+                counter = counter + 1;
+            }
+            nextTime += kFifoPeriodNanos;
+            HostTools::sleepUntilNanoTime(nextTime);
+        }
+    }
+
+    std::unique_ptr<HostThread> mThread;
+    std::atomic<bool>    mQuit{false};
+    int32_t              mType = TYPE_SPIN;
+    int                  mCpu = SYNTHMARK_CPU_UNSPECIFIED;
+    int                  mFifoPriority = SYNTHMARK_THREAD_PRIORITY_DEFAULT;
+    std::vector<uint8_t> mBuffer;
+
+    // Written by the thread and read after it is joined.
+    int64_t              mBytesTouched = 0;
+    int64_t              mCpuNanos = 0;
+    int                  mPromoteResult = -1;
+};
+
+#endif // SYNTHMARK_ANTAGONIST_H
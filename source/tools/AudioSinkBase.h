@@ -19,10 +19,15 @@
 
 #include <cmath>
 #include <cstdint>
+#include <memory>
 #include <sstream>
+#include <string>
 
 #include "IAudioSinkCallback.h"
+#include "LogTool.h"
+#include "ResultReport.h"
 #include "SynthMark.h"
+#include "SynthMarkResult.h"
 #include "HostThreadFactory.h"
 
 #define SYNTHMARK_THREAD_PRIORITY_DEFAULT   2 // 2nd lowest priority, recommended by timmurray@
@@ -45,6 +50,12 @@ public:
         UTIL_CLAMP_ON_LOGGED = 2
     };
 
+    enum : int32_t {
+        UTIL_CLAMP_POLICY_REACTIVE = 0,     // react to slow bursts
+        UTIL_CLAMP_POLICY_FEED_FORWARD = 1, // set from the announced load
+        UTIL_CLAMP_POLICY_COUNT
+    };
+
     enum : int32_t {
         AUDIO_LEVEL_NORMAL = 0,
         AUDIO_LEVEL_CALLBACK = 1,
@@ -92,6 +103,10 @@ public:
         return mCallback->onRenderAudio(buffer, numFrames);
     }
 
+    int32_t getDefaultBufferSizeInBursts() const {
+        return mDefaultBufferSizeInBursts;
+    }
+
     void setDefaultBufferSizeInBursts(int32_t numBursts) {
         mDefaultBufferSizeInBursts = numBursts;
     }
@@ -115,6 +130,13 @@ public:
         return mBufferSizeInFrames;
     }
 
+    /**
+     * Forget the buffer size so the next open() uses the default size in bursts.
+     */
+    void resetBufferSizeInFrames() {
+        mBufferSizeInFrames = 0;
+    }
+
     /**
      * Get the maximum allocated size of the buffer.
      */
@@ -208,6 +230,70 @@ public:
         return mUtilClampLevel == UTIL_CLAMP_ON_LOGGED;
     }
 
+    int32_t getUtilClampPolicy() const {
+        return mUtilClampPolicy;
+    }
+
+    /**
+     * Select how a dynamic utilClamp level is adjusted.
+     * @param policy UTIL_CLAMP_POLICY_REACTIVE or UTIL_CLAMP_POLICY_FEED_FORWARD
+     */
+    void setUtilClampPolicy(int32_t policy) {
+        mUtilClampPolicy = policy;
+    }
+
+    static const char *getUtilClampPolicyName(int32_t policy) {
+        switch (policy) {
+            case UTIL_CLAMP_POLICY_REACTIVE:
+                return "reactive";
+            case UTIL_CLAMP_POLICY_FEED_FORWARD:
+                return "feed.forward";
+            default:
+                return "unknown";
+        }
+    }
+
+    /**
+     * Called from the callback when the application knows the load it is about to render.
+     * This is called on the audio thread before the heavy burst starts.
+     *
+     * @param currentWorkUnits
+     * @param maxWorkUnits
+     */
+    virtual void setApplicationLoad(int32_t currentWorkUnits, int32_t maxWorkUnits) {}
+
+    /**
+     * @return the sched_util_min currently requested by the sink or -1 if it is not managed
+     */
+    virtual int32_t getCurrentUtilClamp() {
+        return -1;
+    }
+
+    /**
+     * Use a CPU manager that belongs to this sink instead of the global one.
+     * The sink does not take ownership. Pass nullptr to go back to the global manager.
+     */
+    void setCpuManager(HostCpuManagerBase *cpuManager) {
+        mCpuManager = cpuManager;
+    }
+
+    HostCpuManagerBase *getCpuManager() {
+        return (mCpuManager != nullptr) ? mCpuManager : HostCpuManager::getInstance();
+    }
+
+    /**
+     * Create a sink with the same settings that can run at the same time as this one.
+     * The copy uses the global CPU manager until setCpuManager() is called.
+     *
+     * @param logTool log for the copy
+     * @param tag added to the name of any file written by the copy so the sinks do not share it
+     * @return the copy or nullptr if this sink cannot be copied
+     */
+    virtual std::unique_ptr<AudioSinkBase> createConcurrentCopy(LogTool &logTool,
+                                                                const std::string &tag) {
+        return nullptr;
+    }
+
     virtual HostThreadFactory::ThreadType getThreadType() const {
         return HostThreadFactory::ThreadType::Default;
     }
@@ -223,6 +309,20 @@ public:
         mSchedFifoEnabled = enabled;
     }
 
+    static constexpr int64_t kTimerSlackUnspecified = -1;
+
+    int64_t getTimerSlackNanos() const {
+        return mTimerSlackNanos;
+    }
+
+    /**
+     * Set the timer slack for the audio thread, or kTimerSlackUnspecified
+     * to leave the thread with its inherited slack.
+     */
+    void setTimerSlackNanos(int64_t slackNanos) {
+        mTimerSlackNanos = slackNanos;
+    }
+
     bool isAdpfEnabled() const {
         return mAdpfEnabled;
     }
@@ -247,28 +347,74 @@ public:
         }
     }
 
-    std::string  dump() {
-        std::stringstream resultMessage;
-        resultMessage << std::endl;
-        resultMessage << "AudioSink:" << std::endl;
-        resultMessage << "  frames.per.burst       = " << getFramesPerBurst() << std::endl;
-        resultMessage << "  scheduler              = "
-                         << schedulerToString(mSchedulerUsed)
-                         << " # 0x" << std::hex << mSchedulerUsed << std::dec << std::endl;
-        resultMessage << "  buffer.size.frames     = "  << getBufferSizeInFrames() << std::endl;
-        resultMessage << "  buffer.size.bursts     = "
-                         << (getBufferSizeInFrames() / getFramesPerBurst()) << std::endl;
-        resultMessage << "  buffer.capacity.frames = "   << getBufferCapacityInFrames() << std::endl;
-        resultMessage << "  sample.rate            = "   << getSampleRate() << std::endl;
-        resultMessage << "  cpu.affinity           = "   << getActualCpu() << std::endl;
-        return resultMessage.str();
+    /**
+     * Called after stop().
+     * @return 0, or a negative SYNTHMARK_RESULT if some of the audio of the run was lost
+     */
+    virtual int32_t getOutputError() {
+        return SYNTHMARK_RESULT_SUCCESS;
+    }
+
+    virtual ResultReport dump() {
+        ResultReport report;
+        report << std::endl;
+        report.addHeading("AudioSink:");
+        report.setMetricLayout(2, 22);
+        report.addMetric("frames.per.burst", getFramesPerBurst());
+        std::stringstream schedulerCode;
+        schedulerCode << "0x" << std::hex << mSchedulerUsed;
+        report.addMetric("scheduler", schedulerToString(mSchedulerUsed), "", schedulerCode.str());
+        report.addMetric("buffer.size.frames", getBufferSizeInFrames());
+        report.addMetric("buffer.size.bursts", (getFramesPerBurst() > 0)
+                             ? (getBufferSizeInFrames() / getFramesPerBurst()) : 0);
+        report.addMetric("buffer.capacity.frames", getBufferCapacityInFrames());
+        report.addMetric("sample.rate", getSampleRate(), "Hz");
+        report.addMetric("cpu.affinity", getActualCpu());
+        report.addMetric("memory.locked", HostTools::isMemoryLocked() ? 1 : 0);
+        report.addMetric("page.faults.minor", mMinorFaults);
+        report.addMetric("page.faults.major", mMajorFaults);
+        return report;
     }
 
 protected:
+    // Copy the scheduling and buffer settings that are shared by every type of sink.
+    void copySettingsTo(AudioSinkBase *other) const {
+        other->setThreadType(getThreadType());
+        other->setSchedFifoEnabled(mSchedFifoEnabled);
+        other->setAdpfEnabled(mAdpfEnabled);
+        other->setUtilClampLevel(mUtilClampLevel);
+        other->setUtilClampPolicy(mUtilClampPolicy);
+        other->setDefaultBufferSizeInBursts(mDefaultBufferSizeInBursts);
+        other->setTimerSlackNanos(mTimerSlackNanos);
+    }
+
     void setActualCpu(int cpuAffinity) {
         mActualCpu = cpuAffinity;
     }
 
+    /**
+     * Count the page faults of the audio thread while it renders.
+     * Call on the audio thread before the first burst and after any prefaulting.
+     * The counts add up over every run of the sink.
+     */
+    void beginPageFaultCount() {
+        if (HostTools::getThreadPageFaults(&mMinorFaultsAtStart, &mMajorFaultsAtStart) < 0) {
+            mMinorFaultsAtStart = -1;
+        }
+    }
+
+    // Call on the audio thread after the last burst.
+    void endPageFaultCount() {
+        int64_t minorFaults = 0;
+        int64_t majorFaults = 0;
+        if (mMinorFaultsAtStart >= 0
+                && HostTools::getThreadPageFaults(&minorFaults, &majorFaults) == 0) {
+            mMinorFaults += minorFaults - mMinorFaultsAtStart;
+            mMajorFaults += majorFaults - mMajorFaultsAtStart;
+        }
+        mMinorFaultsAtStart = -1;
+    }
+
     // set in open
     int32_t       mSampleRate = kSynthmarkSampleRate;
     int32_t       mSamplesPerFrame = 1;
@@ -281,6 +427,12 @@ protected:
     // set in callback loop
     int           mSchedulerUsed = -1;
 
+    // page faults of the audio thread between the first and last burst
+    int64_t       mMinorFaults = 0;
+    int64_t       mMajorFaults = 0;
+    int64_t       mMinorFaultsAtStart = -1;
+    int64_t       mMajorFaultsAtStart = 0;
+
     int32_t       mBufferSizeInFrames = 0;
 // Use 2 for double buffered
     static constexpr int kBufferSizeInBursts = 8;
@@ -293,10 +445,13 @@ private:
     int            mRequestedCpu = SYNTHMARK_CPU_UNSPECIFIED;
     int            mActualCpu = SYNTHMARK_CPU_UNSPECIFIED;
     bool           mSchedFifoEnabled = true;
+    int64_t        mTimerSlackNanos = kTimerSlackUnspecified;
     bool           mAdpfEnabled = false;
     int32_t        mUtilClampLevel = UTIL_CLAMP_OFF;
+    int32_t        mUtilClampPolicy = UTIL_CLAMP_POLICY_REACTIVE;
 
     int32_t        mMaxEmptyFrames = 0;
+    HostCpuManagerBase *mCpuManager = nullptr;
 };
 
 #endif // SYNTHMARK_AUDIO_SINK_BASE_H
@@ -17,10 +17,14 @@
 #ifndef SYNTHMARK_AUTOMATED_TEST_SUITE_H
 #define SYNTHMARK_AUTOMATED_TEST_SUITE_H
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <memory>
+#include <thread>
 #include <vector>
 
+#include "tools/CpuTopology.h"
 #include "tools/LatencyMarkHarness.h"
 #include "tools/TimingAnalyzer.h"
 #include "tools/UtilizationMarkHarness.h"
@@ -30,16 +34,16 @@
 
 /**
  * Run an automated test, analyze the results and print a report.
- * 1) Determine what CPUs are available
- * 2) Run VoiceMark on each CPU to determine big vs little CPUs
+ * 1) Discover the CPU frequency domains from sysfs, see CpuTopology.
+ * 2) Run VoiceMark on one CPU from each domain to rank the domains.
+ *    Independent domains are measured at the same time.
  * 3) Run LatencyMark with a light load, a heavy load, then an alternating load.
  * 4) Print report with analysis.
  *
- * The current code:
- *     assumes that the CPU numbering depends on their capacity,
- *     assumes that both lowCpu and highCpu are online,
- *     assume the existence of only two architectures, homogeneous or BIG.little.
- * TODO handle more architectures
+ * The domains are labelled from slowest to fastest as "little", "mid1", ..., "big".
+ * The fastest domain is always "big". A host with one domain is "big".
+ * Latency is measured on the slowest and the fastest domains.
+ *
  * TODO Measure latency without CPU affinity
  */
 class AutomatedTestSuite : public TestHarnessParameters {
@@ -62,6 +66,15 @@ public:
         return "Automated Test Suite";
     }
 
+    /**
+     * Allow VoiceMark to run on several frequency domains at the same time.
+     * Each extra domain uses its own VirtualAudioSink so this should only be
+     * enabled when the audio is not going to a real device.
+     */
+    void setConcurrentDomainsEnabled(bool enabled) {
+        mConcurrentDomainsEnabled = enabled;
+    }
+
     double framesToMillis(double frames) {
         return frames * SYNTHMARK_MILLIS_PER_SECOND / getSampleRate();
     }
@@ -70,7 +83,7 @@ public:
         mLogTool.log("\nSynthMark Version " SYNTHMARK_VERSION_TEXT "\n");
 
         mLogTool.log("\n-------- CPU Performance ------------\n");
-        int32_t err = measureLowHighCpuPerformance(sampleRate, framesPerBurst, 10);
+        int32_t err = measureCpuPerformance(sampleRate, framesPerBurst, 10);
         if (err) return err;
 
         mLogTool.log("\n-------- LATENCY ------------\n");
@@ -116,118 +129,222 @@ struct LatencyResult {
 #define kKeyLatencyFixedLittle   "latencymark.fixed.little"
 #define kKeyLatencyDynamicLittle "latencymark.dynamic.little"
 
-    static constexpr double kHighLowThreshold = 0.1; // Difference between CPUs to consider them BIG-little.
     static constexpr double kMaxUtilization = 0.9; // Maximum load that we will push the CPU to.
     static constexpr int    kMaxUtilizationPercent = (int)(kMaxUtilization * 100); // as a percentage
 
     // These names must match the names in the Android CDD.
     void printSummaryCDD(double latencyMarkFixedLittleFrames,
                          double latencyMarkDynamicLittleFrames) {
-        std::stringstream resultMessage;
-        resultMessage << TEXT_CDD_SUMMARY_BEGIN << " -------" << std::endl;
+        ResultReport report;
+        report << TEXT_CDD_SUMMARY_BEGIN << " -------" << std::endl;
+        report.setSection("cdd.summary");
 
-        resultMessage << kKeyVoiceMark90 << " = " << mVoiceMarkBig << std::endl;
+        report.addMetric(kKeyVoiceMark90, mVoiceMarkBig);
 
         int latencyMillis = (int)framesToMillis(latencyMarkFixedLittleFrames);
         if (latencyMillis <= 0) {
-            resultMessage << "# " << kKeyLatencyFixedLittle << " could not be measured!" << std::endl;
+            report << "# " << kKeyLatencyFixedLittle << " could not be measured!" << std::endl;
         } else {
-            resultMessage << kKeyLatencyFixedLittle << " = " << latencyMillis << std::endl;
+            report.addMetric(kKeyLatencyFixedLittle, latencyMillis);
         }
 
         latencyMillis = (int)framesToMillis(latencyMarkDynamicLittleFrames);
         if (latencyMillis <= 0) {
-            resultMessage << "# " << kKeyLatencyDynamicLittle << " could not be measured!" << std::endl;
+            report << "# " << kKeyLatencyDynamicLittle << " could not be measured!" << std::endl;
         } else {
-            resultMessage << kKeyLatencyDynamicLittle << " = " << latencyMillis << std::endl;
+            report.addMetric(kKeyLatencyDynamicLittle, latencyMillis);
         }
 
-        resultMessage << TEXT_CDD_SUMMARY_END << " ---------" << std::endl;
-        resultMessage << std::endl;
-        mResult->appendMessage(resultMessage.str());
+        report << TEXT_CDD_SUMMARY_END << " ---------" << std::endl;
+        report.setSection("");
+        report << std::endl;
+        mResult->appendReport(report);
     }
 
-    virtual int32_t measureLowHighCpuPerformance(int32_t sampleRate,
-                                                 int32_t framesPerBurst,
-                                                 int32_t numSeconds) {
-        std::stringstream resultMessage;
-        int numCPUs = HostTools::getCpuCount();
+    struct DomainMark {
+        CpuTopology::Domain domain;
+        std::string         label;
+        double              voiceMark = 0.0;
+        int32_t             err = SYNTHMARK_RESULT_SUCCESS;
+    };
+
+    /**
+     * Run VoiceMark on the representative CPU of one domain.
+     */
+    void measureDomainVoiceMark(AudioSinkBase *audioSink,
+                                LogTool &logTool,
+                                int32_t sampleRate,
+                                int32_t framesPerBurst,
+                                int32_t numSeconds,
+                                DomainMark *mark) {
         SynthMarkResult result1;
-        VoiceMarkHarness *harness = new VoiceMarkHarness(mAudioSink, &result1, mLogTool);
-        harness->setTargetCpuLoad(kMaxUtilization);
-        harness->setInitialVoiceCount(mNumVoices);
-        harness->setDelayNoteOnSeconds(mDelayNotesOn);
-        harness->setThreadType(mThreadType);
+        VoiceMarkHarness harness(audioSink, &result1, logTool);
+        harness.setTargetCpuLoad(kMaxUtilization);
+        harness.setInitialVoiceCount(mNumVoices);
+        harness.setDelayNoteOnSeconds(mDelayNotesOn);
+        harness.setThreadType(mThreadType);
+        harness.setSynthesizerSettings(mSynthesizerSettings);
+
+        int cpu = mark->domain.representativeCpu;
+        audioSink->setRequestedCpu(cpu);
+        logTool.log("Run VoiceMark with CPU #%d from CPUs %s\n",
+                    cpu, mark->domain.getCpuList().c_str());
+        mark->err = harness.runTest(sampleRate, framesPerBurst, numSeconds);
+        mark->voiceMark = result1.getMeasurement();
+        logTool.log("CPU #%d VoiceMark_%d = %5.1f\n",
+                    cpu, kMaxUtilizationPercent, mark->voiceMark);
+    }
 
-        // TODO This is hack way to choose CPUs for BIG.little architectures.
-        // TODO Test each CPU or come up with something better.
-        mLogTool.log("Try to find BIG/LITTLE CPUs\n");
-        int lowCpu = (1 * numCPUs) / 4;
-        mAudioSink->setRequestedCpu(lowCpu);
-        mLogTool.log("Run low VoiceMark with CPU #%d\n", lowCpu);
-        int32_t err = harness->runTest(sampleRate, framesPerBurst, numSeconds);
-        if (err) {
-            delete harness;
-            return err;
+    /**
+     * Run VoiceMark on every domain at once, each with its own copy of the sink and log.
+     * Each copy gets its own CPU manager stub so the threads do not share its timing state.
+     * The logs are copied to the main log when the threads finish.
+     * @return false if the sink cannot be copied, so the domains must be measured one at a time
+     */
+    bool measureDomainsConcurrently(int32_t sampleRate,
+                                    int32_t framesPerBurst,
+                                    int32_t numSeconds) {
+        size_t numDomains = mDomainMarks.size();
+        std::vector<std::unique_ptr<LogTool>> logTools;
+        std::vector<std::unique_ptr<AudioSinkBase>> audioSinks;
+        std::vector<std::unique_ptr<HostCpuManagerStub>> cpuManagers;
+        std::vector<std::thread> threads;
+        // Create the global manager here so the threads do not race to create it.
+        HostCpuManager::getInstance();
+        for (size_t i = 0; i < numDomains; i++) {
+            logTools.push_back(std::make_unique<LogTool>());
+            std::string tag = "cpu" + std::to_string(mDomainMarks[i].domain.representativeCpu);
+            std::unique_ptr<AudioSinkBase> audioSink
+                    = mAudioSink->createConcurrentCopy(*logTools.back(), tag);
+            if (!audioSink) {
+                return false;
+            }
+            cpuManagers.push_back(std::make_unique<HostCpuManagerStub>());
+            audioSink->setCpuManager(cpuManagers.back().get());
+            audioSinks.push_back(std::move(audioSink));
+        }
+        for (size_t i = 0; i < numDomains; i++) {
+            threads.emplace_back(&AutomatedTestSuite::measureDomainVoiceMark, this,
+                                 audioSinks[i].get(), std::ref(*logTools[i]),
+                                 sampleRate, framesPerBurst, numSeconds,
+                                 &mDomainMarks[i]);
         }
+        for (size_t i = 0; i < numDomains; i++) {
+            threads[i].join();
+            std::string text;
+            while (logTools[i]->hasLogs()) {
+                text += logTools[i]->readLog();
+            }
+            // Copy one line at a time because LogTool truncates long messages.
+            std::stringstream lines(text);
+            std::string line;
+            while (std::getline(lines, line)) {
+                mLogTool.log("%s\n", line.c_str());
+            }
+        }
+        return true;
+    }
 
-        double voiceMarkLowIndex = result1.getMeasurement();
-        mLogTool.log("low VoiceMark_%d = %5.1f\n", kMaxUtilizationPercent, voiceMarkLowIndex);
-        double voiceMarkHighIndex = voiceMarkLowIndex;
-
-        int highCpu = (3 * numCPUs) / 4;
-        // If there are more than 2 CPUs than measure one each from top and bottom half in
-        // case they are heterogeneous.
-        if (lowCpu != highCpu) {
-            mAudioSink->setRequestedCpu(highCpu);
-            mLogTool.log("Run high VoiceMark with CPU #%d\n", highCpu);
-            err = harness->runTest(sampleRate, framesPerBurst, numSeconds);
-            if (err) {
-                delete harness;
-                return err;
+    /**
+     * Label the domains, which must be sorted from slowest to fastest.
+     * The fastest domain is always "big", as in the reports before domains were discovered.
+     */
+    void labelDomains() {
+        size_t numDomains = mDomainMarks.size();
+        for (size_t i = 0; i < numDomains; i++) {
+            std::string label;
+            if (i == numDomains - 1) {
+                label = "big";
+            } else if (i == 0) {
+                label = "little";
+            } else {
+                label = "mid" + std::to_string(i);
             }
-            voiceMarkHighIndex = result1.getMeasurement();
-            mLogTool.log("high VoiceMark_%d = %5.1f\n", kMaxUtilizationPercent, voiceMarkHighIndex);
+            mDomainMarks[i].label = label;
+        }
+    }
 
-            double averageVoiceMark = 0.5 * (voiceMarkHighIndex + voiceMarkLowIndex);
-            double threshold = kHighLowThreshold * averageVoiceMark;
+    virtual int32_t measureCpuPerformance(int32_t sampleRate,
+                                          int32_t framesPerBurst,
+                                          int32_t numSeconds) {
+        ResultReport report;
+        CpuTopology topology;
+        int32_t numDomains = topology.discover();
+
+        mDomainMarks.clear();
+        for (const CpuTopology::Domain &domain : topology.getDomains()) {
+            DomainMark mark;
+            mark.domain = domain;
+            mDomainMarks.push_back(mark);
+        }
 
-            mHaveBigLittle = (abs(voiceMarkHighIndex - voiceMarkLowIndex) > threshold);
+        // Domains with their own clock can be measured at the same time.
+        // The workload hints use one global CPU manager so they cannot.
+        bool concurrent = mConcurrentDomainsEnabled
+                && numDomains > 1
+                && topology.areDomainsIndependent()
+                && HostCpuManager::getWorkloadHintsLevel() == HostCpuManager::WORKLOAD_HINTS_OFF;
+        mLogTool.log("Found %d CPU domain(s) using %s, measure them %s\n",
+                     numDomains, CpuTopology::getSourceName(topology.getSource()),
+                     concurrent ? "concurrently" : "sequentially");
+
+        int64_t startTime = HostTools::getNanoTime();
+        if (concurrent && !measureDomainsConcurrently(sampleRate, framesPerBurst, numSeconds)) {
+            mLogTool.log("This audio sink cannot be copied, measure the domains sequentially\n");
+            concurrent = false;
         }
+        if (!concurrent) {
+            for (DomainMark &mark : mDomainMarks) {
+                measureDomainVoiceMark(mAudioSink, mLogTool,
+                                       sampleRate, framesPerBurst, numSeconds, &mark);
+                if (mark.err) break;
+            }
+        }
+        double elapsedSeconds = (HostTools::getNanoTime() - startTime)
+                / (double) SYNTHMARK_NANOS_PER_SECOND;
+        for (const DomainMark &mark : mDomainMarks) {
+            if (mark.err) return mark.err;
+        }
+
+        // Rank by the reported capacity, then the maximum clock, then the measurement.
+        std::stable_sort(mDomainMarks.begin(), mDomainMarks.end(),
+                  [](const DomainMark &a, const DomainMark &b) {
+                      if (a.domain.capacity != b.domain.capacity) {
+                          return a.domain.capacity < b.domain.capacity;
+                      } else if (a.domain.maxFrequencyKHz != b.domain.maxFrequencyKHz) {
+                          return a.domain.maxFrequencyKHz < b.domain.maxFrequencyKHz;
+                      }
+                      return a.voiceMark < b.voiceMark;
+                  });
+        labelDomains();
+
+        const DomainMark &little = mDomainMarks.front();
+        const DomainMark &big = mDomainMarks.back();
+        mLittleCpu = little.domain.representativeCpu;
+        mVoiceMarkLittle = little.voiceMark;
+        mBigCpu = big.domain.representativeCpu;
+        mVoiceMarkBig = big.voiceMark;
+        mHaveBigLittle = (numDomains > 1);
 
         if (mHaveBigLittle) {
-            if (voiceMarkHighIndex > voiceMarkLowIndex) {
-                mLittleCpu = lowCpu;
-                mVoiceMarkLittle = voiceMarkLowIndex;
-                mBigCpu = highCpu;
-                mVoiceMarkBig = voiceMarkHighIndex;
-            } else {
-                mLittleCpu = highCpu;
-                mVoiceMarkLittle = voiceMarkHighIndex;
-                mBigCpu = lowCpu;
-                mVoiceMarkBig = voiceMarkLowIndex;
-            }
-            resultMessage << "# The CPU seems to be heterogeneous. Assume BIG-little.\n";
-            resultMessage << "cpu.little = " << mLittleCpu << std::endl;
-            resultMessage << "cpu.big = " << mBigCpu << std::endl;
+            report << "# The CPU is heterogeneous with " << numDomains << " types of core.\n";
         } else {
-            mLittleCpu = highCpu;
-            mVoiceMarkLittle = voiceMarkHighIndex;
-            mBigCpu = highCpu;
-            mVoiceMarkBig = voiceMarkHighIndex;
-            resultMessage << "# The CPU seems to be homogeneous.\n";
-            resultMessage << "cpu = " << mLittleCpu << std::endl;
+            report << "# The CPU seems to be homogeneous.\n";
         }
-
-        resultMessage << "voice.mark." << cpuToBigLittle(lowCpu) << " = " << voiceMarkLowIndex << std::endl;
-        if (lowCpu != highCpu) {
-            resultMessage << "voice.mark." << cpuToBigLittle(highCpu) << " = " << voiceMarkHighIndex << std::endl;
+        report.addMetric("cpu.domains", numDomains);
+        report.addMetric("cpu.domains.source", CpuTopology::getSourceName(topology.getSource()));
+        report.addMetric("cpu.domains.concurrent", concurrent ? 1 : 0);
+        report.addMetric("cpu.performance.seconds", elapsedSeconds);
+        for (const DomainMark &mark : mDomainMarks) {
+            const std::string &label = mark.label;
+            report.addMetric("cpu." + label, mark.domain.representativeCpu);
+            report.addMetric("cpu." + label + ".cpus", mark.domain.getCpuList());
+            report.addMetric("cpu." + label + ".capacity", mark.domain.capacity);
+            report.addMetric("cpu." + label + ".max.khz", mark.domain.maxFrequencyKHz);
+            report.addMetric("voice.mark." + label, mark.voiceMark);
         }
 
-        // std::cout << result1.getResultMessage();
-
-        mResult->appendMessage(resultMessage.str());
-        delete harness;
+        mResult->appendReport(report);
         return SYNTHMARK_RESULT_SUCCESS;
     }
 
@@ -238,13 +355,14 @@ struct LatencyResult {
                                int32_t numVoices,
                                int32_t numVoicesHigh,
                                double *latencyPtr) {
-        std::stringstream resultMessage;
+        ResultReport report;
         SynthMarkResult result1;
         LatencyMarkHarness *harness = new LatencyMarkHarness(mAudioSink, &result1, mLogTool);
         harness->setDelayNoteOnSeconds(mDelayNotesOn);
         harness->setNumVoices(numVoices);
         harness->setNumVoicesHigh(numVoicesHigh);
         harness->setThreadType(mThreadType);
+        harness->setSynthesizerSettings(mSynthesizerSettings);
 
         mAudioSink->setRequestedCpu(cpu);
         mLogTool.log("Run LatencyMark with CPU #%d, voices = %d / %d\n",
@@ -261,10 +379,10 @@ struct LatencyResult {
         double latencyFrames = result1.getMeasurement();
         std::stringstream suffix;
         suffix << "." << ((cpu < 0) ? "N" : std::to_string(cpu)) << "." << numVoices << "." << numVoicesHigh;
-        resultMessage << "audio.latency.frames" << suffix.str() << " = " << latencyFrames << std::endl;
+        report.addMetric(std::string("audio.latency.frames") + suffix.str(), latencyFrames);
         double latencyMillis = framesToMillis(latencyFrames);
-        resultMessage << "audio.latency.msec" << suffix.str() << " = " << latencyMillis << std::endl;
-        mResult->appendMessage(resultMessage.str());
+        report.addMetric(std::string("audio.latency.msec") + suffix.str(), latencyMillis);
+        mResult->appendReport(report);
         *latencyPtr = latencyFrames;
         mLogTool.log("Got latencyMillis = %5.1f msec\n", latencyMillis);
         delete harness;
@@ -272,9 +390,10 @@ struct LatencyResult {
     }
 
     const char *cpuToBigLittle(int cpu) {
-        if (cpu == mBigCpu) return "big";
-        else if (cpu == mLittleCpu) return "little";
-        else return "cpux";
+        for (const DomainMark &mark : mDomainMarks) {
+            if (cpu == mark.domain.representativeCpu) return mark.label.c_str();
+        }
+        return "cpux";
     }
 
     LatencyResult measureLatency(int32_t sampleRate,
@@ -282,7 +401,7 @@ struct LatencyResult {
                            int32_t numSeconds,
                            int cpu,
                            int32_t numVoicesMax) {
-        std::stringstream message;
+        ResultReport report;
         LatencyResult result;
 
         mLogTool.log("\n---- Measure latency for CPU #%d ----\n", cpu);
@@ -293,47 +412,53 @@ struct LatencyResult {
         result.err = measureLatencyOnce(sampleRate, framesPerBurst, numSeconds,
                                         cpu, numVoicesLow, numVoicesLow, &result.lightLatencyFrames);
         if (result.err) return result;
-        message << "# Latency in frames with a steady light CPU load.\n";
-        message << "latency.light." << cpuToBigLittle(cpu) << " = " << result.lightLatencyFrames << std::endl;
+        report << "# Latency in frames with a steady light CPU load.\n";
+        report.addMetric(std::string("latency.light.") + cpuToBigLittle(cpu),
+                         result.lightLatencyFrames);
 
         // Test latency with a high number of voices.
         result.err = measureLatencyOnce(sampleRate, framesPerBurst, numSeconds,
                                         cpu, numVoicesHigh, numVoicesHigh, &result.heavyLatencyFrames);
         if (result.err) return result;
-        message << "# Latency in frames with a steady heavy CPU load.\n";
-        message << "latency.heavy." << cpuToBigLittle(cpu) << " = " << result.heavyLatencyFrames << std::endl;
+        report << "# Latency in frames with a steady heavy CPU load.\n";
+        report.addMetric(std::string("latency.heavy.") + cpuToBigLittle(cpu),
+                         result.heavyLatencyFrames);
 
         // Alternate low to high to stress the CPU governor.
         result.err = measureLatencyOnce(sampleRate, framesPerBurst, numSeconds,
                                         cpu, numVoicesLow, numVoicesHigh, &result.mixedLatencyFrames);
         if (result.err) return result;
-        message << "# Latency in frames when alternating between light and heavy CPU load.\n";
-        message << "latency.mixed." << cpuToBigLittle(cpu) << " = " << result.mixedLatencyFrames << std::endl;
+        report << "# Latency in frames when alternating between light and heavy CPU load.\n";
+        report.addMetric(std::string("latency.mixed.") + cpuToBigLittle(cpu),
+                         result.mixedLatencyFrames);
 
         // Analysis
         double mixedOverHigh = result.mixedLatencyFrames / result.heavyLatencyFrames;
-        message << "latency.mixed.over.heavy." << cpuToBigLittle(cpu)
-                << " = " << mixedOverHigh << std::endl;
+        report.addMetric(std::string("latency.mixed.over.heavy.") + cpuToBigLittle(cpu),
+                         mixedOverHigh);
         if (mixedOverHigh > 1.1) {
-            message << "# Dynamic load on CPU " << cpu << " has higher latency than"
-                    << " a steady heavy load.\n";
-            message << "# This suggests that the CPU governor is not responding\n";
-            message << "# very quickly to sudden changes in load.\n";
+            report << "# Dynamic load on CPU " << cpu << " has higher latency than"
+                   << " a steady heavy load.\n";
+            report << "# This suggests that the CPU governor is not responding\n";
+            report << "# very quickly to sudden changes in load.\n";
         }
-        message << std::endl;
-        mResult->appendMessage(message.str());
+        report << std::endl;
+        mResult->appendReport(report);
         return result;
     }
 
 private:
 
-    int              mBigCpu = 0;  // A CPU index in fast half of CPUs available.
+    int              mBigCpu = 0;  // A CPU from the fastest domain.
     double           mVoiceMarkBig = 0.0;  // for CDD voicemark.90
 
-    int              mLittleCpu = 0; // A CPU index in slow half of CPUs available.
+    int              mLittleCpu = 0; // A CPU from the slowest domain.
     double           mVoiceMarkLittle = 0.0;
 
     bool             mHaveBigLittle = false;
+    bool             mConcurrentDomainsEnabled = false;
+
+    std::vector<DomainMark> mDomainMarks; // sorted from slowest to fastest
 
 };
 
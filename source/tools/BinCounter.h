@@ -63,6 +63,29 @@ public:
         return mLastMarkers;
     }
 
+    /**
+     * @param fraction of the counts, eg. 0.99
+     * @return index of the bin that holds that fraction of the counts, or -1 if empty
+     */
+    int32_t findPercentileBin(double fraction) const {
+        int64_t total = 0;
+        for (int32_t i = 0; i < mNumBins; i++) {
+            total += mBins[i];
+        }
+        if (total == 0) {
+            return -1;
+        }
+        int64_t needed = (int64_t) (fraction * total + 0.5);
+        int64_t sum = 0;
+        for (int32_t i = 0; i < mNumBins; i++) {
+            sum += mBins[i];
+            if (sum >= needed) {
+                return i;
+            }
+        }
+        return mNumBins - 1;
+    }
+
 private:
     int32_t *mBins;
     int32_t *mLastMarkers;
@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SYNTHMARK_CACHE_SWEEP_HARNESS_H
+#define SYNTHMARK_CACHE_SWEEP_HARNESS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "AudioSinkBase.h"
+#include "SynthMark.h"
+#include "SynthMarkResult.h"
+#include "tools/CpuTopology.h"
+#include "tools/LogTool.h"
+#include "TestHarnessParameters.h"
+#include "UtilizationMarkHarness.h"
+
+/**
+ * Measure the render time per voice as the state of all the voices grows past each cache.
+ *
+ * Each voice is given an extra table that it reads one cache line of for every sample,
+ * see SynthesizerSettings::voiceStateBytes. The size of the table and the number of
+ * voices are varied independently and UtilizationMark is run at every point.
+ * The cost per voice stays flat while the tables of all the voices fit in a cache,
+ * then it jumps when the working set spills into the next level.
+ *
+ * The grid is written like the sweep grid:
+ *   s = state bytes per voice, n = voices
+ * For example "s1024,16384:n1,2,4,8,16,32,64".
+ */
+class CacheSweepHarness : public TestHarnessParameters {
+public:
+    static constexpr int32_t kMaxStateBytes = 1024 * 1024;
+    // A point is a knee when it costs this much more per voice than the smaller working sets.
+    static constexpr double  kKneeRatio = 1.2;
+
+    struct Grid {
+        std::vector<int32_t> stateBytes;
+        std::vector<int32_t> numVoices;
+    };
+
+    CacheSweepHarness(AudioSinkBase *audioSink, SynthMarkResult *result, LogTool &logTool)
+    : TestHarnessParameters(audioSink, result, logTool) {
+        mGrid.stateBytes = {256, 4096, 65536};
+        mGrid.numVoices = {1, 2, 4, 8, 16, 32, 64, 128, 256};
+    }
+
+    virtual ~CacheSweepHarness() = default;
+
+    const char *getName() const override {
+        return "CacheSweep";
+    }
+
+    /**
+     * @return 0 or -1 if the text could not be parsed
+     */
+    static int32_t parseGrid(const std::string &text, Grid *grid) {
+        std::stringstream dimensions(text);
+        std::string dimension;
+        while (std::getline(dimensions, dimension, ':')) {
+            if (dimension.size() < 2) {
+                return -1;
+            }
+            std::vector<int32_t> *values = nullptr;
+            int32_t maxValue = 0;
+            switch (dimension[0]) {
+                case 's': values = &grid->stateBytes; maxValue = kMaxStateBytes; break;
+                case 'n': values = &grid->numVoices; maxValue = kSynthmarkMaxVoices; break;
+                default: return -1;
+            }
+            values->clear();
+            std::stringstream list(dimension.substr(1));
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                char *end = nullptr;
+                long value = strtol(item.c_str(), &end, 10);
+                if (item.empty() || *end != 0 || value < 1 || value > maxValue) {
+                    return -1;
+                }
+                values->push_back((int32_t) value);
+            }
+            if (values->empty()) {
+                return -1;
+            }
+            std::sort(values->begin(), values->end());
+        }
+        return 0;
+    }
+
+    /**
+     * @param text see the class comment
+     * @return 0 or -1 if the grid is invalid
+     */
+    int32_t setGrid(const std::string &text) {
+        Grid grid = mGrid;
+        if (parseGrid(text, &grid) < 0) {
+            return -1;
+        }
+        mGrid = grid;
+        return 0;
+    }
+
+    int32_t runTest(int32_t sampleRate, int32_t framesPerBurst, int32_t numSeconds) override {
+        int cpu = mAudioSink->getRequestedCpu();
+        mCaches = CpuTopology::getDataCaches(std::max(0, cpu));
+        mPoints.clear();
+
+        SynthMarkResult pointResult;
+        UtilizationMarkHarness harness(mAudioSink, &pointResult, mLogTool);
+        harness.setDelayNoteOnSeconds(mDelayNotesOn);
+        harness.setThreadType(mThreadType);
+
+        int32_t result = SYNTHMARK_RESULT_SUCCESS;
+        double nanosPerFrame = (double) SYNTHMARK_NANOS_PER_SECOND / sampleRate;
+        for (int32_t stateBytes : mGrid.stateBytes) {
+            SynthesizerSettings settings = mSynthesizerSettings;
+            settings.voiceStateBytes = stateBytes;
+            harness.setSynthesizerSettings(settings);
+            for (int32_t numVoices : mGrid.numVoices) {
+                if (TestHarnessBase::isCancelled()) {
+                    result = SYNTHMARK_RESULT_CANCELLED;
+                    break;
+                }
+                Point point;
+                harness.setNumVoices(numVoices);
+                pointResult.reset();
+                point.resultCode = harness.runTest(sampleRate, framesPerBurst, numSeconds);
+                if (point.resultCode != SYNTHMARK_RESULT_SUCCESS) {
+                    result = point.resultCode;
+                    break;
+                }
+                point.requestedStateBytes = stateBytes;
+                point.stateBytes = harness.getVoiceStateBytes();
+                point.numVoices = numVoices;
+                point.workingSetBytes = (int64_t) numVoices * point.stateBytes;
+                point.utilization = pointResult.getMeasurement();
+                point.nanosPerVoiceSample = point.utilization * nanosPerFrame / numVoices;
+                mLogTool.log("state = %d bytes, voices = %d, %.2f nsec per voice sample\n",
+                             point.stateBytes, numVoices, point.nanosPerVoiceSample);
+                mPoints.push_back(point);
+            }
+            if (result != SYNTHMARK_RESULT_SUCCESS) {
+                break;
+            }
+        }
+
+        mResult->setTestName(getName());
+        mResult->setMeasurement((double) mPoints.size());
+        mResult->setResultCode(result);
+        mResult->appendReport(dump(numSeconds));
+        return result;
+    }
+
+private:
+    struct Point {
+        int32_t requestedStateBytes = 0; // from the grid
+        int32_t stateBytes = 0;          // allocated by the synthesizer after rounding
+        int32_t numVoices = 0;
+        int64_t workingSetBytes = 0;
+        double  utilization = 0.0;
+        double  nanosPerVoiceSample = 0.0;
+        int32_t resultCode = SYNTHMARK_RESULT_UNINITIALIZED;
+    };
+
+    /**
+     * @return name of the smallest cache that holds the working set, or "memory"
+     */
+    std::string findCacheName(int64_t workingSetBytes) const {
+        for (const CpuTopology::Cache &cache : mCaches) {
+            if (workingSetBytes <= cache.sizeBytes) {
+                return cache.name;
+            }
+        }
+        return "memory";
+    }
+
+    ResultReport dump(int32_t numSeconds) {
+        ResultReport report;
+        report.addMetric("cache.sweep.points", mPoints.size());
+        report.addMetric("cache.sweep.seconds.per.point", numSeconds);
+        for (const CpuTopology::Cache &cache : mCaches) {
+            report.addMetric("cache." + cache.name + ".bytes", cache.sizeBytes);
+        }
+
+        // Find the first knee for each state size in the grid.
+        // Two sizes in the grid may be rounded to the same size, so they are kept apart.
+        size_t first = 0;
+        while (first < mPoints.size()) {
+            size_t end = first;
+            while (end < mPoints.size()
+                    && mPoints[end].requestedStateBytes == mPoints[first].requestedStateBytes) {
+                end++;
+            }
+            int32_t requestedStateBytes = mPoints[first].requestedStateBytes;
+            int32_t stateBytes = mPoints[first].stateBytes;
+            std::string prefix = "cache.sweep.state." + std::to_string(requestedStateBytes) + ".";
+            report.addMetric(prefix + "actual.bytes", stateBytes);
+            double lowest = mPoints[first].nanosPerVoiceSample;
+            bool foundKnee = false;
+            for (size_t i = first + 1; i < end && !foundKnee; i++) {
+                const Point &point = mPoints[i];
+                if (point.nanosPerVoiceSample > kKneeRatio * lowest) {
+                    report.addMetric(prefix + "knee.voices", point.numVoices);
+                    report.addMetric(prefix + "knee.working.set.bytes", point.workingSetBytes);
+                    foundKnee = true;
+                }
+                lowest = std::min(lowest, point.nanosPerVoiceSample);
+            }
+            if (!foundKnee) {
+                report << "# no knee found for " << stateBytes << " bytes per voice"
+                       << std::endl;
+            }
+            // Use the size that was allocated so this matches the working set of the points.
+            for (const CpuTopology::Cache &cache : mCaches) {
+                if (stateBytes > 0) {
+                    report.addMetric(prefix + "voices.in." + cache.name,
+                                     cache.sizeBytes / stateBytes);
+                }
+            }
+            first = end;
+        }
+
+        report << std::endl;
+        report.addHeading("Cache Sweep Points");
+        report.beginTable("state.bytes, voices, working.set.bytes, utilization"
+                          ", nsec.per.voice.sample, fits.in");
+        for (const Point &point : mPoints) {
+            report.addCell(point.stateBytes, 11);
+            report.addCell(point.numVoices, 6);
+            report.addCell(point.workingSetBytes, 17);
+            report << std::fixed << std::setprecision(4);
+            report.addCell(point.utilization, 11);
+            report << std::setprecision(2);
+            report.addCell(point.nanosPerVoiceSample, 21);
+            report.addCell(findCacheName(point.workingSetBytes));
+            report.endRow();
+        }
+        report.endTable();
+        report << std::defaultfloat;
+        return report;
+    }
+
+    Grid                  mGrid;
+    std::vector<CpuTopology::Cache> mCaches;
+    std::vector<Point>    mPoints;
+};
+
+#endif // SYNTHMARK_CACHE_SWEEP_HARNESS_H
@@ -154,32 +154,32 @@ public:
     }
 
     void onEndMeasurement() override {
-        std::stringstream resultMessage;
+        ResultReport report;
 
-        resultMessage << dumpJitter();
+        report << dumpJitter();
 
-        resultMessage << mTestName;
+        report << mTestName;
         if (mState == STATE_SLOW) {
-            resultMessage << " FAIL - Clock ramp duration too long or high voice num "
-                    <<  getNumVoicesHigh() << " too high." << std::endl;
+            report << " FAIL - Clock ramp duration too long or high voice num "
+                   <<  getNumVoicesHigh() << " too high." << std::endl;
         } else if (mState == STATE_TOO_HIGH) {
-            resultMessage << " FAIL - Low voice num " << getNumVoices()
-                          << " was too much for CPU." << std::endl;
+            report << " FAIL - Low voice num " << getNumVoices()
+                   << " was too much for CPU." << std::endl;
         } else if (mState == STATE_TOO_LOW || mRampDurationCount == 0) {
-            resultMessage << " FAIL - Never saturated the CPU. Difference in voices was too low."
-                          << std::endl;
+            report << " FAIL - Never saturated the CPU. Difference in voices was too low."
+                   << std::endl;
         } else {
-            resultMessage << " valid" << std::endl;
+            report << " valid" << std::endl;
             double averageRampMillis = ((double) mRampDurationSum)
                                         / (mRampDurationCount * SYNTHMARK_NANOS_PER_MILLISECOND);
             mResult->setMeasurement(averageRampMillis);
-            resultMessage << "clock.ramp.msec = " << averageRampMillis << std::endl;
+            report.addMetric("clock.ramp.msec", averageRampMillis);
         }
 
-        resultMessage << "underrun.count = " << mAudioSink->getUnderrunCount() << "\n";
-        resultMessage << mCpuAnalyzer.dump();
+        report.addMetric("underrun.count", mAudioSink->getUnderrunCount());
+        report << mCpuAnalyzer.dump();
 
-        mResult->appendMessage(resultMessage.str());
+        mResult->appendReport(report);
     }
 
 private:
@@ -17,25 +17,80 @@
 #ifndef SYNTHMARK_CPU_ANALYZER_H
 #define SYNTHMARK_CPU_ANALYZER_H
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <ctime>
 #include <iomanip>
+#include <memory>
 #include <sstream>
+#include <sys/resource.h>
 
 #include "BinCounter.h"
 #include "HostTools.h"
+#include "SchedStatReader.h"
 #include "SynthMark.h"
 
 /**
  * Measure CPU migration.
+ *
+ * Optionally, every N calls, also sample the schedstat and rusage of the calling thread
+ * to measure the run queue wait, context switches and page faults during the test.
  */
 class CpuAnalyzer
 {
 public:
+    // Run queue wait per sample, 1 usec resolution up to 10 msec.
+    static constexpr int32_t kWaitNanosPerBin = 1000;
+    static constexpr int32_t kWaitNumBins = 10000;
+
+    CpuAnalyzer() {
+        setSchedulerSamplePeriod(defaultSchedulerSamplePeriod().load());
+    }
+
+    /**
+     * Set the period for analyzers that are created after this call.
+     * This lets the command line reach harnesses that are created by other harnesses.
+     *
+     * @param bursts calls to recordCpu() between samples, or 0 to disable
+     */
+    static void setDefaultSchedulerSamplePeriod(int32_t bursts) {
+        defaultSchedulerSamplePeriod().store(std::max(0, bursts));
+    }
+
+    static int32_t getDefaultSchedulerSamplePeriod() {
+        return defaultSchedulerSamplePeriod().load();
+    }
+
+    /**
+     * @param bursts calls to recordCpu() between samples, or 0 to disable
+     */
+    void setSchedulerSamplePeriod(int32_t bursts) {
+        mSchedulerSamplePeriod = std::max(0, bursts);
+        if (mSchedulerSamplePeriod > 0 && !mWaitBins) {
+            mWaitBins = std::make_unique<BinCounter>((int32_t) kWaitNumBins);
+        }
+    }
 
-    void recordCpu() {
+    /**
+     * Open the schedstat file and read the baseline counters.
+     * Call this on the audio thread before the measured callbacks,
+     * so that recordCpu() does not have to open a file or allocate.
+     */
+    void beginOnAudioThread() {
+        if (mSchedulerSamplePeriod <= 0) {
+            return;
+        }
+        mHaveSchedStat = (mSchedStat.open() == 0) && mSchedStat.read(&mPreviousSchedStat);
+        mHaveUsage = readThreadUsage(&mPreviousUsage);
+    }
+
+    /**
+     * @return the CPU that the caller is running on
+     */
+    int recordCpu() {
         int cpuIndex = HostThread::getCpu();
         // Bump histogram for the current CPU.
         if (cpuIndex >= 0 && cpuIndex < kMaxCpuCount) {
@@ -44,42 +99,177 @@ public:
         // Did we change CPUs?
         if (cpuIndex != mPreviousCpu && mPreviousCpu != kCpuIndexInvalid) {
             mMigrationCount++;
+            mWindowMigrationCount++;
         }
         mPreviousCpu = cpuIndex;
         mTotalCount++;
+        if (mSchedulerSamplePeriod > 0 && (mTotalCount % mSchedulerSamplePeriod) == 0) {
+            sampleScheduler();
+        }
+        return cpuIndex;
     }
 
-    std::string dump() {
-        std::stringstream result;
-        result << std::endl << "CPU Core Migration" << std::endl;
-        result << "migration.count = " << mMigrationCount << std::endl;
-        result << "migration.measurements = " << mTotalCount << std::endl;
+    /**
+     * @return number of migrations since the previous call
+     */
+    int32_t snapshotAndResetWindowMigrations() {
+        int32_t count = mWindowMigrationCount;
+        mWindowMigrationCount = 0;
+        return count;
+    }
+
+    ResultReport dump() {
+        ResultReport report;
+        report << std::endl;
+        report.addHeading("CPU Core Migration");
+        report.addMetric("migration.count", mMigrationCount);
+        report.addMetric("migration.measurements", mTotalCount);
 
         // Report bins with non-zero counts.
         int32_t numBins = mCpuBins.getNumBins();
         const int32_t *cpuCounts = mCpuBins.getBins();
         const int32_t *cpuLast = mCpuBins.getLastMarkers();
-        result << TEXT_CSV_BEGIN << std::endl;
-        result << " cpu#,    count,     last" << std::endl;
+        report.beginTable(" cpu#,    count,     last");
         for (int i = 0; i < numBins; i++) {
             if (cpuCounts[i] > 0) {
-                result << "  " << std::setw(3) << i
-                << ", " << std::setw(8) << cpuCounts[i]
-                << ", " << std::setw(8) << cpuLast[i]
-                << std::endl;
+                report.addCell(i, 5);
+                report.addCell(cpuCounts[i], 8);
+                report.addCell(cpuLast[i], 8);
+                report.endRow();
             }
         }
-        result << TEXT_CSV_END << std::endl;
-        return result.str();
+        report.endTable();
+        if (mSchedulerSamplePeriod > 0) {
+            dumpScheduler(report);
+        }
+        return report;
     }
 
 private:
     static constexpr int kCpuIndexInvalid = -1;
 
+    struct ThreadUsage {
+        int64_t voluntarySwitches = 0;
+        int64_t involuntarySwitches = 0;
+        int64_t minorFaults = 0;
+        int64_t majorFaults = 0;
+    };
+
+    static std::atomic<int32_t> &defaultSchedulerSamplePeriod() {
+        static std::atomic<int32_t> bursts{0};
+        return bursts;
+    }
+
+    static bool readThreadUsage(ThreadUsage *usage) {
+#if defined(__APPLE__)
+        (void) usage;
+        return false;
+#else
+        struct rusage rusage;
+        if (getrusage(RUSAGE_THREAD, &rusage) != 0) {
+            return false;
+        }
+        usage->voluntarySwitches = rusage.ru_nvcsw;
+        usage->involuntarySwitches = rusage.ru_nivcsw;
+        usage->minorFaults = rusage.ru_minflt;
+        usage->majorFaults = rusage.ru_majflt;
+        return true;
+#endif
+    }
+
+    /**
+     * Accumulate the change in the counters since the previous sample.
+     * The baseline is read by beginOnAudioThread().
+     */
+    void sampleScheduler() {
+        SchedStat stat;
+        if (mHaveSchedStat && mSchedStat.read(&stat)) {
+            int64_t waitNanos = stat.waitNanos - mPreviousSchedStat.waitNanos;
+            mRunNanos += stat.runNanos - mPreviousSchedStat.runNanos;
+            mWaitNanos += waitNanos;
+            mMaxWaitNanos = std::max(mMaxWaitNanos, waitNanos);
+            mWaitBins->increment((int32_t) std::min(waitNanos / kWaitNanosPerBin,
+                                                    (int64_t) (kWaitNumBins - 1)));
+            mSchedStatSampleCount++;
+            mPreviousSchedStat = stat;
+        }
+
+        ThreadUsage usage;
+        if (mHaveUsage && readThreadUsage(&usage)) {
+            int64_t faults = (usage.minorFaults - mPreviousUsage.minorFaults)
+                    + (usage.majorFaults - mPreviousUsage.majorFaults);
+            int64_t preemptions = usage.involuntarySwitches
+                    - mPreviousUsage.involuntarySwitches;
+            mUsage.voluntarySwitches += usage.voluntarySwitches
+                    - mPreviousUsage.voluntarySwitches;
+            mUsage.involuntarySwitches += preemptions;
+            mUsage.minorFaults += usage.minorFaults - mPreviousUsage.minorFaults;
+            mUsage.majorFaults += usage.majorFaults - mPreviousUsage.majorFaults;
+            mSamplesWithFaults += (faults > 0) ? 1 : 0;
+            mSamplesWithPreemption += (preemptions > 0) ? 1 : 0;
+            mUsageSampleCount++;
+            mPreviousUsage = usage;
+        }
+    }
+
+    double getWaitMicrosAtFraction(double fraction) const {
+        int32_t binIndex = mWaitBins ? mWaitBins->findPercentileBin(fraction) : -1;
+        return (binIndex < 0) ? 0.0
+                : (double) (binIndex + 1) * kWaitNanosPerBin / SYNTHMARK_NANOS_PER_MICROSECOND;
+    }
+
+    void dumpScheduler(ResultReport &report) {
+        report << std::endl;
+        report.addHeading("Scheduler Statistics");
+        report.addMetric("sched.sample.bursts", mSchedulerSamplePeriod);
+        if (mSchedStatSampleCount == 0) {
+            report << "# schedstat of the audio thread could not be read" << std::endl;
+        } else {
+            double runMicros = (double) mRunNanos / SYNTHMARK_NANOS_PER_MICROSECOND;
+            double waitMicros = (double) mWaitNanos / SYNTHMARK_NANOS_PER_MICROSECOND;
+            report.addMetric("sched.samples", mSchedStatSampleCount);
+            report.addMetric("sched.run.micros", runMicros);
+            report.addMetric("sched.wait.micros", waitMicros);
+            report.addMetric("sched.wait.p50.micros", getWaitMicrosAtFraction(0.50));
+            report.addMetric("sched.wait.p99.micros", getWaitMicrosAtFraction(0.99));
+            report.addMetric("sched.wait.p999.micros", getWaitMicrosAtFraction(0.999));
+            report.addMetric("sched.wait.max.micros",
+                             (double) mMaxWaitNanos / SYNTHMARK_NANOS_PER_MICROSECOND);
+        }
+        if (mUsageSampleCount == 0) {
+            report << "# rusage of the audio thread could not be read" << std::endl;
+        } else {
+            report.addMetric("sched.voluntary.switches", mUsage.voluntarySwitches);
+            report.addMetric("sched.involuntary.switches", mUsage.involuntarySwitches);
+            report.addMetric("sched.minor.faults", mUsage.minorFaults);
+            report.addMetric("sched.major.faults", mUsage.majorFaults);
+            report.addMetric("sched.samples.with.faults", mSamplesWithFaults);
+            report.addMetric("sched.samples.with.preemption", mSamplesWithPreemption);
+        }
+    }
+
     int         mPreviousCpu = kCpuIndexInvalid;
     int32_t     mMigrationCount = 0;
+    int32_t     mWindowMigrationCount = 0;
     int32_t     mTotalCount = 0;
     BinCounter  mCpuBins{kMaxCpuCount};
+
+    // Scheduler sampling, only used when mSchedulerSamplePeriod > 0.
+    int32_t         mSchedulerSamplePeriod = 0;
+    SchedStatReader mSchedStat;
+    SchedStat       mPreviousSchedStat;
+    bool            mHaveSchedStat = false;
+    int64_t         mRunNanos = 0;
+    int64_t         mWaitNanos = 0;
+    int64_t         mMaxWaitNanos = 0;
+    int32_t         mSchedStatSampleCount = 0;
+    std::unique_ptr<BinCounter> mWaitBins; // allocated when the period is set
+    ThreadUsage     mPreviousUsage;
+    ThreadUsage     mUsage;
+    bool            mHaveUsage = false;
+    int32_t         mUsageSampleCount = 0;
+    int32_t         mSamplesWithFaults = 0;
+    int32_t         mSamplesWithPreemption = 0;
 };
 
 #endif // SYNTHMARK_CPU_ANALYZER_H
@@ -0,0 +1,509 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SYNTHMARK_CPU_TELEMETRY_SAMPLER_H
+#define SYNTHMARK_CPU_TELEMETRY_SAMPLER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "HostTools.h"
+#include "SynthMark.h"
+
+// Number of samples kept for the CSV trace. Older samples are overwritten.
+constexpr int32_t kTelemetryCapacity = 4096;
+constexpr int32_t kTelemetryMaxThermalZones = 32;
+constexpr int32_t kTelemetryMaxPeriodMillis = 1000;
+
+/**
+ * Sample the real CPU clock, thermal zones and CPU idle time in a background thread.
+ *
+ * The sysfs files are opened once and re-read with pread() so each sample
+ * costs a few system calls per CPU. The sample period is rounded up to a whole
+ * number of bursts and samples are taken on absolute deadlines from the start.
+ *
+ * The CPU that last ran the audio callback is passed in with setAudioCpu()
+ * so the clock of the audio CPU can be reported separately.
+ * The number of bursts the callback has rendered is passed in with setAudioBurst()
+ * so each sample records the burst it was taken in, wherever the sink started.
+ *
+ * A CPU is considered throttled while its scaling_max_freq is below the value
+ * it had when sampling started, which is how the thermal cooling devices
+ * limit cpufreq.
+ */
+class CpuTelemetrySampler
+{
+public:
+    CpuTelemetrySampler() = default;
+
+    ~CpuTelemetrySampler() {
+        stop();
+        closeFiles();
+    }
+
+    /**
+     * Called by the audio callback. This is just a relaxed atomic store.
+     */
+    static void setAudioCpu(int cpu) {
+        audioCpu().store(cpu, std::memory_order_relaxed);
+    }
+
+    /**
+     * Called by the audio callback after each burst. This is just a relaxed atomic store.
+     */
+    static void setAudioBurst(int64_t burstCount) {
+        audioBurst().store(burstCount, std::memory_order_relaxed);
+    }
+
+    /**
+     * Open the files and start the sampling thread.
+     *
+     * @param periodMillis requested time between samples
+     * @param nanosPerBurst the period is rounded up to a multiple of this
+     * @return 0 or a negative error
+     */
+    int32_t start(int32_t periodMillis, int64_t nanosPerBurst) {
+        if (periodMillis < 1 || nanosPerBurst <= 0) {
+            return -1;
+        }
+        int64_t requestedNanos = periodMillis * (SYNTHMARK_NANOS_PER_SECOND / 1000);
+        mBurstsPerSample = std::max((int64_t) 1,
+                (requestedNanos + nanosPerBurst - 1) / nanosPerBurst);
+        mPeriodNanos = mBurstsPerSample * nanosPerBurst;
+
+        openFiles();
+        resetStatistics();
+        setAudioCpu(-1);
+        setAudioBurst(-1);
+        mStartTimeNanos = HostTools::getNanoTime();
+        mEnabled.store(true);
+        mThread = std::thread(&CpuTelemetrySampler::run, this);
+        return 0;
+    }
+
+    void stop() {
+        if (mThread.joinable()) {
+            mEnabled.store(false);
+            mThread.join();
+        }
+    }
+
+    int32_t getSampleCount() const {
+        return mSampleCount;
+    }
+
+    /**
+     * Summarize the samples. Call this after stop().
+     */
+    ResultReport dump() {
+        ResultReport report;
+        report << std::endl;
+        report.addHeading("CPU Telemetry");
+        report.addMetric("telemetry.period.msec",
+                         mPeriodNanos / (double) (SYNTHMARK_NANOS_PER_SECOND / 1000));
+        report.addMetric("telemetry.bursts.per.sample", mBurstsPerSample);
+        report.addMetric("telemetry.samples", mSampleCount);
+        report.addMetric("telemetry.missed.deadlines", mMissedDeadlines);
+        report.addMetric("telemetry.cpus.with.cpufreq", countCpusWithFrequency());
+        report.addMetric("telemetry.thermal.zones", mZones.size());
+        if (mSampleCount < 2) {
+            report << "# Not enough samples." << std::endl;
+            return report;
+        }
+
+        double totalSeconds = nanosToSeconds(mLastSampleNanos - mFirstSampleNanos);
+        report.addMetric("telemetry.seconds", totalSeconds);
+
+        if (mAudioResidency.total > 0) {
+            report.addMetric("telemetry.audio.freq.mean.khz",
+                             (int32_t) mAudioResidency.getMean());
+            report.addMetric("telemetry.audio.freq.min.khz", mAudioResidency.getMin());
+            report.addMetric("telemetry.audio.freq.max.khz", mAudioResidency.getMax());
+        }
+
+        int32_t totalThrottleEvents = 0;
+        for (const CpuState &cpu : mCpus) {
+            totalThrottleEvents += cpu.throttleEvents;
+        }
+        report.addMetric("telemetry.throttle.events", totalThrottleEvents);
+
+        for (const CpuState &cpu : mCpus) {
+            std::string prefix = "telemetry.cpu" + std::to_string(cpu.cpu);
+            if (cpu.residency.total > 0) {
+                report.addMetric(prefix + ".freq.mean.khz", (int32_t) cpu.residency.getMean());
+                report.addMetric(prefix + ".freq.min.khz", cpu.residency.getMin());
+                report.addMetric(prefix + ".freq.max.khz", cpu.residency.getMax());
+            }
+            if (cpu.totalJiffies > 0) {
+                report.addMetric(prefix + ".busy.percent",
+                                 100.0 * cpu.busyJiffies / cpu.totalJiffies);
+            }
+            if (cpu.throttleEvents > 0) {
+                report.addMetric(prefix + ".throttle.events", cpu.throttleEvents);
+                report.addMetric(prefix + ".throttle.seconds", nanosToSeconds(cpu.throttledNanos));
+            }
+        }
+
+        for (const ZoneState &zone : mZones) {
+            std::string prefix = "telemetry.thermal." + zone.type;
+            report.addMetric(prefix + ".max.celsius", zone.maxMilliCelsius / 1000.0);
+            report.addMetric(prefix + ".mean.celsius",
+                             zone.sumMilliCelsius / (1000.0 * mSampleCount));
+        }
+
+        // Frequency residency, the percentage of time spent at each clock.
+        report.beginTable(" cpu#, freq.khz, percent");
+        for (const CpuState &cpu : mCpus) {
+            dumpResidency(report, cpu.cpu, cpu.residency);
+        }
+        dumpResidency(report, "audio", mAudioResidency);
+        report.endTable();
+
+        // The most recent samples, one row per sample.
+        report.beginTable("burst, msec, audio.cpu, audio.khz, max.celsius, throttled.cpus");
+        int32_t numSamples = std::min(mSampleCount, kTelemetryCapacity);
+        for (int32_t i = mSampleCount - numSamples; i < mSampleCount; i++) {
+            const Sample &sample = mSamples[i % kTelemetryCapacity];
+            report.addCell(sample.burstIndex, 5);
+            report << std::fixed << std::setprecision(2);
+            report.addCell((sample.timeNanos - mStartTimeNanos)
+                           / (double) (SYNTHMARK_NANOS_PER_SECOND / 1000), 8);
+            report.addCell(sample.audioCpu, 4);
+            report.addCell(sample.audioFrequencyKHz, 8);
+            report << std::setprecision(1);
+            report.addCell(sample.maxMilliCelsius / 1000.0, 6);
+            report.addCell(sample.throttledCpus, 4);
+            report.endRow();
+            report << std::defaultfloat << std::setprecision(6);
+        }
+        report.endTable();
+        return report;
+    }
+
+private:
+    static constexpr int32_t kUnknown = -1;
+
+    /**
+     * Time spent at each frequency.
+     */
+    struct Residency {
+        std::map<int32_t, int64_t> nanosByFrequency;
+        int64_t total = 0;
+
+        void add(int32_t frequencyKHz, int64_t nanos) {
+            if (frequencyKHz > 0 && nanos > 0) {
+                nanosByFrequency[frequencyKHz] += nanos;
+                total += nanos;
+            }
+        }
+        double getMean() const {
+            double sum = 0.0;
+            for (const auto &entry : nanosByFrequency) {
+                sum += (double) entry.first * entry.second;
+            }
+            return sum / total;
+        }
+        int32_t getMin() const {
+            return nanosByFrequency.begin()->first;
+        }
+        int32_t getMax() const {
+            return nanosByFrequency.rbegin()->first;
+        }
+    };
+
+    struct CpuState {
+        int       cpu = 0;
+        int       curFreqFd = -1;
+        int       maxFreqFd = -1;
+        int32_t   frequencyKHz = kUnknown;
+        int32_t   initialMaxFrequencyKHz = kUnknown;
+        bool      throttled = false;
+        int32_t   throttleEvents = 0;
+        int64_t   throttledNanos = 0;
+        int64_t   previousBusyJiffies = -1;
+        int64_t   previousTotalJiffies = -1;
+        int64_t   busyJiffies = 0;
+        int64_t   totalJiffies = 0;
+        Residency residency;
+    };
+
+    struct ZoneState {
+        int         fd = -1;
+        std::string type;
+        int32_t     maxMilliCelsius = 0;
+        int64_t     sumMilliCelsius = 0;
+    };
+
+    struct Sample {
+        int64_t timeNanos;
+        int64_t burstIndex;
+        int32_t audioCpu;
+        int32_t audioFrequencyKHz;
+        int32_t maxMilliCelsius;
+        int32_t throttledCpus;
+    };
+
+    static std::atomic<int> &audioCpu() {
+        static std::atomic<int> cpu{-1};
+        return cpu;
+    }
+
+    // -1 until the audio callback renders its first burst
+    static std::atomic<int64_t> &audioBurst() {
+        static std::atomic<int64_t> burst{-1};
+        return burst;
+    }
+
+    static double nanosToSeconds(int64_t nanos) {
+        return nanos / (double) SYNTHMARK_NANOS_PER_SECOND;
+    }
+
+    static int openFile(const std::string &path) {
+        return open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+
+    static int32_t readInteger(int fd) {
+        char buffer[32];
+        if (fd < 0) return kUnknown;
+        ssize_t count = pread(fd, buffer, sizeof(buffer) - 1, 0);
+        if (count <= 0) return kUnknown;
+        buffer[count] = 0;
+        return (int32_t) strtol(buffer, nullptr, 10);
+    }
+
+    static std::string readString(const std::string &path) {
+        char buffer[64] = {};
+        int fd = openFile(path);
+        if (fd < 0) return "";
+        ssize_t count = read(fd, buffer, sizeof(buffer) - 1);
+        close(fd);
+        std::string text(buffer, std::max((ssize_t) 0, count));
+        text.erase(text.find_last_not_of(" \n") + 1);
+        return text;
+    }
+
+    void openFiles() {
+        closeFiles();
+        int numCpus = std::min(kMaxCpuCount, std::max(1, HostTools::getCpuCount()));
+        for (int i = 0; i < numCpus; i++) {
+            CpuState cpu;
+            cpu.cpu = i;
+            std::string cpufreq = "/sys/devices/system/cpu/cpu" + std::to_string(i) + "/cpufreq/";
+            cpu.curFreqFd = openFile(cpufreq + "scaling_cur_freq");
+            cpu.maxFreqFd = openFile(cpufreq + "scaling_max_freq");
+            mCpus.push_back(cpu);
+        }
+        for (int i = 0; i < kTelemetryMaxThermalZones; i++) {
+            std::string zonePath = "/sys/class/thermal/thermal_zone" + std::to_string(i) + "/";
+            ZoneState zone;
+            zone.fd = openFile(zonePath + "temp");
+            if (zone.fd < 0) break;
+            zone.type = readString(zonePath + "type");
+            if (zone.type.empty()) zone.type = "zone" + std::to_string(i);
+            mZones.push_back(zone);
+        }
+        mProcStatFd = openFile("/proc/stat");
+        mProcStatBuffer.resize(4096 + 256 * numCpus);
+    }
+
+    void closeFiles() {
+        for (CpuState &cpu : mCpus) {
+            if (cpu.curFreqFd >= 0) close(cpu.curFreqFd);
+            if (cpu.maxFreqFd >= 0) close(cpu.maxFreqFd);
+        }
+        mCpus.clear();
+        for (ZoneState &zone : mZones) {
+            close(zone.fd);
+        }
+        mZones.clear();
+        if (mProcStatFd >= 0) {
+            close(mProcStatFd);
+            mProcStatFd = -1;
+        }
+    }
+
+    void resetStatistics() {
+        mSamples.assign(kTelemetryCapacity, Sample{});
+        mSampleCount = 0;
+        mMissedDeadlines = 0;
+        mFirstSampleNanos = 0;
+        mLastSampleNanos = 0;
+        mAudioResidency = Residency();
+        mPreviousAudioFrequencyKHz = kUnknown;
+    }
+
+    int32_t countCpusWithFrequency() const {
+        int32_t count = 0;
+        for (const CpuState &cpu : mCpus) {
+            if (cpu.curFreqFd >= 0) count++;
+        }
+        return count;
+    }
+
+    /**
+     * @param name CPU number, or a label such as "audio"
+     */
+    template <typename T>
+    void dumpResidency(ResultReport &report, const T &name, const Residency &residency) {
+        for (const auto &entry : residency.nanosByFrequency) {
+            report.addCell(name, 5);
+            report.addCell(entry.first, 8);
+            report << std::fixed << std::setprecision(2);
+            report.addCell(100.0 * entry.second / residency.total, 7);
+            report << std::defaultfloat << std::setprecision(6);
+            report.endRow();
+        }
+    }
+
+    /**
+     * Accumulate busy and total jiffies for each CPU from /proc/stat.
+     */
+    void readProcStat() {
+        if (mProcStatFd < 0) return;
+        ssize_t count = pread(mProcStatFd, &mProcStatBuffer[0], mProcStatBuffer.size() - 1, 0);
+        if (count <= 0) return;
+        mProcStatBuffer[count] = 0;
+        const char *line = &mProcStatBuffer[0];
+        while (line != nullptr && strncmp(line, "cpu", 3) == 0) {
+            int cpuIndex = -1;
+            long long fields[8] = {};
+            int numParsed = sscanf(line, "cpu%d %lld %lld %lld %lld %lld %lld %lld %lld",
+                                   &cpuIndex, &fields[0], &fields[1], &fields[2], &fields[3],
+                                   &fields[4], &fields[5], &fields[6], &fields[7]);
+            if (numParsed >= 5 && cpuIndex >= 0 && cpuIndex < (int) mCpus.size()) {
+                int64_t total = 0;
+                for (long long field : fields) total += field;
+                int64_t idle = fields[3] + fields[4]; // idle + iowait
+                CpuState &cpu = mCpus[cpuIndex];
+                if (cpu.previousTotalJiffies >= 0) {
+                    cpu.totalJiffies += total - cpu.previousTotalJiffies;
+                    cpu.busyJiffies += (total - idle) - cpu.previousBusyJiffies;
+                }
+                cpu.previousTotalJiffies = total;
+                cpu.previousBusyJiffies = total - idle;
+            }
+            line = strchr(line, '\n');
+            if (line != nullptr) line++;
+        }
+    }
+
+    void sampleOnce() {
+        int64_t now = HostTools::getNanoTime();
+        int64_t elapsed = (mSampleCount > 0) ? (now - mLastSampleNanos) : 0;
+        int audio = audioCpu().load(std::memory_order_relaxed);
+
+        Sample &sample = mSamples[mSampleCount % kTelemetryCapacity];
+        sample.timeNanos = now;
+        sample.burstIndex = audioBurst().load(std::memory_order_relaxed);
+        sample.audioCpu = audio;
+        sample.audioFrequencyKHz = kUnknown;
+        sample.maxMilliCelsius = 0;
+        sample.throttledCpus = 0;
+
+        // Credit the time since the last sample to the clock read last time.
+        if (mPreviousAudioFrequencyKHz > 0) {
+            mAudioResidency.add(mPreviousAudioFrequencyKHz, elapsed);
+        }
+        for (CpuState &cpu : mCpus) {
+            cpu.residency.add(cpu.frequencyKHz, elapsed);
+            if (cpu.throttled) cpu.throttledNanos += elapsed;
+
+            cpu.frequencyKHz = readInteger(cpu.curFreqFd);
+            int32_t maxFrequencyKHz = readInteger(cpu.maxFreqFd);
+            if (mSampleCount == 0) {
+                cpu.initialMaxFrequencyKHz = maxFrequencyKHz;
+            }
+            bool throttled = maxFrequencyKHz > 0
+                    && maxFrequencyKHz < cpu.initialMaxFrequencyKHz;
+            if (throttled && !cpu.throttled) {
+                cpu.throttleEvents++;
+            }
+            cpu.throttled = throttled;
+            if (throttled) sample.throttledCpus++;
+        }
+        if (audio >= 0 && audio < (int) mCpus.size()) {
+            sample.audioFrequencyKHz = mCpus[audio].frequencyKHz;
+        }
+        mPreviousAudioFrequencyKHz = sample.audioFrequencyKHz;
+
+        for (ZoneState &zone : mZones) {
+            int32_t milliCelsius = readInteger(zone.fd);
+            zone.maxMilliCelsius = (mSampleCount == 0)
+                    ? milliCelsius : std::max(zone.maxMilliCelsius, milliCelsius);
+            zone.sumMilliCelsius += milliCelsius;
+            sample.maxMilliCelsius = std::max(sample.maxMilliCelsius, milliCelsius);
+        }
+
+        readProcStat();
+
+        if (mSampleCount == 0) mFirstSampleNanos = now;
+        mLastSampleNanos = now;
+        mSampleCount++;
+    }
+
+    void run() {
+        int64_t sampleIndex = 0;
+        while (mEnabled.load()) {
+            sampleOnce();
+            sampleIndex++;
+            int64_t nextTime = mStartTimeNanos + (sampleIndex * mPeriodNanos);
+            // Skip the deadlines that have already passed but stay on the grid.
+            int64_t now = HostTools::getNanoTime();
+            if (nextTime < now) {
+                int64_t missed = 1 + ((now - nextTime) / mPeriodNanos);
+                mMissedDeadlines += missed;
+                sampleIndex += missed;
+                nextTime += missed * mPeriodNanos;
+            }
+            HostTools::sleepUntilNanoTime(nextTime);
+        }
+    }
+
+    std::thread           mThread;
+    std::atomic<bool>     mEnabled{false};
+
+    std::vector<CpuState>  mCpus;
+    std::vector<ZoneState> mZones;
+    int                    mProcStatFd = -1;
+    std::vector<char>      mProcStatBuffer;
+
+    std::vector<Sample>    mSamples;
+    int32_t                mSampleCount = 0;
+    int64_t                mMissedDeadlines = 0;
+    Residency              mAudioResidency;
+    int32_t                mPreviousAudioFrequencyKHz = kUnknown;
+
+    int64_t                mBurstsPerSample = 1;
+    int64_t                mPeriodNanos = 0;
+    int64_t                mStartTimeNanos = 0;
+    int64_t                mFirstSampleNanos = 0;
+    int64_t                mLastSampleNanos = 0;
+};
+
+#endif // SYNTHMARK_CPU_TELEMETRY_SAMPLER_H
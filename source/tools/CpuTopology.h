@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SYNTHMARK_CPU_TOPOLOGY_H
+#define SYNTHMARK_CPU_TOPOLOGY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "HostTools.h"
+
+/**
+ * Discover the CPU frequency domains from sysfs.
+ *
+ * CPUs are grouped by "cpufreq/related_cpus", which lists the CPUs that share
+ * a clock. If cpufreq is not available then "topology/cluster_id" is used.
+ * If neither is available then all the online CPUs are put in one domain.
+ *
+ * Frequency domains with the same "cpu_capacity" and "cpuinfo_max_freq" are
+ * merged because they are the same type of core. This keeps hosts that have
+ * one cpufreq policy per core from being characterized one core at a time.
+ * Domains where both are unknown are merged too because nothing tells them apart.
+ */
+class CpuTopology
+{
+public:
+    static constexpr int32_t kUnknown = -1;
+
+    enum Source : int32_t {
+        SOURCE_NONE,
+        SOURCE_CLUSTER,
+        SOURCE_CPUFREQ,
+    };
+
+    struct Domain {
+        std::vector<int> cpus;
+        int     representativeCpu = kUnknown;
+        int32_t capacity = kUnknown;        // from cpu_capacity, biggest core is usually 1024
+        int32_t maxFrequencyKHz = kUnknown; // from cpufreq/cpuinfo_max_freq
+        int32_t numMerged = 1;              // number of frequency domains of this type
+
+        std::string getCpuList() const {
+            return HostTools::formatCpuList(cpus);
+        }
+    };
+
+    /**
+     * Read sysfs and build the list of domains, sorted by their first CPU.
+     * @return number of domains found
+     */
+    int32_t discover() {
+        mDomains.clear();
+        std::vector<int> onlineCpus;
+        if (!HostTools::parseCpuList(readString(std::string(kCpuRoot) + "online"), &onlineCpus)) {
+            int numCpus = std::max(1, HostTools::getCpuCount());
+            for (int cpu = 0; cpu < numCpus; cpu++) {
+                onlineCpus.push_back(cpu);
+            }
+        }
+
+        // Pick the most specific source that describes every online CPU.
+        mSource = SOURCE_CPUFREQ;
+        for (int cpu : onlineCpus) {
+            if (readString(cpuPath(cpu, "cpufreq/related_cpus")).empty()) {
+                mSource = SOURCE_CLUSTER;
+                break;
+            }
+        }
+        if (mSource == SOURCE_CLUSTER) {
+            for (int cpu : onlineCpus) {
+                if (readInteger(cpuPath(cpu, "topology/cluster_id")) < 0) {
+                    mSource = SOURCE_NONE;
+                    break;
+                }
+            }
+        }
+
+        // Group the CPUs.
+        std::map<std::string, Domain> groups;
+        for (int cpu : onlineCpus) {
+            std::string key;
+            switch (mSource) {
+                case SOURCE_CPUFREQ:
+                    key = readString(cpuPath(cpu, "cpufreq/related_cpus"));
+                    break;
+                case SOURCE_CLUSTER:
+                    key = std::to_string(readInteger(cpuPath(cpu, "topology/physical_package_id")))
+                          + "." + std::to_string(readInteger(cpuPath(cpu, "topology/cluster_id")));
+                    break;
+                default:
+                    break;
+            }
+            Domain &domain = groups[key];
+            domain.cpus.push_back(cpu);
+            domain.capacity = std::max(domain.capacity,
+                    readInteger(cpuPath(cpu, "cpu_capacity")));
+            domain.maxFrequencyKHz = std::max(domain.maxFrequencyKHz,
+                    readInteger(cpuPath(cpu, "cpufreq/cpuinfo_max_freq")));
+        }
+
+        // Merge domains with the same type of core.
+        for (auto &group : groups) {
+            Domain &domain = group.second;
+            bool merged = false;
+            for (Domain &existing : mDomains) {
+                if (existing.capacity == domain.capacity
+                        && existing.maxFrequencyKHz == domain.maxFrequencyKHz) {
+                    existing.cpus.insert(existing.cpus.end(),
+                                         domain.cpus.begin(), domain.cpus.end());
+                    existing.numMerged++;
+                    merged = true;
+                    break;
+                }
+            }
+            if (!merged) {
+                mDomains.push_back(domain);
+            }
+        }
+
+        for (Domain &domain : mDomains) {
+            std::sort(domain.cpus.begin(), domain.cpus.end());
+            // Avoid the lowest CPU, which often handles most of the interrupts.
+            domain.representativeCpu = domain.cpus.back();
+        }
+        std::sort(mDomains.begin(), mDomains.end(),
+                  [](const Domain &a, const Domain &b) {
+                      return a.cpus.front() < b.cpus.front();
+                  });
+        return (int32_t) mDomains.size();
+    }
+
+    const std::vector<Domain> &getDomains() const {
+        return mDomains;
+    }
+
+    Source getSource() const {
+        return mSource;
+    }
+
+    static const char *getSourceName(Source source) {
+        switch (source) {
+            case SOURCE_CPUFREQ: return "cpufreq";
+            case SOURCE_CLUSTER: return "cluster";
+            default: return "none";
+        }
+    }
+
+    /**
+     * Domains are independent when each one has its own clock.
+     * Then a load on one domain will not change the speed of another.
+     */
+    bool areDomainsIndependent() const {
+        return mSource == SOURCE_CPUFREQ;
+    }
+
+    struct Cache {
+        int32_t     level = kUnknown;
+        int64_t     sizeBytes = kUnknown;
+        std::string name; // eg. "L1d" or "L2"
+    };
+
+    /**
+     * Read the data and unified caches of a CPU from "cache/index*".
+     * @return caches sorted from the smallest level
+     */
+    static std::vector<Cache> getDataCaches(int cpu = 0) {
+        std::vector<Cache> caches;
+        for (int index = 0; index < kMaxCacheIndex; index++) {
+            std::string cachePath = "cache/index" + std::to_string(index) + "/";
+            std::string type = readString(cpuPath(cpu, (cachePath + "type").c_str()));
+            std::string sizeText = readString(cpuPath(cpu, (cachePath + "size").c_str()));
+            Cache cache;
+            cache.level = readInteger(cpuPath(cpu, (cachePath + "level").c_str()));
+            long long size = 0;
+            char suffix = 0;
+            if (cache.level < 0 || type == "Instruction"
+                    || sscanf(sizeText.c_str(), "%lld%c", &size, &suffix) < 1) {
+                continue;
+            }
+            if (suffix == 'K') {
+                size *= 1024;
+            } else if (suffix == 'M') {
+                size *= 1024 * 1024;
+            }
+            cache.sizeBytes = size;
+            cache.name = "L" + std::to_string(cache.level) + ((type == "Data") ? "d" : "");
+            caches.push_back(cache);
+        }
+        std::sort(caches.begin(), caches.end(), [](const Cache &a, const Cache &b) {
+            return a.level < b.level;
+        });
+        return caches;
+    }
+
+    /**
+     * @return size of the highest level cache of a CPU in bytes or kUnknown
+     */
+    static int64_t getLastLevelCacheBytes(int cpu = 0) {
+        std::vector<Cache> caches = getDataCaches(cpu);
+        return caches.empty() ? kUnknown : caches.back().sizeBytes;
+    }
+
+private:
+    static std::string cpuPath(int cpu, const char *leaf) {
+        return std::string(kCpuRoot) + "cpu" + std::to_string(cpu) + "/" + leaf;
+    }
+
+    static std::string readString(const std::string &path) {
+        char buffer[256];
+        std::string text;
+        FILE *file = fopen(path.c_str(), "r");
+        if (file == nullptr) {
+            return text;
+        }
+        if (fgets(buffer, sizeof(buffer), file) != nullptr) {
+            text = buffer;
+            text.erase(text.find_last_not_of(" \n") + 1);
+        }
+        fclose(file);
+        return text;
+    }
+
+    static int32_t readInteger(const std::string &path) {
+        std::string text = readString(path);
+        int value = kUnknown;
+        if (text.empty() || sscanf(text.c_str(), "%d", &value) != 1) {
+            return kUnknown;
+        }
+        return value;
+    }
+
+    static constexpr const char *kCpuRoot = "/sys/devices/system/cpu/";
+    static constexpr int kMaxCacheIndex = 8;
+
+    std::vector<Domain> mDomains;
+    Source              mSource = SOURCE_NONE;
+};
+
+#endif // SYNTHMARK_CPU_TOPOLOGY_H
@@ -20,22 +20,27 @@
 #include <cstdint>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <sstream>
 
 #include "HostTools.h"
+#include "DeadlineBandwidthController.h"
 #include "scheddl.h"
 
 
-constexpr double ALPHA_BIG	= 0.95;
-constexpr double ALPHA_SMALL	= 0.1;
 constexpr uint32_t STATS_PERIOD	= 30;
 constexpr double BW_MAX		= 0.9;
 constexpr double BW_BOOST	= BW_MAX;
-constexpr double BW_OFFSET_REL	= 1.1;
-constexpr double BW_OFFSET_ABS	= 0.05;
 
 class CustomHostCpuManager : public HostCpuManagerBase
 {
 public:
+    /**
+     * @param controllerType a DeadlineBandwidthController::Type
+     */
+    explicit CustomHostCpuManager(int32_t controllerType = DeadlineBandwidthController::TYPE_EWMA)
+    : mController(DeadlineBandwidthController::create(controllerType)) {}
+
     /**
      * Update runtime statistics and sleeps for wakeupTime_ns.
      *
@@ -122,28 +127,27 @@ public:
             if (mBWUpdateCounter != 0)
                 mBWUpdateCounter = 0;
 
-            expectedRuntime_ns = mCpuTiming.getWorkUnitRuntime(currentWorkUnits);
+            /* The controller includes its own margins. */
+            expectedRuntime_ns = mController->getReservedRuntime(currentWorkUnits,
+                                                                 mPeriod_ns);
 
             /*
              * When we read a 0 runtime for != 0 workUnits, it means that
              * something bad is going on, so, set the maximum runtime.
-             * This may happen when the linear regression fails.
+             * This may happen when the linear regression fails or when
+             * the controller has not measured enough bursts yet.
              */
             if (expectedRuntime_ns == 0 && currentWorkUnits != 0) {
                 bandwidth = BW_MAX;
+            } else if (expectedRuntime_ns == 0) {
+                /*
+                 * SCHED_DEADLINE does not accept a runtime of 0, so an idle
+                 * load gets the absolute margin.
+                 */
+                bandwidth = BW_OFFSET_ABS;
             } else {
                 bandwidth = static_cast<double>(expectedRuntime_ns) / mPeriod_ns;
 
-                /*
-                 * Add some margins to the computed bandwidth, since the
-                 * application execution times are noisy.
-                 * A first margin is a multiplication factor, meaning that the margin
-                 * proportionally increases with the duration.
-                 */ 
-                bandwidth *= BW_OFFSET_REL;
-                /* A second margin is an absolute offset. */
-                bandwidth += BW_OFFSET_ABS;
-
                 /* Bound the bandwidth to the limit set by the Kernel */
                 if (bandwidth > BW_MAX)
                     bandwidth = BW_MAX;
@@ -167,6 +171,8 @@ public:
             }
 
             expectedRuntime_ns = mPeriod_ns * bandwidth;
+            if (static_cast<uint64_t>(expectedRuntime_ns) != mRuntime_ns)
+                mBandwidthUpdates++;
             updateDeadlineParams(expectedRuntime_ns,
                                  mDeadline_ns,
                                  mPeriod_ns);
@@ -231,6 +237,32 @@ public:
         return ret;
     }
 
+    /**
+     * Compare the bandwidth that was reserved with the bandwidth that was used.
+     */
+    ResultReport dump() override {
+        ResultReport report;
+        report << std::endl;
+        report.addHeading("SCHED_DEADLINE Bandwidth");
+        report.addMetric("dl.controller", mController->getName());
+        report.addMetric("dl.bursts", mMeasuredBursts);
+        report.addMetric("dl.bandwidth.updates", mBandwidthUpdates);
+        report.addMetric("dl.boosts", mBoostCount);
+        if (mMeasuredBursts > 0 && mPeriod_ns > 0) {
+            double periods = static_cast<double>(mMeasuredBursts) * mPeriod_ns;
+            double reserved = mReservedSum_ns / periods;
+            double used = mUsedSum_ns / periods;
+            report.addMetric("dl.reserved.bandwidth", reserved);
+            report.addMetric("dl.used.bandwidth", used);
+            report.addMetric("dl.reservation.used.percent",
+                             (reserved > 0.0) ? (100.0 * used / reserved) : 0.0);
+            report.addMetric("dl.over.reserved.bandwidth", reserved - used);
+            report.addMetric("dl.runtime.overruns", mRuntimeOverruns);
+        }
+        mController->dump(report);
+        return report;
+    }
+
 private:
     /*
      * Forces the maximum bandwidth to the task.
@@ -238,6 +270,7 @@ private:
     void boostBandwidth() {
         if (!mBoosted) {
             mBoosted = true;
+            mBoostCount++;
             updateDeadlineParams(mRuntime_ns, mDeadline_ns, mPeriod_ns, true);
         }
     }
@@ -328,145 +361,20 @@ private:
             duration = durationTimer;
         }
 
-        mCpuTiming.reportApplicationRuntime(duration, getCurrentWorkUnits());
+        mController->reportRuntime(duration, getCurrentWorkUnits());
+
+        /* Account for the bandwidth that was reserved for this burst. */
+        int64_t reserved_ns = mBoosted
+                ? static_cast<int64_t>(mPeriod_ns * BW_BOOST)
+                : static_cast<int64_t>(mRuntime_ns);
+        mReservedSum_ns += reserved_ns;
+        mUsedSum_ns += duration;
+        if (duration > reserved_ns)
+            mRuntimeOverruns++;
+        mMeasuredBursts++;
     }
 
-    /**
-     * Manage the runtime, by updating and returning statistics.
-     */
-    class CpuTiming {
-    public:
-
-        /**
-         * Updates the runtime statistics for a given number of workUnits.
-         *
-         * @param callbackComputingTime callback runtime in nanoseconds
-         * @param currentWorkUnits the current number of workUnits
-         */
-        void reportApplicationRuntime(int64_t callbackComputingTime,
-                                      int32_t currentWorkUnits) {
-            if (callbackComputingTime == 0)
-                return;
-
-            if (smallestSampledWorkUnits > currentWorkUnits ||
-                    smallestSampledWorkUnits == -1)
-                smallestSampledWorkUnits = currentWorkUnits;
-
-            if (mUtils.find(currentWorkUnits) == mUtils.end()) {
-                /*
-                 * If this is the first time we encounter that workUnits, the
-                 * result is directly stored.
-                 */
-                mUtils[currentWorkUnits] = callbackComputingTime;
-            } else {
-                /*
-                 * If there are already statistics for that given number of
-                 * workUnits, apply simple exponential smoothing filter.
-                 * In order to give more weight to the increasing values, two
-                 * different time constants are applied when the value is
-                 * increasing or decreasing.
-                 */
-                int64_t stored = mUtils[currentWorkUnits];
-                if (stored < callbackComputingTime)
-                    mUtils[currentWorkUnits] =
-                            ALPHA_BIG * callbackComputingTime +
-                            (1.0 - ALPHA_BIG) * stored;
-                else
-                    mUtils[currentWorkUnits] =
-                            ALPHA_SMALL * callbackComputingTime +
-                            (1.0 - ALPHA_SMALL) * stored;
-            }
-        }
-
-        /**
-         * Return the a runtime estimation, given the number of workUnits.
-         *
-         * @param workUnits
-         */
-        int64_t getWorkUnitRuntime(int32_t workUnits) {
-            int64_t runtime;
-
-            if (mUtils.find(workUnits) != mUtils.end()) {
-                /* The number of workUnits has been found in the hash table! */
-                runtime = mUtils[workUnits];
-            } else if (workUnits < smallestSampledWorkUnits) {
-                /*
-                 * If we are requesting a number of workUnits that is smaller
-                 * than any other workUnits in our database, then we assign it
-                 * the bandwidth of the runtime associated with the smallest
-                 * workUnits entry of our database. This can be much bigger
-                 * than what the callback requires, but is safe and is fast.
-                 */
-                runtime = mUtils[smallestSampledWorkUnits];
-            } else {
-                /*
-                 * When is required a number of workUnits that is bigger than
-                 * what we ever measured, a linea regression problem is solved.
-                 */
-                std::pair<double, double> linear_params = getLinearParams();
-
-                runtime = linear_params.first
-                        + linear_params.second * workUnits;
-            }
-            return runtime;
-        }
-
-    private:
-
-        /*
-         * Returns the (a, b) parameters of the equation "y = a + b*x",
-         * obtained by performing a min-square linear regression on the
-         * statistics.
-         */
-        std::pair<double, double> getLinearParams() const {
-            uint32_t samples = mUtils.size();
-
-            if (samples == 0)
-                return std::make_pair(0, 0);
-            if (samples == 1)
-                return std::make_pair(0, (*mUtils.begin()).second / (*mUtils.begin()).first);
-
-            // linear regression using least squares
-            double avg_x = 0, avg_y = 0;
-
-            { // Compute the average values
-                for (auto it=mUtils.begin(); it!=mUtils.end(); ++it) {
-                    avg_x += (*it).first;
-                    avg_y += (*it).second;
-                }
-                avg_x /= samples;
-                avg_y /= samples;
-            }
-
-            double beta;
-            { // Compute beta
-                double numerator = 0, denumerator = 0;
-                double x_value;
-
-                for (auto it=mUtils.begin(); it!=mUtils.end(); ++it) {
-                    x_value = (*it).first - avg_x;
-                    numerator += x_value * ((*it).second - avg_y);
-                    denumerator += x_value * x_value;
-                }
-
-                beta = numerator / denumerator;
-            }
-
-            double alpha = avg_y - beta * avg_x;
-
-            if (alpha < 0)
-                alpha = 0;
-            if (beta < 0)
-                beta = 0;
-
-            return std::make_pair(alpha, beta);
-        }
-
-        int32_t smallestSampledWorkUnits = -1;
-        std::map<int32_t, int64_t> mUtils;
-    };
-
-    CpuTiming mCpuTiming;
+    std::unique_ptr<DeadlineBandwidthController> mController;
 
     struct sched_attr mDLStart;
     struct sched_attr mDLEnd;
@@ -481,6 +389,14 @@ private:
     uint64_t  mPeriod_ns       = 0;
 
     uint32_t  mBWUpdateCounter = 0;
+
+    /* Reserved versus used bandwidth */
+    int64_t   mMeasuredBursts  = 0;
+    double    mReservedSum_ns  = 0.0;
+    double    mUsedSum_ns      = 0.0;
+    int32_t   mRuntimeOverruns = 0;
+    int32_t   mBandwidthUpdates = 0;
+    int32_t   mBoostCount      = 0;
 };
 
 #endif /* CUSTOM_HOST_CPU_MANAGER_H */
@@ -0,0 +1,418 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SYNTHMARK_DEADLINE_BANDWIDTH_CONTROLLER_H
+#define SYNTHMARK_DEADLINE_BANDWIDTH_CONTROLLER_H
+
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "ResultReport.h"
+
+constexpr double ALPHA_BIG	= 0.95;
+constexpr double ALPHA_SMALL	= 0.1;
+constexpr double BW_OFFSET_REL	= 1.1;
+constexpr double BW_OFFSET_ABS	= 0.05;
+
+/**
+ * Decide how much SCHED_DEADLINE runtime to reserve for a number of work units.
+ *
+ * CustomHostCpuManager reports the measured runtime of every callback and
+ * asks for a new runtime when the application announces a new load
+ * or every STATS_PERIOD bursts.
+ */
+class DeadlineBandwidthController {
+public:
+    enum Type : int32_t {
+        TYPE_EWMA = 0,
+        TYPE_PERCENTILE = 1,
+        TYPE_PREDICTIVE = 2,
+        TYPE_COUNT
+    };
+
+    virtual ~DeadlineBandwidthController() = default;
+
+    virtual const char *getName() const = 0;
+
+    /**
+     * @param runtime_ns measured runtime of one callback
+     * @param workUnits work units that were being rendered
+     */
+    virtual void reportRuntime(int64_t runtime_ns, int32_t workUnits) = 0;
+
+    /**
+     * @return runtime to reserve per period, including margins,
+     *         or zero if it cannot be estimated yet
+     */
+    virtual int64_t getReservedRuntime(int32_t workUnits, int64_t period_ns) = 0;
+
+    /**
+     * Add extra metrics to the report.
+     */
+    virtual void dump(ResultReport &report) {
+        (void) report;
+    }
+
+    static const char *getTypeName(int32_t type) {
+        switch (type) {
+            case TYPE_EWMA: return "ewma";
+            case TYPE_PERCENTILE: return "p99.window";
+            case TYPE_PREDICTIVE: return "p99.predictive";
+            default: return "unknown";
+        }
+    }
+
+    static std::unique_ptr<DeadlineBandwidthController> create(int32_t type);
+};
+
+/**
+ * The original controller.
+ * Smooth the runtime for each number of work units with an exponential filter
+ * that rises faster than it falls. Unseen loads are estimated by a linear fit.
+ */
+class EwmaBandwidthController : public DeadlineBandwidthController {
+public:
+    const char *getName() const override {
+        return getTypeName(TYPE_EWMA);
+    }
+
+    /**
+     * Updates the runtime statistics for a given number of workUnits.
+     *
+     * @param callbackComputingTime callback runtime in nanoseconds
+     * @param currentWorkUnits the current number of workUnits
+     */
+    void reportRuntime(int64_t callbackComputingTime,
+                       int32_t currentWorkUnits) override {
+        if (callbackComputingTime == 0)
+            return;
+
+        if (smallestSampledWorkUnits > currentWorkUnits ||
+                smallestSampledWorkUnits == -1)
+            smallestSampledWorkUnits = currentWorkUnits;
+
+        if (mUtils.find(currentWorkUnits) == mUtils.end()) {
+            /*
+             * If this is the first time we encounter that workUnits, the
+             * result is directly stored.
+             */
+            mUtils[currentWorkUnits] = callbackComputingTime;
+        } else {
+            /*
+             * If there are already statistics for that given number of
+             * workUnits, apply simple exponential smoothing filter.
+             * In order to give more weight to the increasing values, two
+             * different time constants are applied when the value is
+             * increasing or decreasing.
+             */
+            int64_t stored = mUtils[currentWorkUnits];
+            if (stored < callbackComputingTime)
+                mUtils[currentWorkUnits] =
+                        ALPHA_BIG * callbackComputingTime +
+                        (1.0 - ALPHA_BIG) * stored;
+            else
+                mUtils[currentWorkUnits] =
+                        ALPHA_SMALL * callbackComputingTime +
+                        (1.0 - ALPHA_SMALL) * stored;
+        }
+    }
+
+    int64_t getReservedRuntime(int32_t workUnits, int64_t period_ns) override {
+        int64_t runtime_ns = getWorkUnitRuntime(workUnits);
+        // No estimate for a load, the manager reserves BW_MAX.
+        // A load of 0 work units still gets the absolute margin below.
+        if (runtime_ns == 0 && workUnits != 0) {
+            return 0;
+        }
+        /*
+         * Add some margins to the computed bandwidth, since the
+         * application execution times are noisy.
+         * A first margin is a multiplication factor, meaning that the margin
+         * proportionally increases with the duration.
+         * A second margin is an absolute offset.
+         */
+        double bandwidth = static_cast<double>(runtime_ns) / period_ns;
+        bandwidth = (bandwidth * BW_OFFSET_REL) + BW_OFFSET_ABS;
+        return static_cast<int64_t>(bandwidth * period_ns);
+    }
+
+private:
+    /**
+     * Return the a runtime estimation, given the number of workUnits.
+     *
+     * @param workUnits
+     */
+    int64_t getWorkUnitRuntime(int32_t workUnits) {
+        int64_t runtime;
+
+        if (mUtils.find(workUnits) != mUtils.end()) {
+            /* The number of workUnits has been found in the hash table! */
+            runtime = mUtils[workUnits];
+        } else if (workUnits < smallestSampledWorkUnits) {
+            /*
+             * If we are requesting a number of workUnits that is smaller
+             * than any other workUnits in our database, then we assign it
+             * the bandwidth of the runtime associated with the smallest
+             * workUnits entry of our database. This can be much bigger
+             * than what the callback requires, but is safe and is fast.
+             */
+            runtime = mUtils[smallestSampledWorkUnits];
+        } else {
+            /*
+             * When is required a number of workUnits that is bigger than
+             * what we ever measured, a linea regression problem is solved.
+             */
+            std::pair<double, double> linear_params = getLinearParams(mUtils);
+
+            runtime = linear_params.first
+                    + linear_params.second * workUnits;
+        }
+        return runtime;
+    }
+
+public:
+    /*
+     * Returns the (a, b) parameters of the equation "y = a + b*x",
+     * obtained by performing a min-square linear regression on the
+     * statistics.
+     * The runtime at 0 work units is left out, so a single measured load
+     * gives a line through the origin. Returns (0, 0) if there is nothing to fit.
+     */
+    static std::pair<double, double> getLinearParams(const std::map<int32_t, int64_t> &utils) {
+        // The keys are sorted, so this skips the loads of 0 work units.
+        auto first = utils.upper_bound(0);
+        uint32_t samples = std::distance(first, utils.end());
+
+        if (samples == 0)
+            return std::make_pair(0.0, 0.0);
+        if (samples == 1) {
+            double x = (*first).first;
+            double y = (*first).second;
+            return std::make_pair(0.0, (x == 0.0) ? 0.0 : y / x);
+        }
+
+        // linear regression using least squares
+        double avg_x = 0, avg_y = 0;
+
+        { // Compute the average values
+            for (auto it=first; it!=utils.end(); ++it) {
+                avg_x += (*it).first;
+                avg_y += (*it).second;
+            }
+            avg_x /= samples;
+            avg_y /= samples;
+        }
+
+        double beta;
+        { // Compute beta
+            double numerator = 0, denumerator = 0;
+            double x_value;
+
+            for (auto it=first; it!=utils.end(); ++it) {
+                x_value = (*it).first - avg_x;
+                numerator += x_value * ((*it).second - avg_y);
+                denumerator += x_value * x_value;
+            }
+
+            beta = numerator / denumerator;
+        }
+
+        double alpha = avg_y - beta * avg_x;
+
+        if (alpha < 0)
+            alpha = 0;
+        if (beta < 0)
+            beta = 0;
+
+        return std::make_pair(alpha, beta);
+    }
+
+private:
+    int32_t smallestSampledWorkUnits = -1;
+    std::map<int32_t, int64_t> mUtils;
+};
+
+/**
+ * Quantiles of the most recent runtimes.
+ *
+ * Runtimes are put in logarithmic bins that are kRelativeAccuracy wide so the
+ * quantile is never more than that much below the true value. A ring of bin
+ * indices removes the oldest runtime from its bin when the window is full.
+ */
+class SlidingQuantileSketch {
+public:
+    static constexpr int32_t kWindowSize = 256;
+    static constexpr double  kRelativeAccuracy = 0.02;
+    static constexpr int64_t kMinRuntime_ns = 1000;
+    static constexpr int32_t kNumBins = 320; // about 1 usec to 360 msec
+
+    void add(int64_t runtime_ns) {
+        int32_t bin = toBin(runtime_ns);
+        if (mCount == kWindowSize) {
+            mBinCounts[mRing[mHead]]--;
+        } else {
+            mCount++;
+        }
+        mRing[mHead] = (uint16_t) bin;
+        mBinCounts[bin]++;
+        mHead = (mHead + 1) % kWindowSize;
+    }
+
+    int32_t getCount() const {
+        return mCount;
+    }
+
+    /**
+     * @return the upper edge of the bin that holds the quantile, or zero if empty
+     */
+    int64_t getQuantile(double quantile) const {
+        if (mCount == 0) return 0;
+        int32_t target = (int32_t) std::ceil(quantile * mCount);
+        int32_t sum = 0;
+        for (int32_t bin = 0; bin < kNumBins; bin++) {
+            sum += mBinCounts[bin];
+            if (sum >= target) {
+                return fromBin(bin);
+            }
+        }
+        return fromBin(kNumBins - 1);
+    }
+
+private:
+    static double getGamma() {
+        return (1.0 + kRelativeAccuracy) / (1.0 - kRelativeAccuracy);
+    }
+
+    static int32_t toBin(int64_t runtime_ns) {
+        if (runtime_ns <= kMinRuntime_ns) return 0;
+        int32_t bin = (int32_t) std::ceil(std::log((double) runtime_ns / kMinRuntime_ns)
+                                          / std::log(getGamma()));
+        return (bin >= kNumBins) ? (kNumBins - 1) : bin;
+    }
+
+    static int64_t fromBin(int32_t bin) {
+        return (int64_t) (kMinRuntime_ns * std::pow(getGamma(), bin));
+    }
+
+    uint16_t mRing[kWindowSize] = {};
+    uint16_t mBinCounts[kNumBins] = {};
+    int32_t  mHead = 0;
+    int32_t  mCount = 0;
+};
+
+/**
+ * Reserve the p99 of a sliding window of runtimes, times a margin,
+ * separately for each number of work units.
+ * Loads that have not been measured get no estimate so the manager
+ * reserves BW_MAX until kMinSamples runtimes have been seen.
+ */
+class PercentileBandwidthController : public DeadlineBandwidthController {
+public:
+    static constexpr double  kQuantile = 0.99;
+    static constexpr double  kMargin = 1.1;
+    static constexpr int32_t kMinSamples = 16;
+
+    const char *getName() const override {
+        return getTypeName(TYPE_PERCENTILE);
+    }
+
+    void reportRuntime(int64_t runtime_ns, int32_t workUnits) override {
+        if (runtime_ns > 0) {
+            mSketches[workUnits].add(runtime_ns);
+        }
+    }
+
+    int64_t getReservedRuntime(int32_t workUnits, int64_t period_ns) override {
+        (void) period_ns;
+        auto it = mSketches.find(workUnits);
+        if (it == mSketches.end() || it->second.getCount() < kMinSamples) {
+            return 0;
+        }
+        return (int64_t) (it->second.getQuantile(kQuantile) * kMargin);
+    }
+
+    void dump(ResultReport &report) override {
+        report.addMetric("dl.quantile", kQuantile);
+        report.addMetric("dl.margin", kMargin);
+        report.addMetric("dl.window.bursts", SlidingQuantileSketch::kWindowSize);
+        report.addMetric("dl.loads.measured", mSketches.size());
+    }
+
+protected:
+    std::map<int32_t, SlidingQuantileSketch> mSketches;
+};
+
+/**
+ * Like PercentileBandwidthController but a load that has not been measured,
+ * or has too few samples, is predicted from a least squares fit of the p99
+ * of all the measured loads. So the bandwidth for the voice count announced
+ * by setApplicationLoad() is ready before the first burst of that load runs.
+ */
+class PredictiveBandwidthController : public PercentileBandwidthController {
+public:
+    const char *getName() const override {
+        return getTypeName(TYPE_PREDICTIVE);
+    }
+
+    int64_t getReservedRuntime(int32_t workUnits, int64_t period_ns) override {
+        int64_t runtime_ns = PercentileBandwidthController::getReservedRuntime(workUnits,
+                                                                               period_ns);
+        if (runtime_ns > 0) {
+            return runtime_ns;
+        }
+        std::map<int32_t, int64_t> quantiles;
+        for (const auto &entry : mSketches) {
+            if (entry.second.getCount() >= kMinSamples) {
+                quantiles[entry.first] = entry.second.getQuantile(kQuantile);
+            }
+        }
+        if (quantiles.empty()) {
+            return 0;
+        }
+        std::pair<double, double> line = EwmaBandwidthController::getLinearParams(quantiles);
+        mPredictionCount++;
+        return (int64_t) ((line.first + line.second * workUnits) * kMargin);
+    }
+
+    void dump(ResultReport &report) override {
+        PercentileBandwidthController::dump(report);
+        report.addMetric("dl.predictions", mPredictionCount);
+    }
+
+private:
+    int32_t mPredictionCount = 0;
+};
+
+inline std::unique_ptr<DeadlineBandwidthController>
+        DeadlineBandwidthController::create(int32_t type) {
+    switch (type) {
+        case TYPE_PERCENTILE:
+            return std::make_unique<PercentileBandwidthController>();
+        case TYPE_PREDICTIVE:
+            return std::make_unique<PredictiveBandwidthController>();
+        default:
+            return std::make_unique<EwmaBandwidthController>();
+    }
+}
+
+#endif // SYNTHMARK_DEADLINE_BANDWIDTH_CONTROLLER_H
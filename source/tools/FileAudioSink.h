@@ -0,0 +1,407 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SYNTHMARK_FILE_AUDIO_SINK_H
+#define SYNTHMARK_FILE_AUDIO_SINK_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "HostThreadFactory.h"
+#include "HostTools.h"
+#include "LogTool.h"
+#include "SynthMark.h"
+#include "VirtualAudioSink.h"
+#include "WaveFile.h"
+
+#ifndef O_DIRECT
+#define O_DIRECT 0 // not available on this host so always use buffered writes
+#endif
+
+/**
+ * A VirtualAudioSink that also streams the rendered audio to a file.
+ *
+ * The synthesizer renders directly into one of two large blocks so the
+ * audio thread never copies the data. When a block is full it is handed
+ * to a normal priority writer thread and the other block is filled.
+ * If the writer has not finished with the other block in time then
+ * the bursts are rendered into a scratch buffer and counted as dropped.
+ * A dropped burst leaves a gap in the file, so the run then fails with
+ * SYNTHMARK_RESULT_AUDIO_SINK_WRITE_FAILURE and the file cannot be used as a reference.
+ *
+ * A path ending in ".wav" gets a 32-bit float WAV header. Anything else is raw float.
+ * The file is rewritten each time the sink is opened so it holds the last run.
+ */
+class FileAudioSink : public VirtualAudioSink
+{
+public:
+    static constexpr int32_t kMinBlockSizeBytes = 64 * 1024;
+    static constexpr int32_t kDirectIoAlignment = 4096;
+
+    FileAudioSink(LogTool &logTool, const std::string &path)
+    : VirtualAudioSink(logTool)
+    , mPath(path)
+    {}
+
+    virtual ~FileAudioSink() {
+        finishFile();
+    }
+
+    /**
+     * The copy writes to this path with the tag added before the extension.
+     */
+    std::unique_ptr<AudioSinkBase> createConcurrentCopy(LogTool &logTool,
+                                                        const std::string &tag) override {
+        std::string path = mPath;
+        size_t dot = path.find_last_of('.');
+        size_t slash = path.find_last_of('/');
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+            dot = path.size();
+        }
+        path.insert(dot, "-" + tag);
+        std::unique_ptr<FileAudioSink> copy = std::make_unique<FileAudioSink>(logTool, path);
+        copyVirtualSettingsTo(copy.get());
+        copy->setDirectIoEnabled(mDirectIoEnabled);
+        return copy;
+    }
+
+    bool isDirectIoEnabled() const {
+        return mDirectIoEnabled;
+    }
+
+    /**
+     * Bypass the page cache with O_DIRECT. Must be called before open().
+     */
+    void setDirectIoEnabled(bool enabled) {
+        mDirectIoEnabled = enabled;
+    }
+
+    int32_t open(int32_t sampleRate, int32_t samplesPerFrame,
+                 int32_t framesPerBurst) override {
+        int32_t result = VirtualAudioSink::open(sampleRate, samplesPerFrame, framesPerBurst);
+        if (result < 0) {
+            return result;
+        }
+        finishFile();
+
+        mSamplesPerBurst = samplesPerFrame * framesPerBurst;
+        int32_t bytesPerBurst = mSamplesPerBurst * (int32_t) sizeof(float);
+        // With O_DIRECT each block must be a whole number of pages.
+        int32_t burstsPerUnit = 1;
+        if (mDirectIoEnabled) {
+            burstsPerUnit = kDirectIoAlignment / gcd(bytesPerBurst, kDirectIoAlignment);
+        }
+        int32_t unitBytes = burstsPerUnit * bytesPerBurst;
+        int32_t numUnits = std::max(1, (kMinBlockSizeBytes + unitBytes - 1) / unitBytes);
+        mBurstsPerBlock = numUnits * burstsPerUnit;
+        mBlockSizeBytes = mBurstsPerBlock * bytesPerBurst;
+
+        // One allocation for both blocks, the scratch burst and the header, all page aligned.
+        // With O_DIRECT a JUNK chunk pads the WAV header to a page.
+        mHeaderSizeBytes = isWav()
+                ? (mDirectIoEnabled ? kDirectIoAlignment : WaveFile::kMinHeaderSize) : 0;
+        size_t scratchOffset = 2 * (size_t) mBlockSizeBytes;
+        size_t headerOffset = scratchOffset + alignUp(bytesPerBurst);
+        size_t totalBytes = headerOffset + alignUp(std::max(mHeaderSizeBytes, 1));
+        mMemory = std::make_unique<uint8_t[]>(totalBytes + kDirectIoAlignment);
+        uint8_t *base = (uint8_t *) alignUp((uintptr_t) mMemory.get());
+        memset(base, 0, totalBytes);
+        mBlocks[0] = (float *) base;
+        mBlocks[1] = (float *) (base + mBlockSizeBytes);
+        mScratch = (float *) (base + scratchOffset);
+        mHeader = base + headerOffset;
+
+        int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+        mFd = ::open(mPath.c_str(), mDirectIoEnabled ? (flags | O_DIRECT) : flags, 0644);
+        if (mFd < 0 && mDirectIoEnabled && errno == EINVAL) {
+            mLogTool.log("WARNING O_DIRECT not supported for %s, using buffered writes\n",
+                         mPath.c_str());
+            mFd = ::open(mPath.c_str(), flags, 0644);
+        }
+        if (mFd < 0) {
+            mLogTool.log("ERROR could not open %s, errno = %d\n", mPath.c_str(), errno);
+            return SYNTHMARK_RESULT_AUDIO_SINK_START_FAILURE;
+        }
+        mUsingDirectIo = (fcntl(mFd, F_GETFL) & O_DIRECT) != 0;
+        // Header must be written before the first block so the data is page aligned.
+        if (mHeaderSizeBytes > 0) {
+            writeWavHeader(0);
+            if (writeFully(mHeader, mHeaderSizeBytes) < 0) {
+                return SYNTHMARK_RESULT_AUDIO_SINK_START_FAILURE;
+            }
+        }
+
+        mFillIndex = 0;
+        mBurstsInBlock = 0;
+        mWriteIndex = 0;
+        mBlockReady[0].store(false);
+        mBlockReady[1].store(false);
+        mSubmitSequence.store(0);
+        mWriterError = 0;
+        mDataBytesWritten = 0;
+        mBlocksWritten = 0;
+        mDroppedBursts = 0;
+        mTotalWriteNanos = 0;
+        mMaxWriteNanos = 0;
+        mMaxLagNanos = 0;
+        mFileReport.clear();
+
+        mQuit = false;
+        mWriterThread.reset(HostThreadFactory::createThread(HostThreadFactory::ThreadType::Default));
+        if (mWriterThread->start(writerProc, this) != 0) {
+            mWriterThread.reset();
+            mLogTool.log("ERROR could not start file writer thread\n");
+            return SYNTHMARK_RESULT_THREAD_FAILURE;
+        }
+        return result;
+    }
+
+    void writeBurst(const float *buffer) override {
+        VirtualAudioSink::writeBurst(buffer);
+        if (buffer == mScratch) {
+            mDroppedBursts++;
+        } else if (mBlocks[mFillIndex] != nullptr && ++mBurstsInBlock == mBurstsPerBlock) {
+            submitBlock();
+        }
+    }
+
+    int32_t stop() override {
+        int32_t result = VirtualAudioSink::stop();
+        finishFile();
+        return result;
+    }
+
+    int32_t close() override {
+        finishFile();
+        mMemory.reset();
+        mBlocks[0] = mBlocks[1] = nullptr;
+        return VirtualAudioSink::close();
+    }
+
+    int32_t getOutputError() override {
+        return (mDroppedBursts > 0 || mWriterError != 0)
+                ? SYNTHMARK_RESULT_AUDIO_SINK_WRITE_FAILURE : SYNTHMARK_RESULT_SUCCESS;
+    }
+
+    ResultReport dump() override {
+        ResultReport report = VirtualAudioSink::dump();
+        report << mFileReport;
+        return report;
+    }
+
+protected:
+    /**
+     * Render straight into the block that will be written to the file.
+     */
+    float *getBurstBuffer() override {
+        if (mBlocks[mFillIndex] == nullptr) {
+            return VirtualAudioSink::getBurstBuffer();
+        }
+        if (mBurstsInBlock == 0 && mBlockReady[mFillIndex].load(std::memory_order_acquire)) {
+            return mScratch; // The writer is still busy with this block.
+        }
+        return mBlocks[mFillIndex] + (mBurstsInBlock * mSamplesPerBurst);
+    }
+
+private:
+    static int32_t gcd(int32_t a, int32_t b) {
+        while (b != 0) {
+            int32_t t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+
+    static size_t alignUp(size_t n) {
+        return (n + kDirectIoAlignment - 1) & ~((size_t) kDirectIoAlignment - 1);
+    }
+
+    bool isWav() const {
+        const std::string extension = ".wav";
+        return mPath.size() >= extension.size()
+               && mPath.compare(mPath.size() - extension.size(), extension.size(), extension) == 0;
+    }
+
+    void submitBlock() {
+        mSubmitTimes[mFillIndex] = HostTools::getNanoTime();
+        mBlockReady[mFillIndex].store(true, std::memory_order_release);
+        mSubmitSequence.increment();
+        mSubmitSequence.wakeAll();
+        mFillIndex = 1 - mFillIndex;
+        mBurstsInBlock = 0;
+    }
+
+    static void *writerProc(void *arg) {
+        ((FileAudioSink *) arg)->writerLoop();
+        return nullptr;
+    }
+
+    void writerLoop() {
+        int32_t sequence = 0;
+        while (true) {
+            while (mBlockReady[mWriteIndex].load(std::memory_order_acquire)) {
+                int64_t beginWrite = HostTools::getNanoTime();
+                if (writeFully(mBlocks[mWriteIndex], mBlockSizeBytes) < 0) {
+                    mWriterError = errno;
+                }
+                int64_t endWrite = HostTools::getNanoTime();
+                mDataBytesWritten += mBlockSizeBytes;
+                mBlocksWritten++;
+                mTotalWriteNanos += endWrite - beginWrite;
+                mMaxWriteNanos = std::max(mMaxWriteNanos, endWrite - beginWrite);
+                mMaxLagNanos = std::max(mMaxLagNanos, endWrite - mSubmitTimes[mWriteIndex]);
+                mBlockReady[mWriteIndex].store(false, std::memory_order_release);
+                mWriteIndex = 1 - mWriteIndex;
+            }
+            if (mQuit) {
+                break;
+            }
+            mSubmitSequence.waitWhileEqual(sequence);
+            sequence = mSubmitSequence.load();
+        }
+    }
+
+    /**
+     * Drain the writer, write the partial block and patch the WAV header.
+     */
+    void finishFile() {
+        if (mWriterThread) {
+            mQuit = true;
+            mSubmitSequence.increment();
+            mSubmitSequence.wakeAll();
+            mWriterThread->join();
+            mWriterThread.reset();
+        }
+        if (mFd < 0) {
+            return;
+        }
+        if (mUsingDirectIo) {
+            // The tail is not a whole page so finish with buffered writes.
+            fcntl(mFd, F_SETFL, fcntl(mFd, F_GETFL) & ~O_DIRECT);
+        }
+        if (mBurstsInBlock > 0) {
+            int32_t numBytes = mBurstsInBlock * mSamplesPerBurst * (int32_t) sizeof(float);
+            if (writeFully(mBlocks[mFillIndex], numBytes) == 0) {
+                mDataBytesWritten += numBytes;
+            }
+            mBurstsInBlock = 0;
+        }
+        if (mHeaderSizeBytes > 0) {
+            writeWavHeader(mDataBytesWritten);
+            if (pwrite(mFd, mHeader, mHeaderSizeBytes, 0) != mHeaderSizeBytes) {
+                mWriterError = errno;
+            }
+        }
+        ::close(mFd);
+        mFd = -1;
+        mFileReport = makeReport();
+    }
+
+    int writeFully(const void *data, int32_t numBytes) {
+        const uint8_t *bytes = (const uint8_t *) data;
+        while (numBytes > 0) {
+            ssize_t written = write(mFd, bytes, numBytes);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                mLogTool.log("ERROR writing %s, errno = %d\n", mPath.c_str(), errno);
+                return -1;
+            }
+            bytes += written;
+            numBytes -= (int32_t) written;
+        }
+        return 0;
+    }
+
+    void writeWavHeader(int64_t dataBytes) {
+        uint32_t dataSize = (uint32_t) std::min<int64_t>(dataBytes, UINT32_MAX - mHeaderSizeBytes);
+        std::vector<uint8_t> header = WaveFile::makeFloatHeader(mSampleRate, mSamplesPerFrame,
+                                                                dataSize, mHeaderSizeBytes);
+        memcpy(mHeader, header.data(), mHeaderSizeBytes);
+    }
+
+    ResultReport makeReport() {
+        ResultReport report;
+        int32_t blocks = std::max(1, mBlocksWritten);
+        report.addMetric("file.path", mPath);
+        report.addMetric("file.format", isWav() ? "wav" : "raw");
+        report.addMetric("file.direct.io", mUsingDirectIo ? 1 : 0);
+        report.addMetric("file.block.size.bytes", mBlockSizeBytes);
+        report.addMetric("file.data.bytes", mDataBytesWritten);
+        report.addMetric("file.blocks.written", mBlocksWritten);
+        report.addMetric("file.dropped.bursts", mDroppedBursts);
+        report.addMetric("file.write.average.micros",
+                         (double) mTotalWriteNanos / (blocks * SYNTHMARK_NANOS_PER_MICROSECOND));
+        report.addMetric("file.write.max.micros",
+                         (double) mMaxWriteNanos / SYNTHMARK_NANOS_PER_MICROSECOND);
+        // Time from a block being full until it was on its way to the disk.
+        report.addMetric("file.writer.lag.max.micros",
+                         (double) mMaxLagNanos / SYNTHMARK_NANOS_PER_MICROSECOND);
+        report.addMetric("file.error", mWriterError);
+        return report;
+    }
+
+    const std::string mPath;
+    bool        mDirectIoEnabled = false;
+    bool        mUsingDirectIo = false;
+    int         mFd = -1;
+    int32_t     mSamplesPerBurst = 0;
+    int32_t     mBurstsPerBlock = 1;
+    int32_t     mBlockSizeBytes = 0;
+    int32_t     mHeaderSizeBytes = 0;
+
+    std::unique_ptr<uint8_t[]> mMemory;
+    float      *mBlocks[2] = {nullptr, nullptr};
+    float      *mScratch = nullptr;
+    uint8_t    *mHeader = nullptr;
+
+    // Used by the audio thread.
+    int32_t     mFillIndex = 0;
+    int32_t     mBurstsInBlock = 0;
+    int32_t     mDroppedBursts = 0;
+
+    // Shared between the audio thread and the writer.
+    std::atomic<bool> mBlockReady[2];
+    int64_t     mSubmitTimes[2] = {0, 0};
+    HostFutex   mSubmitSequence;
+    std::atomic<bool> mQuit{false};
+    std::unique_ptr<HostThread> mWriterThread;
+
+    // Used by the writer thread.
+    int32_t     mWriteIndex = 0;
+    int64_t     mDataBytesWritten = 0;
+    int32_t     mBlocksWritten = 0;
+    int64_t     mTotalWriteNanos = 0;
+    int64_t     mMaxWriteNanos = 0;
+    int64_t     mMaxLagNanos = 0;
+    int         mWriterError = 0;
+
+    ResultReport mFileReport;
+};
+
+#endif // SYNTHMARK_FILE_AUDIO_SINK_H
@@ -0,0 +1,362 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SYNTHMARK_GOLDEN_RENDER_HARNESS_H
+#define SYNTHMARK_GOLDEN_RENDER_HARNESS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "HostTools.h"
+#include "SynthMark.h"
+#include "SynthMarkResult.h"
+#include "SynthTools.h"
+#include "synth/Synthesizer.h"
+#include "tools/LogTool.h"
+#include "TestHarnessParameters.h"
+#include "WaveFile.h"
+
+/**
+ * Render a fixed note pattern from a fixed random seed and compare it
+ * with a reference render stored in a WAV file.
+ *
+ * If the reference file does not exist then it is recorded.
+ * Otherwise each burst is compared with the reference and the peak and RMS
+ * error are reported in dB relative to full scale, along with a checksum
+ * of the exact bits and the speed-up of the render compared to the reference.
+ *
+ * This runs the synthesizer directly, without an audio sink,
+ * so that optimized engines can be checked for numerical changes.
+ */
+class GoldenRenderHarness : public TestHarnessParameters {
+public:
+    static constexpr uint64_t kGoldenRandomSeed = 20260601;
+    static constexpr double   kSilenceDecibels = -200.0;
+
+    GoldenRenderHarness(AudioSinkBase *audioSink, SynthMarkResult *result, LogTool &logTool)
+    : TestHarnessParameters(audioSink, result, logTool) {
+    }
+
+    virtual ~GoldenRenderHarness() = default;
+
+    const char *getName() const override {
+        return "GoldenRender";
+    }
+
+    void setReferencePath(const std::string &path) {
+        mReferencePath = path;
+    }
+
+    // There is no audio sink to dump so do not call the base class.
+    int32_t runCompleteTest(int32_t sampleRate,
+                            int32_t framesPerBurst,
+                            int32_t numSeconds) override {
+        mResult->appendMessage("\n" TEXT_RESULTS_BEGIN "\n");
+        startTelemetry(sampleRate, framesPerBurst);
+        int32_t result = runTest(sampleRate, framesPerBurst, numSeconds);
+        stopTelemetry();
+        mResult->appendMessage(TEXT_RESULTS_END "\n");
+        mRunning = false;
+        return result;
+    }
+
+    int32_t runTest(int32_t sampleRate, int32_t framesPerBurst, int32_t numSeconds) override {
+        mResult->setTestName(getName());
+        mLogTool.log("---- Starting %s ----\n", getName());
+        if (mReferencePath.empty()) {
+            return fail(SYNTHMARK_RESULT_UNINITIALIZED, "use -G{path} to set the reference file");
+        }
+        if ((framesPerBurst % kSynthmarkFramesPerRender) != 0) {
+            return fail(SYNTHMARK_RESULT_OUT_OF_RANGE,
+                        "burst size must be a multiple of kSynthmarkFramesPerRender");
+        }
+
+        GoldenInfo expected;
+        expected.sampleRate = sampleRate;
+        expected.framesPerBurst = framesPerBurst;
+        expected.numVoices = std::max(1, getNumVoices());
+        expected.voiceType = (int32_t) mSynthesizerSettings.voiceType;
+        expected.oversampleFactor = mSynthesizerSettings.oversampleFactor;
+        expected.effectsEnabled = mSynthesizerSettings.effectsEnabled ? 1 : 0;
+        expected.seed = kGoldenRandomSeed;
+        expected.numBursts = ((int64_t) numSeconds * sampleRate) / framesPerBurst;
+
+        FILE *reference = fopen(mReferencePath.c_str(), "rb");
+        int32_t result = (reference == nullptr)
+                ? record(expected)
+                : compare(reference, expected);
+        if (reference != nullptr) {
+            fclose(reference);
+        }
+        return result;
+    }
+
+private:
+    static constexpr int32_t kGoldenInfoVersion = 1;
+    static constexpr const char *kGoldenChunkId = "smrk";
+
+    /**
+     * Stored in a chunk of the reference file so that it can only be
+     * compared with a render that used the same pattern.
+     */
+    struct GoldenInfo {
+        int32_t  version = kGoldenInfoVersion;
+        int32_t  sampleRate = 0;
+        int32_t  framesPerBurst = 0;
+        int32_t  numVoices = 0;
+        int32_t  voiceType = 0;
+        int32_t  oversampleFactor = 1;
+        int32_t  effectsEnabled = 0;
+        uint32_t checksum = 0;
+        uint64_t seed = 0;
+        int64_t  numBursts = 0;
+        int64_t  renderNanos = 0;
+    };
+    static_assert(sizeof(GoldenInfo) == 56, "GoldenInfo is stored in files");
+
+    /**
+     * Render the voices one burst at a time.
+     * The notes are turned on at the start of each second and off halfway through
+     * so the envelopes and the effects tails are included.
+     */
+    class PatternRenderer {
+    public:
+        PatternRenderer(const GoldenInfo &info, const SynthesizerSettings &settings)
+        : mInfo(info)
+        , mBuffer(info.framesPerBurst * SAMPLES_PER_FRAME) {
+            SynthesizerSettings renderSettings = settings;
+            renderSettings.pipelineWorkers = 0;
+            renderSettings.degradationEnabled = false;
+            SynthTools::setRandomSeed(info.seed);
+            mSynth.setup(info.sampleRate, kSynthmarkMaxVoices, renderSettings);
+        }
+
+        const float *renderBurst(int64_t burstIndex) {
+            int64_t frame = burstIndex * mInfo.framesPerBurst;
+            int64_t framesPerCycle = mInfo.sampleRate;
+            int64_t cycleFrame = frame % framesPerCycle;
+            if (cycleFrame < mInfo.framesPerBurst) {
+                mSynth.notesOn(mInfo.numVoices);
+            } else if (cycleFrame - (framesPerCycle / 2) >= 0
+                       && cycleFrame - (framesPerCycle / 2) < mInfo.framesPerBurst) {
+                mSynth.allNotesOff();
+            }
+            int64_t startNanos = HostTools::getNanoTime();
+            mSynth.renderStereo(mBuffer.data(), mInfo.framesPerBurst);
+            mSynth.renderEffects(mBuffer.data(), mInfo.framesPerBurst);
+            mRenderNanos += HostTools::getNanoTime() - startNanos;
+            mChecksum = SynthTools::checksumFloats(mChecksum, mBuffer.data(),
+                                                   (int32_t) mBuffer.size());
+            return mBuffer.data();
+        }
+
+        int32_t getSamplesPerBurst() const {
+            return (int32_t) mBuffer.size();
+        }
+
+        int64_t getRenderNanos() const {
+            return mRenderNanos;
+        }
+
+        uint32_t getChecksum() const {
+            return mChecksum;
+        }
+
+    private:
+        const GoldenInfo   &mInfo;
+        Synthesizer         mSynth;
+        std::vector<float>  mBuffer;
+        int64_t             mRenderNanos = 0;
+        uint32_t            mChecksum = SynthTools::kChecksumSeed;
+    };
+
+    int32_t record(GoldenInfo &info) {
+        FILE *file = fopen(mReferencePath.c_str(), "wb");
+        if (file == nullptr) {
+            return fail(SYNTHMARK_RESULT_UNRECOVERABLE_ERROR, "could not create the reference file");
+        }
+        mLogTool.log("Recording reference %s\n", mReferencePath.c_str());
+        PatternRenderer renderer(info, mSynthesizerSettings);
+        int32_t samplesPerBurst = renderer.getSamplesPerBurst();
+        uint32_t dataBytes = (uint32_t) (info.numBursts * samplesPerBurst * sizeof(float));
+        // Write the header first so the size is known, then again when the checksum is known.
+        bool ok = writeHeader(file, info, dataBytes);
+        for (int64_t burst = 0; ok && burst < info.numBursts; burst++) {
+            const float *output = renderer.renderBurst(burst);
+            ok = fwrite(output, sizeof(float), samplesPerBurst, file) == (size_t) samplesPerBurst;
+        }
+        info.checksum = renderer.getChecksum();
+        info.renderNanos = renderer.getRenderNanos();
+        ok = ok && fseek(file, 0, SEEK_SET) == 0 && writeHeader(file, info, dataBytes);
+        ok = (fclose(file) == 0) && ok;
+        if (!ok) {
+            return fail(SYNTHMARK_RESULT_UNRECOVERABLE_ERROR, "could not write the reference file");
+        }
+
+        ResultReport report;
+        appendCommon(report, info, renderer);
+        report.addMetric("golden.mode", "record");
+        mResult->setMeasurement(0.0);
+        mResult->setResultCode(SYNTHMARK_RESULT_SUCCESS);
+        mResult->appendReport(report);
+        return SYNTHMARK_RESULT_SUCCESS;
+    }
+
+    int32_t compare(FILE *file, const GoldenInfo &expected) {
+        WaveFile::Info waveInfo;
+        GoldenInfo reference;
+        if (WaveFile::readHeader(file, &waveInfo, kGoldenChunkId, &reference, sizeof(reference)) < 0
+                || !waveInfo.hasExtra || reference.version != kGoldenInfoVersion
+                || waveInfo.formatTag != WaveFile::kFormatFloat
+                || waveInfo.channels != SAMPLES_PER_FRAME) {
+            return fail(SYNTHMARK_RESULT_UNRECOVERABLE_ERROR, "not a SynthMark reference render");
+        }
+        if (reference.sampleRate != expected.sampleRate
+                || reference.framesPerBurst != expected.framesPerBurst
+                || reference.numVoices != expected.numVoices
+                || reference.seed != expected.seed
+                || reference.numBursts != expected.numBursts) {
+            mLogTool.log("Reference used -r%d -b%d -n%d -s%d\n",
+                         reference.sampleRate, reference.framesPerBurst, reference.numVoices,
+                         (int) (reference.numBursts * reference.framesPerBurst
+                                / std::max(1, reference.sampleRate)));
+            return fail(SYNTHMARK_RESULT_OUT_OF_RANGE,
+                        "the reference was rendered with a different pattern");
+        }
+        if (reference.voiceType != expected.voiceType
+                || reference.oversampleFactor != expected.oversampleFactor
+                || reference.effectsEnabled != expected.effectsEnabled) {
+            mLogTool.log("WARNING comparing with a reference that used other -V -O -e options\n");
+        }
+
+        mLogTool.log("Comparing with reference %s\n", mReferencePath.c_str());
+        GoldenInfo info = expected;
+        PatternRenderer renderer(info, mSynthesizerSettings);
+        int32_t samplesPerBurst = renderer.getSamplesPerBurst();
+        std::vector<float> referenceBurst(samplesPerBurst);
+        double maxPeakError = 0.0;
+        double maxBlockRmsError = 0.0;
+        double totalSquaredError = 0.0;
+        int64_t worstBurst = -1;
+        int64_t mismatchedSamples = 0;
+        for (int64_t burst = 0; burst < info.numBursts; burst++) {
+            const float *output = renderer.renderBurst(burst);
+            if (fread(referenceBurst.data(), sizeof(float), samplesPerBurst, file)
+                    != (size_t) samplesPerBurst) {
+                return fail(SYNTHMARK_RESULT_UNRECOVERABLE_ERROR, "the reference file is truncated");
+            }
+            double peakError = 0.0;
+            double squaredError = 0.0;
+            for (int32_t i = 0; i < samplesPerBurst; i++) {
+                double error = (double) output[i] - (double) referenceBurst[i];
+                if (error != 0.0) {
+                    mismatchedSamples++;
+                }
+                peakError = std::max(peakError, std::abs(error));
+                squaredError += error * error;
+            }
+            totalSquaredError += squaredError;
+            double blockRmsError = sqrt(squaredError / samplesPerBurst);
+            maxBlockRmsError = std::max(maxBlockRmsError, blockRmsError);
+            if (peakError > maxPeakError) {
+                maxPeakError = peakError;
+                worstBurst = burst;
+            }
+        }
+        info.checksum = renderer.getChecksum();
+        info.renderNanos = renderer.getRenderNanos();
+        double totalRmsError = sqrt(totalSquaredError
+                                    / std::max(1.0, (double) info.numBursts * samplesPerBurst));
+        double speedup = (info.renderNanos > 0)
+                ? ((double) reference.renderNanos / info.renderNanos) : 0.0;
+
+        ResultReport report;
+        appendCommon(report, info, renderer);
+        report.addMetric("golden.mode", "compare");
+        report.addMetric("golden.reference.checksum", formatChecksum(reference.checksum));
+        report.addMetric("golden.bit.exact",
+                         (reference.checksum == info.checksum && mismatchedSamples == 0) ? 1 : 0);
+        report.addMetric("golden.mismatched.samples", mismatchedSamples);
+        report << std::setprecision(4);
+        report.addMetric("golden.max.peak.error.db", toDecibels(maxPeakError));
+        report.addMetric("golden.max.block.rms.error.db", toDecibels(maxBlockRmsError));
+        report.addMetric("golden.total.rms.error.db", toDecibels(totalRmsError));
+        report.addMetric("golden.worst.burst", worstBurst);
+        report.addMetric("golden.reference.ns.per.frame",
+                         nanosPerFrame(reference.renderNanos, reference));
+        report.addMetric("golden.speedup", speedup);
+
+        mResult->setMeasurement(toDecibels(maxPeakError));
+        mResult->setResultCode(SYNTHMARK_RESULT_SUCCESS);
+        mResult->appendReport(report);
+        return SYNTHMARK_RESULT_SUCCESS;
+    }
+
+    void appendCommon(ResultReport &report,
+                      const GoldenInfo &info,
+                      const PatternRenderer &renderer) {
+        report.addMetric("golden.reference", mReferencePath);
+        report.addMetric("golden.seed", info.seed);
+        report.addMetric("golden.voices", info.numVoices);
+        report.addMetric("golden.frames", info.numBursts * info.framesPerBurst);
+        report.addMetric("golden.checksum", formatChecksum(renderer.getChecksum()));
+        report.addMetric("golden.render.ns.per.frame",
+                         nanosPerFrame(renderer.getRenderNanos(), info));
+    }
+
+    bool writeHeader(FILE *file, const GoldenInfo &info, uint32_t dataBytes) {
+        std::vector<uint8_t> header = WaveFile::makeFloatHeader(
+                info.sampleRate, SAMPLES_PER_FRAME, dataBytes, 0,
+                kGoldenChunkId, &info, sizeof(info));
+        return fwrite(header.data(), 1, header.size(), file) == header.size();
+    }
+
+    int32_t fail(int32_t resultCode, const char *message) {
+        mLogTool.log("ERROR %s: %s\n", getName(), message);
+        mResult->setResultCode(resultCode);
+        ResultReport report;
+        report.addMetric("golden.error", message);
+        mResult->appendReport(report);
+        return resultCode;
+    }
+
+    static double toDecibels(double amplitude) {
+        return (amplitude > 0.0) ? std::max((double) kSilenceDecibels, 20.0 * log10(amplitude))
+                                 : kSilenceDecibels;
+    }
+
+    static double nanosPerFrame(int64_t nanos, const GoldenInfo &info) {
+        double numFrames = (double) info.numBursts * info.framesPerBurst;
+        return (numFrames > 0) ? (nanos / numFrames) : 0.0;
+    }
+
+    static std::string formatChecksum(uint32_t checksum) {
+        std::stringstream text;
+        text << "0x" << std::hex << std::setw(8) << std::setfill('0') << checksum;
+        return text.str();
+    }
+
+    std::string mReferencePath;
+};
+
+#endif // SYNTHMARK_GOLDEN_RENDER_HARNESS_H
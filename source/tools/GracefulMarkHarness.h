@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_GRACEFULMARK_HARNESS_H
+#define SYNTHMARK_GRACEFULMARK_HARNESS_H
+
+#include <cstdint>
+#include <sstream>
+
+#include "SynthMark.h"
+#include "SynthMarkResult.h"
+#include "tools/LogTool.h"
+#include "TestHarnessParameters.h"
+#include "UtilizationMarkHarness.h"
+
+/**
+ * Measure how many voices can be played without a glitch,
+ * first with the load shedding controller off and then with it on.
+ * The difference is the headroom gained by degrading gracefully.
+ *
+ * The voice count starts at numVoices and grows by kGrowthFactor until there is an underrun.
+ * Each step runs for the requested number of seconds.
+ */
+class GracefulMarkHarness : public TestHarnessParameters {
+public:
+    GracefulMarkHarness(AudioSinkBase *audioSink, SynthMarkResult *result, LogTool &logTool)
+    : TestHarnessParameters(audioSink, result, logTool) {
+    }
+
+    virtual ~GracefulMarkHarness() = default;
+
+    const char *getName() const override {
+        return "GracefulMark";
+    }
+
+    int32_t runTest(int32_t sampleRate, int32_t framesPerBurst, int32_t numSeconds) override {
+        ResultReport report;
+        mResult->setTestName(getName());
+
+        mLogTool.log("---- GracefulMark without load shedding ----\n");
+        int32_t voicesOff = 0;
+        int32_t err = findGlitchFreeVoices(sampleRate, framesPerBurst, numSeconds,
+                                           false, &voicesOff);
+        if (err != SYNTHMARK_RESULT_SUCCESS) {
+            return err;
+        }
+
+        mLogTool.log("---- GracefulMark with load shedding ----\n");
+        int32_t voicesOn = 0;
+        err = findGlitchFreeVoices(sampleRate, framesPerBurst, numSeconds,
+                                   true, &voicesOn);
+        if (err != SYNTHMARK_RESULT_SUCCESS) {
+            return err;
+        }
+
+        report.addMetric("graceful.voices.degrade.off", voicesOff);
+        report.addMetric("graceful.voices.degrade.on", voicesOn);
+        double headroom = (voicesOff > 0) ? ((double) voicesOn / voicesOff) : 0.0;
+        report.addMetric("graceful.headroom.ratio", headroom);
+        report << "# Load shedding at the largest glitch-free voice count." << std::endl;
+        report << mLastPassingReport;
+
+        mResult->setMeasurement(headroom);
+        mResult->setResultCode(SYNTHMARK_RESULT_SUCCESS);
+        mResult->appendReport(report);
+        return SYNTHMARK_RESULT_SUCCESS;
+    }
+
+private:
+    static constexpr double kGrowthFactor = 1.25;
+
+    int32_t findGlitchFreeVoices(int32_t sampleRate,
+                                 int32_t framesPerBurst,
+                                 int32_t numSeconds,
+                                 bool degradationEnabled,
+                                 int32_t *maxVoicesPtr) {
+        int32_t numVoices = std::max(1, getNumVoices());
+        int32_t lastPassingVoices = 0;
+        while (numVoices <= kSynthmarkMaxVoices) {
+            bool glitched = false;
+            int32_t err = runOnce(sampleRate, framesPerBurst, numSeconds, numVoices,
+                                  degradationEnabled, &glitched);
+            if (err != SYNTHMARK_RESULT_SUCCESS) {
+                return err;
+            }
+            mLogTool.log("%3d voices, %s\n", numVoices, glitched ? "GLITCHED" : "ok");
+            if (glitched) {
+                break;
+            }
+            lastPassingVoices = numVoices;
+            numVoices = std::max(numVoices + 1, (int32_t) (numVoices * kGrowthFactor));
+        }
+        *maxVoicesPtr = lastPassingVoices;
+        return SYNTHMARK_RESULT_SUCCESS;
+    }
+
+    int32_t runOnce(int32_t sampleRate,
+                    int32_t framesPerBurst,
+                    int32_t numSeconds,
+                    int32_t numVoices,
+                    bool degradationEnabled,
+                    bool *glitchedPtr) {
+        SynthMarkResult result1;
+        UtilizationMarkHarness *harness = new UtilizationMarkHarness(mAudioSink,
+                                                                     &result1,
+                                                                     mLogTool);
+        SynthesizerSettings settings = mSynthesizerSettings;
+        settings.degradationEnabled = degradationEnabled;
+        harness->setNumVoices(numVoices);
+        harness->setDelayNoteOnSeconds(mDelayNotesOn);
+        harness->setThreadType(mThreadType);
+        harness->setSynthesizerSettings(settings);
+
+        mAudioSink->setUnderrunCount(0);
+        int32_t err = harness->runTest(sampleRate, framesPerBurst, numSeconds);
+        *glitchedPtr = (mAudioSink->getUnderrunCount() > 0);
+        if (err == SYNTHMARK_RESULT_SUCCESS && degradationEnabled && !*glitchedPtr) {
+            mLastPassingReport = harness->getLoadShedController().dump();
+        }
+        delete harness;
+        return err;
+    }
+
+    ResultReport mLastPassingReport;
+};
+
+#endif // SYNTHMARK_GRACEFULMARK_HARNESS_H
@@ -0,0 +1,506 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SYNTHMARK_HANDOFF_MATRIX_HARNESS_H
+#define SYNTHMARK_HANDOFF_MATRIX_HARNESS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#if !defined(__APPLE__)
+#include <sys/eventfd.h>
+#endif
+
+#include "AudioSinkBase.h"
+#include "HostThreadFactory.h"
+#include "HostTools.h"
+#include "SynthMark.h"
+#include "SynthMarkResult.h"
+#include "tools/LogTool.h"
+#include "TestHarnessParameters.h"
+
+/**
+ * Wake one thread from another, in one direction.
+ *
+ * MECHANISM_FUTEX always blocks in the kernel, like the RenderPipeline.
+ * MECHANISM_SPIN_THEN_PARK spins for kSpinNanos before blocking on the futex.
+ *     The futex is only woken when the other thread has parked.
+ * MECHANISM_EVENTFD blocks in read() on an eventfd, like a poll() based event loop.
+ */
+class HandoffSignal
+{
+public:
+    enum Mechanism : int32_t {
+        MECHANISM_FUTEX,
+        MECHANISM_SPIN_THEN_PARK,
+        MECHANISM_EVENTFD,
+        MECHANISM_COUNT
+    };
+
+    static constexpr int64_t kSpinNanos = 20 * SYNTHMARK_NANOS_PER_MICROSECOND;
+
+    static const char *getMechanismName(int32_t mechanism) {
+        switch (mechanism) {
+            case MECHANISM_FUTEX: return "futex";
+            case MECHANISM_SPIN_THEN_PARK: return "spin.park";
+            case MECHANISM_EVENTFD: return "eventfd";
+            default: return "unknown";
+        }
+    }
+
+    static bool isMechanismSupported(int32_t mechanism) {
+#if defined(__APPLE__)
+        return mechanism != MECHANISM_EVENTFD;
+#else
+        return mechanism >= 0 && mechanism < MECHANISM_COUNT;
+#endif
+    }
+
+    ~HandoffSignal() {
+        close();
+    }
+
+    /**
+     * @return 0 or a negative error
+     */
+    int32_t open(int32_t mechanism) {
+        close();
+        mMechanism = mechanism;
+        mSequence.store(0);
+        mSeen = 0;
+        mWaiters.store(0);
+#if !defined(__APPLE__)
+        if (mechanism == MECHANISM_EVENTFD) {
+            mEventFd = eventfd(0, EFD_CLOEXEC);
+            if (mEventFd < 0) {
+                return -errno;
+            }
+        }
+#endif
+        return 0;
+    }
+
+    void close() {
+        if (mEventFd >= 0) {
+            ::close(mEventFd);
+            mEventFd = -1;
+        }
+    }
+
+    void signal() {
+        switch (mMechanism) {
+            case MECHANISM_FUTEX:
+                mSequence.increment();
+                mSequence.wakeAll();
+                break;
+            case MECHANISM_SPIN_THEN_PARK:
+                mSequence.increment();
+                // Pairs with the fence in wait() so a parked waiter is never missed.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (mWaiters.load(std::memory_order_relaxed) > 0) {
+                    mSequence.wakeAll();
+                }
+                break;
+            case MECHANISM_EVENTFD: {
+                uint64_t one = 1;
+                ssize_t written = write(mEventFd, &one, sizeof(one));
+                (void) written;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    /**
+     * Block until signal() has been called since the last wait().
+     * Only one thread may wait.
+     */
+    void wait() {
+        switch (mMechanism) {
+            case MECHANISM_FUTEX:
+                mSequence.waitWhileEqual(mSeen);
+                mSeen = mSequence.load();
+                break;
+            case MECHANISM_SPIN_THEN_PARK: {
+                int64_t deadline = HostTools::getNanoTime() + kSpinNanos;
+                int32_t loops = 0;
+                while (mSequence.load() == mSeen) {
+                    if ((++loops & 63) == 0 && HostTools::getNanoTime() > deadline) {
+                        mWaiters.fetch_add(1);
+                        std::atomic_thread_fence(std::memory_order_seq_cst);
+                        mSequence.waitWhileEqual(mSeen);
+                        mWaiters.fetch_sub(1);
+                        break;
+                    }
+                }
+                mSeen = mSequence.load();
+                break;
+            }
+            case MECHANISM_EVENTFD: {
+                uint64_t count = 0;
+                ssize_t numRead = read(mEventFd, &count, sizeof(count));
+                (void) numRead;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+private:
+    int32_t              mMechanism = MECHANISM_FUTEX;
+    HostFutex            mSequence;
+    int32_t              mSeen = 0; // only used by the waiter
+    std::atomic<int32_t> mWaiters{0};
+    int                  mEventFd = -1;
+};
+
+/**
+ * Measure the round trip wakeup latency between every pair of CPUs.
+ *
+ * For each cell of the matrix a thread on the "from" CPU wakes a thread on the "to" CPU,
+ * which wakes it back. The threads are created with HostThreadFactory like the
+ * RenderPipeline workers, and are measured with SCHED_OTHER and with SCHED_FIFO
+ * at the priority of the audio thread, if -f allows SCHED_FIFO.
+ * The threads sleep for kGapMicros between round trips so the CPUs may go idle,
+ * as they do between audio bursts.
+ *
+ * The number of cells grows with the square of the number of CPUs, so -s is
+ * a time budget that is shared by all of the cells. Each cell does up to kRoundTrips,
+ * and at least kMinRoundTrips, so a host with many CPUs may take longer than -s.
+ */
+class HandoffMatrixHarness : public TestHarnessParameters {
+public:
+    static constexpr int32_t kRoundTrips = 200;
+    static constexpr int32_t kMinRoundTrips = 20;
+    static constexpr int32_t kWarmupRoundTrips = 20;
+    static constexpr int32_t kGapMicros = 200;
+    static constexpr double  kTailFraction = 0.99;
+
+    HandoffMatrixHarness(AudioSinkBase *audioSink, SynthMarkResult *result, LogTool &logTool)
+    : TestHarnessParameters(audioSink, result, logTool) {
+    }
+
+    virtual ~HandoffMatrixHarness() = default;
+
+    const char *getName() const override {
+        return "HandoffMatrix";
+    }
+
+    /**
+     * @param sampleRate not used, no audio is rendered
+     * @param framesPerBurst not used
+     * @param numSeconds time budget for all of the cells
+     */
+    int32_t runTest(int32_t sampleRate, int32_t framesPerBurst, int32_t numSeconds) override {
+        (void) sampleRate;
+        (void) framesPerBurst;
+        int numCpus = std::max(1, HostTools::getCpuCount());
+        mMatrices.clear();
+        std::vector<bool> policies = {false};
+        if (mAudioSink->isSchedFifoEnabled()) {
+            policies.push_back(true);
+        }
+        int32_t numMatrices = 0;
+        for (int32_t mechanism = 0; mechanism < HandoffSignal::MECHANISM_COUNT; mechanism++) {
+            numMatrices += HandoffSignal::isMechanismSupported(mechanism) ? 1 : 0;
+        }
+        numMatrices *= (int32_t) policies.size();
+        mSeconds = numSeconds;
+        mCellBudgetNanos = (int64_t) numSeconds * SYNTHMARK_NANOS_PER_SECOND
+                / std::max(1, numMatrices * numCpus * numCpus);
+        for (bool useSchedFifo : policies) {
+            for (int32_t mechanism = 0; mechanism < HandoffSignal::MECHANISM_COUNT; mechanism++) {
+                if (!HandoffSignal::isMechanismSupported(mechanism)) {
+                    continue;
+                }
+                if (TestHarnessBase::isCancelled()) {
+                    return SYNTHMARK_RESULT_CANCELLED;
+                }
+                Matrix matrix;
+                matrix.mechanism = mechanism;
+                matrix.useSchedFifo = useSchedFifo;
+                matrix.cells.resize(numCpus * numCpus);
+                mLogTool.log("---- Handoff with %s and %s on %d CPUs ----\n",
+                             HandoffSignal::getMechanismName(mechanism),
+                             getPolicyName(useSchedFifo), numCpus);
+                for (int from = 0; from < numCpus; from++) {
+                    for (int to = 0; to < numCpus; to++) {
+                        measureCell(mechanism, useSchedFifo, from, to, mCellBudgetNanos,
+                                    &matrix.cells[from * numCpus + to]);
+                    }
+                }
+                mMatrices.push_back(matrix);
+            }
+        }
+
+        mResult->setTestName(getName());
+        mResult->setResultCode(SYNTHMARK_RESULT_SUCCESS);
+        mResult->appendReport(dump(numCpus));
+        return SYNTHMARK_RESULT_SUCCESS;
+    }
+
+private:
+    struct Cell {
+        bool   valid = false;
+        int32_t roundTrips = 0;
+        double medianMicros = 0.0;
+        double tailMicros = 0.0;
+    };
+
+    struct Matrix {
+        int32_t           mechanism = HandoffSignal::MECHANISM_FUTEX;
+        bool              useSchedFifo = false;
+        std::vector<Cell> cells;
+    };
+
+    // Shared by the two threads that measure one cell.
+    struct Exchange {
+        int32_t       mechanism = HandoffSignal::MECHANISM_FUTEX;
+        bool          useSchedFifo = false;
+        int           fromCpu = 0;
+        int           toCpu = 0;
+        int64_t       budgetNanos = 0; // for the measured round trips, not the warm-up
+        HandoffSignal ping;
+        HandoffSignal pong;
+        std::atomic<int32_t> pongReady{0}; // 1 if ready, -1 if it could not be set up
+        std::atomic<bool>    quit{false};
+        std::unique_ptr<HostThread> fromThread;
+        std::unique_ptr<HostThread> toThread;
+        std::vector<int64_t> roundTripNanos;
+        bool          valid = false;
+    };
+
+    static const char *getPolicyName(bool useSchedFifo) {
+        return useSchedFifo ? "fifo" : "other";
+    }
+
+    static double toMicros(int64_t nanos) {
+        return (double) nanos / SYNTHMARK_NANOS_PER_MICROSECOND;
+    }
+
+    static bool setupThread(HostThread *thread, int cpu, bool useSchedFifo) {
+        if (HostThread::setCpuAffinity(cpu) != 0) {
+            return false;
+        }
+        return !useSchedFifo || thread->promote(SYNTHMARK_THREAD_PRIORITY_DEFAULT) == 0;
+    }
+
+    static void *pongProc(void *arg) {
+        Exchange *exchange = (Exchange *) arg;
+        if (!setupThread(exchange->toThread.get(), exchange->toCpu, exchange->useSchedFifo)) {
+            exchange->pongReady.store(-1);
+            return nullptr;
+        }
+        exchange->pongReady.store(1);
+        while (true) {
+            exchange->ping.wait();
+            if (exchange->quit.load()) {
+                break;
+            }
+            exchange->pong.signal();
+        }
+        return nullptr;
+    }
+
+    static void *pingProc(void *arg) {
+        Exchange *exchange = (Exchange *) arg;
+        bool ready = setupThread(exchange->fromThread.get(), exchange->fromCpu,
+                                 exchange->useSchedFifo);
+        int32_t pongReady;
+        while ((pongReady = exchange->pongReady.load()) == 0) {
+            HostThread::yield();
+        }
+        if (ready && pongReady > 0) {
+            exchange->roundTripNanos.reserve(kRoundTrips);
+            int64_t deadlineNanos = 0;
+            for (int32_t i = 0; i < kWarmupRoundTrips + kRoundTrips; i++) {
+                if (i == kWarmupRoundTrips) {
+                    deadlineNanos = HostTools::getNanoTime() + exchange->budgetNanos;
+                } else if (i >= kWarmupRoundTrips + kMinRoundTrips
+                        && HostTools::getNanoTime() > deadlineNanos) {
+                    break;
+                }
+                int64_t startNanos = HostTools::getNanoTime();
+                exchange->ping.signal();
+                exchange->pong.wait();
+                int64_t endNanos = HostTools::getNanoTime();
+                if (i >= kWarmupRoundTrips) {
+                    exchange->roundTripNanos.push_back(endNanos - startNanos);
+                }
+                HostTools::sleepForNanoseconds(kGapMicros * SYNTHMARK_NANOS_PER_MICROSECOND);
+            }
+            exchange->valid = true;
+        }
+        exchange->quit.store(true);
+        if (pongReady > 0) {
+            exchange->ping.signal();
+        }
+        return nullptr;
+    }
+
+    void measureCell(int32_t mechanism, bool useSchedFifo, int fromCpu, int toCpu,
+                     int64_t budgetNanos, Cell *cell) {
+        Exchange exchange;
+        exchange.mechanism = mechanism;
+        exchange.useSchedFifo = useSchedFifo;
+        exchange.fromCpu = fromCpu;
+        exchange.toCpu = toCpu;
+        exchange.budgetNanos = budgetNanos;
+        if (exchange.ping.open(mechanism) < 0 || exchange.pong.open(mechanism) < 0) {
+            return;
+        }
+        exchange.toThread.reset(HostThreadFactory::createThread(
+                HostThreadFactory::ThreadType::Default));
+        exchange.fromThread.reset(HostThreadFactory::createThread(
+                HostThreadFactory::ThreadType::Default));
+        if (exchange.toThread->start(pongProc, &exchange) != 0) {
+            return;
+        }
+        if (exchange.fromThread->start(pingProc, &exchange) != 0) {
+            // Let the pong thread exit.
+            while (exchange.pongReady.load() == 0) {
+                HostThread::yield();
+            }
+            exchange.quit.store(true);
+            exchange.ping.signal();
+            exchange.toThread->join();
+            return;
+        }
+        exchange.fromThread->join();
+        exchange.toThread->join();
+
+        if (exchange.valid && !exchange.roundTripNanos.empty()) {
+            std::vector<int64_t> &nanos = exchange.roundTripNanos;
+            std::sort(nanos.begin(), nanos.end());
+            size_t tailIndex = std::min(nanos.size() - 1,
+                                        (size_t) (kTailFraction * nanos.size()));
+            cell->valid = true;
+            cell->roundTrips = (int32_t) nanos.size();
+            cell->medianMicros = toMicros(nanos[nanos.size() / 2]);
+            cell->tailMicros = toMicros(nanos[tailIndex]);
+        }
+    }
+
+    ResultReport dump(int numCpus) {
+        ResultReport report;
+        int32_t minRoundTrips = kRoundTrips;
+        for (const Matrix &matrix : mMatrices) {
+            for (const Cell &cell : matrix.cells) {
+                if (cell.valid) {
+                    minRoundTrips = std::min(minRoundTrips, cell.roundTrips);
+                }
+            }
+        }
+        report.addMetric("handoff.cpus", numCpus);
+        report.addMetric("handoff.seconds", mSeconds);
+        report.addMetric("handoff.cell.budget.micros", toMicros(mCellBudgetNanos));
+        report.addMetric("handoff.round.trips", kRoundTrips);
+        report.addMetric("handoff.round.trips.min", minRoundTrips);
+        report.addMetric("handoff.gap.micros", kGapMicros);
+        report.addMetric("handoff.fifo.priority", SYNTHMARK_THREAD_PRIORITY_DEFAULT);
+
+        double measurement = 0.0;
+        for (const Matrix &matrix : mMatrices) {
+            std::string prefix = std::string("handoff.") + getPolicyName(matrix.useSchedFifo)
+                    + "." + HandoffSignal::getMechanismName(matrix.mechanism) + ".";
+            // Summarize the pairs of different CPUs, unless there is only one CPU.
+            std::vector<double> medians;
+            double worstTail = 0.0;
+            int bestFrom = -1;
+            int bestTo = -1;
+            double bestMedian = 0.0;
+            int32_t numInvalid = 0;
+            for (int from = 0; from < numCpus; from++) {
+                for (int to = 0; to < numCpus; to++) {
+                    const Cell &cell = matrix.cells[from * numCpus + to];
+                    if (!cell.valid) {
+                        numInvalid++;
+                        continue;
+                    }
+                    if (from == to && numCpus > 1) {
+                        continue;
+                    }
+                    medians.push_back(cell.medianMicros);
+                    worstTail = std::max(worstTail, cell.tailMicros);
+                    if (bestFrom < 0 || cell.medianMicros < bestMedian) {
+                        bestFrom = from;
+                        bestTo = to;
+                        bestMedian = cell.medianMicros;
+                    }
+                }
+            }
+            report.addMetric(prefix + "invalid.cells", numInvalid);
+            if (medians.empty()) {
+                report << "# " << prefix << "could not be measured" << std::endl;
+                continue;
+            }
+            std::sort(medians.begin(), medians.end());
+            double typicalMedian = medians[medians.size() / 2];
+            report.addMetric(prefix + "median.micros", typicalMedian);
+            report.addMetric(prefix + "p99.max.micros", worstTail);
+            report.addMetric(prefix + "best.from", bestFrom);
+            report.addMetric(prefix + "best.to", bestTo);
+            report.addMetric(prefix + "best.median.micros", bestMedian);
+            // Report the futex with the scheduler that the audio thread uses.
+            if (matrix.mechanism == HandoffSignal::MECHANISM_FUTEX) {
+                measurement = typicalMedian;
+            }
+        }
+        mResult->setMeasurement(measurement);
+
+        for (const Matrix &matrix : mMatrices) {
+            report << std::endl << "Handoff " << getPolicyName(matrix.useSchedFifo)
+                   << " " << HandoffSignal::getMechanismName(matrix.mechanism)
+                   << " median round trip micros, rows are from, columns are to"
+                   << std::endl;
+            report.setSection(std::string("handoff.") + getPolicyName(matrix.useSchedFifo)
+                              + "." + HandoffSignal::getMechanismName(matrix.mechanism));
+            std::stringstream header;
+            header << "from";
+            for (int to = 0; to < numCpus; to++) {
+                header << ", " << std::setw(7) << ("cpu" + std::to_string(to));
+            }
+            report.beginTable(header.str());
+            for (int from = 0; from < numCpus; from++) {
+                report.addCell(from, 4);
+                report << std::fixed << std::setprecision(1);
+                for (int to = 0; to < numCpus; to++) {
+                    const Cell &cell = matrix.cells[from * numCpus + to];
+                    report.addCell(cell.valid ? cell.medianMicros : -1.0, 7);
+                }
+                report.endRow();
+            }
+            report.endTable();
+        }
+        report << std::defaultfloat;
+        return report;
+    }
+
+    std::vector<Matrix> mMatrices;
+    int32_t             mSeconds = 0;
+    int64_t             mCellBudgetNanos = 0;
+};
+
+#endif // SYNTHMARK_HANDOFF_MATRIX_HARNESS_H
@@ -16,6 +16,14 @@
 
 #include "HostTools.h"
 
+int32_t             HostTools::mSleepMode               = HostTools::kDefaultSleepMode;
+bool                HostTools::mMemoryLocked            = false;
 HostCpuManagerBase *HostCpuManager::mInstance           = nullptr;
 int32_t             HostCpuManager::mWorkloadHintsLevel = HostCpuManager::WORKLOAD_HINTS_OFF;
+int32_t             HostCpuManager::mDeadlineControllerType
+                    = DeadlineBandwidthController::TYPE_EWMA;
 
+SysfsHostCpuManager::RestoreEntry
+                    SysfsHostCpuManager::sRestoreEntries[kMaxRestoreEntries];
+volatile int        SysfsHostCpuManager::sNumRestoreEntries = 0;
+bool                SysfsHostCpuManager::sHandlersInstalled = false;
@@ -17,22 +17,34 @@
 #ifndef ANDROID_HOSTTOOLS_H
 #define ANDROID_HOSTTOOLS_H
 
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <cstdio>
 #include <ctime>
 #include <cerrno>
 #include <memory.h>
+#include <sstream>
+#include <string>
+#include <vector>
 #include <pthread.h>
 #include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <unistd.h>
 
 #if defined(__APPLE__)
 #include <mach/mach_time.h>
 #else
+#include <linux/futex.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
 #include <sys/sysinfo.h>
+#include <sys/timerfd.h>
 #endif
 
+#include "ResultReport.h"
+
 constexpr int64_t kNanosPerMicrosecond  = 1000;
 constexpr int64_t kNanosPerSecond       = 1000000 * kNanosPerMicrosecond;
 
@@ -45,6 +57,81 @@ class HostTools
 {
 public:
 
+    /**
+     * Ways of sleeping until the next hardware read time.
+     */
+    enum : int32_t {
+        SLEEP_MODE_USLEEP = 0,     // relative usleep() in a loop, rounded up to microseconds
+        SLEEP_MODE_NANOSLEEP = 1,  // clock_nanosleep() with an absolute deadline
+        SLEEP_MODE_TIMERFD = 2,    // block in read() on an absolute timerfd
+        SLEEP_MODE_COUNT
+    };
+
+    // Keep usleep() so that results can be compared with older versions. Use -S to change it.
+    static constexpr int32_t kDefaultSleepMode = SLEEP_MODE_USLEEP;
+
+    static bool isSleepModeSupported(int32_t sleepMode) {
+#if defined(__APPLE__)
+        return sleepMode == SLEEP_MODE_USLEEP;
+#else
+        return sleepMode >= 0 && sleepMode < SLEEP_MODE_COUNT;
+#endif
+    }
+
+    static const char *getSleepModeName(int32_t sleepMode) {
+        switch (sleepMode) {
+            case SLEEP_MODE_USLEEP:
+                return "usleep";
+            case SLEEP_MODE_NANOSLEEP:
+                return "clock_nanosleep";
+            case SLEEP_MODE_TIMERFD:
+                return "timerfd";
+            default:
+                return "unknown";
+        }
+    }
+
+    static int32_t getSleepMode() {
+        return mSleepMode;
+    }
+
+    /**
+     * Select how sleepUntilNanoTime() waits. This applies to every thread.
+     */
+    static void setSleepMode(int32_t sleepMode) {
+        mSleepMode = sleepMode;
+    }
+
+    /**
+     * Set the timer slack of the calling thread.
+     * The kernel may delay a normal priority wakeup by up to this amount
+     * so that it can be merged with other timers. It is ignored for SCHED_FIFO.
+     *
+     * @param slackNanos zero restores the default slack of the thread
+     * @return 0 on success or a negative errno
+     */
+    static int setTimerSlackNanos(int64_t slackNanos) {
+#if defined(__APPLE__)
+        (void) slackNanos;
+        return -1;
+#else
+        int err = prctl(PR_SET_TIMERSLACK, (unsigned long) slackNanos, 0, 0, 0);
+        return err == 0 ? 0 : -errno;
+#endif
+    }
+
+    /**
+     * @return the timer slack of the calling thread or a negative errno
+     */
+    static int64_t getTimerSlackNanos() {
+#if defined(__APPLE__)
+        return -1;
+#else
+        int result = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+        return result >= 0 ? result : -errno;
+#endif
+    }
+
     /**
      * @return system time in nanoseconds, CLOCK_MONOTONIC on Linux
      */
@@ -75,10 +162,33 @@ public:
     }
 
     /**
-     * Sleep until the specified time.
+     * Sleep until the specified time using the current sleep mode.
      * @return the time we actually woke up
      */
     static int64_t sleepUntilNanoTime(int64_t wakeupTime) {
+        int64_t currentTime = getNanoTime();
+        if (wakeupTime <= currentTime) {
+            return currentTime;
+        }
+#if !defined(__APPLE__)
+        switch (mSleepMode) {
+            case SLEEP_MODE_NANOSLEEP:
+                return sleepUntilNanoTimeAbsolute(wakeupTime);
+            case SLEEP_MODE_TIMERFD:
+                return sleepUntilNanoTimeTimerFd(wakeupTime);
+            default:
+                break;
+        }
+#endif
+        return sleepUntilNanoTimeMicros(wakeupTime);
+    }
+
+    /**
+     * Sleep until the specified time by calling usleep() in a loop.
+     * Each sleep is relative and rounded up to a whole microsecond.
+     * @return the time we actually woke up
+     */
+    static int64_t sleepUntilNanoTimeMicros(int64_t wakeupTime) {
         const int32_t kMaxMicros = 999999; // from usleep documentation
         int64_t currentTime = getNanoTime();
         int64_t nanosToSleep = wakeupTime - currentTime;
@@ -98,6 +208,90 @@ public:
         return currentTime;
     }
 
+#if !defined(__APPLE__)
+    /**
+     * Sleep until an absolute CLOCK_MONOTONIC deadline.
+     * There is no rounding and no drift from the time spent computing the delay.
+     * @return the time we actually woke up
+     */
+    static int64_t sleepUntilNanoTimeAbsolute(int64_t wakeupTime) {
+        struct timespec deadline;
+        deadline.tv_sec = wakeupTime / kNanosPerSecond;
+        deadline.tv_nsec = wakeupTime % kNanosPerSecond;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+            ; // An absolute deadline can simply be retried.
+        }
+        return getNanoTime();
+    }
+
+    /**
+     * Sleep by blocking on a timerfd armed with an absolute deadline.
+     * Each thread lazily creates its own timer, which is closed when the thread exits.
+     * @return the time we actually woke up
+     */
+    static int64_t sleepUntilNanoTimeTimerFd(int64_t wakeupTime) {
+        static thread_local TimerFd timer;
+        if (!timer.isValid()) {
+            return sleepUntilNanoTimeAbsolute(wakeupTime);
+        }
+        struct itimerspec spec;
+        memset(&spec, 0, sizeof(spec));
+        spec.it_value.tv_sec = wakeupTime / kNanosPerSecond;
+        spec.it_value.tv_nsec = wakeupTime % kNanosPerSecond;
+        if (timerfd_settime(timer.get(), TFD_TIMER_ABSTIME, &spec, NULL) < 0) {
+            return sleepUntilNanoTimeAbsolute(wakeupTime);
+        }
+        uint64_t expirations = 0;
+        while (read(timer.get(), &expirations, sizeof(expirations)) < 0 && errno == EINTR) {
+            ;
+        }
+        return getNanoTime();
+    }
+#endif
+
+    /**
+     * Parse a list in the kernel format, eg. "0-3,6".
+     * @return true if at least one CPU was parsed
+     */
+    static bool parseCpuList(const std::string &text, std::vector<int> *cpus) {
+        cpus->clear();
+        std::stringstream stream(text);
+        std::string range;
+        while (std::getline(stream, range, ',')) {
+            int first = 0;
+            int last = 0;
+            int count = sscanf(range.c_str(), "%d-%d", &first, &last);
+            if (count < 1 || first < 0) {
+                return false;
+            } else if (count == 1) {
+                last = first;
+            }
+            for (int cpu = first; cpu <= last; cpu++) {
+                cpus->push_back(cpu);
+            }
+        }
+        return !cpus->empty();
+    }
+
+    /**
+     * Format a sorted list of CPUs in the kernel format, eg. "0-3,6".
+     */
+    static std::string formatCpuList(const std::vector<int> &cpus) {
+        std::stringstream text;
+        size_t i = 0;
+        while (i < cpus.size()) {
+            size_t j = i;
+            while ((j + 1) < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+                j++;
+            }
+            if (i > 0) text << ",";
+            text << cpus[i];
+            if (j > i) text << "-" << cpus[j];
+            i = j + 1;
+        }
+        return text.str();
+    }
+
     static int getCpuCount() {
 #if defined(__APPLE__)
         return -1;
@@ -106,6 +300,184 @@ public:
 #endif
     }
 
+    /**
+     * @return "MemAvailable" from /proc/meminfo in bytes, or -1 if it is not known
+     */
+    static int64_t getAvailableMemoryBytes() {
+        FILE *file = fopen("/proc/meminfo", "r");
+        if (file == nullptr) {
+            return -1;
+        }
+        char line[256];
+        long long kiloBytes = -1;
+        while (fgets(line, sizeof(line), file) != nullptr) {
+            if (sscanf(line, "MemAvailable: %lld kB", &kiloBytes) == 1) {
+                break;
+            }
+        }
+        fclose(file);
+        return (kiloBytes < 0) ? -1 : (int64_t) kiloBytes * 1024;
+    }
+
+    // Size of the stack touched by prefaultStack().
+    static constexpr int32_t kPrefaultStackBytes = 256 * 1024;
+    static constexpr int32_t kPrefaultPageBytes = 4096;
+
+    /**
+     * Lock all current and future pages of the process in memory with mlockall().
+     * Later mappings, including the stacks of new threads, are faulted in when they are made.
+     * This may require root or a higher RLIMIT_MEMLOCK.
+     *
+     * @return 0 on success or a negative errno
+     */
+    static int lockMemory() {
+        int err = mlockall(MCL_CURRENT | MCL_FUTURE);
+        if (err != 0) {
+            return -errno;
+        }
+        mMemoryLocked = true;
+        return 0;
+    }
+
+    static bool isMemoryLocked() {
+        return mMemoryLocked;
+    }
+
+    /**
+     * Write to every page of a buffer so that it is mapped before a real-time thread uses it.
+     * The contents are not changed.
+     */
+    static void prefaultMemory(void *address, size_t numBytes) {
+        volatile char *bytes = (volatile char *) address;
+        for (size_t i = 0; i < numBytes; i += kPrefaultPageBytes) {
+            bytes[i] = bytes[i];
+        }
+        if (numBytes > 0) {
+            bytes[numBytes - 1] = bytes[numBytes - 1];
+        }
+    }
+
+    /**
+     * Touch kPrefaultStackBytes of the stack below the caller
+     * so the calling thread will not fault when its stack grows.
+     */
+    static void __attribute__((noinline)) prefaultStack() {
+        volatile char stack[kPrefaultStackBytes];
+        for (int32_t i = 0; i < kPrefaultStackBytes; i += kPrefaultPageBytes) {
+            stack[i] = 0;
+        }
+        (void) stack[0]; // the writes are volatile so they are not removed
+    }
+
+    /**
+     * Get the page faults of the calling thread so far.
+     * Apple hosts do not have RUSAGE_THREAD so they report the whole process.
+     * @return 0 on success or a negative errno
+     */
+    static int getThreadPageFaults(int64_t *minorFaults, int64_t *majorFaults) {
+        struct rusage usage;
+#if defined(__APPLE__)
+        int who = RUSAGE_SELF;
+#else
+        int who = RUSAGE_THREAD;
+#endif
+        if (getrusage(who, &usage) != 0) {
+            return -errno;
+        }
+        *minorFaults = usage.ru_minflt;
+        *majorFaults = usage.ru_majflt;
+        return 0;
+    }
+
+private:
+#if !defined(__APPLE__)
+    /**
+     * Owns a timerfd so it is closed when a thread_local instance is destroyed.
+     */
+    class TimerFd {
+    public:
+        TimerFd()
+        : mFd(timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC)) {}
+
+        ~TimerFd() {
+            if (mFd >= 0) {
+                close(mFd);
+            }
+        }
+
+        bool isValid() const {
+            return mFd >= 0;
+        }
+
+        int get() const {
+            return mFd;
+        }
+
+    private:
+        int mFd;
+    };
+#endif
+
+    static int32_t mSleepMode;
+    static bool    mMemoryLocked;
+};
+
+/**
+ * An atomic integer that a thread can block on until it changes.
+ * This uses a futex on Linux so no lock is needed to signal it.
+ * Other hosts just yield until the value changes.
+ */
+class HostFutex
+{
+public:
+    explicit HostFutex(int32_t value = 0)
+    : mValue(value) {}
+
+    int32_t load() const {
+        return mValue.load(std::memory_order_acquire);
+    }
+
+    void store(int32_t value) {
+        mValue.store(value, std::memory_order_release);
+    }
+
+    /**
+     * @return the value after the increment
+     */
+    int32_t increment() {
+        return mValue.fetch_add(1, std::memory_order_acq_rel) + 1;
+    }
+
+    /**
+     * Wake up every thread that is blocked in waitWhileEqual().
+     */
+    void wakeAll() {
+#if !defined(__APPLE__)
+        syscall(SYS_futex, getAddress(), FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+#endif
+    }
+
+    /**
+     * Block until the value is no longer equal to the expected value.
+     */
+    void waitWhileEqual(int32_t expected) {
+        while (load() == expected) {
+#if defined(__APPLE__)
+            sched_yield();
+#else
+            // Returns immediately with EAGAIN if the value already changed.
+            syscall(SYS_futex, getAddress(), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#endif
+        }
+    }
+
+private:
+    int32_t *getAddress() {
+        static_assert(sizeof(mValue) == sizeof(int32_t), "futex must be 32 bits");
+        return reinterpret_cast<int32_t *>(&mValue);
+    }
+
+    std::atomic<int32_t> mValue;
 };
 
 typedef void * host_thread_proc_t(void *arg);
@@ -200,6 +572,7 @@ protected:
 class HostCpuManagerBase
 {
 public:
+    virtual ~HostCpuManagerBase() = default;
 
     /**
      * Sleep until the specified time and tune the CPU for optimal performance.
@@ -238,6 +611,13 @@ public:
         return mNanosPerBurst;
     }
 
+    /**
+     * @return a report to append to the results, may be empty
+     */
+    virtual ResultReport dump() {
+        return ResultReport();
+    }
+
 private:
 
     int32_t mCurrentWorkUnits = 0;
@@ -376,6 +756,7 @@ private:
 };
 
 #include "CustomHostCpuManager.h"
+#include "SysfsHostCpuManager.h"
 
 /**
  * Return a singleton instance of a HostCpuManagerBase.
@@ -387,13 +768,19 @@ public:
     enum : int32_t {
         WORKLOAD_HINTS_OFF = 0,
         WORKLOAD_HINTS_ON = 1,
-        WORKLOAD_HINTS_ON_LOGGED = 2
+        WORKLOAD_HINTS_ON_LOGGED = 2,
+        WORKLOAD_HINTS_SYSFS_MIN_FREQ = 3,
+        WORKLOAD_HINTS_SYSFS_USERSPACE = 4,
     };
 
     static HostCpuManagerBase *getInstance() {
         if (mInstance == nullptr) {
             if (areWorkloadHintsEnabled()) {
-                mInstance = new CustomHostCpuManager();
+                mInstance = new CustomHostCpuManager(mDeadlineControllerType);
+            } else if (mWorkloadHintsLevel == WORKLOAD_HINTS_SYSFS_MIN_FREQ) {
+                mInstance = new SysfsHostCpuManager(SysfsHostCpuManager::MODE_MIN_FREQ);
+            } else if (mWorkloadHintsLevel == WORKLOAD_HINTS_SYSFS_USERSPACE) {
+                mInstance = new SysfsHostCpuManager(SysfsHostCpuManager::MODE_USERSPACE);
             } else {
                 mInstance = new HostCpuManagerStub();
             }
@@ -401,6 +788,14 @@ public:
         return mInstance;
     }
 
+    /**
+     * Delete the instance so it can restore any settings that it changed.
+     */
+    static void releaseInstance() {
+        delete mInstance;
+        mInstance = nullptr;
+    }
+
     static int32_t getWorkloadHintsLevel() {
         return mWorkloadHintsLevel;
     }
@@ -409,6 +804,17 @@ public:
         mWorkloadHintsLevel = level;
     }
 
+    /**
+     * @param type a DeadlineBandwidthController::Type used by -w1 and -w2
+     */
+    static void setDeadlineControllerType(int32_t type) {
+        mDeadlineControllerType = type;
+    }
+
+    static int32_t getDeadlineControllerType() {
+        return mDeadlineControllerType;
+    }
+
     static bool areWorkloadHintsEnabled() {
         return mWorkloadHintsLevel == WORKLOAD_HINTS_ON
                || mWorkloadHintsLevel == WORKLOAD_HINTS_ON_LOGGED;
@@ -418,6 +824,7 @@ private:
     HostCpuManager() {}
     static HostCpuManagerBase *mInstance;
     static int32_t             mWorkloadHintsLevel;
+    static int32_t             mDeadlineControllerType;
 
 };
 
@@ -34,6 +34,12 @@ public:
         Finished = 1,   // all done so stop calling the callback
     };
 
+    /**
+     * Called on the audio thread before the first call to onRenderAudio().
+     * Per thread resources can be set up here, outside the timed callbacks.
+     */
+    virtual void onBeginAudioThread() {}
+
     virtual Result onRenderAudio(float *buffer, int32_t numFrames) = 0;
 };
 
@@ -19,6 +19,7 @@
 
 #include <cmath>
 #include <cstdint>
+#include "synth/Synthesizer.h"
 
 class ITestHarness {
 
@@ -35,6 +36,10 @@ public:
 
     virtual void setThreadType(HostThreadFactory::ThreadType mThreadType) = 0;
 
+    virtual void setSynthesizerSettings(const SynthesizerSettings &settings) = 0;
+
+    virtual void setTelemetryPeriodMillis(int32_t periodMillis) = 0;
+
     virtual void launch(int32_t sampleRate,
                    int32_t framesPerBurst,
                    int32_t numSeconds) = 0;
@@ -0,0 +1,408 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SYNTHMARK_INTERFERENCE_MARK_HARNESS_H
+#define SYNTHMARK_INTERFERENCE_MARK_HARNESS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "AudioSinkBase.h"
+#include "HostTools.h"
+#include "SynthMark.h"
+#include "SynthMarkResult.h"
+#include "tools/Antagonist.h"
+#include "tools/CpuTopology.h"
+#include "tools/JitterMarkHarness.h"
+#include "tools/LatencyMarkHarness.h"
+#include "tools/LogTool.h"
+#include "tools/VoiceMarkHarness.h"
+#include "TestHarnessParameters.h"
+
+/**
+ * Measure how VoiceMark, LatencyMark and the wakeup jitter degrade
+ * when other threads compete with the audio thread.
+ *
+ * The three tests are run on an idle system, for a baseline,
+ * then again while each type of Antagonist runs on every selected CPU.
+ * The antagonists are configured with dimensions separated by ':' like the sweep grid:
+ *   c = CPUs for the antagonists, eg. "c0-3,6", default is every CPU
+ *   a = antagonist types, 0 = memory stream, 1 = cache thrash, 2 = spin, 3 = SCHED_FIFO,
+ *       default is all of them
+ *   p = priority of the SCHED_FIFO antagonist, default is the priority of the audio thread
+ * For example "c4-7:a0,1".
+ */
+class InterferenceMarkHarness : public TestHarnessParameters {
+public:
+    struct Config {
+        std::vector<int>     cpus;
+        std::vector<int32_t> types;
+        int32_t              fifoPriority = SYNTHMARK_THREAD_PRIORITY_DEFAULT;
+    };
+
+    // Let the antagonists fill the caches and raise the clocks before measuring.
+    static constexpr int32_t kSettleMillis = 500;
+    static constexpr double  kWakeupFraction = 0.99;
+    static constexpr int64_t kMinStreamBytes = 16 * 1024 * 1024;
+    static constexpr int64_t kMaxStreamBytes = 128 * 1024 * 1024;
+    static constexpr int64_t kDefaultCacheBytes = 2 * 1024 * 1024;
+    static constexpr int64_t kMaxThrashBytes = 64 * 1024 * 1024;
+    // The buffers of all the antagonists together may use this much of MemAvailable.
+    static constexpr double  kMaxAvailableMemoryFraction = 0.25;
+    // Total for all the antagonists when MemAvailable cannot be read.
+    static constexpr int64_t kMaxTotalBufferBytes = 512 * 1024 * 1024;
+
+    InterferenceMarkHarness(AudioSinkBase *audioSink, SynthMarkResult *result, LogTool &logTool)
+    : TestHarnessParameters(audioSink, result, logTool) {
+    }
+
+    virtual ~InterferenceMarkHarness() = default;
+
+    const char *getName() const override {
+        return "InterferenceMark";
+    }
+
+    /**
+     * @return 0 or -1 if the text could not be parsed
+     */
+    static int32_t parseConfig(const std::string &text, Config *config) {
+        std::stringstream dimensions(text);
+        std::string dimension;
+        while (std::getline(dimensions, dimension, ':')) {
+            if (dimension.size() < 2) {
+                return -1;
+            }
+            std::string values = dimension.substr(1);
+            switch (dimension[0]) {
+                case 'c':
+                    if (!HostTools::parseCpuList(values, &config->cpus)
+                            || config->cpus.empty()) {
+                        return -1;
+                    }
+                    break;
+                case 'a': {
+                    std::stringstream list(values);
+                    std::string item;
+                    while (std::getline(list, item, ',')) {
+                        char *end = nullptr;
+                        long type = strtol(item.c_str(), &end, 10);
+                        if (item.empty() || *end != 0
+                                || type < 0 || type >= Antagonist::TYPE_COUNT) {
+                            return -1;
+                        }
+                        config->types.push_back((int32_t) type);
+                    }
+                    if (config->types.empty()) {
+                        return -1;
+                    }
+                    break;
+                }
+                case 'p': {
+                    char *end = nullptr;
+                    long priority = strtol(values.c_str(), &end, 10);
+                    if (*end != 0 || priority < 1 || priority > 99) {
+                        return -1;
+                    }
+                    config->fifoPriority = (int32_t) priority;
+                    break;
+                }
+                default:
+                    return -1;
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * @param text see the class comment
+     * @return 0 or -1 if the configuration is invalid
+     */
+    int32_t setConfig(const std::string &text) {
+        Config config;
+        if (parseConfig(text, &config) < 0) {
+            return -1;
+        }
+        mConfig = config;
+        return 0;
+    }
+
+    /**
+     * @param load for VoiceMark, 0.5 would be 50% of one CPU
+     */
+    void setTargetCpuLoad(double load) {
+        mTargetCpuLoad = load;
+    }
+
+    int32_t runTest(int32_t sampleRate, int32_t framesPerBurst, int32_t numSeconds) override {
+        Config config = mConfig;
+        if (config.cpus.empty()) {
+            int numCpus = std::max(1, HostTools::getCpuCount());
+            for (int cpu = 0; cpu < numCpus; cpu++) {
+                config.cpus.push_back(cpu);
+            }
+        }
+        if (config.types.empty()) {
+            for (int32_t type = 0; type < Antagonist::TYPE_COUNT; type++) {
+                config.types.push_back(type);
+            }
+        }
+        int64_t cacheBytes = CpuTopology::getLastLevelCacheBytes();
+        if (cacheBytes <= 0) {
+            cacheBytes = kDefaultCacheBytes;
+        }
+
+        // The first scenario has no antagonist.
+        mScenarios.clear();
+        mScenarios.push_back(Scenario());
+        for (int32_t type : config.types) {
+            Scenario scenario;
+            scenario.type = type;
+            mScenarios.push_back(scenario);
+        }
+
+        int32_t result = SYNTHMARK_RESULT_SUCCESS;
+        for (Scenario &scenario : mScenarios) {
+            if (TestHarnessBase::isCancelled()) {
+                result = SYNTHMARK_RESULT_CANCELLED;
+                break;
+            }
+            mLogTool.log("---- InterferenceMark with %s on CPUs %s ----\n",
+                         getScenarioName(scenario),
+                         (scenario.type < 0) ? "none"
+                                 : HostTools::formatCpuList(config.cpus).c_str());
+            size_t bufferBytes = 0;
+            if (scenario.type == Antagonist::TYPE_MEMORY_STREAM) {
+                bufferBytes = (size_t) std::max((int64_t) kMinStreamBytes,
+                                                std::min((int64_t) kMaxStreamBytes,
+                                                         4 * cacheBytes));
+            } else if (scenario.type == Antagonist::TYPE_CACHE_THRASH) {
+                bufferBytes = (size_t) std::min((int64_t) kMaxThrashBytes, cacheBytes);
+            }
+            int64_t maxBufferBytes = getMaxBufferBytes(config);
+            if (bufferBytes > (size_t) maxBufferBytes) {
+                mLogTool.log("Limit each %s buffer to %lld bytes\n",
+                             getScenarioName(scenario), (long long) maxBufferBytes);
+                bufferBytes = (size_t) maxBufferBytes;
+            }
+            result = measureScenario(sampleRate, framesPerBurst, numSeconds,
+                                     config, bufferBytes, &scenario);
+            if (result != SYNTHMARK_RESULT_SUCCESS) {
+                break;
+            }
+        }
+
+        mResult->setTestName(getName());
+        mResult->setResultCode(result);
+        mResult->appendReport(dump(config, cacheBytes));
+        return result;
+    }
+
+private:
+    struct Scenario {
+        int32_t type = -1; // no antagonist
+        double  voiceMark = 0.0;
+        double  latencyMillis = 0.0;
+        double  wakeupAverageMicros = 0.0;
+        double  wakeupTailMicros = 0.0;
+        int32_t jitterUnderruns = 0;
+        double  antagonistCpuSeconds = 0.0;
+        double  antagonistMBytesPerSecond = 0.0;
+        int32_t antagonistsPromoted = 0;
+        bool    done = false;
+    };
+
+    static const char *getScenarioName(const Scenario &scenario) {
+        return (scenario.type < 0) ? "none" : Antagonist::getTypeName(scenario.type);
+    }
+
+    /**
+     * One antagonist runs on each CPU so limit the total size of their buffers.
+     * @return maximum bytes for the buffer of one antagonist
+     */
+    static int64_t getMaxBufferBytes(const Config &config) {
+        int64_t availableBytes = HostTools::getAvailableMemoryBytes();
+        int64_t totalBytes = (availableBytes > 0)
+                ? (int64_t) (availableBytes * kMaxAvailableMemoryFraction)
+                : kMaxTotalBufferBytes;
+        return totalBytes / std::max((int64_t) 1, (int64_t) config.cpus.size());
+    }
+
+    int32_t measureScenario(int32_t sampleRate,
+                            int32_t framesPerBurst,
+                            int32_t numSeconds,
+                            const Config &config,
+                            size_t bufferBytes,
+                            Scenario *scenario) {
+        std::vector<std::unique_ptr<Antagonist>> antagonists;
+        if (scenario->type >= 0) {
+            for (int cpu : config.cpus) {
+                antagonists.push_back(std::make_unique<Antagonist>());
+                if (antagonists.back()->start(scenario->type, cpu,
+                                              config.fifoPriority, bufferBytes) < 0) {
+                    mLogTool.log("ERROR could not start the %s antagonist on CPU %d\n",
+                                 getScenarioName(*scenario), cpu);
+                    return SYNTHMARK_RESULT_THREAD_FAILURE;
+                }
+            }
+        }
+        int64_t startTime = HostTools::getNanoTime();
+        usleep(kSettleMillis * 1000);
+
+        SynthMarkResult result1;
+        int32_t err = SYNTHMARK_RESULT_SUCCESS;
+        {
+            VoiceMarkHarness harness(mAudioSink, &result1, mLogTool);
+            harness.setTargetCpuLoad(mTargetCpuLoad);
+            harness.setInitialVoiceCount(mNumVoices);
+            configure(&harness);
+            err = harness.runTest(sampleRate, framesPerBurst, numSeconds);
+            scenario->voiceMark = result1.getMeasurement();
+        }
+        if (err == SYNTHMARK_RESULT_SUCCESS) {
+            result1.reset();
+            LatencyMarkHarness harness(mAudioSink, &result1, mLogTool);
+            harness.setNumVoices(mNumVoices);
+            harness.setInitialBursts(mAudioSink->getDefaultBufferSizeInBursts());
+            configure(&harness);
+            err = harness.runTest(sampleRate, framesPerBurst, numSeconds);
+            scenario->latencyMillis = result1.getMeasurement()
+                    * SYNTHMARK_MILLIS_PER_SECOND / sampleRate;
+        }
+        if (err == SYNTHMARK_RESULT_SUCCESS) {
+            result1.reset();
+            JitterMarkHarness harness(mAudioSink, &result1, mLogTool);
+            harness.setNumVoices(mNumVoices);
+            configure(&harness);
+            // Only count the underruns of the JitterMark phase.
+            mAudioSink->setUnderrunCount(0);
+            err = harness.runTest(sampleRate, framesPerBurst, numSeconds);
+            scenario->wakeupAverageMicros = harness.getAverageWakeupDelayMicros();
+            scenario->wakeupTailMicros = harness.getWakeupDelayMicrosAtFraction(kWakeupFraction);
+            scenario->jitterUnderruns = mAudioSink->getUnderrunCount();
+        }
+
+        double elapsedSeconds = (HostTools::getNanoTime() - startTime)
+                / (double) SYNTHMARK_NANOS_PER_SECOND;
+        int64_t bytesTouched = 0;
+        for (std::unique_ptr<Antagonist> &antagonist : antagonists) {
+            antagonist->stop();
+            scenario->antagonistCpuSeconds += antagonist->getCpuSeconds();
+            bytesTouched += antagonist->getBytesTouched();
+            if (antagonist->wasPromoted()) {
+                scenario->antagonistsPromoted++;
+            }
+        }
+        scenario->antagonistMBytesPerSecond = bytesTouched / (elapsedSeconds * 1024 * 1024);
+        scenario->done = (err == SYNTHMARK_RESULT_SUCCESS);
+        if (err) {
+            mLogTool.log("ERROR InterferenceMark with %s returned %d\n",
+                         getScenarioName(*scenario), err);
+        }
+        return err;
+    }
+
+    void configure(TestHarnessParameters *harness) {
+        harness->setDelayNoteOnSeconds(mDelayNotesOn);
+        harness->setThreadType(mThreadType);
+        harness->setSynthesizerSettings(mSynthesizerSettings);
+    }
+
+    static double ratio(double value, double baseline) {
+        return (baseline > 0.0) ? (value / baseline) : 0.0;
+    }
+
+    ResultReport dump(const Config &config, int64_t cacheBytes) {
+        ResultReport report;
+        const Scenario &baseline = mScenarios.front();
+        double worstVoiceMarkRatio = 1.0;
+        for (const Scenario &scenario : mScenarios) {
+            if (scenario.done && scenario.type >= 0) {
+                worstVoiceMarkRatio = std::min(worstVoiceMarkRatio,
+                                               ratio(scenario.voiceMark, baseline.voiceMark));
+            }
+        }
+        mResult->setMeasurement(worstVoiceMarkRatio);
+
+        report.addMetric(getName(), worstVoiceMarkRatio);
+        report.addMetric("interference.cpus", HostTools::formatCpuList(config.cpus));
+        report.addMetric("interference.fifo.priority", config.fifoPriority);
+        report.addMetric("interference.llc.bytes", cacheBytes);
+        for (const Scenario &scenario : mScenarios) {
+            if (!scenario.done) {
+                continue;
+            }
+            std::string prefix = std::string("interference.") + getScenarioName(scenario) + ".";
+            report.addMetric(prefix + "voice.mark", scenario.voiceMark);
+            report.addMetric(prefix + "latency.msec", scenario.latencyMillis);
+            report.addMetric(prefix + "wakeup.average.micros", scenario.wakeupAverageMicros);
+            report.addMetric(prefix + "wakeup.p99.micros", scenario.wakeupTailMicros);
+            report.addMetric(prefix + "jitter.underruns", scenario.jitterUnderruns);
+            if (scenario.type < 0) {
+                continue;
+            }
+            report.addMetric(prefix + "voice.mark.ratio",
+                             ratio(scenario.voiceMark, baseline.voiceMark));
+            report.addMetric(prefix + "latency.ratio",
+                             ratio(scenario.latencyMillis, baseline.latencyMillis));
+            report.addMetric(prefix + "antagonist.cpu.seconds", scenario.antagonistCpuSeconds);
+            if (Antagonist::usesMemory(scenario.type)) {
+                report.addMetric(prefix + "antagonist.mbytes.per.second",
+                                 scenario.antagonistMBytesPerSecond);
+            }
+            if (scenario.type == Antagonist::TYPE_FIFO) {
+                report.addMetric(prefix + "antagonist.promoted", scenario.antagonistsPromoted);
+            }
+        }
+
+        report << std::endl;
+        report.addHeading("Interference");
+        report.beginTable("   antagonist, voice.mark,  ratio, latency.msec, wakeup.avg.us,"
+                          " wakeup.p99.us, underruns");
+        for (const Scenario &scenario : mScenarios) {
+            if (!scenario.done) {
+                continue;
+            }
+            report.addCell(getScenarioName(scenario), 13);
+            report << std::fixed << std::setprecision(1);
+            report.addCell(scenario.voiceMark, 10);
+            report << std::setprecision(3);
+            report.addCell(ratio(scenario.voiceMark, baseline.voiceMark), 6);
+            report << std::setprecision(2);
+            report.addCell(scenario.latencyMillis, 12);
+            report.addCell(scenario.wakeupAverageMicros, 13);
+            report.addCell(scenario.wakeupTailMicros, 13);
+            report.addCell(scenario.jitterUnderruns, 9);
+            report.endRow();
+        }
+        report.endTable();
+        report << std::defaultfloat;
+        return report;
+    }
+
+    Config                mConfig;
+    double                mTargetCpuLoad = 0.5;
+    std::vector<Scenario> mScenarios;
+};
+
+#endif // SYNTHMARK_INTERFERENCE_MARK_HARNESS_H
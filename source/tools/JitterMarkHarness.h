@@ -17,6 +17,7 @@
 #ifndef SYNTHMARK_JITTERMARK_HARNESS_H
 #define SYNTHMARK_JITTERMARK_HARNESS_H
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <iomanip>
@@ -57,18 +58,37 @@ public:
     virtual void onEndMeasurement() override {
 
         double measurement = mAudioSink->getMaxEmptyFrames();
-        std::stringstream resultMessage;
-        resultMessage << mTestName << " = " << measurement << std::endl;
+        ResultReport report;
+        report.addMetric(mTestName, measurement);
 
-        resultMessage << dumpJitter();
-        resultMessage << "underrun.count = " << mAudioSink->getUnderrunCount() << "\n";
-        resultMessage << "underrun.skip.count = " << mAudioSink->getUnderrunSkipCount() << "\n";
-        resultMessage << "max.empty.frames = " << mAudioSink->getMaxEmptyFrames() << "\n";
-        resultMessage << "latency.required.msec = " << calculateRequiredLatencyMillis() << "\n";
-        resultMessage << mCpuAnalyzer.dump();
+        report << dumpJitter();
+        report.addMetric("underrun.count", mAudioSink->getUnderrunCount());
+        report.addMetric("underrun.skip.count", mAudioSink->getUnderrunSkipCount());
+        report.addMetric("max.empty.frames", mAudioSink->getMaxEmptyFrames());
+        report.addMetric("latency.required.msec", calculateRequiredLatencyMillis());
+        report << mCpuAnalyzer.dump();
 
         mResult->setMeasurement(measurement);
-        mResult->appendMessage(resultMessage.str());
+        mResult->appendReport(report);
+    }
+
+    double getAverageWakeupDelayMicros() {
+        int32_t numWakeups = std::max(1, mTimer.getCallCount() - 1); // first is not measured
+        return mTimer.getTotalWakeupDelayNanos()
+                / (double) (numWakeups * SYNTHMARK_NANOS_PER_MICROSECOND);
+    }
+
+    /**
+     * @param fraction eg. 0.99
+     * @return upper edge of the histogram bin that holds the fraction of the wakeups
+     */
+    double getWakeupDelayMicrosAtFraction(double fraction) {
+        BinCounter *bins = mTimer.getWakeupBins();
+        int32_t binIndex = (bins == nullptr) ? -1 : bins->findPercentileBin(fraction);
+        if (binIndex < 0) {
+            return 0.0;
+        }
+        return (double) (binIndex + 1) * mNanosPerBin / SYNTHMARK_NANOS_PER_MICROSECOND;
     }
 
 
@@ -45,26 +45,38 @@ public:
     }
 
     const char *getName() const override {
-        return "LatencyMark";
+        return mSearchEnabled ? "LatencySearch" : "LatencyMark";
     }
 
     void setInitialBursts(int32_t bursts) {
         mInitialBursts = bursts;
     }
 
+    /**
+     * Search for the smallest buffer size that survives progressively longer runs,
+     * instead of measuring the depth of the underruns in a single run.
+     * The duration of the test is then the glitch free time required at the final size.
+     */
+    void setSearchEnabled(bool enabled) {
+        mSearchEnabled = enabled;
+    }
+
     // Run the benchmark.
     int32_t runTest(int32_t sampleRate, int32_t framesPerBurst, int32_t numSeconds) override {
-        std::stringstream resultMessage;
-        int32_t result = measureLatencyInBursts(sampleRate, framesPerBurst, numSeconds);
+        ResultReport report;
+        mSearchReport.clear();
+        int32_t result = mSearchEnabled
+                ? searchLatencyInBursts(sampleRate, framesPerBurst, numSeconds)
+                : measureLatencyInBursts(sampleRate, framesPerBurst, numSeconds);
         if (result < 0) {
-            resultMessage << "ERROR in latency search = " << result << std::endl;
-            mResult->appendMessage(resultMessage.str());
+            report << "ERROR in latency search = " << result << std::endl;
+            mResult->appendReport(report);
             mResult->setResultCode(SYNTHMARK_RESULT_UNRECOVERABLE_ERROR);
             mResult->setMeasurement(0);
             return result;
         } else if (result >= BURSTS_OVER_RANGE) {
-            resultMessage << "ERROR - latency was too high to measure" << std::endl;
-            mResult->appendMessage(resultMessage.str());
+            report << "ERROR - latency was too high to measure" << std::endl;
+            mResult->appendReport(report);
             mResult->setResultCode(SYNTHMARK_RESULT_OUT_OF_RANGE);
             mResult->setMeasurement(0);
             return SYNTHMARK_RESULT_OUT_OF_RANGE;
@@ -74,18 +86,160 @@ public:
         int32_t sizeFrames = latencyBursts * framesPerBurst;
         double latencyMsec = 1000.0 * sizeFrames / getSampleRate();
 
-        resultMessage << "frames.per.burst     = " << getFramesPerBurst() << std::endl;
-        resultMessage << "# Latency values apply only to the top level buffer." << std::endl;
-        resultMessage << "audio.latency.bursts = " << latencyBursts << std::endl;
-        resultMessage << "audio.latency.frames = " << sizeFrames << std::endl;
-        resultMessage << "audio.latency.msec   = " << latencyMsec << std::endl;
-        mResult->appendMessage(resultMessage.str());
+        report.setMetricLayout(0, 20); // line up the " = "
+        report.addMetric("frames.per.burst", getFramesPerBurst());
+        report << "# Latency values apply only to the top level buffer." << std::endl;
+        report.addMetric("audio.latency.bursts", latencyBursts);
+        report.addMetric("audio.latency.frames", sizeFrames);
+        report.addMetric("audio.latency.msec", latencyMsec);
+        report.setMetricLayout(0, 0);
+        report << mSearchReport;
+        mResult->appendReport(report);
+
+        if (mSynthesizerSettings.pipelineWorkers > 0) {
+            result = comparePipelineWithSynchronous(sampleRate, framesPerBurst, numSeconds,
+                                                    latencyBursts);
+            if (result < 0) {
+                return result;
+            }
+        }
         mResult->setResultCode(SYNTHMARK_RESULT_SUCCESS);
         mResult->setMeasurement((double) sizeFrames);
         return 0;
     }
 
 private:
+    static constexpr int32_t kSearchFirstStageSeconds = 2;
+    static constexpr int32_t kSearchMaxBursts = 256;
+    static constexpr double  kSearchConfidence = 0.95;
+
+    /**
+     * Find the smallest buffer that does not glitch, then confirm it.
+     *
+     * A single run gives an initial estimate from the depth of the underruns.
+     * Short runs then bracket and binary search the size, stopping each run at the first
+     * underrun. The result is confirmed by runs that double in length until they
+     * add up to confirmSeconds. If a confirmation run glitches then the search
+     * continues one burst higher.
+     *
+     * @return latency in bursts or a negative error code or BURSTS_OVER_RANGE
+     */
+    int32_t searchLatencyInBursts(int32_t sampleRate, int32_t framesPerBurst,
+                                  int32_t confirmSeconds) {
+        mSearchRuns = 0;
+        mSearchTotalFrames = 0;
+        int32_t estimate = measureLatencyInBursts(sampleRate, framesPerBurst, confirmSeconds);
+        if (estimate < 0 || estimate >= BURSTS_OVER_RANGE) {
+            return estimate;
+        }
+        mSearchRuns++;
+        mSearchTotalFrames += getFrameCount();
+
+        const int32_t stageSeconds = std::min((int32_t) kSearchFirstStageSeconds, confirmSeconds);
+        int32_t glitchingBursts = 0; // largest size known to glitch
+        int32_t passingBursts = std::max(1, estimate);
+
+        // Grow until a short run passes.
+        int32_t result;
+        while ((result = verifyBursts(passingBursts, sampleRate, framesPerBurst, stageSeconds))
+               == 0) {
+            glitchingBursts = passingBursts;
+            passingBursts *= 2;
+            if (passingBursts > kSearchMaxBursts) {
+                return BURSTS_OVER_RANGE;
+            }
+        }
+        if (result < 0 || result == BURSTS_OVER_RANGE) {
+            return result;
+        }
+
+        // Binary search between the glitching and passing sizes.
+        while (passingBursts - glitchingBursts > 1) {
+            int32_t middle = (glitchingBursts + passingBursts) / 2;
+            result = verifyBursts(middle, sampleRate, framesPerBurst, stageSeconds);
+            if (result < 0 || result == BURSTS_OVER_RANGE) {
+                return result;
+            } else if (result > 0) {
+                passingBursts = middle;
+            } else {
+                glitchingBursts = middle;
+            }
+        }
+
+        // Confirm with runs that double in length.
+        int32_t confirmedSeconds = stageSeconds;
+        int32_t runSeconds = stageSeconds * 2;
+        while (confirmedSeconds < confirmSeconds) {
+            int32_t seconds = std::min(runSeconds, confirmSeconds - confirmedSeconds);
+            result = verifyBursts(passingBursts, sampleRate, framesPerBurst, seconds);
+            if (result < 0 || result == BURSTS_OVER_RANGE) {
+                return result;
+            } else if (result > 0) {
+                confirmedSeconds += seconds;
+                runSeconds *= 2;
+            } else {
+                glitchingBursts = passingBursts;
+                passingBursts++;
+                if (passingBursts > kSearchMaxBursts) {
+                    return BURSTS_OVER_RANGE;
+                }
+                // The new size must pass a short run before the longer ones.
+                confirmedSeconds = 0;
+                runSeconds = stageSeconds;
+            }
+        }
+
+        // With no glitches in N bursts, the upper bound on the probability of a glitch
+        // in each burst is 1 - (1 - confidence)^(1/N), which is about 3/N for 95%.
+        double confirmedBursts = (double) confirmedSeconds * sampleRate / framesPerBurst;
+        double probabilityBound = 1.0 - pow(1.0 - kSearchConfidence, 1.0 / confirmedBursts);
+        double rateBoundPerHour = -log(1.0 - kSearchConfidence) * 3600.0 / confirmedSeconds;
+        ResultReport searchReport;
+        searchReport.addMetric("search.runs", mSearchRuns);
+        searchReport.addMetric("search.total.seconds", (double) mSearchTotalFrames / sampleRate);
+        searchReport.addMetric("search.glitching.bursts", glitchingBursts);
+        searchReport.addMetric("search.confirmed.seconds", confirmedSeconds);
+        searchReport.addMetric("search.confidence", kSearchConfidence);
+        searchReport.addMetric("search.glitch.probability.per.burst.bound", probabilityBound);
+        searchReport.addMetric("search.glitch.rate.per.hour.bound", rateBoundPerHour);
+        mSearchReport = searchReport;
+        return passingBursts;
+    }
+
+    /**
+     * Run with a fixed buffer size until the end or the first underrun.
+     * @return 1 if there were no underruns, 0 if there was one, a negative error,
+     *         or BURSTS_OVER_RANGE if the sink could not be set to that size
+     */
+    int32_t verifyBursts(int32_t bursts, int32_t sampleRate, int32_t framesPerBurst,
+                         int32_t numSeconds) {
+        mLogTool.log("LatencySearch: #%d, %d seconds with bursts = %d ----\n",
+                     mSearchRuns + 1, numSeconds, bursts);
+        int32_t desiredSizeInFrames = bursts * framesPerBurst;
+        int32_t actualSize = mAudioSink->setBufferSizeInFrames(desiredSizeInFrames);
+        if (actualSize < desiredSizeInFrames) {
+            // Do not report a size that was never tested.
+            mLogTool.log("LatencySearch: requested buffer size %d, got %d\n",
+                         desiredSizeInFrames, actualSize);
+            return BURSTS_OVER_RANGE;
+        }
+        mAudioSink->setUnderrunCount(0);
+        setStopOnUnderrun(true);
+        int32_t err = ChangingVoiceHarness::runTest(sampleRate, framesPerBurst, numSeconds);
+        setStopOnUnderrun(false);
+        mSearchRuns++;
+        mSearchTotalFrames += getFrameCount();
+        if (err < 0) {
+            return err;
+        }
+        bool glitched = (mAudioSink->getUnderrunCount() > 0);
+        if (glitched) {
+            mLogTool.log("LatencySearch: glitch after %.2f seconds\n",
+                         (double) getFrameCount() / sampleRate);
+        }
+        return glitched ? 0 : 1;
+    }
+
     /**
      *
      * @param sampleRate
@@ -124,6 +278,44 @@ private:
 
         return measuredBursts;
     }
+    /**
+     * The pipeline adds a burst of latency but moves the voices off the audio thread,
+     * which may reduce the depth of the underruns.
+     * Measure again without the pipeline so the two can be compared.
+     */
+    int32_t comparePipelineWithSynchronous(int32_t sampleRate,
+                                           int32_t framesPerBurst,
+                                           int32_t numSeconds,
+                                           int32_t pipelineBufferBursts) {
+        ResultReport report;
+        ResultReport pipelineReport = dumpPipeline();
+        int32_t pipelineMaxEmptyFrames = mAudioSink->getMaxEmptyFrames();
+        int32_t pipelineUnderruns = mAudioSink->getUnderrunCount();
+
+        mLogTool.log("LatencyMark: measure again without the pipeline\n");
+        SynthesizerSettings savedSettings = mSynthesizerSettings;
+        mSynthesizerSettings.pipelineWorkers = 0;
+        int32_t syncBufferBursts = measureLatencyInBursts(sampleRate, framesPerBurst, numSeconds);
+        mSynthesizerSettings = savedSettings;
+        if (syncBufferBursts < 0) {
+            return syncBufferBursts;
+        }
+
+        int32_t pipelineLatencyBursts = RenderPipeline::kLatencyBursts;
+        int32_t pipelineTotalBursts = pipelineBufferBursts + pipelineLatencyBursts;
+        report << pipelineReport;
+        report.addMetric("pipeline.max.empty.frames", pipelineMaxEmptyFrames);
+        report.addMetric("pipeline.underruns", pipelineUnderruns);
+        report.addMetric("pipeline.total.latency.bursts", pipelineTotalBursts);
+        report.addMetric("sync.max.empty.frames", mAudioSink->getMaxEmptyFrames());
+        report.addMetric("sync.underruns", mAudioSink->getUnderrunCount());
+        report.addMetric("sync.total.latency.bursts", syncBufferBursts);
+        // Positive if the pipeline needs less total latency than the synchronous render.
+        report.addMetric("pipeline.saved.bursts", syncBufferBursts - pipelineTotalBursts);
+        mResult->appendReport(report);
+        return 0;
+    }
+
 /*
     int32_t measureOnce(int32_t sampleRate,
                         int32_t framesPerBurst,
@@ -132,6 +324,10 @@ private:
 */
 private:
     int32_t           mInitialBursts = kDefaultBufferSizeBursts;
+    bool              mSearchEnabled = false;
+    int32_t           mSearchRuns = 0;
+    int64_t           mSearchTotalFrames = 0;
+    ResultReport      mSearchReport;
 };
 
 #endif // SYNTHMARK_LATENCYMARK_HARNESS_H
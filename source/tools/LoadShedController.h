@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_LOAD_SHED_CONTROLLER_H
+#define SYNTHMARK_LOAD_SHED_CONTROLLER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+
+#include "ResultReport.h"
+#include "SynthMark.h"
+#include "synth/VoiceBase.h"
+
+/**
+ * Decide how much to degrade the synthesizer based on how long the last burst took to render.
+ *
+ * When a burst uses more than kHighLoad of the burst period the level goes up by one.
+ * At the top level it also asks for some releasing voices to be shed.
+ * After kRecoveryBursts in a row below kLowLoad the level goes down by one.
+ */
+class LoadShedController
+{
+public:
+    static constexpr double  kHighLoad = 0.75;
+    static constexpr double  kLowLoad = 0.40;
+    static constexpr int32_t kRecoveryBursts = 100;
+    static constexpr int32_t kShedDivisor = 8; // shed up to 1/8 of the voices at a time
+
+    LoadShedController() {
+        reset();
+    }
+
+    void reset() {
+        mLevel = kDegradationNone;
+        mQuietBursts = 0;
+        mShedRequested = false;
+        mEscalations = 0;
+        mVoicesShed = 0;
+        mMaxLevel = kDegradationNone;
+        for (int32_t i = 0; i <= kDegradationMax; i++) {
+            mBurstsAtLevel[i] = 0;
+        }
+    }
+
+    /**
+     * @param renderNanos time taken to render the last burst
+     * @param nanosPerBurst burst period
+     * @return degradation level to use for the next burst
+     */
+    int32_t onBurstRendered(int64_t renderNanos, int64_t nanosPerBurst) {
+        double load = (nanosPerBurst > 0) ? ((double) renderNanos / nanosPerBurst) : 0.0;
+        mShedRequested = false;
+        if (load > kHighLoad) {
+            mQuietBursts = 0;
+            if (mLevel < kDegradationMax) {
+                mLevel++;
+                mEscalations++;
+            }
+            if (mLevel >= kDegradationShedVoices) {
+                mShedRequested = true;
+            }
+        } else if (load < kLowLoad && mLevel > kDegradationNone) {
+            if (++mQuietBursts >= kRecoveryBursts) {
+                mLevel--;
+                mQuietBursts = 0;
+            }
+        } else {
+            mQuietBursts = 0;
+        }
+        mMaxLevel = std::max(mMaxLevel, mLevel);
+        mBurstsAtLevel[mLevel]++;
+        return mLevel;
+    }
+
+    /**
+     * @return true if the last call to onBurstRendered() asked for voices to be shed
+     */
+    bool isShedRequested() const {
+        return mShedRequested;
+    }
+
+    /**
+     * @return number of voices to shed out of the active voices
+     */
+    int32_t getNumVoicesToShed(int32_t numActiveVoices) const {
+        return std::max(1, numActiveVoices / kShedDivisor);
+    }
+
+    void addVoicesShed(int32_t numVoices) {
+        mVoicesShed += numVoices;
+    }
+
+    int32_t getLevel() const {
+        return mLevel;
+    }
+
+    int32_t getMaxLevel() const {
+        return mMaxLevel;
+    }
+
+    int32_t getVoicesShed() const {
+        return mVoicesShed;
+    }
+
+    ResultReport dump() {
+        ResultReport report;
+        int64_t totalBursts = 0;
+        for (int32_t i = 0; i <= kDegradationMax; i++) {
+            totalBursts += mBurstsAtLevel[i];
+        }
+        report.addMetric("degrade.escalations", mEscalations);
+        report.addMetric("degrade.max.level", mMaxLevel);
+        report.addMetric("degrade.voices.shed", mVoicesShed);
+        for (int32_t i = 0; i <= kDegradationMax; i++) {
+            double fraction = (totalBursts == 0) ? 0.0 : ((double) mBurstsAtLevel[i] / totalBursts);
+            report.addMetric("degrade.level." + std::to_string(i) + ".fraction", fraction);
+        }
+        return report;
+    }
+
+private:
+    int32_t mLevel = kDegradationNone;
+    int32_t mQuietBursts = 0;
+    bool    mShedRequested = false;
+    int32_t mEscalations = 0;
+    int32_t mVoicesShed = 0;
+    int32_t mMaxLevel = kDegradationNone;
+    int64_t mBurstsAtLevel[kDegradationMax + 1];
+};
+
+#endif // SYNTHMARK_LOAD_SHED_CONTROLLER_H
@@ -458,6 +458,8 @@ public:
     int run() override {
         createAudioSink();
         AutomatedTestSuite harness(mAudioSink.get(), &mResult, mLogTool);
+        int audioLevel = mParams.getValueFromInt(PARAMS_AUDIO_LEVEL);
+        harness.setConcurrentDomainsEnabled(audioLevel != AudioSinkBase::AUDIO_LEVEL_OUTPUT);
 
         return CommonNativeTestUnit::runTestHarness(harness);
     }
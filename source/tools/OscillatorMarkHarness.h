@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_OSCILLATORMARK_HARNESS_H
+#define SYNTHMARK_OSCILLATORMARK_HARNESS_H
+
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include "HostTools.h"
+#include "SynthMark.h"
+#include "SynthMarkResult.h"
+#include "synth/HalfBandDecimator.h"
+#include "synth/PulseOscillatorPolyBLEP.h"
+#include "synth/SawtoothOscillatorDPW.h"
+#include "synth/SawtoothOscillatorPolyBLEP.h"
+#include "synth/SquareOscillatorDPW.h"
+#include "synth/SquareOscillatorPolyBLEP.h"
+#include "synth/TriangleOscillatorPolyBLAMP.h"
+#include "synth/UnitGenerator.h"
+#include "tools/LogTool.h"
+#include "TestHarnessParameters.h"
+
+/**
+ * Measure the cost of each band limited oscillator in nanoseconds per sample.
+ * The oscillators are run directly, without an audio sink,
+ * so the result is not affected by scheduling.
+ * Each oscillator renders numVoices instances that sweep across
+ * the audio band so the cost of the discontinuity corrections is included.
+ * The half-band decimator used for oversampled voices is also measured.
+ */
+class OscillatorMarkHarness : public TestHarnessParameters {
+public:
+    OscillatorMarkHarness(AudioSinkBase *audioSink, SynthMarkResult *result, LogTool &logTool)
+    : TestHarnessParameters(audioSink, result, logTool) {
+    }
+
+    virtual ~OscillatorMarkHarness() = default;
+
+    const char *getName() const override {
+        return "OscillatorMark";
+    }
+
+    // There is no audio sink to dump so do not call the base class.
+    int32_t runCompleteTest(int32_t sampleRate,
+                            int32_t framesPerBurst,
+                            int32_t numSeconds) override {
+        mResult->appendMessage("\n" TEXT_RESULTS_BEGIN "\n");
+        startTelemetry(sampleRate, framesPerBurst);
+        int32_t result = runTest(sampleRate, framesPerBurst, numSeconds);
+        stopTelemetry();
+        mResult->appendMessage(TEXT_RESULTS_END "\n");
+        mRunning = false;
+        return result;
+    }
+
+    int32_t runTest(int32_t sampleRate, int32_t framesPerBurst, int32_t numSeconds) override {
+        (void) framesPerBurst;
+        mResult->setTestName(getName());
+        mLogTool.log("---- Starting %s ----\n", getName());
+        UnitGenerator::setSampleRate(sampleRate);
+        int32_t numVoices = std::max(1, getNumVoices());
+        int64_t numBlocks = ((int64_t) numSeconds * sampleRate) / kSynthmarkFramesPerRender;
+
+        double sawDPW = measure<SawtoothOscillatorDPW>(numVoices, numBlocks);
+        double sawPolyBLEP = measure<SawtoothOscillatorPolyBLEP>(numVoices, numBlocks);
+        double squareDPW = measure<SquareOscillatorDPW>(numVoices, numBlocks);
+        double squarePolyBLEP = measure<SquareOscillatorPolyBLEP>(numVoices, numBlocks);
+        double pulsePolyBLEP = measurePulseWidthModulation(numVoices, numBlocks);
+        double trianglePolyBLAMP = measure<TriangleOscillatorPolyBLAMP>(numVoices, numBlocks);
+        double halfBand = measureHalfBandDecimator(numVoices, numBlocks);
+
+        ResultReport report;
+        report << std::setprecision(3);
+        report.addMetric("osc.voices", numVoices);
+        report.addMetric("osc.samples.per.voice", numBlocks * kSynthmarkFramesPerRender);
+        report.addMetric("osc.saw.dpw.ns.per.sample", sawDPW);
+        report.addMetric("osc.saw.polyblep.ns.per.sample", sawPolyBLEP);
+        report.addMetric("osc.square.dpw.ns.per.sample", squareDPW);
+        report.addMetric("osc.square.polyblep.ns.per.sample", squarePolyBLEP);
+        report.addMetric("osc.pulse.pwm.polyblep.ns.per.sample", pulsePolyBLEP);
+        report.addMetric("osc.triangle.polyblamp.ns.per.sample", trianglePolyBLAMP);
+        report.addMetric("osc.halfband.ns.per.output", halfBand);
+        // A ratio above 1.0 means PolyBLEP is cheaper than DPW.
+        report.addMetric("osc.saw.dpw.over.polyblep", sawDPW / sawPolyBLEP);
+        report.addMetric("osc.square.dpw.over.polyblep", squareDPW / squarePolyBLEP);
+
+        mResult->setMeasurement(sawDPW / sawPolyBLEP);
+        mResult->setResultCode(SYNTHMARK_RESULT_SUCCESS);
+        mResult->appendReport(report);
+        return SYNTHMARK_RESULT_SUCCESS;
+    }
+
+private:
+    static constexpr synth_float_t kLowFrequency = 50.0;
+    static constexpr synth_float_t kHighFrequency = 5000.0;
+
+    /**
+     * Fill the buffer with an exponential sweep that depends on the voice and block index.
+     */
+    static void fillFrequencies(synth_float_t *frequencies, int32_t voiceIndex, int64_t blockIndex) {
+        const int64_t kBlocksPerSweep = 1024;
+        synth_float_t position = (((blockIndex + (voiceIndex * 97)) % kBlocksPerSweep)
+                / (synth_float_t) kBlocksPerSweep);
+        synth_float_t frequency = kLowFrequency * powf(kHighFrequency / kLowFrequency, position);
+        for (int i = 0; i < kSynthmarkFramesPerRender; i++) {
+            frequencies[i] = frequency;
+        }
+    }
+
+    /**
+     * @return nanoseconds per sample
+     */
+    template <class OSCILLATOR>
+    double measure(int32_t numVoices, int64_t numBlocks) {
+        std::vector<OSCILLATOR> oscillators(numVoices);
+        synth_float_t frequencies[kSynthmarkFramesPerRender];
+        synth_float_t sum = 0.0;
+        int64_t startNanos = HostTools::getNanoTime();
+        for (int64_t block = 0; block < numBlocks; block++) {
+            for (int32_t iv = 0; iv < numVoices; iv++) {
+                fillFrequencies(frequencies, iv, block);
+                oscillators[iv].generate(frequencies, kSynthmarkFramesPerRender);
+                sum += oscillators[iv].output[0];
+            }
+        }
+        int64_t elapsedNanos = HostTools::getNanoTime() - startNanos;
+        mCheckSum += sum; // so the compiler cannot remove the loop
+        return nanosPerSample(elapsedNanos, numVoices, numBlocks);
+    }
+
+    double measurePulseWidthModulation(int32_t numVoices, int64_t numBlocks) {
+        std::vector<PulseOscillatorPolyBLEP> oscillators(numVoices);
+        synth_float_t frequencies[kSynthmarkFramesPerRender];
+        synth_float_t widths[kSynthmarkFramesPerRender];
+        synth_float_t sum = 0.0;
+        int64_t startNanos = HostTools::getNanoTime();
+        for (int64_t block = 0; block < numBlocks; block++) {
+            // Slowly sweep the pulse width.
+            synth_float_t width = 0.1f + (0.8f * ((block % 256) / 256.0f));
+            for (int i = 0; i < kSynthmarkFramesPerRender; i++) {
+                widths[i] = width;
+            }
+            for (int32_t iv = 0; iv < numVoices; iv++) {
+                fillFrequencies(frequencies, iv, block);
+                oscillators[iv].generate(frequencies, widths, kSynthmarkFramesPerRender);
+                sum += oscillators[iv].output[0];
+            }
+        }
+        int64_t elapsedNanos = HostTools::getNanoTime() - startNanos;
+        mCheckSum += sum;
+        return nanosPerSample(elapsedNanos, numVoices, numBlocks);
+    }
+
+    /**
+     * @return nanoseconds per output sample for one 2:1 stage
+     */
+    double measureHalfBandDecimator(int32_t numVoices, int64_t numBlocks) {
+        std::vector<HalfBandDecimator> decimators(numVoices);
+        synth_float_t input[2 * kSynthmarkFramesPerRender];
+        synth_float_t output[kSynthmarkFramesPerRender];
+        SawtoothOscillatorPolyBLEP source;
+        synth_float_t frequencies[kSynthmarkFramesPerRender];
+        for (int i = 0; i < kSynthmarkFramesPerRender; i++) {
+            frequencies[i] = 440.0f;
+        }
+        source.generate(frequencies, kSynthmarkFramesPerRender);
+        memcpy(input, source.output, kSynthmarkFramesPerRender * sizeof(synth_float_t));
+        memcpy(&input[kSynthmarkFramesPerRender], source.output,
+               kSynthmarkFramesPerRender * sizeof(synth_float_t));
+        synth_float_t sum = 0.0;
+        int64_t startNanos = HostTools::getNanoTime();
+        for (int64_t block = 0; block < numBlocks; block++) {
+            for (int32_t iv = 0; iv < numVoices; iv++) {
+                decimators[iv].process(input, output, kSynthmarkFramesPerRender);
+                sum += output[0];
+            }
+        }
+        int64_t elapsedNanos = HostTools::getNanoTime() - startNanos;
+        mCheckSum += sum;
+        return nanosPerSample(elapsedNanos, numVoices, numBlocks);
+    }
+
+    static double nanosPerSample(int64_t elapsedNanos, int32_t numVoices, int64_t numBlocks) {
+        double numSamples = (double) numVoices * numBlocks * kSynthmarkFramesPerRender;
+        return (numSamples > 0) ? (elapsedNanos / numSamples) : 0.0;
+    }
+
+    synth_float_t mCheckSum = 0.0;
+};
+
+#endif // SYNTHMARK_OSCILLATORMARK_HARNESS_H
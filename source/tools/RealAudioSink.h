@@ -18,6 +18,7 @@
 #define SYNTHMARK_REAL_AUDIO_SINK_H
 
 #include <cstdint>
+#include <cstring>
 #include <ctime>
 #include <memory>
 #include <unistd.h>
@@ -148,7 +149,18 @@ public:
             void *audioData,
             int32_t numFrames) {
 
-        if (mCallbackCount == 0 && isAdpfEnabled()) {
+        // The stack of the callback thread can only be touched from the callback.
+        // So the first callback just prefaults and outputs silence, and the
+        // page faults are counted from the second callback.
+        if (mCallbackCount == 0 && HostTools::isMemoryLocked()) {
+            HostTools::prefaultStack();
+            memset(audioData, 0, numFrames * mSamplesPerFrame * sizeof(float));
+            mCallbackCount++;
+            return AAUDIO_CALLBACK_RESULT_CONTINUE;
+        }
+
+        bool isFirstRender = (mCallbackCount == (HostTools::isMemoryLocked() ? 1 : 0));
+        if (isFirstRender && isAdpfEnabled()) {
             int64_t targetDurationNanos = (mFramesPerBurst * 1e9) / getSampleRate();
             // This has to be called from the callback thread so we get the right TID.
             int adpfResult = mAdpfWrapper.open(gettid(), targetDurationNanos);
@@ -160,6 +172,12 @@ public:
                 mUseADPF = true;
             }
         }
+        if (isFirstRender) {
+            if (getCallback() != NULL) {
+                getCallback()->onBeginAudioThread();
+            }
+            beginPageFaultCount();
+        }
         int64_t beginCallback = HostTools::getNanoTime();
 
         aaudio_data_callback_result_t aaudioCallbackResult = AAUDIO_CALLBACK_RESULT_CONTINUE;
@@ -185,6 +203,7 @@ public:
                     mFramesPerBurst);
             if (callbackResult != IAudioSinkCallback::Result::Continue) {
                 aaudioCallbackResult = AAUDIO_CALLBACK_RESULT_STOP;
+                endPageFaultCount();
                 mThreadDone = true;
             }
 
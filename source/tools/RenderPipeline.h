@@ -0,0 +1,311 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_RENDER_PIPELINE_H
+#define SYNTHMARK_RENDER_PIPELINE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string.h>
+#include <vector>
+
+#include "AudioSinkBase.h"
+#include "HostThreadFactory.h"
+#include "HostTools.h"
+#include "SynthMark.h"
+#include "synth/Synthesizer.h"
+
+/**
+ * Render the voices for the next burst on worker threads while the
+ * audio thread mixes and delivers the current burst.
+ *
+ * The voices are split evenly between the workers. Each worker mixes its voices
+ * into its own stereo buffer so no locks are needed. There are two sets of buffers.
+ * The audio thread reads the front set while the workers write the back set.
+ *
+ * On each callback the audio thread must:
+ *   1. call waitForVoices(), after which it may turn notes on and off,
+ *   2. call renderStereo(), which outputs the front buffers and starts the next burst.
+ *
+ * This adds one burst of latency.
+ *
+ * Each worker records when it started and finished rendering. The time from the first
+ * start to the last finish is the cost of rendering the voices for a burst. It is the
+ * longest render when the workers run in parallel and the sum when they share a CPU.
+ * It is reported with that burst by getOutputRenderNanos().
+ */
+class RenderPipeline
+{
+public:
+    static constexpr int32_t kMaxWorkers = 8;
+    static constexpr int32_t kLatencyBursts = 1; // added by the double buffer
+
+    explicit RenderPipeline(Synthesizer &synth)
+    : mSynth(synth) {}
+
+    virtual ~RenderPipeline() {
+        stop();
+    }
+
+    /**
+     * Allocate the buffers and start the worker threads.
+     * @return 0 on success or a negative error
+     */
+    int32_t start(int32_t numWorkers, int32_t maxFramesPerBurst, bool useSchedFifo) {
+        if (numWorkers < 1 || numWorkers > kMaxWorkers) {
+            return -1;
+        }
+        mNumWorkers = numWorkers;
+        mMaxFrames = maxFramesPerBurst;
+        mUseSchedFifo = useSchedFifo;
+        mSamplesPerWorker = maxFramesPerBurst * SAMPLES_PER_FRAME;
+        mBuffers.assign(2 * numWorkers * mSamplesPerWorker, 0.0f);
+        mFramesInBuffer[0] = mFramesInBuffer[1] = 0;
+        mRenderNanos[0] = mRenderNanos[1] = 0;
+        mOutputRenderNanos = 0;
+        mFrontIndex = 0;
+        mRequestedFrames = 0;
+        mInFlight = false;
+        mQuit = false;
+        mStartSequence.store(0);
+        mDoneCount.store(0);
+        resetStatistics();
+
+        for (int32_t i = 0; i < numWorkers; i++) {
+            mWorkerArgs[i].pipeline = this;
+            mWorkerArgs[i].index = i;
+            mWorkers[i].reset(HostThreadFactory::createThread(
+                    HostThreadFactory::ThreadType::Default));
+            int err = mWorkers[i]->start(workerProc, &mWorkerArgs[i]);
+            if (err != 0) {
+                mWorkers[i].reset();
+                stop();
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * Wait for any burst in progress and then join the workers.
+     */
+    void stop() {
+        waitForVoices();
+        mQuit = true;
+        mStartSequence.increment();
+        mStartSequence.wakeAll();
+        for (int32_t i = 0; i < kMaxWorkers; i++) {
+            if (mWorkers[i]) {
+                mWorkers[i]->join();
+                mWorkers[i].reset();
+            }
+        }
+    }
+
+    /**
+     * Block until the workers have finished the burst that was started
+     * by the last call to renderStereo(). The voices are then idle.
+     */
+    void waitForVoices() {
+        if (!mInFlight) {
+            return;
+        }
+        int64_t startNanos = HostTools::getNanoTime();
+        int32_t done;
+        while ((done = mDoneCount.load()) < mNumWorkers) {
+            mDoneCount.waitWhileEqual(done);
+        }
+        int64_t waitNanos = HostTools::getNanoTime() - startNanos;
+        mWaitCount++;
+        mTotalWaitNanos += waitNanos;
+        mMaxWaitNanos = std::max(mMaxWaitNanos, waitNanos);
+
+        mInFlight = false;
+        mFrontIndex = 1 - mFrontIndex;
+        mFramesInBuffer[mFrontIndex] = mRequestedFrames;
+        int64_t firstStart = mWorkerStartNanos[0];
+        int64_t lastFinish = mWorkerFinishNanos[0];
+        for (int32_t w = 1; w < mNumWorkers; w++) {
+            firstStart = std::min(firstStart, mWorkerStartNanos[w]);
+            lastFinish = std::max(lastFinish, mWorkerFinishNanos[w]);
+        }
+        mRenderNanos[mFrontIndex] = lastFinish - firstStart;
+    }
+
+    /**
+     * Write the voices rendered during the previous callback
+     * and start rendering the voices for the next callback.
+     */
+    void renderStereo(float *output, int32_t numFrames) {
+        assert(!mInFlight);
+        int32_t framesInFront = mFramesInBuffer[mFrontIndex];
+        mOutputRenderNanos = 0;
+        if (framesInFront == 0) {
+            // Nothing has been rendered yet.
+            memset(output, 0, numFrames * SAMPLES_PER_FRAME * sizeof(float));
+        } else if (framesInFront != numFrames) {
+            // The burst size changed so render this one synchronously.
+            mSynth.renderStereo(output, numFrames);
+            mMismatchCount++;
+        } else {
+            mOutputRenderNanos = mRenderNanos[mFrontIndex];
+            int32_t numSamples = numFrames * SAMPLES_PER_FRAME;
+            memcpy(output, getBuffer(mFrontIndex, 0), numSamples * sizeof(float));
+            for (int32_t w = 1; w < mNumWorkers; w++) {
+                const float *partial = getBuffer(mFrontIndex, w);
+                for (int32_t i = 0; i < numSamples; i++) {
+                    output[i] += partial[i];
+                }
+            }
+        }
+
+        if (numFrames > mMaxFrames) {
+            // Too big for the buffers so the next burst will start from silence.
+            mFramesInBuffer[mFrontIndex] = 0;
+            return;
+        }
+        mRequestedFrames = numFrames;
+        mDoneCount.store(0);
+        mInFlight = true;
+        mStartSequence.increment();
+        mStartSequence.wakeAll();
+    }
+
+    /**
+     * @return time the workers took to render the burst that finished in the last
+     *         waitForVoices(), which will be output by the next renderStereo()
+     */
+    int64_t getLastRenderNanos() const {
+        return mRenderNanos[mFrontIndex];
+    }
+
+    /**
+     * @return time the workers took to render the voices output by the last renderStereo(),
+     *         or 0 if they were rendered by the audio thread or not at all
+     */
+    int64_t getOutputRenderNanos() const {
+        return mOutputRenderNanos;
+    }
+
+    /**
+     * @return extra latency added by the pipeline
+     */
+    int32_t getLatencyBursts() const {
+        return kLatencyBursts;
+    }
+
+    int32_t getNumWorkers() const {
+        return mNumWorkers;
+    }
+
+    void resetStatistics() {
+        mWaitCount = 0;
+        mTotalWaitNanos = 0;
+        mMaxWaitNanos = 0;
+        mMismatchCount = 0;
+    }
+
+    ResultReport dump() {
+        ResultReport report;
+        double averageWaitMicros = (mWaitCount == 0) ? 0.0
+                : (double) mTotalWaitNanos / (mWaitCount * SYNTHMARK_NANOS_PER_MICROSECOND);
+        report.addMetric("pipeline.workers", mNumWorkers);
+        report.addMetric("pipeline.latency.bursts", getLatencyBursts());
+        report.addMetric("pipeline.wait.average.micros", averageWaitMicros);
+        report.addMetric("pipeline.wait.max.micros",
+                         (double) mMaxWaitNanos / SYNTHMARK_NANOS_PER_MICROSECOND);
+        report.addMetric("pipeline.sync.fallbacks", mMismatchCount);
+        return report;
+    }
+
+private:
+    struct WorkerArgs {
+        RenderPipeline *pipeline = nullptr;
+        int32_t         index = 0;
+    };
+
+    static void *workerProc(void *arg) {
+        WorkerArgs *workerArgs = (WorkerArgs *) arg;
+        workerArgs->pipeline->workerLoop(workerArgs->index);
+        return nullptr;
+    }
+
+    void workerLoop(int32_t workerIndex) {
+        if (mUseSchedFifo) {
+            // Failure is not fatal. The workers will just be less responsive.
+            (void) mWorkers[workerIndex]->promote(SYNTHMARK_THREAD_PRIORITY_DEFAULT);
+        }
+        int32_t sequence = 0;
+        while (true) {
+            mStartSequence.waitWhileEqual(sequence);
+            sequence = mStartSequence.load();
+            if (mQuit) {
+                break;
+            }
+            int32_t numActive = mSynth.getActiveVoiceCount();
+            int32_t firstVoice = (workerIndex * numActive) / mNumWorkers;
+            int32_t endVoice = ((workerIndex + 1) * numActive) / mNumWorkers;
+            int32_t backIndex = 1 - mFrontIndex;
+            mWorkerStartNanos[workerIndex] = HostTools::getNanoTime();
+            mSynth.renderVoices(firstVoice, endVoice - firstVoice,
+                                getBuffer(backIndex, workerIndex), mRequestedFrames);
+            mWorkerFinishNanos[workerIndex] = HostTools::getNanoTime();
+            if (mDoneCount.increment() == mNumWorkers) {
+                mDoneCount.wakeAll();
+            }
+        }
+    }
+
+    float *getBuffer(int32_t bufferIndex, int32_t workerIndex) {
+        return &mBuffers[((bufferIndex * mNumWorkers) + workerIndex) * mSamplesPerWorker];
+    }
+
+    Synthesizer           &mSynth;
+    std::unique_ptr<HostThread> mWorkers[kMaxWorkers];
+    WorkerArgs             mWorkerArgs[kMaxWorkers];
+    std::vector<float>     mBuffers;
+    int32_t                mNumWorkers = 0;
+    int32_t                mMaxFrames = 0;
+    int32_t                mSamplesPerWorker = 0;
+    bool                   mUseSchedFifo = false;
+
+    // Written by the audio thread only while the workers are idle.
+    int32_t                mFrontIndex = 0;
+    int32_t                mFramesInBuffer[2] = {0, 0};
+    int64_t                mRenderNanos[2] = {0, 0};
+    int64_t                mOutputRenderNanos = 0;
+    int32_t                mRequestedFrames = 0;
+    bool                   mInFlight = false;
+    std::atomic<bool>      mQuit{false};
+
+    // Written by each worker before it signals that it is done.
+    int64_t                mWorkerStartNanos[kMaxWorkers] = {};
+    int64_t                mWorkerFinishNanos[kMaxWorkers] = {};
+
+    HostFutex              mStartSequence;
+    HostFutex              mDoneCount;
+
+    int32_t                mWaitCount = 0;
+    int64_t                mTotalWaitNanos = 0;
+    int64_t                mMaxWaitNanos = 0;
+    int32_t                mMismatchCount = 0;
+};
+
+#endif // SYNTHMARK_RENDER_PIPELINE_H
@@ -0,0 +1,400 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_REPEATED_TEST_HARNESS_H
+#define SYNTHMARK_REPEATED_TEST_HARNESS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SynthMark.h"
+#include "SynthMarkResult.h"
+#include "tools/LogTool.h"
+#include "TestHarnessBase.h"
+#include "TestHarnessParameters.h"
+
+/**
+ * Statistics for a small number of repeated measurements.
+ */
+class TrialStatistics {
+public:
+    static constexpr int32_t kBootstrapResamples = 2000;
+    static constexpr double  kConfidenceLevel = 0.95;
+    // Modified z-score above which a trial is an outlier, from Iglewicz and Hoaglin.
+    static constexpr double  kOutlierScore = 3.5;
+    // MSER is not meaningful for fewer values than this.
+    static constexpr int32_t kMinMserValues = 4;
+
+    /**
+     * Find the end of the warm-up with the Marginal Standard Error Rule (MSER).
+     * The truncation d minimizes the squared standard error of the mean of x[d..n).
+     * At most half of the data is truncated.
+     *
+     * @return number of leading values to discard
+     */
+    static int32_t findWarmupMser(const std::vector<double> &x) {
+        int32_t n = (int32_t) x.size();
+        if (n < kMinMserValues) {
+            return 0;
+        }
+        // Accumulate the sums of x[d..n) from the end so each truncation costs O(1).
+        // The values are shifted by the last one to keep the subtraction accurate.
+        double offset = x[n - 1];
+        double sum = 0.0;
+        double sumSquares = 0.0;
+        int32_t bestD = 0;
+        double bestMser = -1.0;
+        for (int32_t d = n - 1; d >= 0; d--) {
+            double value = x[d] - offset;
+            sum += value;
+            sumSquares += value * value;
+            if (d > n / 2) {
+                continue;
+            }
+            double count = n - d;
+            double mser = std::max(0.0, sumSquares - sum * sum / count) / (count * count);
+            if (bestMser < 0.0 || mser <= bestMser) {
+                bestMser = mser;
+                bestD = d;
+            }
+        }
+        return bestD;
+    }
+
+    static double median(std::vector<double> x) {
+        if (x.empty()) {
+            return 0.0;
+        }
+        std::sort(x.begin(), x.end());
+        size_t middle = x.size() / 2;
+        return (x.size() % 2) ? x[middle] : 0.5 * (x[middle - 1] + x[middle]);
+    }
+
+    /**
+     * @return true for each value whose modified z-score, based on the
+     *         median absolute deviation, is above kOutlierScore
+     */
+    static std::vector<bool> findOutliers(const std::vector<double> &x) {
+        std::vector<bool> outliers(x.size(), false);
+        double center = median(x);
+        std::vector<double> deviations;
+        for (double value : x) {
+            deviations.push_back(std::fabs(value - center));
+        }
+        double mad = median(deviations);
+        if (mad <= 0.0) {
+            return outliers;
+        }
+        for (size_t i = 0; i < x.size(); i++) {
+            outliers[i] = (0.6745 * deviations[i] / mad) > kOutlierScore;
+        }
+        return outliers;
+    }
+
+    static double mean(const std::vector<double> &x) {
+        double sum = 0.0;
+        for (double value : x) sum += value;
+        return x.empty() ? 0.0 : sum / x.size();
+    }
+
+    // Sample standard deviation.
+    static double stdev(const std::vector<double> &x) {
+        if (x.size() < 2) {
+            return 0.0;
+        }
+        double average = mean(x);
+        double sumSquares = 0.0;
+        for (double value : x) sumSquares += (value - average) * (value - average);
+        return std::sqrt(sumSquares / (x.size() - 1));
+    }
+
+    /**
+     * Percentile bootstrap confidence interval of the median.
+     * A fixed seed makes the interval repeatable for the same data.
+     */
+    static void bootstrapMedian(const std::vector<double> &x, double *low, double *high) {
+        *low = *high = median(x);
+        if (x.size() < 2) {
+            return;
+        }
+        std::mt19937 generator(kBootstrapSeed);
+        std::uniform_int_distribution<size_t> pick(0, x.size() - 1);
+        std::vector<double> medians(kBootstrapResamples);
+        std::vector<double> sample(x.size());
+        for (int32_t i = 0; i < kBootstrapResamples; i++) {
+            for (size_t j = 0; j < x.size(); j++) {
+                sample[j] = x[pick(generator)];
+            }
+            medians[i] = median(sample);
+        }
+        std::sort(medians.begin(), medians.end());
+        double tail = (1.0 - kConfidenceLevel) / 2.0;
+        *low = medians[(size_t) (tail * (kBootstrapResamples - 1))];
+        *high = medians[(size_t) ((1.0 - tail) * (kBootstrapResamples - 1))];
+    }
+
+private:
+    static constexpr uint32_t kBootstrapSeed = 12345;
+};
+
+/**
+ * Run another test several times and report the median of its measurement.
+ *
+ * The warm-up is found from the data with MSER, instead of a fixed delay.
+ * It is searched for in the render time of each note on and off cycle of every trial,
+ * and a trial whose timing had not settled by the middle of the run is a warm-up trial.
+ * It is also searched for across the measurements of the trials.
+ * Outliers are rejected with the median absolute deviation.
+ * The report includes a bootstrap confidence interval of the median and
+ * the coefficient of variation, so a change can be compared with the noise.
+ * The detailed report of the last trial is kept.
+ */
+class RepeatedTestHarness : public TestHarnessParameters {
+public:
+    /**
+     * @param harness test to repeat, it must write into the same result, takes ownership
+     */
+    RepeatedTestHarness(TestHarnessParameters *harness,
+                        int32_t numTrials,
+                        AudioSinkBase *audioSink,
+                        SynthMarkResult *result,
+                        LogTool &logTool)
+    : TestHarnessParameters(audioSink, result, logTool)
+    , mHarness(harness)
+    , mNumTrials(numTrials) {
+        mName = std::string(harness->getName()) + " Repeated";
+    }
+
+    virtual ~RepeatedTestHarness() = default;
+
+    const char *getName() const override {
+        return mName.c_str();
+    }
+
+    void setNumVoices(int32_t numVoices) override {
+        TestHarnessParameters::setNumVoices(numVoices);
+        mHarness->setNumVoices(numVoices);
+    }
+
+    void setDelayNoteOnSeconds(int32_t seconds) override {
+        TestHarnessParameters::setDelayNoteOnSeconds(seconds);
+        mHarness->setDelayNoteOnSeconds(seconds);
+    }
+
+    void setThreadType(HostThreadFactory::ThreadType threadType) override {
+        TestHarnessParameters::setThreadType(threadType);
+        mHarness->setThreadType(threadType);
+    }
+
+    void setSynthesizerSettings(const SynthesizerSettings &settings) override {
+        TestHarnessParameters::setSynthesizerSettings(settings);
+        mHarness->setSynthesizerSettings(settings);
+    }
+
+    int32_t runTest(int32_t sampleRate, int32_t framesPerBurst, int32_t numSeconds) override {
+        // Keep what was written before the trials, eg. TEXT_RESULTS_BEGIN.
+        ResultReport header = mResult->getReport();
+        ResultReport lastReport;
+        mMeasurements.clear();
+        mResultCodes.clear();
+        mWarmupCycles.clear();
+        mNumCycles.clear();
+        mSteadyRenderMicros.clear();
+        int32_t result = SYNTHMARK_RESULT_SUCCESS;
+        for (int32_t trial = 0; trial < mNumTrials; trial++) {
+            if (TestHarnessBase::isCancelled()) {
+                result = SYNTHMARK_RESULT_CANCELLED;
+                break;
+            }
+            mLogTool.log("---- trial %d of %d ----\n", trial + 1, mNumTrials);
+            mResult->reset();
+            int32_t trialResult = mHarness->runTest(sampleRate, framesPerBurst, numSeconds);
+            mMeasurements.push_back(mResult->getMeasurement());
+            mResultCodes.push_back(trialResult);
+            std::vector<double> cycles = mHarness->getCycleRenderNanos();
+            mNumCycles.push_back((int32_t) cycles.size());
+            int32_t warmupCycles = TrialStatistics::findWarmupMser(cycles);
+            mWarmupCycles.push_back(warmupCycles);
+            // Truncate the samples of the trial at its own warm-up.
+            std::vector<double> steadyCycles(cycles.begin() + warmupCycles, cycles.end());
+            mSteadyRenderMicros.push_back(TrialStatistics::mean(steadyCycles)
+                                          / SYNTHMARK_NANOS_PER_MICROSECOND);
+            lastReport = mResult->getReport();
+            mLogTool.log("trial %d measured %g\n", trial + 1, mResult->getMeasurement());
+        }
+        mResult->reset();
+        mResult->appendReport(header);
+        mResult->appendReport(lastReport);
+        mResult->appendReport(analyze());
+        if (result == SYNTHMARK_RESULT_SUCCESS && mNumAccepted == 0) {
+            result = SYNTHMARK_RESULT_TOO_FEW_MEASUREMENTS;
+        }
+        mResult->setResultCode(result);
+        return result;
+    }
+
+private:
+    enum TrialStatus {
+        TRIAL_ACCEPTED,
+        TRIAL_WARMUP,
+        TRIAL_OUTLIER,
+        TRIAL_FAILED,
+    };
+
+    static const char *getStatusName(TrialStatus status) {
+        switch (status) {
+            case TRIAL_ACCEPTED: return "accepted";
+            case TRIAL_WARMUP: return "warmup";
+            case TRIAL_OUTLIER: return "outlier";
+            case TRIAL_FAILED: return "failed";
+        }
+        return "unknown";
+    }
+
+    /**
+     * @return true if the render time of the trial settled in its first half,
+     *         false if it did not or there were too few cycles to tell
+     */
+    bool isTrialSettled(size_t trial) const {
+        return mNumCycles[trial] >= TrialStatistics::kMinMserValues
+                && mWarmupCycles[trial] < mNumCycles[trial] / 2;
+    }
+
+    bool hasCycles(size_t trial) const {
+        return mNumCycles[trial] >= TrialStatistics::kMinMserValues;
+    }
+
+    ResultReport analyze() {
+        size_t numTrials = mMeasurements.size();
+        std::vector<TrialStatus> status(numTrials, TRIAL_ACCEPTED);
+
+        // Only use the trials that succeeded.
+        std::vector<size_t> valid;
+        for (size_t i = 0; i < numTrials; i++) {
+            if (mResultCodes[i] == SYNTHMARK_RESULT_SUCCESS) {
+                valid.push_back(i);
+            } else {
+                status[i] = TRIAL_FAILED;
+            }
+        }
+        std::vector<double> series;
+        for (size_t i : valid) series.push_back(mMeasurements[i]);
+
+        int32_t numWarmup = TrialStatistics::findWarmupMser(series);
+        // The leading trials whose own timing never settled were still warming up.
+        // At least half of the trials are kept.
+        int32_t numUnsettled = 0;
+        while (numUnsettled < (int32_t) valid.size() / 2
+                && hasCycles(valid[numUnsettled])
+                && !isTrialSettled(valid[numUnsettled])) {
+            numUnsettled++;
+        }
+        numWarmup = std::max(numWarmup, numUnsettled);
+        int32_t maxWarmupCycles = 0;
+        for (size_t i : valid) {
+            maxWarmupCycles = std::max(maxWarmupCycles, mWarmupCycles[i]);
+        }
+        for (int32_t i = 0; i < numWarmup; i++) {
+            status[valid[i]] = TRIAL_WARMUP;
+        }
+        std::vector<double> steady(series.begin() + numWarmup, series.end());
+        std::vector<bool> outliers = TrialStatistics::findOutliers(steady);
+        std::vector<double> accepted;
+        std::vector<double> acceptedRenderMicros;
+        int32_t numOutliers = 0;
+        for (size_t i = 0; i < steady.size(); i++) {
+            size_t trial = valid[numWarmup + i];
+            if (outliers[i]) {
+                status[trial] = TRIAL_OUTLIER;
+                numOutliers++;
+            } else {
+                accepted.push_back(steady[i]);
+                if (mNumCycles[trial] > 0) {
+                    acceptedRenderMicros.push_back(mSteadyRenderMicros[trial]);
+                }
+            }
+        }
+        mNumAccepted = (int32_t) accepted.size();
+
+        double median = TrialStatistics::median(accepted);
+        double low = median;
+        double high = median;
+        TrialStatistics::bootstrapMedian(accepted, &low, &high);
+        double mean = TrialStatistics::mean(accepted);
+        double stdev = TrialStatistics::stdev(accepted);
+        mResult->setMeasurement(median);
+
+        ResultReport report;
+        report << std::endl;
+        report.addHeading("Repeated Trials");
+        report.addMetric("repeat.trials", numTrials);
+        report.addMetric("repeat.failed", numTrials - valid.size());
+        report.addMetric("repeat.warmup", numWarmup);
+        report.addMetric("repeat.burst.warmup.cycles.max", maxWarmupCycles);
+        report.addMetric("repeat.outliers", numOutliers);
+        report.addMetric("repeat.accepted", accepted.size());
+        report.addMetric("repeat.median", median);
+        report.addMetric("repeat.median.ci.level.percent",
+                         (int) (TrialStatistics::kConfidenceLevel * 100));
+        report.addMetric("repeat.median.ci.low", low);
+        report.addMetric("repeat.median.ci.high", high);
+        // A change smaller than this is not distinguishable from the noise.
+        report.addMetric("repeat.median.ci.half.width.percent",
+                         (median != 0.0) ? (50.0 * (high - low) / std::fabs(median)) : 0.0);
+        report.addMetric("repeat.mean", mean);
+        report.addMetric("repeat.stdev", stdev);
+        report.addMetric("repeat.cv.percent",
+                         (mean != 0.0) ? (100.0 * stdev / std::fabs(mean)) : 0.0);
+        if (!acceptedRenderMicros.empty()) {
+            // The render time with the warm-up cycles of each trial removed.
+            report.addMetric("repeat.steady.render.micros.median",
+                             TrialStatistics::median(acceptedRenderMicros));
+        }
+        report.beginTable("trial#, measurement, result, cycles, warmup.cycles"
+                          ", steady.render.micros, status");
+        for (size_t i = 0; i < numTrials; i++) {
+            report.addCell(i, 6);
+            report.addCell(mMeasurements[i], 11);
+            report.addCell(mResultCodes[i], 6);
+            report.addCell(mNumCycles[i], 6);
+            report.addCell(mWarmupCycles[i], 13);
+            report.addCell(mSteadyRenderMicros[i], 20);
+            report.addCell(getStatusName(status[i]));
+            report.endRow();
+        }
+        report.endTable();
+        return report;
+    }
+
+    std::unique_ptr<TestHarnessParameters> mHarness;
+    int32_t             mNumTrials;
+    std::string         mName;
+    std::vector<double> mMeasurements;
+    std::vector<int32_t> mResultCodes;
+    std::vector<int32_t> mNumCycles;    // note on and off cycles timed in each trial
+    std::vector<int32_t> mWarmupCycles; // cycles found to be warm-up by MSER in each trial
+    std::vector<double>  mSteadyRenderMicros; // mean render time after the warm-up cycles
+    int32_t             mNumAccepted = 0;
+};
+
+#endif // SYNTHMARK_REPEATED_TEST_HARNESS_H
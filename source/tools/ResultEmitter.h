@@ -0,0 +1,406 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_RESULT_EMITTER_H
+#define SYNTHMARK_RESULT_EMITTER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <sys/utsname.h>
+#include <utility>
+#include <vector>
+
+#include "ResultReport.h"
+#include "SynthMark.h"
+#include "SynthMarkResult.h"
+
+/**
+ * A typed view of the results of one run.
+ *
+ * The harnesses record their metrics and tables in the ResultReport of the SynthMarkResult.
+ * StructuredResult names the tables, adds metadata about the run and the device,
+ * and a ResultEmitter then writes it as text, JSON Lines or CSV.
+ */
+class StructuredResult {
+public:
+    typedef ResultReport::Metric Metric;
+    typedef ResultReport::Cell Cell;
+
+    struct Table {
+        std::string section;
+        std::string name;
+        std::string kind;    // "histogram", "per.cpu" or "series"
+        std::vector<std::string> columns;
+        std::vector<std::string> units;
+        std::vector<std::vector<Cell>> rows;
+    };
+
+    /**
+     * Collect the report in the result and add the standard metadata.
+     */
+    explicit StructuredResult(SynthMarkResult &result) : mResult(result) {
+        addMetadata("synthmark.version", SYNTHMARK_VERSION_TEXT);
+        if (!result.getTestName().empty()) {
+            addMetadata("test.name", result.getTestName());
+        }
+        addMetadata("result.code", std::to_string(result.getResultCode()));
+        addMetadata("measurement", formatDouble(result.getMeasurement()));
+        addMetadata("time.unix", std::to_string((long long) time(nullptr)));
+        addMetadata("isa", getIsaName());
+        struct utsname name;
+        if (uname(&name) == 0) {
+            addMetadata("kernel", std::string(name.sysname) + " " + name.release);
+            addMetadata("machine", name.machine);
+        }
+        addMetadata("cpu.governors", getGovernors());
+        collect(result.getReport());
+    }
+
+    /**
+     * Add a run parameter or other fact about the run.
+     */
+    void addMetadata(const std::string &name, const std::string &value) {
+        mMetadata.emplace_back(name, value);
+    }
+
+    const std::vector<std::pair<std::string, std::string>> &getMetadata() const {
+        return mMetadata;
+    }
+
+    const std::vector<Metric> &getMetrics() const {
+        return mMetrics;
+    }
+
+    const std::vector<Table> &getTables() const {
+        return mTables;
+    }
+
+    SynthMarkResult &getResult() const {
+        return mResult;
+    }
+
+    static std::string formatDouble(double value) {
+        std::stringstream text;
+        text << std::setprecision(9) << value;
+        return text.str();
+    }
+
+private:
+    SynthMarkResult &mResult;
+    std::vector<std::pair<std::string, std::string>> mMetadata;
+    std::vector<Metric> mMetrics;
+    std::vector<Table> mTables;
+
+    static std::string trim(const std::string &text) {
+        size_t first = text.find_first_not_of(" \t\r");
+        if (first == std::string::npos) {
+            return "";
+        }
+        size_t last = text.find_last_not_of(" \t\r");
+        return text.substr(first, last - first + 1);
+    }
+
+    static std::string getTableKind(const std::vector<std::string> &columns) {
+        if (columns.empty()) {
+            return "series";
+        } else if (columns[0].find("bin") == 0) {
+            return "histogram";
+        } else if (columns[0].find("cpu") == 0) {
+            return "per.cpu";
+        }
+        return "series";
+    }
+
+    void collect(const ResultReport &report) {
+        mMetrics = report.getMetrics();
+        std::string section;
+        int32_t tablesInSection = 0;
+        for (const ResultReport::Table &reportTable : report.getTables()) {
+            if (reportTable.section != section) {
+                section = reportTable.section;
+                tablesInSection = 0;
+            }
+            // Number the tables within each section, eg. "AudioSink.1".
+            tablesInSection++;
+            Table table;
+            table.section = reportTable.section;
+            table.name = (section.empty() ? std::string("results") : section)
+                    + "." + std::to_string(tablesInSection);
+            table.kind = getTableKind(reportTable.columns);
+            table.columns = reportTable.columns;
+            table.units = reportTable.units;
+            table.rows = reportTable.rows;
+            mTables.push_back(table);
+        }
+    }
+
+    static const char *getIsaName() {
+#if defined(__aarch64__)
+        return "arm64";
+#elif defined(__arm__)
+        return "arm";
+#elif defined(__x86_64__)
+        return "x86_64";
+#elif defined(__i386__)
+        return "x86";
+#elif defined(__riscv)
+        return "riscv";
+#else
+        return "unknown";
+#endif
+    }
+
+    /**
+     * @return the different cpufreq governors in use, eg. "schedutil", or "none"
+     */
+    static std::string getGovernors() {
+        std::vector<std::string> governors;
+        for (int cpu = 0; cpu < kMaxGovernorCpus; cpu++) {
+            std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu)
+                    + "/cpufreq/scaling_governor";
+            FILE *file = fopen(path.c_str(), "r");
+            if (file == nullptr) {
+                continue;
+            }
+            char buffer[64] = {0};
+            if (fgets(buffer, sizeof(buffer), file) != nullptr) {
+                std::string governor = trim(std::string(buffer).substr(
+                        0, std::string(buffer).find('\n')));
+                bool found = false;
+                for (const std::string &known : governors) {
+                    found = found || (known == governor);
+                }
+                if (!found && !governor.empty()) {
+                    governors.push_back(governor);
+                }
+            }
+            fclose(file);
+        }
+        if (governors.empty()) {
+            return "none";
+        }
+        std::string result = governors[0];
+        for (size_t i = 1; i < governors.size(); i++) {
+            result += "," + governors[i];
+        }
+        return result;
+    }
+
+    static constexpr int kMaxGovernorCpus = 64;
+};
+
+/**
+ * Write a StructuredResult in one format.
+ */
+class ResultEmitter {
+public:
+    enum : int32_t {
+        FORMAT_TEXT = 0,
+        FORMAT_JSON_LINES = 1,
+        FORMAT_CSV = 2,
+        FORMAT_COUNT
+    };
+
+    virtual ~ResultEmitter() = default;
+
+    virtual void emit(const StructuredResult &result, std::ostream &out) = 0;
+
+    static const char *getFormatName(int32_t format) {
+        switch (format) {
+            case FORMAT_TEXT:
+                return "text";
+            case FORMAT_JSON_LINES:
+                return "jsonl";
+            case FORMAT_CSV:
+                return "csv";
+            default:
+                return "unknown";
+        }
+    }
+
+    static std::unique_ptr<ResultEmitter> create(int32_t format);
+};
+
+/**
+ * The original report, unchanged.
+ */
+class TextResultEmitter : public ResultEmitter {
+public:
+    void emit(const StructuredResult &result, std::ostream &out) override {
+        out << result.getResult().getResultMessage();
+    }
+};
+
+/**
+ * One JSON object per run on a single line so that many runs can be appended to one file.
+ */
+class JsonLinesResultEmitter : public ResultEmitter {
+public:
+    void emit(const StructuredResult &result, std::ostream &out) override {
+        out << "{\"metadata\":{";
+        const char *separator = "";
+        for (const auto &entry : result.getMetadata()) {
+            out << separator << quote(entry.first) << ":" << quote(entry.second);
+            separator = ",";
+        }
+        out << "},\"metrics\":[";
+        separator = "";
+        for (const StructuredResult::Metric &metric : result.getMetrics()) {
+            out << separator << "{\"section\":" << quote(metric.section)
+                << ",\"name\":" << quote(metric.name)
+                << ",\"value\":" << (metric.isNumeric ? number(metric.value) : quote(metric.text))
+                << ",\"unit\":" << quote(metric.unit) << "}";
+            separator = ",";
+        }
+        out << "],\"tables\":[";
+        separator = "";
+        for (const StructuredResult::Table &table : result.getTables()) {
+            out << separator << "{\"section\":" << quote(table.section)
+                << ",\"name\":" << quote(table.name)
+                << ",\"kind\":" << quote(table.kind)
+                << ",\"columns\":" << stringArray(table.columns)
+                << ",\"units\":" << stringArray(table.units)
+                << ",\"rows\":[";
+            const char *rowSeparator = "";
+            for (const std::vector<StructuredResult::Cell> &row : table.rows) {
+                out << rowSeparator << "[";
+                const char *cellSeparator = "";
+                for (const StructuredResult::Cell &cell : row) {
+                    out << cellSeparator << (cell.isNumeric ? number(cell.value) : quote(cell.text));
+                    cellSeparator = ",";
+                }
+                out << "]";
+                rowSeparator = ",";
+            }
+            out << "]}";
+            separator = ",";
+        }
+        out << "]}" << std::endl;
+    }
+
+private:
+    static std::string quote(const std::string &text) {
+        std::string result = "\"";
+        for (char c : text) {
+            switch (c) {
+                case '"': result += "\\\""; break;
+                case '\\': result += "\\\\"; break;
+                case '\n': result += "\\n"; break;
+                case '\t': result += "\\t"; break;
+                default:
+                    if ((unsigned char) c < 0x20) {
+                        char escaped[8];
+                        snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                        result += escaped;
+                    } else {
+                        result += c;
+                    }
+                    break;
+            }
+        }
+        return result + "\"";
+    }
+
+    // JSON has no NaN or infinity.
+    static std::string number(double value) {
+        if (value != value || value > 1.0e308 || value < -1.0e308) {
+            return "null";
+        }
+        return StructuredResult::formatDouble(value);
+    }
+
+    static std::string stringArray(const std::vector<std::string> &strings) {
+        std::string result = "[";
+        for (size_t i = 0; i < strings.size(); i++) {
+            if (i > 0) result += ",";
+            result += quote(strings[i]);
+        }
+        return result + "]";
+    }
+};
+
+/**
+ * Long format CSV with one value per row:
+ *   record, section, table, row, name, value, unit
+ */
+class CsvResultEmitter : public ResultEmitter {
+public:
+    void emit(const StructuredResult &result, std::ostream &out) override {
+        out << "record,section,table,row,name,value,unit" << std::endl;
+        for (const auto &entry : result.getMetadata()) {
+            writeRow(out, "metadata", "", "", "", entry.first, entry.second, "");
+        }
+        for (const StructuredResult::Metric &metric : result.getMetrics()) {
+            writeRow(out, "metric", metric.section, "", "", metric.name,
+                     metric.text, metric.unit);
+        }
+        for (const StructuredResult::Table &table : result.getTables()) {
+            for (size_t row = 0; row < table.rows.size(); row++) {
+                const std::vector<StructuredResult::Cell> &cells = table.rows[row];
+                for (size_t column = 0; column < cells.size(); column++) {
+                    bool hasColumn = column < table.columns.size();
+                    writeRow(out, table.kind.c_str(), table.section, table.name,
+                             std::to_string(row),
+                             hasColumn ? table.columns[column] : std::to_string(column),
+                             cells[column].text,
+                             hasColumn ? table.units[column] : "");
+                }
+            }
+        }
+    }
+
+private:
+    static std::string field(const std::string &text) {
+        if (text.find_first_of(",\"\n") == std::string::npos) {
+            return text;
+        }
+        std::string result = "\"";
+        for (char c : text) {
+            if (c == '"') result += '"';
+            result += c;
+        }
+        return result + "\"";
+    }
+
+    static void writeRow(std::ostream &out, const char *record,
+                         const std::string &section, const std::string &table,
+                         const std::string &row, const std::string &name,
+                         const std::string &value, const std::string &unit) {
+        out << record << "," << field(section) << "," << field(table) << ","
+            << row << "," << field(name) << "," << field(value) << "," << field(unit)
+            << std::endl;
+    }
+};
+
+inline std::unique_ptr<ResultEmitter> ResultEmitter::create(int32_t format) {
+    switch (format) {
+        case FORMAT_JSON_LINES:
+            return std::unique_ptr<ResultEmitter>(new JsonLinesResultEmitter());
+        case FORMAT_CSV:
+            return std::unique_ptr<ResultEmitter>(new CsvResultEmitter());
+        case FORMAT_TEXT:
+        default:
+            return std::unique_ptr<ResultEmitter>(new TextResultEmitter());
+    }
+}
+
+#endif // SYNTHMARK_RESULT_EMITTER_H
@@ -0,0 +1,312 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_RESULT_REPORT_H
+#define SYNTHMARK_RESULT_REPORT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "SynthMark.h"
+
+/**
+ * The results of a test as typed metrics and tables, plus the text report rendered from them.
+ *
+ * A harness adds each result with addMetric() and each CSV block with beginTable(),
+ * addCell(), endRow() and endTable(). Headings, comments and blank lines are written
+ * with operator<<. The "key = value" lines and CSV blocks of the text report are written
+ * from the same calls, using the current stream format, so the typed values
+ * never have to be parsed back out of the text.
+ * Values are passed by value so that a static constexpr member does not need a definition.
+ */
+class ResultReport {
+public:
+    struct Metric {
+        std::string section; // heading that the metric appeared under, may be empty
+        std::string name;
+        std::string text;     // the value as it was printed
+        double      value = 0.0;
+        bool        isNumeric = false;
+        std::string unit;
+    };
+
+    struct Cell {
+        std::string text;     // without the padding
+        double      value = 0.0;
+        bool        isNumeric = false;
+    };
+
+    struct Table {
+        std::string section;
+        std::vector<std::string> columns;
+        std::vector<std::string> units;
+        std::vector<std::vector<Cell>> rows;
+    };
+
+    ResultReport() = default;
+
+    ResultReport(const ResultReport &other) {
+        *this << other;
+    }
+
+    ResultReport &operator=(const ResultReport &other) {
+        if (this != &other) {
+            clear();
+            *this << other;
+        }
+        return *this;
+    }
+
+    /**
+     * Write text that is not a result, eg. a comment or a blank line.
+     */
+    template <typename T>
+    ResultReport &operator<<(T value) {
+        mText << value;
+        return *this;
+    }
+
+    ResultReport &operator<<(std::ostream &(*manipulator)(std::ostream &)) {
+        mText << manipulator;
+        return *this;
+    }
+
+    /**
+     * Append another report. Its metrics and tables without a heading
+     * go under the current heading of this report.
+     */
+    ResultReport &operator<<(const ResultReport &other) {
+        mText << other.getText();
+        for (Metric metric : other.mMetrics) {
+            if (metric.section.empty()) metric.section = mSection;
+            mMetrics.push_back(metric);
+        }
+        for (Table table : other.mTables) {
+            if (table.section.empty()) table.section = mSection;
+            mTables.push_back(table);
+        }
+        if (!other.mSection.empty()) {
+            mSection = other.mSection;
+        }
+        return *this;
+    }
+
+    /**
+     * Write a heading line such as "AudioSink:". Later metrics and tables are filed under it.
+     */
+    void addHeading(const std::string &heading) {
+        mText << heading << std::endl;
+        mSection = heading;
+        if (!mSection.empty() && mSection.back() == ':') {
+            mSection.pop_back();
+        }
+    }
+
+    /**
+     * File the later metrics and tables under a section without writing a heading.
+     */
+    void setSection(const std::string &section) {
+        mSection = section;
+    }
+
+    /**
+     * Indent the following "name = value" lines and pad the names so they line up.
+     */
+    void setMetricLayout(int32_t indent, int32_t nameWidth) {
+        mIndent = indent;
+        mNameWidth = nameWidth;
+    }
+
+    /**
+     * Write "name = value" using the current stream format and record the value.
+     *
+     * @param name dotted name, eg. "audio.latency.msec"
+     * @param value number or text
+     * @param unit eg. "ms", or empty to use the unit named in the name
+     * @param comment written after the value as " # comment", not part of the value
+     */
+    template <typename T>
+    void addMetric(const std::string &name, T value, const std::string &unit = "",
+                   const std::string &comment = "") {
+        Metric metric;
+        metric.section = mSection;
+        metric.name = name;
+        metric.text = format(value);
+        metric.isNumeric = toNumber(value, &metric.value);
+        metric.unit = unit.empty() ? getUnit(name) : unit;
+        std::string padding(std::max(0, mNameWidth - (int32_t) name.size()), ' ');
+        mText << std::string(mIndent, ' ') << name << padding << " = " << metric.text;
+        if (!comment.empty()) {
+            mText << " # " << comment;
+        }
+        mText << std::endl;
+        mMetrics.push_back(metric);
+    }
+
+    /**
+     * Write TEXT_CSV_BEGIN and the column names.
+     * @param header names separated by commas, padded to line up with the cells
+     */
+    void beginTable(const std::string &header) {
+        mText << TEXT_CSV_BEGIN << std::endl << header << std::endl;
+        mTables.emplace_back();
+        Table &table = mTables.back();
+        table.section = mSection;
+        std::stringstream names(header);
+        std::string name;
+        while (std::getline(names, name, ',')) {
+            name = trim(name);
+            table.columns.push_back(name);
+            table.units.push_back(getUnit(name));
+        }
+        mRowStarted = false;
+    }
+
+    /**
+     * Write one cell of the current row with the current stream format.
+     * @param width minimum width of the cell in the text, it is padded on the left
+     */
+    template <typename T>
+    void addCell(T value, int width = 0) {
+        if (mTables.empty()) {
+            return;
+        }
+        Table &table = mTables.back();
+        if (!mRowStarted) {
+            table.rows.emplace_back();
+            mRowStarted = true;
+        } else {
+            mText << ", ";
+        }
+        Cell cell;
+        cell.text = format(value);
+        cell.isNumeric = toNumber(value, &cell.value);
+        mText << std::setw(width) << cell.text;
+        table.rows.back().push_back(cell);
+    }
+
+    void endRow() {
+        mText << std::endl;
+        mRowStarted = false;
+    }
+
+    void endTable() {
+        mText << TEXT_CSV_END << std::endl;
+    }
+
+    std::string getText() const {
+        return mText.str();
+    }
+
+    const std::vector<Metric> &getMetrics() const {
+        return mMetrics;
+    }
+
+    const std::vector<Table> &getTables() const {
+        return mTables;
+    }
+
+    void clear() {
+        mText.str("");
+        mText.clear();
+        mText.copyfmt(std::stringstream());
+        mMetrics.clear();
+        mTables.clear();
+        mSection.clear();
+        mRowStarted = false;
+        mIndent = 0;
+        mNameWidth = 0;
+    }
+
+    /**
+     * Guess the unit from the parts of a dotted name, eg. "audio.latency.msec.0.91.91".
+     * The last part that names a unit is used.
+     * @return unit or an empty string
+     */
+    static std::string getUnit(const std::string &name) {
+        static const char *kUnits[][2] = {
+                {"msec", "ms"}, {"millis", "ms"}, {"usec", "us"}, {"micros", "us"},
+                {"nanos", "ns"}, {"nsec", "ns"}, {"seconds", "s"}, {"sec", "s"},
+                {"khz", "kHz"}, {"mhz", "MHz"}, {"hz", "Hz"}, {"percent", "%"},
+                {"celsius", "C"}, {"frames", "frames"}, {"bursts", "bursts"},
+                {"bytes", "B"}, {"kib", "KiB"}
+        };
+        size_t end = name.size();
+        while (end > 0) {
+            size_t dot = name.find_last_of('.', end - 1);
+            size_t start = (dot == std::string::npos) ? 0 : dot + 1;
+            std::string part = name.substr(start, end - start);
+            for (const auto &entry : kUnits) {
+                if (part == entry[0]) {
+                    return entry[1];
+                }
+            }
+            if (dot == std::string::npos) {
+                break;
+            }
+            end = dot;
+        }
+        return "";
+    }
+
+private:
+    template <typename T>
+    std::string format(const T &value) const {
+        std::stringstream text;
+        text.copyfmt(mText);
+        text.width(0);
+        text << value;
+        return text.str();
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_arithmetic<T>::value, bool>::type
+    toNumber(const T &value, double *number) {
+        *number = (double) value;
+        return true;
+    }
+
+    template <typename T>
+    static typename std::enable_if<!std::is_arithmetic<T>::value, bool>::type
+    toNumber(const T &value, double *number) {
+        *number = 0.0;
+        return false;
+    }
+
+    static std::string trim(const std::string &text) {
+        size_t first = text.find_first_not_of(" \t");
+        if (first == std::string::npos) {
+            return "";
+        }
+        size_t last = text.find_last_not_of(" \t");
+        return text.substr(first, last - first + 1);
+    }
+
+    std::stringstream   mText;
+    std::vector<Metric> mMetrics;
+    std::vector<Table>  mTables;
+    std::string         mSection;
+    bool                mRowStarted = false;
+    int32_t             mIndent = 0;
+    int32_t             mNameWidth = 0;
+};
+
+#endif // SYNTHMARK_RESULT_REPORT_H
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SYNTHMARK_SCHED_STAT_READER_H
+#define SYNTHMARK_SCHED_STAT_READER_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#if !defined(__APPLE__)
+#include <sys/syscall.h>
+#endif
+
+/**
+ * Scheduler counters of one thread from /proc/self/task/{tid}/schedstat.
+ */
+struct SchedStat {
+    int64_t runNanos = 0;    // time spent running on a CPU
+    int64_t waitNanos = 0;   // time spent runnable on a run queue, waiting for a CPU
+    int64_t timeslices = 0;  // number of times the thread was switched onto a CPU
+};
+
+/**
+ * Read the schedstat counters of one thread.
+ *
+ * The file is opened once by the thread that will be measured and re-read with pread(),
+ * so a read is one system call and can be done from the audio callback.
+ * The kernel only updates the counters when the thread is switched in or out,
+ * so waitNanos grows when a woken thread finally gets a CPU.
+ *
+ * This requires a kernel with CONFIG_SCHED_INFO, which Android and most Linux
+ * distributions enable. It is not available on Mac.
+ */
+class SchedStatReader
+{
+public:
+    ~SchedStatReader() {
+        close();
+    }
+
+    /**
+     * Open the schedstat file of the calling thread.
+     * @return 0 or a negative errno
+     */
+    int32_t open() {
+        close();
+#if defined(__APPLE__)
+        return -ENOSYS;
+#else
+        int64_t threadId = getCallingThreadId();
+        std::string path = "/proc/self/task/" + std::to_string(threadId) + "/schedstat";
+        mFd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (mFd < 0) {
+            return -errno;
+        }
+        SchedStat stat;
+        if (!read(&stat)) {
+            close();
+            return -EIO;
+        }
+        mThreadId = threadId;
+        return 0;
+#endif
+    }
+
+    void close() {
+        if (mFd >= 0) {
+            ::close(mFd);
+            mFd = -1;
+        }
+        mThreadId = -1;
+    }
+
+    bool isOpen() const {
+        return mFd >= 0;
+    }
+
+    /**
+     * A harness may be run again on a new audio thread, so check before reading.
+     * @return true if open() was called by the calling thread
+     */
+    bool isOpenForCallingThread() const {
+        return isOpen() && mThreadId == getCallingThreadId();
+    }
+
+    static int64_t getCallingThreadId() {
+#if defined(__APPLE__)
+        return -1;
+#else
+        return (int64_t) syscall(SYS_gettid);
+#endif
+    }
+
+    /**
+     * @return true if all three counters were read
+     */
+    bool read(SchedStat *stat) {
+        if (mFd < 0) {
+            return false;
+        }
+        char buffer[96];
+        ssize_t count = pread(mFd, buffer, sizeof(buffer) - 1, 0);
+        if (count <= 0) {
+            return false;
+        }
+        buffer[count] = 0;
+        long long runNanos = 0;
+        long long waitNanos = 0;
+        long long timeslices = 0;
+        if (sscanf(buffer, "%lld %lld %lld", &runNanos, &waitNanos, &timeslices) != 3) {
+            return false;
+        }
+        stat->runNanos = runNanos;
+        stat->waitNanos = waitNanos;
+        stat->timeslices = timeslices;
+        return true;
+    }
+
+private:
+    int     mFd = -1;
+    int64_t mThreadId = -1;
+};
+
+#endif // SYNTHMARK_SCHED_STAT_READER_H
@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SYNTHMARK_SIMULATED_DMA_H
+#define SYNTHMARK_SIMULATED_DMA_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include "AudioSinkBase.h"
+#include "HostThreadFactory.h"
+#include "HostTools.h"
+#include "SynthMark.h"
+#include "SynthTools.h"
+
+/**
+ * Simulate the DMA engine of an audio device with a thread that reads
+ * bursts from a lock-free ring buffer at the exact hardware rate.
+ *
+ * There is one writer, the audio thread, and one reader, the DMA thread.
+ * Each side only writes its own counter so no locks are needed.
+ * The reader copies every burst into a "hardware" buffer and checksums it
+ * so the audio data really moves between the CPUs, as it would in a HAL.
+ *
+ * Underruns are detected by the reader when a burst is missing at the moment
+ * it must be played. The reader then wakes the writer if it is blocked
+ * waiting for room so we can measure the cross-core handoff latency.
+ */
+class SimulatedDma
+{
+public:
+    virtual ~SimulatedDma() {
+        stop();
+    }
+
+    /**
+     * Allocate the ring buffer.
+     * The capacity is rounded up to a power of two bursts.
+     * @return 0 on success or a negative error
+     */
+    int32_t open(int32_t samplesPerFrame, int32_t framesPerBurst,
+                 int32_t capacityInFrames, int64_t nanosPerBurst) {
+        if (samplesPerFrame < 1 || framesPerBurst < 1 || nanosPerBurst < 1) {
+            return -1;
+        }
+        mSamplesPerFrame = samplesPerFrame;
+        mFramesPerBurst = framesPerBurst;
+        mNanosPerBurst = nanosPerBurst;
+        int32_t capacityInBursts = 1;
+        while (capacityInBursts * framesPerBurst < capacityInFrames) {
+            capacityInBursts *= 2;
+        }
+        mCapacityInBursts = capacityInBursts;
+        int32_t samplesPerBurst = samplesPerFrame * framesPerBurst;
+        mRing.assign((size_t) capacityInBursts * samplesPerBurst, 0.0f);
+        mWriteTimes = std::make_unique<std::atomic<int64_t>[]>(capacityInBursts);
+        mHardwareBuffer.assign(samplesPerBurst, 0.0f);
+        return 0;
+    }
+
+    /**
+     * Start the DMA thread.
+     * The ring is primed with silence so the first read happens at startTimeNanos.
+     *
+     * @return 0 on success or a negative error
+     */
+    int32_t start(int64_t startTimeNanos, int32_t primedFrames, bool useSchedFifo, int priority) {
+        stop();
+        for (int32_t i = 0; i < mCapacityInBursts; i++) {
+            mWriteTimes[i].store(startTimeNanos, std::memory_order_relaxed);
+        }
+        std::fill(mRing.begin(), mRing.end(), 0.0f);
+        mWriteCounter.store(primedFrames, std::memory_order_release);
+        mReadCounter.store(0, std::memory_order_release);
+        mNextReadTimeNanos.store(startTimeNanos, std::memory_order_release);
+        mReadSequence.store(0);
+        mUnderrunCount.store(0);
+        mUseSchedFifo = useSchedFifo;
+        mPriority = priority;
+        mQuit = false;
+        resetStatistics();
+
+        mThread.reset(HostThreadFactory::createThread(HostThreadFactory::ThreadType::Default));
+        mRunning = true;
+        int err = mThread->start(threadProc, this);
+        if (err != 0) {
+            mRunning = false;
+            mThread.reset();
+            return -1;
+        }
+        return 0;
+    }
+
+    void stop() {
+        mQuit = true;
+        // Release a writer that may still be blocked.
+        mReadSequence.increment();
+        mReadSequence.wakeAll();
+        if (mThread) {
+            mThread->join();
+            mThread.reset();
+        }
+    }
+
+    /**
+     * Write one burst. Called only by the audio thread.
+     * The caller must check that there is room.
+     */
+    void writeBurst(const float *buffer) {
+        int64_t writeCounter = mWriteCounter.load(std::memory_order_relaxed);
+        int32_t slot = getSlot(writeCounter);
+        int32_t samplesPerBurst = mSamplesPerFrame * mFramesPerBurst;
+        memcpy(&mRing[(size_t) slot * samplesPerBurst], buffer, samplesPerBurst * sizeof(float));
+        mWriteTimes[slot].store(HostTools::getNanoTime(), std::memory_order_relaxed);
+        mWriteCounter.store(writeCounter + mFramesPerBurst, std::memory_order_release);
+    }
+
+    int64_t getFramesWritten() const {
+        return mWriteCounter.load(std::memory_order_acquire);
+    }
+
+    int64_t getFramesRead() const {
+        return mReadCounter.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @return time that the DMA thread will read the next burst
+     */
+    int64_t getNextReadTimeNanos() const {
+        return mNextReadTimeNanos.load(std::memory_order_acquire);
+    }
+
+    int32_t getUnderrunCount() const {
+        return mUnderrunCount.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @return false once stop() was called or the DMA thread has exited
+     */
+    bool isRunning() const {
+        return mRunning && !mQuit;
+    }
+
+    /**
+     * Block the writer until the DMA thread has read past framesRead.
+     */
+    void waitForRead(int64_t framesRead) {
+        int32_t sequence = mReadSequence.load();
+        bool blocked = false;
+        while (getFramesRead() <= framesRead && isRunning()) {
+            mReadSequence.waitWhileEqual(sequence);
+            sequence = mReadSequence.load();
+            blocked = true;
+        }
+        if (blocked) {
+            // How long it took the writer to run after the reader woke it.
+            int64_t handoffNanos = HostTools::getNanoTime()
+                    - mLastWakeNanos.load(std::memory_order_acquire);
+            mHandoffCount++;
+            mTotalHandoffNanos += handoffNanos;
+            mMaxHandoffNanos = std::max(mMaxHandoffNanos, handoffNanos);
+        }
+    }
+
+    void resetStatistics() {
+        mBurstsRead = 0;
+        mTotalLatencyNanos = 0;
+        mMaxLatencyNanos = 0;
+        mTotalCopyNanos = 0;
+        mMaxCopyNanos = 0;
+        mChecksum = SynthTools::kChecksumSeed;
+        mHandoffCount = 0;
+        mTotalHandoffNanos = 0;
+        mMaxHandoffNanos = 0;
+        mDmaCpu = -1;
+    }
+
+    /**
+     * Call after stop() so the statistics written by the DMA thread are stable.
+     */
+    ResultReport dump() {
+        ResultReport report;
+        int32_t bursts = std::max(1, mBurstsRead);
+        int32_t handoffs = std::max(1, mHandoffCount);
+        report.addMetric("dma.ring.capacity.bursts", mCapacityInBursts);
+        report.addMetric("dma.cpu", mDmaCpu);
+        report.addMetric("dma.bursts.read", mBurstsRead);
+        report.addMetric("dma.underrun.count", getUnderrunCount());
+        std::stringstream checksum;
+        checksum << "0x" << std::hex << std::setw(8) << std::setfill('0') << mChecksum;
+        report.addMetric("dma.checksum", checksum.str());
+        report.addMetric("dma.delivery.latency.average.micros",
+                         toMicros(mTotalLatencyNanos / bursts));
+        report.addMetric("dma.delivery.latency.max.micros", toMicros(mMaxLatencyNanos));
+        report.addMetric("dma.copy.average.nanos", mTotalCopyNanos / bursts);
+        report.addMetric("dma.copy.max.nanos", mMaxCopyNanos);
+        report.addMetric("dma.handoff.count", mHandoffCount);
+        report.addMetric("dma.handoff.average.micros", toMicros(mTotalHandoffNanos / handoffs));
+        report.addMetric("dma.handoff.max.micros", toMicros(mMaxHandoffNanos));
+        return report;
+    }
+
+private:
+    static double toMicros(int64_t nanos) {
+        return (double) nanos / SYNTHMARK_NANOS_PER_MICROSECOND;
+    }
+
+    int32_t getSlot(int64_t framePosition) const {
+        return (int32_t) ((framePosition / mFramesPerBurst) & (mCapacityInBursts - 1));
+    }
+
+    static void *threadProc(void *arg) {
+        ((SimulatedDma *) arg)->dmaLoop();
+        return nullptr;
+    }
+
+    void dmaLoop() {
+        if (mUseSchedFifo) {
+            // Failure is not fatal. The DMA will just be less punctual.
+            (void) mThread->promote(mPriority);
+        }
+        int32_t samplesPerBurst = mSamplesPerFrame * mFramesPerBurst;
+        int64_t nextReadTime = getNextReadTimeNanos();
+        while (!mQuit) {
+            HostTools::sleepUntilNanoTime(nextReadTime);
+            if (mQuit) {
+                break;
+            }
+            mDmaCpu = HostThread::getCpu();
+
+            int64_t readCounter = mReadCounter.load(std::memory_order_relaxed);
+            int64_t writeCounter = mWriteCounter.load(std::memory_order_acquire);
+            if (writeCounter - readCounter >= mFramesPerBurst) {
+                int32_t slot = getSlot(readCounter);
+                int64_t beginCopy = HostTools::getNanoTime();
+                int64_t writeTime = mWriteTimes[slot].load(std::memory_order_relaxed);
+                const float *source = &mRing[(size_t) slot * samplesPerBurst];
+                memcpy(mHardwareBuffer.data(), source, samplesPerBurst * sizeof(float));
+                mChecksum = SynthTools::checksumFloats(mChecksum, mHardwareBuffer.data(),
+                                                       samplesPerBurst);
+                int64_t endCopy = HostTools::getNanoTime();
+
+                int64_t latencyNanos = beginCopy - writeTime;
+                int64_t copyNanos = endCopy - beginCopy;
+                mBurstsRead++;
+                mTotalLatencyNanos += latencyNanos;
+                mMaxLatencyNanos = std::max(mMaxLatencyNanos, latencyNanos);
+                mTotalCopyNanos += copyNanos;
+                mMaxCopyNanos = std::max(mMaxCopyNanos, copyNanos);
+            } else {
+                // The hardware plays whatever is in the buffer, so this is a glitch.
+                mUnderrunCount.fetch_add(1, std::memory_order_acq_rel);
+            }
+
+            // The hardware position always advances, even after an underrun.
+            nextReadTime += mNanosPerBurst;
+            mNextReadTimeNanos.store(nextReadTime, std::memory_order_release);
+            mReadCounter.store(readCounter + mFramesPerBurst, std::memory_order_release);
+            mLastWakeNanos.store(HostTools::getNanoTime(), std::memory_order_release);
+            mReadSequence.increment();
+            mReadSequence.wakeAll();
+        }
+        // Release a writer that may be waiting for a read that will never come.
+        mRunning = false;
+        mReadSequence.increment();
+        mReadSequence.wakeAll();
+    }
+
+    int32_t                   mSamplesPerFrame = 1;
+    int32_t                   mFramesPerBurst = 1;
+    int64_t                   mNanosPerBurst = 1;
+    int32_t                   mCapacityInBursts = 1;
+    std::vector<float>        mRing;
+    std::unique_ptr<std::atomic<int64_t>[]> mWriteTimes;
+    std::vector<float>        mHardwareBuffer;
+
+    std::unique_ptr<HostThread> mThread;
+    bool                      mUseSchedFifo = false;
+    int                       mPriority = SYNTHMARK_THREAD_PRIORITY_DEFAULT;
+    std::atomic<bool>         mQuit{false};
+    std::atomic<bool>         mRunning{false};
+
+    // Each counter is only written by one side.
+    std::atomic<int64_t>      mWriteCounter{0};
+    std::atomic<int64_t>      mReadCounter{0};
+    std::atomic<int64_t>      mNextReadTimeNanos{0};
+    std::atomic<int64_t>      mLastWakeNanos{0};
+    std::atomic<int32_t>      mUnderrunCount{0};
+    HostFutex                 mReadSequence;
+
+    // Written by the DMA thread.
+    int32_t                   mBurstsRead = 0;
+    int64_t                   mTotalLatencyNanos = 0;
+    int64_t                   mMaxLatencyNanos = 0;
+    int64_t                   mTotalCopyNanos = 0;
+    int64_t                   mMaxCopyNanos = 0;
+    uint32_t                  mChecksum = SynthTools::kChecksumSeed;
+    int                       mDmaCpu = -1;
+
+    // Written by the audio thread.
+    int32_t                   mHandoffCount = 0;
+    int64_t                   mTotalHandoffNanos = 0;
+    int64_t                   mMaxHandoffNanos = 0;
+};
+
+#endif // SYNTHMARK_SIMULATED_DMA_H
@@ -0,0 +1,374 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SYNTHMARK_SOAK_HARNESS_H
+#define SYNTHMARK_SOAK_HARNESS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+#include "AudioSinkBase.h"
+#include "HostTools.h"
+#include "SynthMark.h"
+#include "synth/Synthesizer.h"
+#include "tools/CpuAnalyzer.h"
+#include "tools/LogTool.h"
+#include "tools/TestHarnessBase.h"
+#include "tools/TimingAnalyzer.h"
+#include "TestHarnessParameters.h"
+
+/**
+ * Statistics for one rolling window of a soak test.
+ */
+struct SoakWindow {
+    int32_t index = 0;
+    int64_t endTimeNanos = 0;    // from HostTools::getNanoTime()
+    int64_t durationNanos = 0;
+    int32_t bursts = 0;
+    double  dutyCycle = 0.0;
+    int64_t p99RenderNanos = 0;
+    int64_t maxRenderNanos = 0;
+    int32_t underruns = 0;       // during this window
+    int32_t migrations = 0;      // during this window
+    int32_t utilClamp = -1;      // -1 if not managed by the sink
+    int32_t cpu = -1;
+};
+
+/**
+ * Lock free queue for passing windows from the audio thread to the publisher.
+ * There must be only one writer and one reader.
+ */
+class SoakWindowQueue {
+public:
+    static constexpr int32_t kCapacity = 64; // power of two
+
+    /**
+     * @return false if the queue was full and the window was lost
+     */
+    bool write(const SoakWindow &window) {
+        uint32_t writeIndex = mWriteIndex.load(std::memory_order_relaxed);
+        uint32_t readIndex = mReadIndex.load(std::memory_order_acquire);
+        if (writeIndex - readIndex >= (uint32_t) kCapacity) {
+            return false;
+        }
+        mWindows[writeIndex & (kCapacity - 1)] = window;
+        mWriteIndex.store(writeIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool read(SoakWindow *window) {
+        uint32_t readIndex = mReadIndex.load(std::memory_order_relaxed);
+        uint32_t writeIndex = mWriteIndex.load(std::memory_order_acquire);
+        if (readIndex == writeIndex) {
+            return false;
+        }
+        *window = mWindows[readIndex & (kCapacity - 1)];
+        mReadIndex.store(readIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+    void clear() {
+        mReadIndex.store(0);
+        mWriteIndex.store(0);
+    }
+
+private:
+    SoakWindow            mWindows[kCapacity];
+    std::atomic<uint32_t> mReadIndex{0};
+    std::atomic<uint32_t> mWriteIndex{0};
+};
+
+/**
+ * Render a fixed load for a long time and report statistics for every one second window.
+ *
+ * At the end of each window the audio thread takes a snapshot of the TimingAnalyzer
+ * and CpuAnalyzer window counters, resets them, and puts the result in a lock free queue.
+ * It never blocks or allocates memory for this.
+ * A publisher thread drains the queue and, if a socket path was set, sends each window
+ * as one line of JSON in a Unix domain datagram to a local collector.
+ * The datagrams are sent without waiting so a slow or missing collector
+ * just causes windows to be dropped.
+ *
+ * A collector can be as simple as:
+ *   socat -u UNIX-RECV:/tmp/synthmark.sock STDOUT
+ */
+class SoakHarness : public TestHarnessBase {
+public:
+    static constexpr int64_t kWindowNanos = SYNTHMARK_NANOS_PER_SECOND;
+    static constexpr int32_t kMaxReportedWindows = 60; // in the final CSV
+    static constexpr int32_t kPublishPeriodMillis = 100;
+
+    SoakHarness(AudioSinkBase *audioSink, SynthMarkResult *result, LogTool &logTool)
+            : TestHarnessBase(audioSink, result, logTool) {
+        mTestName = "Soak";
+    }
+
+    virtual ~SoakHarness() {
+        stopPublisher();
+    }
+
+    /**
+     * @param path of a Unix domain datagram socket bound by the collector
+     * @return 0 or -1 if the path is empty or too long
+     */
+    int32_t setSocketPath(const char *path) {
+        if (path == nullptr || *path == 0
+                || strlen(path) >= sizeof(((struct sockaddr_un *) nullptr)->sun_path)) {
+            return -1;
+        }
+        mSocketPath = path;
+        return 0;
+    }
+
+    void onBeginMeasurement() override {
+        mResult->setTestName(mTestName);
+        mLogTool.log("---- Soak for %d seconds, %d voices, window = %d msec ----\n",
+                     (int) (mFramesNeeded / mSampleRate), getNumVoices(),
+                     (int) (kWindowNanos / SYNTHMARK_NANOS_PER_MILLISECOND));
+
+        mWindowIndex = 0;
+        mWindowUnderrunBase = mAudioSink->getUnderrunCount();
+        mWindowsOverflowed.store(0);
+        mTimer.snapshotAndResetWindow(0);
+        mCpuAnalyzer.snapshotAndResetWindowMigrations();
+        mWindowStartTime = 0;
+        startPublisher();
+    }
+
+    IAudioSinkCallback::Result onRenderAudio(float *buffer, int32_t numFrames) override {
+        IAudioSinkCallback::Result result = TestHarnessBase::onRenderAudio(buffer, numFrames);
+        if (result != IAudioSinkCallback::Result::Continue) {
+            return result;
+        }
+        int64_t now = HostTools::getNanoTime();
+        if (mWindowStartTime == 0) {
+            mWindowStartTime = mTimer.getLastEntryTime();
+        } else if (now - mWindowStartTime >= kWindowNanos) {
+            endWindow(now);
+        }
+        return result;
+    }
+
+    void onEndMeasurement() override {
+        stopPublisher();
+
+        double maxDutyCycle = mMaxDutyCycle;
+        double meanDutyCycle = (mWindowsReceived > 0)
+                ? (mSumDutyCycle / mWindowsReceived) : 0.0;
+
+        ResultReport report;
+        report.addMetric(mTestName, maxDutyCycle);
+        report.addMetric("soak.window.msec", kWindowNanos / SYNTHMARK_NANOS_PER_MILLISECOND);
+        report.addMetric("soak.windows", mWindowsReceived);
+        report.addMetric("soak.windows.overflowed", mWindowsOverflowed.load());
+        if (!mSocketPath.empty()) {
+            report.addMetric("soak.socket.path", mSocketPath);
+            report.addMetric("soak.windows.published", mWindowsPublished);
+            report.addMetric("soak.windows.dropped", mWindowsDropped);
+        }
+        report.addMetric("soak.duty.cycle.mean", meanDutyCycle);
+        report.addMetric("soak.duty.cycle.max", maxDutyCycle);
+        report.addMetric("soak.render.p99.msec.worst", toMillis(mWorstP99RenderNanos));
+        report.addMetric("soak.render.max.msec", toMillis(mMaxRenderNanos));
+        report.addMetric("soak.windows.with.underruns", mWindowsWithUnderruns);
+        report.addMetric("underrun.count", mAudioSink->getUnderrunCount());
+        report << mCpuAnalyzer.dump();
+
+        report << std::endl;
+        report.addHeading("Soak Windows");
+        report.beginTable("window,   duty,  p99.msec,  max.msec, underruns, migrations,"
+                          " util.clamp, cpu");
+        for (const SoakWindow &window : mHistory) {
+            report.addCell(window.index, 6);
+            report << std::fixed << std::setprecision(3);
+            report.addCell(window.dutyCycle, 5);
+            report.addCell(toMillis(window.p99RenderNanos), 9);
+            report.addCell(toMillis(window.maxRenderNanos), 9);
+            report.addCell(window.underruns, 9);
+            report.addCell(window.migrations, 10);
+            report.addCell(window.utilClamp, 10);
+            report.addCell(window.cpu, 3);
+            report.endRow();
+        }
+        report.endTable();
+        report << std::defaultfloat;
+
+        mResult->setMeasurement(maxDutyCycle);
+        mResult->appendReport(report);
+    }
+
+private:
+    static double toMillis(int64_t nanos) {
+        return (double) nanos / SYNTHMARK_NANOS_PER_MILLISECOND;
+    }
+
+    // Called on the audio thread.
+    void endWindow(int64_t now) {
+        TimingWindow timing = mTimer.snapshotAndResetWindow(now);
+        timing.durationNanos = now - mWindowStartTime;
+        mWindowStartTime = now;
+
+        SoakWindow window;
+        window.index = mWindowIndex++;
+        window.endTimeNanos = now;
+        window.durationNanos = timing.durationNanos;
+        window.bursts = timing.callCount;
+        window.dutyCycle = timing.getDutyCycle();
+        window.p99RenderNanos = timing.p99RenderNanos;
+        window.maxRenderNanos = timing.maxRenderNanos;
+        int32_t underruns = mAudioSink->getUnderrunCount();
+        window.underruns = underruns - mWindowUnderrunBase;
+        mWindowUnderrunBase = underruns;
+        window.migrations = mCpuAnalyzer.snapshotAndResetWindowMigrations();
+        window.utilClamp = mAudioSink->getCurrentUtilClamp();
+        window.cpu = HostThread::getCpu();
+
+        if (!mQueue.write(window)) {
+            mWindowsOverflowed++;
+        }
+        mLogTool.log("window %4d: duty = %5.3f, p99 = %6.3f msec, underruns = %d\n",
+                     window.index, window.dutyCycle, toMillis(window.p99RenderNanos),
+                     window.underruns);
+    }
+
+    void startPublisher() {
+        stopPublisher();
+        mQueue.clear();
+        mHistory.clear();
+        mWindowsReceived = 0;
+        mWindowsPublished = 0;
+        mWindowsDropped = 0;
+        mWindowsWithUnderruns = 0;
+        mMaxDutyCycle = 0.0;
+        mSumDutyCycle = 0.0;
+        mWorstP99RenderNanos = 0;
+        mMaxRenderNanos = 0;
+        if (!mSocketPath.empty()) {
+            mSocket = socket(AF_UNIX, SOCK_DGRAM, 0);
+            if (mSocket < 0) {
+                mLogTool.log("WARNING could not create a socket for %s\n", mSocketPath.c_str());
+            }
+        }
+        mPublishing.store(true);
+        mPublisher = std::thread(&SoakHarness::runPublisher, this);
+    }
+
+    void stopPublisher() {
+        if (mPublisher.joinable()) {
+            mPublishing.store(false);
+            mPublisher.join();
+        }
+        if (mSocket >= 0) {
+            ::close(mSocket);
+            mSocket = -1;
+        }
+    }
+
+    void runPublisher() {
+        bool publishing = true;
+        while (publishing) {
+            // Drain once more after being stopped.
+            publishing = mPublishing.load();
+            SoakWindow window;
+            while (mQueue.read(&window)) {
+                receiveWindow(window);
+            }
+            if (publishing) {
+                usleep(kPublishPeriodMillis * 1000);
+            }
+        }
+    }
+
+    void receiveWindow(const SoakWindow &window) {
+        mWindowsReceived++;
+        mSumDutyCycle += window.dutyCycle;
+        mMaxDutyCycle = std::max(mMaxDutyCycle, window.dutyCycle);
+        mWorstP99RenderNanos = std::max(mWorstP99RenderNanos, window.p99RenderNanos);
+        mMaxRenderNanos = std::max(mMaxRenderNanos, window.maxRenderNanos);
+        if (window.underruns > 0) {
+            mWindowsWithUnderruns++;
+        }
+        mHistory.push_back(window);
+        if ((int32_t) mHistory.size() > kMaxReportedWindows) {
+            mHistory.pop_front();
+        }
+        if (mSocket >= 0) {
+            sendWindow(window);
+        }
+    }
+
+    void sendWindow(const SoakWindow &window) {
+        char line[512];
+        int length = snprintf(line, sizeof(line),
+                "{\"window\":%d,\"time.unix\":%lld,\"duration.msec\":%.3f,\"bursts\":%d"
+                ",\"duty.cycle\":%.4f,\"render.p99.msec\":%.4f,\"render.max.msec\":%.4f"
+                ",\"underruns\":%d,\"migrations\":%d,\"util.clamp\":%d,\"cpu\":%d}\n",
+                window.index, (long long) time(nullptr), toMillis(window.durationNanos),
+                window.bursts, window.dutyCycle, toMillis(window.p99RenderNanos),
+                toMillis(window.maxRenderNanos), window.underruns, window.migrations,
+                window.utilClamp, window.cpu);
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, mSocketPath.c_str(), sizeof(address.sun_path) - 1);
+        // Send to the address every time so the collector can be restarted.
+        ssize_t sent = sendto(mSocket, line, length, MSG_DONTWAIT,
+                              (struct sockaddr *) &address, sizeof(address));
+        if (sent == length) {
+            mWindowsPublished++;
+        } else {
+            mWindowsDropped++;
+        }
+    }
+
+    // Only used by the audio thread.
+    int64_t               mWindowStartTime = 0;
+    int32_t               mWindowIndex = 0;
+    int32_t               mWindowUnderrunBase = 0;
+
+    SoakWindowQueue       mQueue;
+    std::atomic<int32_t>  mWindowsOverflowed{0};
+
+    // Only used by the publisher thread until it is joined.
+    std::thread           mPublisher;
+    std::atomic<bool>     mPublishing{false};
+    std::string           mSocketPath;
+    int                   mSocket = -1;
+    std::deque<SoakWindow> mHistory;
+    int32_t               mWindowsReceived = 0;
+    int32_t               mWindowsPublished = 0;
+    int32_t               mWindowsDropped = 0;
+    int32_t               mWindowsWithUnderruns = 0;
+    double                mMaxDutyCycle = 0.0;
+    double                mSumDutyCycle = 0.0;
+    int64_t               mWorstP99RenderNanos = 0;
+    int64_t               mMaxRenderNanos = 0;
+};
+
+#endif // SYNTHMARK_SOAK_HARNESS_H
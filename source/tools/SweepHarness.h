@@ -0,0 +1,415 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHMARK_SWEEP_HARNESS_H
+#define SYNTHMARK_SWEEP_HARNESS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "AudioSinkBase.h"
+#include "HostThreadFactory.h"
+#include "SynthMark.h"
+#include "SynthMarkResult.h"
+#include "tools/LogTool.h"
+#include "TestHarnessParameters.h"
+#include "UtilizationMarkHarness.h"
+
+/**
+ * Measure the CPU utilization at every point of a grid of
+ * sample rates, burst sizes, voice counts, CPUs and thread types.
+ *
+ * One UtilizationMarkHarness, with its Synthesizer, and the audio sink are reused
+ * for every point. The points are run in a random order so that a slow rise in
+ * temperature does not bias one end of the grid.
+ * After each point the result can be appended to a checkpoint file.
+ * If the sweep is interrupted then running it again with the same grid and
+ * checkpoint skips the points that were already measured.
+ *
+ * The grid is written as dimensions separated by ':'. Each dimension is a letter
+ * followed by a comma separated list:
+ *   r = sample rates, b = frames per burst, n = voices, c = CPUs (-1 for any),
+ *   t = thread type (0 = default, 1 = audio)
+ * For example "r48000:b96,192:n10,40,80:c0,7".
+ * Dimensions that are not specified use the normal command line values.
+ */
+class SweepHarness : public TestHarnessParameters {
+public:
+    static constexpr int32_t kMaxPoints = 10000;
+
+    struct Grid {
+        std::vector<int32_t> sampleRates;
+        std::vector<int32_t> framesPerBurst;
+        std::vector<int32_t> numVoices;
+        std::vector<int32_t> cpus;
+        std::vector<int32_t> threadTypes;
+    };
+
+    SweepHarness(AudioSinkBase *audioSink, SynthMarkResult *result, LogTool &logTool)
+    : TestHarnessParameters(audioSink, result, logTool) {
+    }
+
+    virtual ~SweepHarness() = default;
+
+    const char *getName() const override {
+        return "Sweep";
+    }
+
+    /**
+     * @return 0 or -1 if the text could not be parsed
+     */
+    static int32_t parseGrid(const std::string &text, Grid *grid) {
+        std::stringstream dimensions(text);
+        std::string dimension;
+        while (std::getline(dimensions, dimension, ':')) {
+            if (dimension.size() < 2) {
+                return -1;
+            }
+            std::vector<int32_t> *values = nullptr;
+            switch (dimension[0]) {
+                case 'r': values = &grid->sampleRates; break;
+                case 'b': values = &grid->framesPerBurst; break;
+                case 'n': values = &grid->numVoices; break;
+                case 'c': values = &grid->cpus; break;
+                case 't': values = &grid->threadTypes; break;
+                default: return -1;
+            }
+            std::stringstream list(dimension.substr(1));
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                char *end = nullptr;
+                long value = strtol(item.c_str(), &end, 10);
+                if (item.empty() || *end != 0 || value < -1 || value > INT32_MAX) {
+                    return -1;
+                }
+                values->push_back((int32_t) value);
+            }
+            if (values->empty()) {
+                return -1;
+            }
+        }
+        for (int32_t threadType : grid->threadTypes) {
+            if (threadType < 0 || threadType > 1) return -1;
+        }
+        for (int32_t cpu : grid->cpus) {
+            if (cpu < SYNTHMARK_CPU_UNSPECIFIED) return -1;
+        }
+        return 0;
+    }
+
+    /**
+     * @param text see the class comment
+     * @return 0 or -1 if the grid is invalid
+     */
+    int32_t setGrid(const std::string &text) {
+        Grid grid;
+        if (parseGrid(text, &grid) < 0) {
+            return -1;
+        }
+        mGridText = text;
+        mGrid = grid;
+        return 0;
+    }
+
+    /**
+     * @param path file that the results are appended to after each point
+     */
+    void setCheckpointPath(const std::string &path) {
+        mCheckpointPath = path;
+    }
+
+    int32_t runTest(int32_t sampleRate, int32_t framesPerBurst, int32_t numSeconds) override {
+        Grid grid = mGrid;
+        if (grid.sampleRates.empty()) grid.sampleRates.push_back(sampleRate);
+        if (grid.framesPerBurst.empty()) grid.framesPerBurst.push_back(framesPerBurst);
+        if (grid.numVoices.empty()) grid.numVoices.push_back(getNumVoices());
+        if (grid.cpus.empty()) grid.cpus.push_back(mAudioSink->getRequestedCpu());
+        if (grid.threadTypes.empty()) {
+            grid.threadTypes.push_back(mThreadType == HostThreadFactory::ThreadType::Audio
+                                       ? 1 : 0);
+        }
+        buildPoints(grid);
+        if ((int32_t) mPoints.size() > kMaxPoints) {
+            mLogTool.log("ERROR sweep has %d points, more than %d\n",
+                         (int) mPoints.size(), kMaxPoints);
+            return SYNTHMARK_RESULT_OUT_OF_RANGE;
+        }
+
+        mSeed = (uint32_t) time(nullptr);
+        int32_t numResumed = 0;
+        if (!mCheckpointPath.empty()) {
+            int32_t err = readCheckpoint(numSeconds, &numResumed);
+            if (err < 0) {
+                return err;
+            }
+        }
+
+        // Run the points in a random order. The order only depends on the seed
+        // so a resumed sweep continues with the same order.
+        std::vector<int32_t> order(mPoints.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            order[i] = (int32_t) i;
+        }
+        std::mt19937 generator(mSeed);
+        std::shuffle(order.begin(), order.end(), generator);
+
+        FILE *checkpoint = nullptr;
+        if (!mCheckpointPath.empty()) {
+            checkpoint = openCheckpoint(numSeconds, numResumed == 0);
+            if (checkpoint == nullptr) {
+                return SYNTHMARK_RESULT_UNRECOVERABLE_ERROR;
+            }
+        }
+
+        const int requestedCpu = mAudioSink->getRequestedCpu();
+        const HostThreadFactory::ThreadType threadType = mThreadType;
+        SynthMarkResult pointResult;
+        UtilizationMarkHarness harness(mAudioSink, &pointResult, mLogTool);
+        harness.setDelayNoteOnSeconds(mDelayNotesOn);
+        harness.setSynthesizerSettings(mSynthesizerSettings);
+
+        int32_t result = SYNTHMARK_RESULT_SUCCESS;
+        int32_t numFailed = 0;
+        for (size_t position = 0; position < order.size(); position++) {
+            if (TestHarnessBase::isCancelled()) {
+                result = SYNTHMARK_RESULT_CANCELLED;
+                break;
+            }
+            Point &point = mPoints[order[position]];
+            point.order = (int32_t) position;
+            if (point.done) {
+                continue;
+            }
+            mLogTool.log("sweep point %d of %d: rate = %d, burst = %d, voices = %d"
+                         ", cpu = %d, thread = %d\n",
+                         (int) position + 1, (int) order.size(),
+                         point.sampleRate, point.framesPerBurst, point.numVoices,
+                         point.cpu, point.threadType);
+            mAudioSink->setRequestedCpu(point.cpu);
+            harness.setThreadType(point.threadType == 1
+                                  ? HostThreadFactory::ThreadType::Audio
+                                  : HostThreadFactory::ThreadType::Default);
+            harness.setNumVoices(point.numVoices);
+            pointResult.reset();
+            // Otherwise the sink keeps the buffer size of the previous point.
+            mAudioSink->resetBufferSizeInFrames();
+            point.resultCode = harness.runTest(point.sampleRate, point.framesPerBurst,
+                                               numSeconds);
+            int32_t expectedFrames = mAudioSink->getDefaultBufferSizeInBursts()
+                    * point.framesPerBurst;
+            if (point.resultCode == SYNTHMARK_RESULT_SUCCESS
+                    && mAudioSink->getBufferSizeInFrames() != expectedFrames) {
+                mLogTool.log("ERROR sweep point used a buffer of %d frames, expected %d\n",
+                             mAudioSink->getBufferSizeInFrames(), expectedFrames);
+                point.resultCode = SYNTHMARK_RESULT_OUT_OF_RANGE;
+            }
+            point.utilization = pointResult.getMeasurement();
+            point.underruns = mAudioSink->getUnderrunCount();
+            point.done = true;
+            if (point.resultCode != SYNTHMARK_RESULT_SUCCESS) {
+                numFailed++;
+            }
+            if (checkpoint != nullptr) {
+                writePoint(checkpoint, order[position], point);
+            }
+        }
+        if (checkpoint != nullptr) {
+            fclose(checkpoint);
+        }
+        mAudioSink->setRequestedCpu(requestedCpu);
+        mAudioSink->setThreadType(threadType);
+
+        mResult->setTestName(getName());
+        mResult->setMeasurement((double) mPoints.size());
+        mResult->setResultCode(result);
+        mResult->appendReport(dump(numSeconds, numResumed, numFailed));
+        return result;
+    }
+
+private:
+    struct Point {
+        int32_t sampleRate = 0;
+        int32_t framesPerBurst = 0;
+        int32_t numVoices = 0;
+        int32_t cpu = SYNTHMARK_CPU_UNSPECIFIED;
+        int32_t threadType = 1;
+        int32_t order = -1;
+        bool    done = false;
+        double  utilization = 0.0;
+        int32_t underruns = 0;
+        int32_t resultCode = SYNTHMARK_RESULT_UNINITIALIZED;
+    };
+
+    static constexpr const char *kCheckpointHeader = "# synthmark sweep";
+
+    Grid               mGrid;
+    std::string        mGridText;
+    std::string        mCheckpointPath;
+    std::vector<Point> mPoints;
+    uint32_t           mSeed = 0;
+
+    void buildPoints(const Grid &grid) {
+        mPoints.clear();
+        for (int32_t sampleRate : grid.sampleRates) {
+            for (int32_t framesPerBurst : grid.framesPerBurst) {
+                for (int32_t numVoices : grid.numVoices) {
+                    for (int32_t cpu : grid.cpus) {
+                        for (int32_t threadType : grid.threadTypes) {
+                            Point point;
+                            point.sampleRate = sampleRate;
+                            point.framesPerBurst = framesPerBurst;
+                            point.numVoices = numVoices;
+                            point.cpu = cpu;
+                            point.threadType = threadType;
+                            mPoints.push_back(point);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::string getCheckpointHeader(int32_t numSeconds) const {
+        std::stringstream header;
+        header << kCheckpointHeader << " grid=" << mGridText
+               << " seconds=" << numSeconds << " points=" << mPoints.size();
+        return header.str();
+    }
+
+    /**
+     * Load the points that were measured by an earlier run of the same sweep.
+     * @return 0 or a negative error if the checkpoint is for a different sweep
+     */
+    int32_t readCheckpoint(int32_t numSeconds, int32_t *numResumed) {
+        FILE *file = fopen(mCheckpointPath.c_str(), "r");
+        if (file == nullptr) {
+            return 0; // start a new sweep
+        }
+        std::string expected = getCheckpointHeader(numSeconds);
+        char line[512];
+        int32_t err = 0;
+        if (fgets(line, sizeof(line), file) == nullptr) {
+            fclose(file);
+            return 0; // empty so start a new sweep
+        }
+        std::string header(line);
+        size_t seedPosition = header.find(" seed=");
+        if (seedPosition == std::string::npos
+                || header.substr(0, seedPosition) != expected) {
+            mLogTool.log("ERROR checkpoint %s is for a different sweep\n",
+                         mCheckpointPath.c_str());
+            fclose(file);
+            return SYNTHMARK_RESULT_OUT_OF_RANGE;
+        }
+        mSeed = (uint32_t) strtoul(header.c_str() + seedPosition + 6, nullptr, 10);
+        while (fgets(line, sizeof(line), file) != nullptr) {
+            int index = -1;
+            int resultCode = 0;
+            int underruns = 0;
+            double utilization = 0.0;
+            if (sscanf(line, "%d, %lf, %d, %d", &index, &utilization, &underruns,
+                       &resultCode) != 4) {
+                continue; // probably a partial line written when the sweep was killed
+            }
+            if (index < 0 || index >= (int) mPoints.size()) {
+                err = SYNTHMARK_RESULT_OUT_OF_RANGE;
+                break;
+            }
+            Point &point = mPoints[index];
+            if (!point.done) {
+                (*numResumed)++;
+            }
+            point.done = true;
+            point.utilization = utilization;
+            point.underruns = underruns;
+            point.resultCode = resultCode;
+        }
+        fclose(file);
+        if (err < 0) {
+            mLogTool.log("ERROR checkpoint %s has an invalid point\n", mCheckpointPath.c_str());
+        } else {
+            mLogTool.log("resuming sweep with %d points from %s\n",
+                         *numResumed, mCheckpointPath.c_str());
+        }
+        return err;
+    }
+
+    FILE *openCheckpoint(int32_t numSeconds, bool isNew) {
+        FILE *file = fopen(mCheckpointPath.c_str(), isNew ? "w" : "a");
+        if (file == nullptr) {
+            mLogTool.log("ERROR could not open checkpoint %s\n", mCheckpointPath.c_str());
+            return nullptr;
+        }
+        if (isNew) {
+            fprintf(file, "%s seed=%u\n", getCheckpointHeader(numSeconds).c_str(), mSeed);
+            fflush(file);
+        }
+        return file;
+    }
+
+    // Write each point to storage so that it survives a crash or reboot.
+    static void writePoint(FILE *file, int32_t index, const Point &point) {
+        fprintf(file, "%d, %.6f, %d, %d\n", index, point.utilization, point.underruns,
+                point.resultCode);
+        fflush(file);
+        fsync(fileno(file));
+    }
+
+    ResultReport dump(int32_t numSeconds, int32_t numResumed, int32_t numFailed) {
+        ResultReport report;
+        report.addMetric("sweep.grid", mGridText.empty() ? "none" : mGridText);
+        report.addMetric("sweep.points", mPoints.size());
+        report.addMetric("sweep.points.resumed", numResumed);
+        report.addMetric("sweep.points.failed", numFailed);
+        report.addMetric("sweep.seconds.per.point", numSeconds);
+        report.addMetric("sweep.seed", mSeed);
+        report << std::endl;
+        report.addHeading("Sweep Points");
+        report.beginTable("point#, order,  rate, burst, voices, cpu, thread"
+                          ", utilization, underruns, result");
+        for (size_t i = 0; i < mPoints.size(); i++) {
+            const Point &point = mPoints[i];
+            if (!point.done) {
+                continue;
+            }
+            report.addCell(i, 6);
+            report.addCell(point.order, 5);
+            report.addCell(point.sampleRate, 5);
+            report.addCell(point.framesPerBurst, 5);
+            report.addCell(point.numVoices, 6);
+            report.addCell(point.cpu, 3);
+            report.addCell(point.threadType, 6);
+            report << std::fixed << std::setprecision(4);
+            report.addCell(point.utilization, 11);
+            report.addCell(point.underruns, 9);
+            report.addCell(point.resultCode, 6);
+            report.endRow();
+        }
+        report.endTable();
+        return report;
+    }
+};
+
+#endif // SYNTHMARK_SWEEP_HARNESS_H
@@ -20,16 +20,29 @@
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <stdlib.h>
 
 #include "SynthMark.h"
 #include "synth/IncludeMeOnce.h"
 #include "synth/Synthesizer.h"
 #include "tools/AutomatedTestSuite.h"
+#include "tools/CacheSweepHarness.h"
 #include "tools/ClockRampHarness.h"
+#include "tools/FileAudioSink.h"
+#include "tools/GoldenRenderHarness.h"
+#include "tools/GracefulMarkHarness.h"
+#include "tools/HandoffMatrixHarness.h"
+#include "tools/InterferenceMarkHarness.h"
 #include "tools/JitterMarkHarness.h"
 #include "tools/ITestHarness.h"
 #include "tools/LatencyMarkHarness.h"
+#include "tools/OscillatorMarkHarness.h"
+#include "tools/RepeatedTestHarness.h"
+#include "tools/ResultEmitter.h"
+#include "tools/SoakHarness.h"
+#include "tools/SweepHarness.h"
 #include "tools/TimingAnalyzer.h"
 #if defined(__ANDROID__)
 #include "tools/RealAudioSink.h"
@@ -38,6 +51,7 @@
 #include "tools/UtilizationSeriesHarness.h"
 #include "tools/VirtualAudioSink.h"
 #include "tools/VoiceMarkHarness.h"
+#include "tools/WakeupMarkHarness.h"
 
 constexpr char kDefaultTestCode         = 'v';
 constexpr int  kDefaultSeconds          = 10;
@@ -45,13 +59,18 @@ constexpr int  kDefaultFramesPerBurst   = 96; // 2 msec at 48000 Hz
 constexpr int  kDefaultNumVoices        = 8;
 constexpr int  kDefaultNoteOnDelay      = 0;
 constexpr int  kDefaultPercentCpu       = 50;
+constexpr int  kDefaultVoiceType        = (int) VoiceType::SimpleDPW;
+constexpr int  kDefaultOversampleFactor = 1;
 
 static void usage(const char *name) {
     printf("SynthMark version %d.%d\n", SYNTHMARK_MAJOR_VERSION, SYNTHMARK_MINOR_VERSION);
     printf("%s -t{test} -n{numVoices} -d{noteOnDelay} -p{percentCPU} -r{sampleRate}"
            " -s{seconds} -b{burstSize} -c{cpuAffinity}\n", name);
     printf("    -t{test}, v=voice, l=latency, j=jitter, u=utilization"
-           ", s=series_util, c=clock_ramp, a=automated, default is %c\n",
+           ", s=series_util, c=clock_ramp, a=automated, o=oscillator, g=graceful"
+           ", r=golden_render, b=latency_search, w=sweep, k=soak"
+           ", i=interference, x=cache_sweep, h=handoff, q=wakeup"
+           ", default is %c\n",
            kDefaultTestCode);
 
     printf("    -a{audioLevel} 0 = normal thread, 1 = audio callback (default), 2 = audio output\n");
@@ -60,22 +79,64 @@ static void usage(const char *name) {
     printf("    -B{bursts} initial buffer size in bursts, default = %d\n",
            kDefaultBufferSizeBursts);
     printf("    -c{cpuAffinity} index of CPU to run on, default = UNSPECIFIED\n");
+    printf("    -C{controller} SCHED_DEADLINE bandwidth for -w1 and -w2, 0 = ewma (default),\n");
+    printf("           1 = p99 of a sliding window, 2 = p99 predicted for the next voice count\n");
     printf("    -d{noteOnDelay} seconds to delay the first NoteOn, default = %d\n",
            kDefaultNoteOnDelay);
+    printf("    -D{enable} read the virtual buffer with a simulated DMA thread"
+           ", 0 = off (default), 1 = on\n");
+    printf("    -e{enable} add chorus and reverb after the voice mix, 0 = off (default), 1 = on\n");
+    printf("    -E{format} of the results, 0 = text (default), 1 = JSON Lines, 2 = CSV\n");
+    printf("           the text report always goes to stdout, JSON Lines or CSV go to -J\n");
+    printf("    -F{path} also write the audio to a file, a path ending in .wav gets a header\n");
     printf("    -f{enable} use SCHED_FIFO for normal thread, 0 = off, 1 = on (default)\n");
+    printf("    -g{enable} degrade the voices when a burst is near its deadline"
+           ", 0 = off (default), 1 = on\n");
+    printf("    -G{path} reference render for -tr, recorded if it does not exist\n");
+    printf("    -I{antagonists} for -ti, eg. c4-7:a0,1:p3, c = CPUs, a = types, p = FIFO priority\n");
+    printf("           0 = memory stream, 1 = cache thrash, 2 = spin, 3 = SCHED_FIFO\n");
+    printf("    -J{path} append the -E1 or -E2 results to a file, default = stderr\n");
+    printf("    -K{path} Unix datagram socket that receives a JSON line per -tk window\n");
+    printf("    -l{micros} busy loop in each -tq callback instead of rendering, default = 0\n");
+    printf("    -q{bursts} sample schedstat and rusage of the audio thread every N bursts"
+           ", 0 = off (default)\n");
+    printf("           also report the sleep overshoot of the virtual audio device\n");
     printf("    -n{numVoices} to render, default = %d\n", kDefaultNumVoices);
-    printf("    -N{numVoices} to render for toggling high load, only for -t{l|j|c|s}\n");
+    printf("    -N{numVoices} to render for toggling high load, only for -t{l|b|j|c|s}\n");
+    printf("    -L{nanos} timer slack of the audio thread, default = inherited\n");
+    printf("    -M{enable} lock memory with mlockall() and prefault the audio thread stack"
+           ", 0 = off (default), 1 = on\n");
     printf("    -m{voicesMode} algorithm to choose the number of voices in the range\n"
            "      [-n, -N]. This value can be 'l' for a linear increment, 'r' for a\n"
            "      random choice, or 's' to switch between -n and -N. default = s\n");
+    printf("    -O{factor} oversample the voices by 1 (default), 2 or 4,"
+           " then decimate with half-band FIR filters\n");
+    printf("    -P{workers} render voices one burst ahead on worker threads, 0 = off (default)\n");
+    printf("           LatencyMark then also measures without the pipeline for comparison.\n");
     printf("    -p{percentCPU} target load, default = %d\n", kDefaultPercentCpu);
+    printf("    -Q{path} checkpoint file for -tw, a sweep resumes from it\n");
+    printf("    -R{trials} repeat the test and report the median"
+           " after removing warm-up and outliers, default = 1\n");
     printf("    -r{sampleRate} should be typical, 44100, 48000, etc. default is %d\n",
            kSynthmarkSampleRate);
     printf("    -s{seconds} to run the test, latencyMark may take longer, default is %d\n",
            kDefaultSeconds);
+    printf("    -S{sleepMode} 0 = usleep, 1 = clock_nanosleep, 2 = timerfd, default = %d\n",
+           HostTools::kDefaultSleepMode);
+    printf("    -T{msec} sample the CPU clocks, temperatures and idle time"
+           " at this period, 0 = off (default)\n");
     printf("    -u{utilClampLevel} 0 = off (default), 1 = on, 2 = on verbose, >2 = fixed\n");
     printf("           Using utilClamp helps the scheduler adapt to dynamic workloads.\n");
+    printf("    -U{policy} for -u1 and -u2, 0 = react to slow bursts (default),\n");
+    printf("           1 = feed forward, set from the voice count before it is rendered\n");
+    printf("    -V{voiceType} 0 = SimpleDPW (default), 1 = SimplePolyBLEP\n");
+    printf("    -W{enable} write the -F file with O_DIRECT, 0 = off (default), 1 = on\n");
     printf("    -w{workloadHintsEnabled} 0 = no (default), 1 = give workload hints to scheduler\n");
+    printf("           3 = raise cpufreq scaling_min_freq, 4 = set the clock with the userspace"
+           " governor\n");
+    printf("    -X{grid} points for -tw, eg. r44100,48000:b96,192:n10,40:c0,7:t0,1\n");
+    printf("           r = rates, b = bursts, n = voices, c = CPUs, t = thread types\n");
+    printf("           or for -tx, eg. s1024,16384:n1,8,64, s = state bytes per voice\n");
     printf("    -z{enable} use ADPF for performance hints, 0 = off (default), 1 = on\n");
 }
 
@@ -113,8 +174,32 @@ int synthmark_command_main(int argc, char **argv)
     bool    useSchedFifo = true;
     bool    useADPF = false;
     int32_t utilClampLevel = AudioSinkBase::UTIL_CLAMP_OFF;
+    int32_t utilClampPolicy = AudioSinkBase::UTIL_CLAMP_POLICY_REACTIVE;
     int32_t workloadHintsLevel = HostCpuManager::WORKLOAD_HINTS_OFF;
+    int32_t deadlineController = DeadlineBandwidthController::TYPE_EWMA;
     int32_t bufferSizeBursts = kDefaultBufferSizeBursts;
+    int32_t voiceType = kDefaultVoiceType;
+    int32_t oversampleFactor = kDefaultOversampleFactor;
+    bool    useEffects = false;
+    int32_t pipelineWorkers = 0;
+    bool    useDegradation = false;
+    int32_t sleepMode = HostTools::kDefaultSleepMode;
+    int64_t timerSlackNanos = AudioSinkBase::kTimerSlackUnspecified;
+    bool    useDma = false;
+    bool    lockMemory = false;
+    int32_t telemetryMillis = 0;
+    int32_t resultFormat = ResultEmitter::FORMAT_TEXT;
+    const char *resultPath = nullptr;
+    const char *outputPath = nullptr;
+    bool    useDirectIo = false;
+    const char *referencePath = nullptr;
+    const char *sweepGrid = nullptr;
+    int32_t numTrials = 1;
+    const char *checkpointPath = nullptr;
+    const char *soakSocketPath = nullptr;
+    const char *interferenceConfig = nullptr;
+    int32_t wakeupLoadMicros = 0;
+    int32_t schedulerSampleBursts = 0;
     VoicesMode voicesMode = VOICES_UNDEFINED;
     char testCode = kDefaultTestCode;
 
@@ -145,17 +230,83 @@ int synthmark_command_main(int argc, char **argv)
                 case 'c':
                     if ((cpuAffinity = stringToPositiveInteger(&arg[2], "-c")) < 0) return 1;
                     break;
+                case 'C':
+                    if ((deadlineController = stringToPositiveInteger(&arg[2], "-C")) < 0) {
+                        return 1;
+                    }
+                    break;
                 case 'd':
                     if ((numSecondsDelayNoteOn = stringToPositiveInteger(&arg[2], "-d")) < 0) return 1;
                     break;
+                case 'D':
+                    temp = stringToPositiveInteger(&arg[2], "-D");
+                    if (temp < 0) return 1;
+                    useDma = (temp > 0);
+                    break;
+                case 'M':
+                    temp = stringToPositiveInteger(&arg[2], "-M");
+                    if (temp < 0) return 1;
+                    lockMemory = (temp > 0);
+                    break;
+                case 'e':
+                    temp = stringToPositiveInteger(&arg[2], "-e");
+                    if (temp < 0) return 1;
+                    useEffects = (temp > 0);
+                    break;
+                case 'E':
+                    if ((resultFormat = stringToPositiveInteger(&arg[2], "-E")) < 0) return 1;
+                    break;
+                case 'F':
+                    outputPath = &arg[2];
+                    break;
+                case 'J':
+                    resultPath = &arg[2];
+                    break;
                 case 'f':
                     temp = stringToPositiveInteger(&arg[2], "-a");
                     if (temp < 0) return 1;
                     useSchedFifo = (temp > 0);
                     break;
+                case 'O':
+                    if ((oversampleFactor = stringToPositiveInteger(&arg[2], "-O")) < 0) return 1;
+                    break;
+                case 'P':
+                    if ((pipelineWorkers = stringToPositiveInteger(&arg[2], "-P")) < 0) return 1;
+                    break;
+                case 'G':
+                    referencePath = &arg[2];
+                    break;
+                case 'Q':
+                    checkpointPath = &arg[2];
+                    break;
+                case 'X':
+                    sweepGrid = &arg[2];
+                    break;
+                case 'I':
+                    interferenceConfig = &arg[2];
+                    break;
+                case 'K':
+                    soakSocketPath = &arg[2];
+                    break;
+                case 'l':
+                    if ((wakeupLoadMicros = stringToPositiveInteger(&arg[2], "-l")) < 0) return 1;
+                    break;
+                case 'q':
+                    if ((schedulerSampleBursts = stringToPositiveInteger(&arg[2], "-q")) < 0) {
+                        return 1;
+                    }
+                    break;
+                case 'g':
+                    temp = stringToPositiveInteger(&arg[2], "-g");
+                    if (temp < 0) return 1;
+                    useDegradation = (temp > 0);
+                    break;
                 case 'p':
                     if ((percentCpu = stringToPositiveInteger(&arg[2], "-p")) < 0) return 1;
                     break;
+                case 'L':
+                    if ((timerSlackNanos = stringToPositiveInteger(&arg[2], "-L")) < 0) return 1;
+                    break;
                 case 'm':
                     switch (arg[2]) {
                         case 'r':
@@ -179,9 +330,18 @@ int synthmark_command_main(int argc, char **argv)
                 case 'r':
                     if ((sampleRate = stringToPositiveInteger(&arg[2], "-r")) < 0) return 1;
                     break;
+                case 'R':
+                    if ((numTrials = stringToPositiveInteger(&arg[2], "-R")) < 0) return 1;
+                    break;
                 case 's':
                     if ((numSeconds = stringToPositiveInteger(&arg[2], "-s")) < 0) return 1;
                     break;
+                case 'S':
+                    if ((sleepMode = stringToPositiveInteger(&arg[2], "-S")) < 0) return 1;
+                    break;
+                case 'T':
+                    if ((telemetryMillis = stringToPositiveInteger(&arg[2], "-T")) < 0) return 1;
+                    break;
                 case 't':
                     testCode = arg[2];
                     break;
@@ -189,6 +349,18 @@ int synthmark_command_main(int argc, char **argv)
                     utilClampLevel = stringToPositiveInteger(&arg[2], "-u");
                     if (utilClampLevel < 0) return 1;
                     break;
+                case 'U':
+                    utilClampPolicy = stringToPositiveInteger(&arg[2], "-U");
+                    if (utilClampPolicy < 0) return 1;
+                    break;
+                case 'V':
+                    if ((voiceType = stringToPositiveInteger(&arg[2], "-V")) < 0) return 1;
+                    break;
+                case 'W':
+                    temp = stringToPositiveInteger(&arg[2], "-W");
+                    if (temp < 0) return 1;
+                    useDirectIo = (temp > 0);
+                    break;
                 case 'w':
                     workloadHintsLevel = stringToPositiveInteger(&arg[2], "-w");
                     if (workloadHintsLevel < 0) return 1;
@@ -233,7 +405,7 @@ int synthmark_command_main(int argc, char **argv)
         return 1;
     }
     if (numVoicesHigh != 0
-            && testCode != 'l' && testCode != 'j'
+            && testCode != 'l' && testCode != 'b' && testCode != 'j'
             && testCode != 's' && testCode != 'c') {
         printf(TEXT_ERROR "Num voices high ignored for this test.\n");
         usage(argv[0]);
@@ -244,6 +416,51 @@ int synthmark_command_main(int argc, char **argv)
         usage(argv[0]);
         return 1;
     }
+    if (!VoiceRegistry::isValid(voiceType)) {
+        printf(TEXT_ERROR "Invalid voice type = %d\n", voiceType);
+        usage(argv[0]);
+        return 1;
+    }
+    if (!VoiceRegistry::isValidOversampleFactor(oversampleFactor)) {
+        printf(TEXT_ERROR "Invalid oversample factor = %d\n", oversampleFactor);
+        usage(argv[0]);
+        return 1;
+    }
+    if (pipelineWorkers > RenderPipeline::kMaxWorkers) {
+        printf(TEXT_ERROR "Invalid number of pipeline workers = %d\n", pipelineWorkers);
+        usage(argv[0]);
+        return 1;
+    }
+    if (!HostTools::isSleepModeSupported(sleepMode)) {
+        printf(TEXT_ERROR "Invalid sleep mode = %d\n", sleepMode);
+        usage(argv[0]);
+        return 1;
+    }
+    if (workloadHintsLevel > HostCpuManager::WORKLOAD_HINTS_SYSFS_USERSPACE) {
+        printf(TEXT_ERROR "Invalid workload hints level = %d\n", workloadHintsLevel);
+        usage(argv[0]);
+        return 1;
+    }
+    if (resultFormat >= ResultEmitter::FORMAT_COUNT) {
+        printf(TEXT_ERROR "Invalid result format = %d\n", resultFormat);
+        usage(argv[0]);
+        return 1;
+    }
+    if (utilClampPolicy >= AudioSinkBase::UTIL_CLAMP_POLICY_COUNT) {
+        printf(TEXT_ERROR "Invalid utilClamp policy = %d\n", utilClampPolicy);
+        usage(argv[0]);
+        return 1;
+    }
+    if (deadlineController >= DeadlineBandwidthController::TYPE_COUNT) {
+        printf(TEXT_ERROR "Invalid deadline controller = %d\n", deadlineController);
+        usage(argv[0]);
+        return 1;
+    }
+    if (telemetryMillis > kTelemetryMaxPeriodMillis) {
+        printf(TEXT_ERROR "Invalid telemetry period = %d msec\n", telemetryMillis);
+        usage(argv[0]);
+        return 1;
+    }
     if (numSeconds < 1) {
         printf(TEXT_ERROR "Invalid duration in seconds = %d\n", numSeconds);
         usage(argv[0]);
@@ -269,6 +486,31 @@ int synthmark_command_main(int argc, char **argv)
         return 1;
     }
 
+    if (useDma && audioLevel == AudioSinkBase::AUDIO_LEVEL_OUTPUT) {
+        printf(TEXT_ERROR "-D1 requires the virtual audio sink\n");
+        usage(argv[0]);
+        return 1;
+    }
+    if (outputPath != nullptr
+            && (*outputPath == 0 || audioLevel == AudioSinkBase::AUDIO_LEVEL_OUTPUT)) {
+        printf(TEXT_ERROR "-F needs a path and the virtual audio sink\n");
+        usage(argv[0]);
+        return 1;
+    }
+    if (useDirectIo && outputPath == nullptr) {
+        printf(TEXT_ERROR "-W1 requires -F\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Lock before the sink and harness allocate their buffers.
+    if (lockMemory) {
+        int err = HostTools::lockMemory();
+        if (err < 0) {
+            printf("WARNING mlockall() failed, %d, %s\n", err, strerror(-err));
+        }
+    }
+
     if (audioLevel == AudioSinkBase::AUDIO_LEVEL_OUTPUT) {
 #if defined(__ANDROID__)
         audioSink = std::make_unique<RealAudioSink>(logTool);
@@ -279,14 +521,29 @@ int synthmark_command_main(int argc, char **argv)
 #endif
     } else
     {
-        audioSink = std::make_unique<VirtualAudioSink>(logTool);
+        std::unique_ptr<VirtualAudioSink> virtualSink;
+        if (outputPath != nullptr) {
+            std::unique_ptr<FileAudioSink> fileSink
+                    = std::make_unique<FileAudioSink>(logTool, outputPath);
+            fileSink->setDirectIoEnabled(useDirectIo);
+            virtualSink = std::move(fileSink);
+        } else {
+            virtualSink = std::make_unique<VirtualAudioSink>(logTool);
+        }
+        virtualSink->setDmaEnabled(useDma);
+        audioSink = std::move(virtualSink);
     }
     audioSink->setRequestedCpu(cpuAffinity);
     audioSink->setSchedFifoEnabled(useSchedFifo);
     audioSink->setAdpfEnabled(useADPF);
     audioSink->setUtilClampLevel(utilClampLevel);
+    audioSink->setUtilClampPolicy(utilClampPolicy);
     audioSink->setDefaultBufferSizeInBursts(bufferSizeBursts);
+    audioSink->setTimerSlackNanos(timerSlackNanos);
+    HostTools::setSleepMode(sleepMode);
     HostCpuManager::setWorkloadHintsLevel(workloadHintsLevel);
+    HostCpuManager::setDeadlineControllerType(deadlineController);
+    CpuAnalyzer::setDefaultSchedulerSamplePeriod(schedulerSampleBursts);
 
     // Create a test harness and set the parameters.
     switch(testCode) {
@@ -300,8 +557,10 @@ int synthmark_command_main(int argc, char **argv)
             break;
 
         case 'l':
+        case 'b':
         {
             LatencyMarkHarness *latencyHarness = new LatencyMarkHarness(audioSink.get(), &result, logTool);
+            latencyHarness->setSearchEnabled(testCode == 'b');
             latencyHarness->setNumVoicesHigh(numVoicesHigh);
             latencyHarness->setVoicesMode(voicesMode);
             latencyHarness->setInitialBursts(bufferSizeBursts);
@@ -338,6 +597,7 @@ int synthmark_command_main(int argc, char **argv)
         case 'a':
         {
             AutomatedTestSuite *testSuite = new AutomatedTestSuite(audioSink.get(), &result, logTool);
+            testSuite->setConcurrentDomainsEnabled(audioLevel != AudioSinkBase::AUDIO_LEVEL_OUTPUT);
             harness = testSuite;
         }
             break;
@@ -351,17 +611,125 @@ int synthmark_command_main(int argc, char **argv)
         }
             break;
 
+        case 'g':
+        {
+            harness = new GracefulMarkHarness(audioSink.get(), &result, logTool);
+        }
+            break;
+
+        case 'r':
+        {
+            GoldenRenderHarness *goldenHarness
+                    = new GoldenRenderHarness(audioSink.get(), &result, logTool);
+            if (referencePath != nullptr) {
+                goldenHarness->setReferencePath(referencePath);
+            }
+            harness = goldenHarness;
+        }
+            break;
+
+        case 'o':
+        {
+            harness = new OscillatorMarkHarness(audioSink.get(), &result, logTool);
+        }
+            break;
+
+        case 'w':
+        {
+            SweepHarness *sweepHarness = new SweepHarness(audioSink.get(), &result, logTool);
+            if (sweepGrid != nullptr && sweepHarness->setGrid(sweepGrid) < 0) {
+                printf(TEXT_ERROR "Invalid sweep grid = %s\n", sweepGrid);
+                delete sweepHarness;
+                usage(argv[0]);
+                return 1;
+            }
+            if (checkpointPath != nullptr) {
+                sweepHarness->setCheckpointPath(checkpointPath);
+            }
+            harness = sweepHarness;
+        }
+            break;
+
+        case 'x':
+        {
+            CacheSweepHarness *cacheHarness
+                    = new CacheSweepHarness(audioSink.get(), &result, logTool);
+            if (sweepGrid != nullptr && cacheHarness->setGrid(sweepGrid) < 0) {
+                printf(TEXT_ERROR "Invalid cache sweep grid = %s\n", sweepGrid);
+                delete cacheHarness;
+                usage(argv[0]);
+                return 1;
+            }
+            harness = cacheHarness;
+        }
+            break;
+
+        case 'i':
+        {
+            InterferenceMarkHarness *interferenceHarness
+                    = new InterferenceMarkHarness(audioSink.get(), &result, logTool);
+            if (interferenceConfig != nullptr
+                    && interferenceHarness->setConfig(interferenceConfig) < 0) {
+                printf(TEXT_ERROR "Invalid antagonists = %s\n", interferenceConfig);
+                delete interferenceHarness;
+                usage(argv[0]);
+                return 1;
+            }
+            interferenceHarness->setTargetCpuLoad(percentCpu * 0.01);
+            harness = interferenceHarness;
+        }
+            break;
+
+        case 'k':
+        {
+            SoakHarness *soakHarness = new SoakHarness(audioSink.get(), &result, logTool);
+            if (soakSocketPath != nullptr && soakHarness->setSocketPath(soakSocketPath) < 0) {
+                printf(TEXT_ERROR "Invalid soak socket path = %s\n", soakSocketPath);
+                delete soakHarness;
+                usage(argv[0]);
+                return 1;
+            }
+            harness = soakHarness;
+        }
+            break;
+
+        case 'h':
+            harness = new HandoffMatrixHarness(audioSink.get(), &result, logTool);
+            break;
+
+        case 'q':
+        {
+            WakeupMarkHarness *wakeupHarness
+                    = new WakeupMarkHarness(audioSink.get(), &result, logTool);
+            wakeupHarness->setLoadMicros(wakeupLoadMicros);
+            harness = wakeupHarness;
+        }
+            break;
+
         default:
             printf(TEXT_ERROR "unrecognized testCode = %c\n", testCode);
             usage(argv[0]);
             return 1;
             break;
     }
+    if (numTrials > 1) {
+        // Every harness is a TestHarnessParameters.
+        harness = new RepeatedTestHarness(static_cast<TestHarnessParameters *>(harness),
+                                          numTrials, audioSink.get(), &result, logTool);
+    }
     harness->setNumVoices(numVoices);
     harness->setDelayNoteOnSeconds(numSecondsDelayNoteOn);
     harness->setThreadType(useAudioThread
                            ? HostThreadFactory::ThreadType::Audio
                            : HostThreadFactory::ThreadType::Default);
+    SynthesizerSettings synthesizerSettings;
+    synthesizerSettings.voiceType = (VoiceType) voiceType;
+    synthesizerSettings.oversampleFactor = oversampleFactor;
+    synthesizerSettings.effectsEnabled = useEffects;
+    synthesizerSettings.pipelineWorkers = pipelineWorkers;
+    synthesizerSettings.degradationEnabled = useDegradation;
+    harness->setSynthesizerSettings(synthesizerSettings);
+    harness->setTelemetryPeriodMillis(telemetryMillis);
 
     // Print specified parameters.
     printf("  test.name            = %s\n",  harness->getName());
@@ -377,7 +745,38 @@ int synthmark_command_main(int argc, char **argv)
     printf("  cpu.count            = %6d\n", HostTools::getCpuCount());
     printf("  audio.level          = %6d\n", audioLevel);
     printf("  util.clamp           = %6d\n", utilClampLevel);
+    if (audioSink->isUtilClampDynamic()) {
+        printf("  util.clamp.policy    = %6d, %s\n", utilClampPolicy,
+               AudioSinkBase::getUtilClampPolicyName(utilClampPolicy));
+    }
     printf("  workload.hints       = %6d\n", workloadHintsLevel);
+    if (HostCpuManager::areWorkloadHintsEnabled()) {
+        printf("  dl.controller        = %6d, %s\n", deadlineController,
+               DeadlineBandwidthController::getTypeName(deadlineController));
+    }
+    printf("  voice.type           = %6d, %s\n", voiceType,
+           VoiceRegistry::getName(synthesizerSettings.voiceType));
+    printf("  voice.oversample     = %6d\n", oversampleFactor);
+    printf("  effects.enabled      = %6d\n", useEffects ? 1 : 0);
+    printf("  pipeline.workers     = %6d\n", pipelineWorkers);
+    printf("  degradation.enabled  = %6d\n", useDegradation ? 1 : 0);
+    printf("  sleep.mode           = %6d, %s\n", sleepMode, HostTools::getSleepModeName(sleepMode));
+    printf("  timer.slack.nanos    = %6lld\n", (long long) timerSlackNanos);
+    printf("  dma.enabled          = %6d\n", useDma ? 1 : 0);
+    printf("  memory.locked        = %6d\n", HostTools::isMemoryLocked() ? 1 : 0);
+    printf("  telemetry.msec       = %6d\n", telemetryMillis);
+    printf("  sched.sample.bursts  = %6d\n", schedulerSampleBursts);
+    printf("  repeat.trials        = %6d\n", std::max(1, numTrials));
+    printf("  result.format        = %6d, %s\n", resultFormat,
+           ResultEmitter::getFormatName(resultFormat));
+    if (resultFormat != ResultEmitter::FORMAT_TEXT) {
+        printf("  result.path          = %s\n",
+               (resultPath == nullptr || *resultPath == 0) ? "stderr" : resultPath);
+    }
+    if (outputPath != nullptr) {
+        printf("  output.path          = %s\n", outputPath);
+        printf("  output.direct.io     = %6d\n", useDirectIo ? 1 : 0);
+    }
     printf("# wait at least %d seconds for benchmark to complete\n", numSeconds);
     fflush(stdout);
 
@@ -399,9 +798,37 @@ int synthmark_command_main(int argc, char **argv)
         fflush(stdout);
     }
 
+    // Restore any CPU settings that were changed.
+    HostCpuManager::releaseInstance();
+
     // Print the test results.
-    std::cout << result.getResultMessage();
+    StructuredResult structuredResult(result);
+    structuredResult.addMetadata("harness", harness->getName());
+    structuredResult.addMetadata("test.code", std::string(1, testCode));
+    structuredResult.addMetadata("sample.rate", std::to_string(sampleRate));
+    structuredResult.addMetadata("frames.per.burst", std::to_string(framesPerBurst));
+    structuredResult.addMetadata("num.voices", std::to_string(numVoices));
+    structuredResult.addMetadata("num.voices.high", std::to_string(numVoicesHigh));
+    structuredResult.addMetadata("seconds", std::to_string(numSeconds));
+    structuredResult.addMetadata("cpu.affinity", std::to_string(cpuAffinity));
+    structuredResult.addMetadata("cpu.count", std::to_string(HostTools::getCpuCount()));
+    structuredResult.addMetadata("audio.level", std::to_string(audioLevel));
+    // The text report goes to stdout and the structured results to their own stream,
+    // so the two never have to be separated again.
+    ResultEmitter::create(ResultEmitter::FORMAT_TEXT)->emit(structuredResult, std::cout);
     fflush(stdout);
+    if (resultFormat != ResultEmitter::FORMAT_TEXT) {
+        if (resultPath == nullptr || *resultPath == 0) {
+            ResultEmitter::create(resultFormat)->emit(structuredResult, std::cerr);
+        } else {
+            std::ofstream resultFile(resultPath, std::ios::app);
+            if (!resultFile) {
+                printf(TEXT_ERROR "Could not open %s\n", resultPath);
+                return 1;
+            }
+            ResultEmitter::create(resultFormat)->emit(structuredResult, resultFile);
+        }
+    }
 
     return result.getResultCode();
 }
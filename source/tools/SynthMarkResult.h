@@ -20,6 +20,8 @@
 #include <cstdint>
 #include <string>
 
+#include "ResultReport.h"
+
 
 // TODO Use synthmark namespace and more C++ style naming conventions.
 enum : int32_t {
@@ -43,7 +45,7 @@ enum : int32_t {
  *
  * SynthMark version
  * Numeric result of test
- * Text report that may include CSV values.
+ * Report with typed metrics and tables, and the text rendered from them.
  *
  */
 class SynthMarkResult {
@@ -56,7 +58,7 @@ public:
 
     void reset() {
         mMeasurement = 0.0;
-        mResultMessage.clear();
+        mReport.clear();
     }
 
     std::string getTestName() {
@@ -68,11 +70,22 @@ public:
     }
 
     std::string getResultMessage() {
-        return mResultMessage;
+        return mReport.getText();
     }
 
+    /**
+     * Append text that is not a result, eg. a comment or TEXT_RESULTS_BEGIN.
+     */
     void appendMessage(std::string message) {
-        mResultMessage.append(message);
+        mReport << message;
+    }
+
+    void appendReport(const ResultReport &report) {
+        mReport << report;
+    }
+
+    const ResultReport &getReport() const {
+        return mReport;
     }
 
     int32_t getResultCode() {
@@ -98,7 +111,7 @@ public:
 private:
 
     std::string mTestName;
-    std::string mResultMessage;
+    ResultReport mReport;
     int32_t mResultCode;
     double mMeasurement;
 
@@ -19,6 +19,7 @@
 
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 
 /**
  * A fractional amplitude corresponding to exactly -96 dB.
@@ -141,11 +142,21 @@ public:
     }
 
 
+    static constexpr uint64_t kDefaultRandomSeed = 99887766;
+
+    /**
+     * Restart the random sequence so that a render can be repeated exactly.
+     * Each thread has its own sequence, which starts at kDefaultRandomSeed.
+     */
+    static void setRandomSeed(uint64_t seed) {
+        getRandomSeed() = seed;
+    }
+
     /**
      * Calculate random 32 bit number using linear-congruential method.
      */
     static uint32_t nextRandomInteger() {
-        static uint64_t seed = 99887766;
+        uint64_t &seed = getRandomSeed();
         // Use values for 64-bit sequence from MMIX by Donald Knuth.
         seed = (seed * 6364136223846793005L) + 1442695040888963407L;
         return (uint32_t) (seed >> 32); // The higher bits have a longer sequence.
@@ -159,6 +170,28 @@ public:
         return nextRandomInteger() * scaler;
     }
 
+    static constexpr uint32_t kChecksumSeed = 2166136261u; // FNV-1a offset basis
+
+    /**
+     * Update a 32-bit FNV-1a hash with the exact bits of each sample.
+     * Start with kChecksumSeed.
+     */
+    static uint32_t checksumFloats(uint32_t hash, const float *data, int32_t numSamples) {
+        const uint32_t kPrime = 16777619u;
+        for (int32_t i = 0; i < numSamples; i++) {
+            uint32_t bits;
+            memcpy(&bits, &data[i], sizeof(bits));
+            hash = (hash ^ bits) * kPrime;
+        }
+        return hash;
+    }
+
+private:
+    static uint64_t &getRandomSeed() {
+        static thread_local uint64_t seed = kDefaultRandomSeed;
+        return seed;
+    }
+
 };
 
 #endif // SYNTHMARK_SYNTHTOOLS_H
@@ -0,0 +1,405 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SYNTHMARK_SYSFS_HOST_CPU_MANAGER_H
+#define SYNTHMARK_SYSFS_HOST_CPU_MANAGER_H
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "HostTools.h"
+
+/**
+ * Request CPU clock speeds through cpufreq in sysfs based on the work unit model.
+ *
+ * Like HostCpuManagerStub, it measures how long each callback takes, scales it
+ * by the real clock divided by the maximum clock, and divides by the number
+ * of work units. setApplicationLoad() then calculates the clock needed to run
+ * the new load at kTargetUtilization and requests it from the cpufreq policy
+ * of the CPU that the audio thread is running on.
+ *
+ * MODE_MIN_FREQ raises scaling_min_freq so the governor, eg. schedutil, may still go higher.
+ * MODE_USERSPACE switches the policy to the userspace governor and writes scaling_setspeed.
+ *
+ * The requests are written by a normal priority thread so the audio thread
+ * never blocks in sysfs. The audio thread just posts the latest request for each policy.
+ *
+ * The original settings are restored when the manager is deleted or when
+ * the process gets SIGINT or SIGTERM. Writing sysfs usually requires root.
+ * If the files cannot be written then the manager just measures.
+ */
+class SysfsHostCpuManager : public HostCpuManagerBase
+{
+public:
+    enum Mode : int32_t {
+        MODE_MIN_FREQ,
+        MODE_USERSPACE,
+    };
+
+    explicit SysfsHostCpuManager(Mode mode)
+    : mMode(mode) {
+        openPolicies();
+        mPendingRequestKHz = std::make_unique<std::atomic<int32_t>[]>(mPolicies.size());
+        for (size_t i = 0; i < mPolicies.size(); i++) {
+            mPendingRequestKHz[i].store(0);
+        }
+        mWriterThread = std::thread(&SysfsHostCpuManager::writerLoop, this);
+    }
+
+    virtual ~SysfsHostCpuManager() {
+        mQuit.store(true);
+        mRequestSequence.increment();
+        mRequestSequence.wakeAll();
+        mWriterThread.join();
+        restoreSettings();
+        for (Policy &policy : mPolicies) {
+            if (policy.curFreqFd >= 0) close(policy.curFreqFd);
+            if (policy.requestFd >= 0) close(policy.requestFd);
+        }
+    }
+
+    void sleepAndTuneCPU(int64_t wakeupTime) override {
+        int64_t endingTime = HostTools::getNanoTime();
+        int endingCpu = HostThread::getCpu();
+        if (endingCpu == mStartingCpu && mStartingTime > 0) {
+            updateModel(endingCpu, endingTime - mStartingTime);
+        }
+
+        // Re-evaluate periodically because the model keeps learning.
+        if (++mBurstCounter >= kUpdatePeriodBursts) {
+            mBurstCounter = 0;
+            requestFrequencyForLoad(getCurrentWorkUnits());
+        }
+
+        if (wakeupTime > 0) {
+            HostTools::sleepUntilNanoTime(wakeupTime); // SLEEP
+        }
+
+        mStartingCpu = HostThread::getCpu();
+        mStartingTime = HostTools::getNanoTime();
+    }
+
+    void setApplicationLoad(int32_t currentWorkUnits, int32_t maxWorkUnits) override {
+        if (currentWorkUnits != getCurrentWorkUnits()
+                || maxWorkUnits != getMaxWorkUnits()) {
+            requestFrequencyForLoad(currentWorkUnits);
+        }
+        HostCpuManagerBase::setApplicationLoad(currentWorkUnits, maxWorkUnits);
+    }
+
+    ResultReport dump() override {
+        ResultReport report;
+        report << std::endl;
+        report.addHeading("SysfsHostCpuManager");
+        report.addMetric("sysfs.manager.mode",
+                         (mMode == MODE_USERSPACE) ? "userspace" : "min_freq");
+        int32_t numWritable = 0;
+        for (const Policy &policy : mPolicies) {
+            if (policy.requestFd >= 0) numWritable++;
+        }
+        report.addMetric("sysfs.manager.policies", mPolicies.size());
+        report.addMetric("sysfs.manager.writable.policies", numWritable);
+        report.addMetric("sysfs.manager.requests", mRequestCount);
+        report.addMetric("sysfs.manager.write.failures", mWriteFailures.load());
+        for (const Policy &policy : mPolicies) {
+            std::string prefix = "sysfs.manager.policy" + std::to_string(policy.cpus.front());
+            report.addMetric(prefix + ".cpus", HostTools::formatCpuList(policy.cpus));
+            report.addMetric(prefix + ".min.khz", policy.minFrequencyKHz);
+            report.addMetric(prefix + ".max.khz", policy.maxFrequencyKHz);
+            report.addMetric(prefix + ".requests", policy.requestCount);
+            if (policy.requestCount > 0) {
+                report.addMetric(prefix + ".mean.request.khz",
+                                 policy.sumRequestKHz / policy.requestCount);
+            }
+        }
+        return report;
+    }
+
+    /**
+     * Write back the settings that were changed. This is safe to call more than once.
+     */
+    static void restoreSettings() {
+        // Only async-signal-safe calls are used here.
+        for (int i = sNumRestoreEntries - 1; i >= 0; i--) {
+            const RestoreEntry &entry = sRestoreEntries[i];
+            int fd = open(entry.path, O_WRONLY | O_CLOEXEC);
+            if (fd >= 0) {
+                ssize_t ignored = write(fd, entry.value, strlen(entry.value));
+                (void) ignored;
+                close(fd);
+            }
+        }
+        sNumRestoreEntries = 0;
+    }
+
+private:
+    static constexpr double  kTargetUtilization = 0.8;
+    static constexpr double  kSmoothing = 0.5; // weight of the newest measurement
+    static constexpr double  kHysteresis = 0.05; // ignore requests that change less than this
+    static constexpr int32_t kUpdatePeriodBursts = 32;
+    static constexpr int32_t kFrequencyReadPeriodBursts = 8;
+    static constexpr int32_t kMaxRestoreEntries = 64;
+    static constexpr int32_t kMaxRestoreTextSize = 128;
+
+    struct Policy {
+        std::vector<int> cpus;
+        std::string      path;
+        int              curFreqFd = -1;
+        int              requestFd = -1; // scaling_min_freq or scaling_setspeed
+        int32_t          minFrequencyKHz = 0;
+        int32_t          maxFrequencyKHz = 0;
+        int32_t          currentFrequencyKHz = 0;
+        int32_t          requestedFrequencyKHz = 0;
+        int32_t          readCountdown = 0;
+        int32_t          requestCount = 0;
+        int64_t          sumRequestKHz = 0;
+        double           normalizedWorkUnitUtilization = 0.0;
+    };
+
+    struct RestoreEntry {
+        char path[kMaxRestoreTextSize];
+        char value[kMaxRestoreTextSize];
+    };
+
+    static std::string readString(const std::string &path) {
+        char buffer[256] = {};
+        FILE *file = fopen(path.c_str(), "r");
+        if (file == nullptr) return "";
+        if (fgets(buffer, sizeof(buffer), file) == nullptr) buffer[0] = 0;
+        fclose(file);
+        std::string text(buffer);
+        text.erase(text.find_last_not_of(" \n") + 1);
+        return text;
+    }
+
+    static int32_t readInteger(int fd) {
+        char buffer[32];
+        ssize_t count = pread(fd, buffer, sizeof(buffer) - 1, 0);
+        if (count <= 0) return 0;
+        buffer[count] = 0;
+        return (int32_t) strtol(buffer, nullptr, 10);
+    }
+
+    static bool writeString(int fd, const std::string &text) {
+        return pwrite(fd, text.c_str(), text.size(), 0) == (ssize_t) text.size();
+    }
+
+    static bool writeString(const std::string &path, const std::string &text) {
+        int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        bool ok = writeString(fd, text);
+        close(fd);
+        return ok;
+    }
+
+    /**
+     * Remember a setting so it can be restored, then install the signal handlers.
+     */
+    static bool saveSetting(const std::string &path, const std::string &value) {
+        if (sNumRestoreEntries >= kMaxRestoreEntries
+                || path.size() >= kMaxRestoreTextSize
+                || value.size() >= kMaxRestoreTextSize
+                || value.empty()) {
+            return false;
+        }
+        RestoreEntry &entry = sRestoreEntries[sNumRestoreEntries];
+        strncpy(entry.path, path.c_str(), sizeof(entry.path));
+        strncpy(entry.value, value.c_str(), sizeof(entry.value));
+        sNumRestoreEntries++;
+        if (!sHandlersInstalled) {
+            signal(SIGINT, restoreAndExit);
+            signal(SIGTERM, restoreAndExit);
+            sHandlersInstalled = true;
+        }
+        return true;
+    }
+
+    static void restoreAndExit(int sig) {
+        restoreSettings();
+        signal(sig, SIG_DFL);
+        raise(sig);
+    }
+
+    void openPolicies() {
+        std::vector<int> onlineCpus;
+        if (!HostTools::parseCpuList(readString("/sys/devices/system/cpu/online"), &onlineCpus)) {
+            return;
+        }
+        for (int cpu : onlineCpus) {
+            if (cpu >= kMaxCpuCount || mPolicyIndexByCpu[cpu] >= 0) continue;
+            std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/";
+            Policy policy;
+            if (!HostTools::parseCpuList(readString(path + "related_cpus"), &policy.cpus)) {
+                continue;
+            }
+            policy.path = path;
+            policy.minFrequencyKHz = atoi(readString(path + "cpuinfo_min_freq").c_str());
+            policy.maxFrequencyKHz = atoi(readString(path + "cpuinfo_max_freq").c_str());
+            policy.curFreqFd = open((path + "scaling_cur_freq").c_str(), O_RDONLY | O_CLOEXEC);
+            if (policy.maxFrequencyKHz <= 0 || policy.curFreqFd < 0) {
+                if (policy.curFreqFd >= 0) close(policy.curFreqFd);
+                continue;
+            }
+            policy.currentFrequencyKHz = readInteger(policy.curFreqFd);
+            openRequestFile(&policy);
+            for (int related : policy.cpus) {
+                if (related >= 0 && related < kMaxCpuCount) {
+                    mPolicyIndexByCpu[related] = (int) mPolicies.size();
+                }
+            }
+            mPolicies.push_back(policy);
+        }
+    }
+
+    void openRequestFile(Policy *policy) {
+        const std::string &path = policy->path;
+        if (mMode == MODE_USERSPACE) {
+            std::string governors = readString(path + "scaling_available_governors");
+            std::string governor = readString(path + "scaling_governor");
+            if (governors.find("userspace") == std::string::npos) {
+                return;
+            }
+            if (governor != "userspace") {
+                std::string setspeed = readString(path + "scaling_cur_freq");
+                if (!writeString(path + "scaling_governor", "userspace")) {
+                    return;
+                }
+                saveSetting(path + "scaling_governor", governor);
+                writeString(path + "scaling_setspeed", setspeed);
+            }
+            policy->requestFd = open((path + "scaling_setspeed").c_str(), O_WRONLY | O_CLOEXEC);
+        } else {
+            std::string minFreq = readString(path + "scaling_min_freq");
+            policy->requestFd = open((path + "scaling_min_freq").c_str(), O_WRONLY | O_CLOEXEC);
+            if (policy->requestFd >= 0 && !saveSetting(path + "scaling_min_freq", minFreq)) {
+                close(policy->requestFd);
+                policy->requestFd = -1;
+            }
+        }
+    }
+
+    Policy *getPolicyForCpu(int cpu) {
+        if (cpu < 0 || cpu >= kMaxCpuCount || mPolicyIndexByCpu[cpu] < 0) {
+            return nullptr;
+        }
+        return &mPolicies[mPolicyIndexByCpu[cpu]];
+    }
+
+    /**
+     * Update the normalized CPU runtime per work unit.
+     */
+    void updateModel(int cpu, int64_t callbackNanos) {
+        Policy *policy = getPolicyForCpu(cpu);
+        int32_t workUnits = getCurrentWorkUnits();
+        if (policy == nullptr || workUnits <= 0 || getNanosPerBurst() <= 0) {
+            return;
+        }
+        if (--policy->readCountdown <= 0) {
+            policy->readCountdown = kFrequencyReadPeriodBursts;
+            policy->currentFrequencyKHz = readInteger(policy->curFreqFd);
+        }
+        double normalizedSpeed = policy->currentFrequencyKHz / (double) policy->maxFrequencyKHz;
+        double utilization = callbackNanos / (double) getNanosPerBurst();
+        double perWorkUnit = normalizedSpeed * utilization / workUnits;
+        policy->normalizedWorkUnitUtilization = (policy->normalizedWorkUnitUtilization == 0.0)
+                ? perWorkUnit
+                : ((1.0 - kSmoothing) * policy->normalizedWorkUnitUtilization
+                   + kSmoothing * perWorkUnit);
+    }
+
+    /**
+     * Write the requests posted by the audio thread. Runs at normal priority.
+     */
+    void writerLoop() {
+        int32_t sequence = 0;
+        while (true) {
+            mRequestSequence.waitWhileEqual(sequence);
+            sequence = mRequestSequence.load();
+            for (size_t i = 0; i < mPolicies.size(); i++) {
+                int32_t requestKHz = mPendingRequestKHz[i].exchange(0);
+                if (requestKHz > 0
+                        && !writeString(mPolicies[i].requestFd, std::to_string(requestKHz))) {
+                    mWriteFailures++;
+                }
+            }
+            if (mQuit.load()) {
+                break;
+            }
+        }
+    }
+
+    /**
+     * Calculate the clock needed for the load and post it to the writer if it changed enough.
+     */
+    void requestFrequencyForLoad(int32_t workUnits) {
+        Policy *policy = getPolicyForCpu(HostThread::getCpu());
+        if (policy == nullptr || policy->requestFd < 0
+                || policy->normalizedWorkUnitUtilization <= 0.0) {
+            return;
+        }
+        double required = workUnits * policy->normalizedWorkUnitUtilization
+                * policy->maxFrequencyKHz / kTargetUtilization;
+        int32_t requestKHz = (int32_t) std::min((double) policy->maxFrequencyKHz,
+                std::max((double) policy->minFrequencyKHz, required));
+        int32_t previous = policy->requestedFrequencyKHz;
+        if (previous > 0 && std::abs(requestKHz - previous) < kHysteresis * previous) {
+            return;
+        }
+        // A request that has not been written yet is replaced by this one.
+        mPendingRequestKHz[policy - mPolicies.data()].store(requestKHz);
+        mRequestSequence.increment();
+        mRequestSequence.wakeAll();
+        policy->requestedFrequencyKHz = requestKHz;
+        policy->requestCount++;
+        policy->sumRequestKHz += requestKHz;
+        mRequestCount++;
+    }
+
+    const Mode          mMode;
+    std::vector<Policy> mPolicies;
+    std::vector<int>    mPolicyIndexByCpu = std::vector<int>(kMaxCpuCount, -1);
+
+    int                 mStartingCpu = -1;
+    int64_t             mStartingTime = 0;
+    int32_t             mBurstCounter = 0;
+    int32_t             mRequestCount = 0;
+
+    // The latest request for each policy in kHz, or 0 after it has been written.
+    std::unique_ptr<std::atomic<int32_t>[]> mPendingRequestKHz;
+    HostFutex           mRequestSequence;
+    std::atomic<bool>   mQuit{false};
+    std::atomic<int32_t> mWriteFailures{0};
+    std::thread         mWriterThread;
+
+    static RestoreEntry sRestoreEntries[kMaxRestoreEntries];
+    static volatile int sNumRestoreEntries;
+    static bool         sHandlersInstalled;
+};
+
+#endif // SYNTHMARK_SYSFS_HOST_CPU_MANAGER_H
@@ -20,6 +20,7 @@
 #include <iomanip>
 #include <cmath>
 #include <cstdint>
+#include <vector>
 
 #include "AudioSinkBase.h"
 #include "BinCounter.h"
@@ -31,6 +32,8 @@
 #include "tools/CpuAnalyzer.h"
 #include "tools/LogTool.h"
 #include "tools/ITestHarness.h"
+#include "tools/LoadShedController.h"
+#include "tools/RenderPipeline.h"
 #include "tools/TimingAnalyzer.h"
 #include "tools/TestHarnessBase.h"
 #include "HostThreadFactory.h"
@@ -90,6 +93,10 @@ public:
         return err;
     };
 
+    void onBeginAudioThread() override {
+        mCpuAnalyzer.beginOnAudioThread();
+    }
+
     // This is called by the AudioSink in a loop.
     virtual IAudioSinkCallback::Result onRenderAudio(float *buffer,
                                                      int32_t numFrames) override {
@@ -98,6 +105,18 @@ public:
         if (mFrameCounter >= mFramesNeeded || isCancelled()) {
             return IAudioSinkCallback::Result::Finished;
         }
+        if (mStopOnUnderrun && mAudioSink->getUnderrunCount() > 0) {
+            return IAudioSinkCallback::Result::Finished; // no need to run any longer
+        }
+
+        // The voices must not be touched while the workers are rendering them.
+        if (mPipeline) {
+            mPipeline->waitForVoices();
+        }
+
+        if (mSynthesizerSettings.degradationEnabled && mBurstCounter > 0) {
+            applyLoadShedding();
+        }
 
         // Only start turning notes on and off after the initial delay
         if (mFrameCounter >= mDelayNotesOnUntilFrame){
@@ -116,8 +135,9 @@ public:
                         return IAudioSinkCallback::Result::Finished;
                     }
                     int32_t currentNumVoices = getCurrentNumVoices();
-                    HostCpuManager::getInstance()->setApplicationLoad(currentNumVoices,
-                                                                      kSynthmarkMaxVoices);
+                    mAudioSink->getCpuManager()->setApplicationLoad(currentNumVoices,
+                                                                    kSynthmarkMaxVoices);
+                    mAudioSink->setApplicationLoad(currentNumVoices, kSynthmarkMaxVoices);
                     result = mSynth.notesOn(currentNumVoices);
                     if (result < 0) {
                         mLogTool.log("%s() notesOn() returned %d\n", __func__, result);
@@ -139,15 +159,29 @@ public:
                                     - mFramesPerBurst;
         int64_t idealTime = mAudioSink->convertFrameToTime(fullFramePosition);
         mTimer.markEntry(idealTime);
-        mSynth.renderStereo(buffer, numFrames);  // DO THE MATH!
+        if (mPipeline) {
+            mPipeline->renderStereo(buffer, numFrames); // voices were rendered by the workers
+            mTimer.addOtherThreadDuration(mPipeline->getOutputRenderNanos());
+        } else {
+            mSynth.renderStereo(buffer, numFrames);  // DO THE MATH!
+        }
+        if (mSynth.areEffectsEnabled()) {
+            mTimer.markEffectsEntry();
+            mSynth.renderEffects(buffer, numFrames);
+            mTimer.markEffectsExit();
+        }
         mTimer.markExit();
+        recordCycleRenderTime(mTimer.getLastRenderDurationNanos()
+                              + mTimer.getLastOtherThreadDurationNanos());
 
-        mCpuAnalyzer.recordCpu(); // at end so we have less affect on timing
+        int cpuIndex = mCpuAnalyzer.recordCpu(); // at end so we have less affect on timing
+        CpuTelemetrySampler::setAudioCpu(cpuIndex);
 
         mLogTool.setVar1(mBurstCounter);
 
         mFrameCounter += numFrames;
         mBurstCounter++;
+        CpuTelemetrySampler::setAudioBurst(mBurstCounter);
 
         return IAudioSinkCallback::Result::Continue;
     }
@@ -163,7 +197,7 @@ public:
         assert(mResult != NULL);
 
         int32_t result; // Used to store the results of various operations during the test
-        mFramesNeeded = (int)(mSampleRate * seconds);
+        mFramesNeeded = (int64_t)(mSampleRate * seconds);
         mFrameCounter = 0;
         mBurstCounter = 0;
         mLogTool.setVar1(mBurstCounter);
@@ -174,6 +208,16 @@ public:
         mBurstsOn = (int) (0.2 * mSampleRate / mFramesPerBurst);
         mBurstsOff = (int) (0.3 * mSampleRate / mFramesPerBurst);
 
+        // Allocate the cycle times here, not in the callback.
+        int32_t burstsPerCycle = std::max(1, mBurstsOn + mBurstsOff);
+        mCycleRenderNanos.assign(mFramesNeeded / (mFramesPerBurst * burstsPerCycle) + 1, 0.0);
+        mNumCycles = 0;
+        mCycleBursts = 0;
+        mCycleSumNanos = 0;
+
+        mLoadShedController.reset();
+        mSynth.setDegradationLevel(kDegradationNone);
+
         onBeginMeasurement();
 
         mAudioSink->setCallback(this);
@@ -198,11 +242,46 @@ public:
 
         onEndMeasurement();
         mLogTool.clearVar1();
+        int32_t outputError = mAudioSink->getOutputError();
+        if (outputError < 0) {
+            mLogTool.log("ERROR the audio sink lost some of the output, %d\n", outputError);
+            result = outputError;
+        }
         mResult->setResultCode(result);
         return result;
     }
 
-    std::string dumpJitter() {
+    /**
+     * Degrade the synthesizer based on how long the previous burst took.
+     * This is called while the voices are idle.
+     */
+    void applyLoadShedding() {
+        int64_t nanosPerBurst = (mFramesPerBurst * SYNTHMARK_NANOS_PER_SECOND) / mSampleRate;
+        int64_t renderNanos = mTimer.getLastRenderDurationNanos();
+        if (mPipeline) {
+            // The workers render the voices with a whole burst to do it,
+            // so shed voices when the burst they just finished was slow.
+            renderNanos = mPipeline->getLastRenderNanos();
+        }
+        int32_t level = mLoadShedController.onBurstRendered(renderNanos, nanosPerBurst);
+        mSynth.setDegradationLevel(level);
+        if (mLoadShedController.isShedRequested()) {
+            int32_t numToShed = mLoadShedController.getNumVoicesToShed(
+                    mSynth.getActiveVoiceCount());
+            mLoadShedController.addVoicesShed(mSynth.shedQuietestReleasingVoices(numToShed));
+        }
+    }
+
+    std::vector<double> getCycleRenderNanos() const override {
+        return std::vector<double>(mCycleRenderNanos.begin(),
+                                   mCycleRenderNanos.begin() + mNumCycles);
+    }
+
+    LoadShedController &getLoadShedController() {
+        return mLoadShedController;
+    }
+
+    ResultReport dumpJitter() {
         return mTimer.dumpJitter();
     }
 
@@ -252,14 +331,47 @@ public:
         mSamplesPerFrame = samplesPerFrame;
         mFramesPerBurst = framesPerBurst;
 
-        mSynth.setup(sampleRate, kSynthmarkMaxVoices);
+        mPipeline.reset(); // the workers must not be rendering the old voices
+        mSynth.setup(sampleRate, kSynthmarkMaxVoices, mSynthesizerSettings);
+
+        int32_t numWorkers = mSynthesizerSettings.pipelineWorkers;
+        if (numWorkers > 0) {
+            mPipeline = std::make_unique<RenderPipeline>(mSynth);
+            if (mPipeline->start(numWorkers, framesPerBurst,
+                                 mAudioSink->isSchedFifoEnabled()) < 0) {
+                mLogTool.log("ERROR in open, could not start %d pipeline workers\n", numWorkers);
+                mPipeline.reset();
+                return -1;
+            }
+        }
         return mAudioSink->open(sampleRate, samplesPerFrame, framesPerBurst);
     }
 
     int32_t close() {
+        if (mPipeline) {
+            mPipelineReport = mPipeline->dump();
+            mPipeline.reset(); // join the workers
+        }
         return mAudioSink->close();
     }
 
+    /**
+     * With -P the voices are rendered by the workers, so their duty cycle is used.
+     * It is the time from the first worker starting to the last one finishing,
+     * as a fraction of the wall time.
+     * @return fraction of the time spent rendering the voices since mTimer was reset
+     */
+    double getVoiceDutyCycle() {
+        return mPipeline ? mTimer.getOtherThreadDutyCycle() : mTimer.getDutyCycle();
+    }
+
+    /**
+     * @return statistics from the last pipelined run, may be empty
+     */
+    const ResultReport &dumpPipeline() const {
+        return mPipelineReport;
+    }
+
     bool isVerbose() {
         return mVerbose;
     }
@@ -272,10 +384,21 @@ public:
         mAudioSink->setThreadType(mThreadType);
     }
 
-    int32_t getFrameCount() {
+    int64_t getFrameCount() {
         return mFrameCounter;
     }
 
+    int32_t getVoiceStateBytes() const {
+        return mSynth.getVoiceStateBytes();
+    }
+
+    /**
+     * End the measurement as soon as the audio sink reports an underrun.
+     */
+    void setStopOnUnderrun(bool stop) {
+        mStopOnUnderrun = stop;
+    }
+
     double calculateRequiredLatencyMillis() {
         return 1000.0 * mAudioSink->getMaxEmptyFrames() / getSampleRate();
     }
@@ -297,13 +420,16 @@ protected:
     Synthesizer      mSynth;
     TimingAnalyzer   mTimer;
     CpuAnalyzer      mCpuAnalyzer;
+    std::unique_ptr<RenderPipeline> mPipeline;
+    LoadShedController mLoadShedController;
+    ResultReport     mPipelineReport;
     std::string      mTestName;
 
     int32_t          mSampleRate = 0;
     int32_t          mSamplesPerFrame = 0;
     int32_t          mFramesPerBurst = 0;  // number of frames read by hardware at one time
-    int32_t          mFrameCounter = 0;
-    int32_t          mFramesNeeded = 0;
+    int64_t          mFrameCounter = 0; // 32 bits would overflow after 12 hours at 48000 Hz
+    int64_t          mFramesNeeded = 0;
     int32_t          mDelayNotesOnUntilFrame = 0;
     int32_t          mNoteCounter = 0;
     int32_t          mBurstCounter = 0;
@@ -316,7 +442,31 @@ protected:
     int32_t          mBurstsOff = 0;
 
 private:
+    /**
+     * Average the render time over each note on and off cycle, after the note on delay,
+     * so that a warm-up can be found in the timing without the notes toggling.
+     */
+    void recordCycleRenderTime(int64_t renderNanos) {
+        if (mFrameCounter < mDelayNotesOnUntilFrame) {
+            return;
+        }
+        mCycleSumNanos += renderNanos;
+        mCycleBursts++;
+        if (mCycleBursts >= mBurstsOn + mBurstsOff
+                && mNumCycles < (int32_t) mCycleRenderNanos.size()) {
+            mCycleRenderNanos[mNumCycles++] = (double) mCycleSumNanos / mCycleBursts;
+            mCycleBursts = 0;
+            mCycleSumNanos = 0;
+        }
+    }
+
+    std::vector<double> mCycleRenderNanos;
+    int32_t          mNumCycles = 0;
+    int32_t          mCycleBursts = 0;
+    int64_t          mCycleSumNanos = 0;
+
     bool             mVerbose = false;
+    bool             mStopOnUnderrun = false;
 
     static bool      mCancelled;
 };
@@ -18,7 +18,9 @@
 #define ANDROID_TEST_HARNESS_PARAMETERS_H
 
 #include <cstdint>
+#include <memory>
 #include <thread>
+#include <vector>
 #include "AudioSinkBase.h"
 #include "BinCounter.h"
 #include "HostTools.h"
@@ -26,6 +28,7 @@
 #include "SynthMarkResult.h"
 #include "synth/Synthesizer.h"
 #include "tools/CpuAnalyzer.h"
+#include "tools/CpuTelemetrySampler.h"
 #include "tools/LogTool.h"
 #include "tools/ITestHarness.h"
 #include "tools/TimingAnalyzer.h"
@@ -62,8 +65,13 @@ public:
                             int32_t framesPerBurst,
                             int32_t numSeconds) override {
         mResult->appendMessage("\n" TEXT_RESULTS_BEGIN "\n");
+        startTelemetry(sampleRate, framesPerBurst);
         int32_t result = runTest(sampleRate, framesPerBurst, numSeconds);
-        mResult->appendMessage(mAudioSink->dump());
+        stopTelemetry();
+        mResult->appendReport(mAudioSink->dump());
+        mResult->appendReport(HostCpuManager::getInstance()->dump());
+        // Restore any CPU settings that were changed, whichever app ran the test.
+        HostCpuManager::releaseInstance();
         mResult->appendMessage(TEXT_RESULTS_END "\n");
         mRunning = false;
         return result;
@@ -118,6 +126,14 @@ public:
         return mNumVoicesHigh;
     }
 
+    void setSynthesizerSettings(const SynthesizerSettings &settings) override {
+        mSynthesizerSettings = settings;
+    }
+
+    const SynthesizerSettings &getSynthesizerSettings() const {
+        return mSynthesizerSettings;
+    }
+
     SynthMarkResult *getResult() {
         return mResult;
     }
@@ -130,12 +146,47 @@ public:
         return mAudioSink->getSampleRate();
     }
 
+    /**
+     * Sample the CPU clocks and temperatures while the test runs.
+     * @param periodMillis time between samples or zero to disable
+     */
+    void setTelemetryPeriodMillis(int32_t periodMillis) override {
+        mTelemetryPeriodMillis = periodMillis;
+    }
+
+    /**
+     * @return mean render time of each note on and off cycle of the last run,
+     *         or empty if the test does not render in cycles
+     */
+    virtual std::vector<double> getCycleRenderNanos() const {
+        return std::vector<double>();
+    }
+
 protected:
+    void startTelemetry(int32_t sampleRate, int32_t framesPerBurst) {
+        if (mTelemetryPeriodMillis <= 0) return;
+        int64_t nanosPerBurst = framesPerBurst * SYNTHMARK_NANOS_PER_SECOND / sampleRate;
+        mTelemetry = std::make_unique<CpuTelemetrySampler>();
+        if (mTelemetry->start(mTelemetryPeriodMillis, nanosPerBurst) < 0) {
+            mLogTool.log("WARNING could not start CPU telemetry\n");
+            mTelemetry.reset();
+        }
+    }
+
+    void stopTelemetry() {
+        if (mTelemetry) {
+            mTelemetry->stop();
+            mResult->appendReport(mTelemetry->dump());
+            mTelemetry.reset();
+        }
+    }
+
     int32_t          mNumVoices = 8;
     int32_t          mDelayNotesOn = 0;
     int32_t          mNumVoicesHigh = 0;
 
     VoicesMode       mVoicesMode = VOICES_SWITCH;
+    SynthesizerSettings mSynthesizerSettings;
 
     AudioSinkBase   *mAudioSink = nullptr;
     SynthMarkResult *mResult = nullptr;
@@ -144,6 +195,9 @@ protected:
     bool             mRunning;
 
     HostThreadFactory::ThreadType mThreadType = HostThreadFactory::ThreadType::Audio;
+
+    int32_t          mTelemetryPeriodMillis = 0;
+    std::unique_ptr<CpuTelemetrySampler> mTelemetry;
 };
 
 #endif //ANDROID_TEST_HARNESS_PARAMETERS_H
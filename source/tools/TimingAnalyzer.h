@@ -17,6 +17,7 @@
 #ifndef SYNTHMARK_TIMING_ANALYZER_H
 #define SYNTHMARK_TIMING_ANALYZER_H
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <cstring>
@@ -25,12 +26,27 @@
 
 #include "BinCounter.h"
 #include "HostTools.h"
+#include "ResultReport.h"
 #include "SynthMark.h"
 
 #if defined(__APPLE__)
 #include <mach/mach_time.h>
 #endif
 
+/**
+ * Render statistics for the bursts since the previous window snapshot.
+ */
+struct TimingWindow {
+    int64_t durationNanos = 0;
+    int64_t activeNanos = 0;
+    int64_t maxRenderNanos = 0;
+    int64_t p99RenderNanos = 0;
+    int32_t callCount = 0;
+
+    double getDutyCycle() const {
+        return (durationNanos <= 0) ? 0.0 : (double) activeNanos / durationNanos;
+    }
+};
 
 class TimingAnalyzer
 {
@@ -67,6 +83,9 @@ public:
         if (mBaseTime == 0) {
             mBaseTime = now; // when we started
         }
+        if (mWindowStartTime == 0) {
+            mWindowStartTime = now;
+        }
         mIdealTime = idealTime;
         mEntryTime = now;
         if (mCallCount > 0) {
@@ -85,7 +104,11 @@ public:
     void markExit() {
         int64_t now = HostTools::getNanoTime();
         mLastRenderDuration = now - mEntryTime;
+        mLastOtherThreadDuration = mOtherThreadDuration;
+        mOtherThreadTime += mOtherThreadDuration;
+        mOtherThreadDuration = 0;
         mActiveTime += mLastRenderDuration; // for CPU load calculation
+        updateWindow(mLastRenderDuration);
         // Calculate jitter delay values for histogram.
         mExitTime = now;
         if (mCallCount > 0) {
@@ -102,7 +125,37 @@ public:
         mCallCount++;
     }
 
+    /**
+     * Called between markEntry() and markExit() to add time spent rendering
+     * this burst on other threads, such as the render pipeline workers.
+     * It is kept apart from the render time of the audio thread,
+     * so the duty cycle stays a fraction of the wall time of one thread.
+     */
+    void addOtherThreadDuration(int64_t nanos) {
+        mOtherThreadDuration += nanos;
+    }
+
+    /**
+     * Called between markEntry() and markExit() around the global effects
+     * so their cost can be reported separately from the voices.
+     */
+    void markEffectsEntry() {
+        mEffectsEntryTime = HostTools::getNanoTime();
+    }
+
+    void markEffectsExit() {
+        mLastEffectsDuration = HostTools::getNanoTime() - mEffectsEntryTime;
+        mEffectsTime += mLastEffectsDuration;
+    }
+
     void reset() {
+        mOtherThreadDuration = 0;
+        mLastOtherThreadDuration = 0;
+        mOtherThreadTime = 0;
+        mEffectsTime = 0;
+        mEffectsEntryTime = 0;
+        mLastEffectsDuration = 0;
+        mLastRenderDuration = 0;
         mBaseTime = 0;
         mIdealTime = 0;
         mEntryTime = 0;
@@ -110,6 +163,7 @@ public:
         mActiveTime = 0;
         mCallCount = 0;
         mTotalWakeupDelay = 0;
+        snapshotAndResetWindow(0);
         delete mWakeupBins;
         delete mRenderBins;
         delete mDeliveryBins;
@@ -131,6 +185,21 @@ public:
         return mLastRenderDuration;
     }
 
+    /**
+     * @return time added by addOtherThreadDuration() for the last burst
+     */
+    int64_t getLastOtherThreadDurationNanos() {
+        return mLastOtherThreadDuration;
+    }
+
+    int64_t getLastEffectsDurationNanos() {
+        return mLastEffectsDuration;
+    }
+
+    int64_t getEffectsTime() {
+        return mEffectsTime;
+    }
+
     int64_t getLastEntryTime() {
         return mEntryTime;
     }
@@ -152,6 +221,62 @@ public:
         }
     }
 
+    /**
+     * @return time added by addOtherThreadDuration() as a fraction of the wall time,
+     *         like getDutyCycle()
+     */
+    double getOtherThreadDutyCycle() {
+        int64_t totalTime = mEntryTime - mBaseTime;
+        if (totalTime <= 0) {
+            return 0.0;
+        } else {
+            return (double) (mOtherThreadTime - mLastOtherThreadDuration) / totalTime;
+        }
+    }
+
+    /**
+     * @return fraction of the time spent in the global effects
+     */
+    double getEffectsDutyCycle() {
+        int64_t totalTime = mExitTime - mBaseTime;
+        if (totalTime <= 0) {
+            return 0.0;
+        } else {
+            return (double) mEffectsTime / totalTime;
+        }
+    }
+
+    /**
+     * Return the render statistics since the previous call and start a new window.
+     * This is cheap enough to call from the audio thread once per window.
+     *
+     * @param now time that ends the window, from HostTools::getNanoTime()
+     */
+    TimingWindow snapshotAndResetWindow(int64_t now) {
+        TimingWindow window;
+        window.durationNanos = (mWindowStartTime > 0) ? (now - mWindowStartTime) : 0;
+        window.activeNanos = mWindowActiveTime;
+        window.maxRenderNanos = mWindowMaxRender;
+        window.callCount = mWindowCallCount;
+        // Walk down from the top until 1% of the calls have been passed.
+        int32_t remaining = mWindowCallCount / 100;
+        for (int i = kWindowNumBins - 1; i >= 0; i--) {
+            remaining -= mWindowRenderBins[i];
+            if (remaining < 0) {
+                window.p99RenderNanos = std::min(mWindowMaxRender,
+                                                 (int64_t) (i + 1) * kWindowNanosPerBin);
+                break;
+            }
+        }
+
+        mWindowStartTime = now;
+        mWindowActiveTime = 0;
+        mWindowMaxRender = 0;
+        mWindowCallCount = 0;
+        memset(mWindowRenderBins, 0, sizeof(mWindowRenderBins));
+        return window;
+    }
+
     BinCounter *getWakeupBins() {
         return mWakeupBins;
     }
@@ -162,12 +287,11 @@ public:
         return mDeliveryBins;
     }
 
-    std::string dumpJitter() {
+    ResultReport dumpJitter() {
         const bool showDeliveryTime = false;
-        std::stringstream resultMessage;
+        ResultReport report;
         // Print jitter histogram
         if (mWakeupBins != NULL && mRenderBins != NULL && mDeliveryBins != NULL) {
-            resultMessage << TEXT_CSV_BEGIN << std::endl;
             int32_t numBins = mDeliveryBins->getNumBins();
             const int32_t *wakeupCounts = mWakeupBins->getBins();
             const int32_t *wakeupLast = mWakeupBins->getLastMarkers();
@@ -175,45 +299,55 @@ public:
             const int32_t *renderLast = mRenderBins->getLastMarkers();
             const int32_t *deliveryCounts = mDeliveryBins->getBins();
             const int32_t *deliveryLast = mDeliveryBins->getLastMarkers();
-            resultMessage << " bin#,  msec,"
-                          << "   wakeup#,  wlast,"
-                          << "   render#,  rlast";
+            std::string header = " bin#,  msec,   wakeup#,  wlast,   render#,  rlast";
             if (showDeliveryTime) {
-                resultMessage << " delivery#,  dlast";
+                header += " delivery#,  dlast";
             }
-            resultMessage << std::endl;
+            report.beginTable(header);
             for (int i = 0; i < numBins; i++) {
                 if (wakeupCounts[i] > 0 || renderCounts[i] > 0
                     || (deliveryCounts[i] > 0 && showDeliveryTime)) {
                     double msec = (double) i * mNanosPerBin * SYNTHMARK_MILLIS_PER_SECOND
                                   / SYNTHMARK_NANOS_PER_SECOND;
-                    resultMessage << "  " << std::setw(3) << i
-                                  << ", " << std::fixed << std::setw(5) << std::setprecision(2)
-                                  << msec
-                                  << ", " << std::setw(9) << wakeupCounts[i]
-                                  << ", " << std::setw(6) << wakeupLast[i]
-                                  << ", " << std::setw(9) << renderCounts[i]
-                                  << ", " << std::setw(6) << renderLast[i];
+                    report.addCell(i, 5);
+                    report << std::fixed << std::setprecision(2);
+                    report.addCell(msec, 5);
+                    report.addCell(wakeupCounts[i], 9);
+                    report.addCell(wakeupLast[i], 6);
+                    report.addCell(renderCounts[i], 9);
+                    report.addCell(renderLast[i], 6);
                     if (showDeliveryTime) {
-                        resultMessage << ", " << std::setw(9) << deliveryCounts[i]
-                                      << ", " << std::setw(6) << deliveryLast[i];
+                        report.addCell(deliveryCounts[i], 9);
+                        report.addCell(deliveryLast[i], 6);
                     }
-                    resultMessage << std::endl;
+                    report.endRow();
                 }
             }
-            resultMessage << TEXT_CSV_END << std::endl;
+            report.endTable();
 
             double averageWakeupDelayMicros = getTotalWakeupDelayNanos()
                     / (double) (mCallCount * SYNTHMARK_NANOS_PER_MICROSECOND);
-            resultMessage << "average.wakeup.delay.micros = " << averageWakeupDelayMicros
-                          << std::endl;
+            report.addMetric("average.wakeup.delay.micros", averageWakeupDelayMicros);
         } else {
-            resultMessage << "ERROR NULL BinCounter!\n";
+            report << "ERROR NULL BinCounter!\n";
         }
-        return resultMessage.str();
+        return report;
     }
 
 private:
+    void updateWindow(int64_t renderNanos) {
+        mWindowActiveTime += renderNanos;
+        mWindowMaxRender = std::max(mWindowMaxRender, renderNanos);
+        mWindowCallCount++;
+        int64_t binIndex = std::min(renderNanos / kWindowNanosPerBin,
+                                    (int64_t) (kWindowNumBins - 1));
+        mWindowRenderBins[binIndex]++;
+    }
+
+    // A fixed histogram so the percentile can be found without allocating.
+    static constexpr int32_t kWindowNanosPerBin = 10 * SYNTHMARK_NANOS_PER_MICROSECOND;
+    static constexpr int32_t kWindowNumBins = 1000; // last bin holds everything above 10 msec
+
     int64_t  mBaseTime;
     int64_t  mIdealTime;
     int64_t  mEntryTime;
@@ -221,11 +355,23 @@ private:
     int64_t  mActiveTime;
     int64_t  mTotalWakeupDelay;
     int64_t  mLastRenderDuration = 0;
+    int64_t  mEffectsEntryTime = 0;
+    int64_t  mEffectsTime = 0;
+    int64_t  mLastEffectsDuration = 0;
+    int64_t  mOtherThreadDuration = 0;
+    int64_t  mLastOtherThreadDuration = 0;
+    int64_t  mOtherThreadTime = 0;
     BinCounter *mWakeupBins;
     BinCounter *mRenderBins;
     BinCounter *mDeliveryBins;
     int32_t  mNanosPerBin;
     int32_t  mCallCount;
+
+    int64_t  mWindowStartTime = 0;
+    int64_t  mWindowActiveTime = 0;
+    int64_t  mWindowMaxRender = 0;
+    int32_t  mWindowCallCount = 0;
+    int32_t  mWindowRenderBins[kWindowNumBins] = {};
 };
 
 #endif // SYNTHMARK_TIMING_ANALYZER_H
@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_UTIL_CLAMP_FEED_FORWARD_BEHAVIOR_H
+#define ANDROID_UTIL_CLAMP_FEED_FORWARD_BEHAVIOR_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "HostTools.h"
+
+/**
+ * Choose sched_util_min from the load that the application announces
+ * instead of reacting to slow bursts.
+ *
+ * For each CPU it learns the utilization needed per work unit.
+ * The utilization is scaled by the capacity of the CPU and its current clock
+ * so it is the same at any clock speed, like the scheduler's own PELT signal.
+ * When a new load is announced, before the heavy burst is rendered,
+ * the clamp is set so that load would run at kTargetUtilization.
+ *
+ * The estimate rises quickly and falls slowly so that bursts where
+ * the notes are off or releasing do not pull it down.
+ */
+class UtilClampFeedForwardBehavior {
+public:
+    ~UtilClampFeedForwardBehavior() {
+        closeFiles();
+    }
+
+    /**
+     * Forget any previous estimates and open the CPU files.
+     * Call this before the timing loop because it allocates.
+     */
+    void setup(int32_t minValue,
+               int32_t maxValue,
+               int64_t targetDurationNanos) {
+        closeFiles();
+        mWorkUnits = 0;
+        mAnnouncements = 0;
+        mBurstCount = 0;
+        mMinValue = minValue;
+        mMaxValue = maxValue;
+        mTargetDurationNanos = targetDurationNanos;
+        int numCpus = HostTools::getCpuCount();
+        mCpuModels.resize(std::max(1, numCpus));
+        for (int cpu = 0; cpu < (int) mCpuModels.size(); cpu++) {
+            CpuModel &model = mCpuModels[cpu];
+            std::string path = std::string(kCpuRoot) + "cpu" + std::to_string(cpu) + "/";
+            int32_t capacity = readInteger(path + "cpu_capacity");
+            model.capacity = (capacity > 0) ? capacity : kMaxCapacity;
+            model.maxFrequencyKHz = readInteger(path + "cpufreq/cpuinfo_max_freq");
+            if (model.maxFrequencyKHz > 0) {
+                model.curFreqFd = open((path + "cpufreq/scaling_cur_freq").c_str(),
+                                       O_RDONLY | O_CLOEXEC);
+            }
+        }
+    }
+
+    /**
+     * Called when the application announces a new load, before it renders it.
+     * @return sched_util_min that should be set now
+     */
+    int32_t onApplicationLoad(int32_t workUnits, int cpu) {
+        mWorkUnits = workUnits;
+        mAnnouncements++;
+        return predictClamp(cpu);
+    }
+
+    /**
+     * Learn from the duration of the last burst.
+     * @return sched_util_min for the current load with the updated estimate
+     */
+    int32_t processTiming(int64_t actualDurationNanos, int cpu) {
+        CpuModel *model = getModel(cpu);
+        if (model != nullptr && mWorkUnits > 0) {
+            // Read the clock occasionally because it is a system call.
+            if (model->curFreqFd >= 0
+                    && (model->frequencyKHz <= 0 || (mBurstCount % kFrequencyReadBursts) == 0)) {
+                int32_t frequencyKHz = readFd(model->curFreqFd);
+                if (frequencyKHz > 0) {
+                    model->frequencyKHz = frequencyKHz;
+                }
+            }
+            double clockFraction = (model->frequencyKHz > 0 && model->maxFrequencyKHz > 0)
+                    ? ((double) model->frequencyKHz / model->maxFrequencyKHz)
+                    : 1.0;
+            double utilization = calculateFractionRealTime(actualDurationNanos)
+                    * model->capacity * clockFraction;
+            double perUnit = utilization / mWorkUnits;
+            if (model->samples == 0) {
+                model->utilizationPerUnit = perUnit;
+            } else {
+                double alpha = (perUnit > model->utilizationPerUnit) ? kAlphaRise : kAlphaFall;
+                model->utilizationPerUnit = (alpha * perUnit)
+                        + ((1.0 - alpha) * model->utilizationPerUnit);
+            }
+            model->samples++;
+        }
+        mBurstCount++;
+        return predictClamp(cpu);
+    }
+
+    double calculateFractionRealTime(int64_t actualDurationNanos) const {
+        return ((double)actualDurationNanos) / mTargetDurationNanos;
+    }
+
+    /**
+     * @return number of times a load was announced
+     */
+    int32_t getAnnouncementCount() const {
+        return mAnnouncements;
+    }
+
+    /**
+     * @return number of CPUs that have an estimate
+     */
+    int32_t getLearnedCpuCount() const {
+        int32_t count = 0;
+        for (const CpuModel &model : mCpuModels) {
+            if (model.samples > 0) count++;
+        }
+        return count;
+    }
+
+private:
+    static constexpr const char *kCpuRoot = "/sys/devices/system/cpu/";
+    static constexpr int32_t kMaxCapacity = 1024; // SCHED_CAPACITY_SCALE
+    static constexpr double  kTargetUtilization = 0.8; // schedutil adds 25% headroom
+    static constexpr double  kAlphaRise = 0.5;
+    static constexpr double  kAlphaFall = 0.02;
+    static constexpr int32_t kFrequencyReadBursts = 8;
+
+    struct CpuModel {
+        int32_t capacity = kMaxCapacity;
+        int32_t maxFrequencyKHz = 0;
+        int32_t frequencyKHz = 0;
+        int     curFreqFd = -1;
+        double  utilizationPerUnit = 0.0;
+        int32_t samples = 0;
+    };
+
+    std::vector<CpuModel> mCpuModels;
+    int64_t mTargetDurationNanos = 0;
+    int32_t mMinValue = 0;
+    int32_t mMaxValue = kMaxCapacity;
+    int32_t mWorkUnits = 0;
+    int32_t mAnnouncements = 0;
+    int64_t mBurstCount = 0;
+
+    void closeFiles() {
+        for (CpuModel &model : mCpuModels) {
+            if (model.curFreqFd >= 0) {
+                close(model.curFreqFd);
+            }
+        }
+        mCpuModels.clear();
+    }
+
+    CpuModel *getModel(int cpu) {
+        if (cpu < 0 || cpu >= (int) mCpuModels.size()) {
+            return nullptr;
+        }
+        return &mCpuModels[cpu];
+    }
+
+    /**
+     * Use the estimate for this CPU, or the highest estimate from any CPU
+     * if the thread has not run here yet. Without any estimate use the maximum.
+     */
+    int32_t predictClamp(int cpu) const {
+        double perUnit = -1.0;
+        if (cpu >= 0 && cpu < (int) mCpuModels.size() && mCpuModels[cpu].samples > 0) {
+            perUnit = mCpuModels[cpu].utilizationPerUnit;
+        } else {
+            for (const CpuModel &model : mCpuModels) {
+                if (model.samples > 0) {
+                    perUnit = std::max(perUnit, model.utilizationPerUnit);
+                }
+            }
+        }
+        if (perUnit < 0.0) {
+            return mMaxValue;
+        }
+        int32_t clamp = (int32_t) (mWorkUnits * perUnit / kTargetUtilization);
+        return std::max(mMinValue, std::min(mMaxValue, clamp));
+    }
+
+    static int32_t readFd(int fd) {
+        char buffer[32];
+        ssize_t count = pread(fd, buffer, sizeof(buffer) - 1, 0);
+        if (count <= 0) {
+            return -1;
+        }
+        buffer[count] = 0;
+        return atoi(buffer);
+    }
+
+    static int32_t readInteger(const std::string &path) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return -1;
+        }
+        int32_t value = readFd(fd);
+        close(fd);
+        return value;
+    }
+};
+
+#endif //ANDROID_UTIL_CLAMP_FEED_FORWARD_BEHAVIOR_H
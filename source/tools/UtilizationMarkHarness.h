@@ -61,6 +61,7 @@ public:
 
     void reportUtilization() {
         mFractionOfCpu = mTimer.getDutyCycle();
+        mVoiceLoad = getVoiceDutyCycle();
         mLogTool.log("%2d: %3d voices used %5.3f of CPU\n", mBeatCount, getNumVoices(), mFractionOfCpu);
     }
 
@@ -76,25 +77,37 @@ public:
     virtual void onEndMeasurement() override {
 
         int8_t resultCode = SYNTHMARK_RESULT_SUCCESS;
-        std::stringstream resultMessage;
+        ResultReport report;
 
         reportUtilization();
         double measurement = mFractionOfCpu;
         resultCode = SYNTHMARK_RESULT_SUCCESS;
-        resultMessage << "underrun.count = " << mAudioSink->getUnderrunCount() << std::endl;
-        resultMessage << mTestName << " = " << measurement << std::endl;
+        report.addMetric("underrun.count", mAudioSink->getUnderrunCount());
+        report.addMetric(mTestName, measurement);
 
-        resultMessage << "normalized.voices.100 = " << (getNumVoices() / mFractionOfCpu) << std::endl;
+        if (mSynthesizerSettings.pipelineWorkers > 0) {
+            // The voices were rendered by the workers, not by the audio thread.
+            report.addMetric("pipeline.worker.load", mVoiceLoad);
+        }
+        report.addMetric("normalized.voices.100", getNumVoices() / mVoiceLoad);
+        if (mSynth.areEffectsEnabled()) {
+            report.addMetric("effects.size.bytes", mSynth.getEffectsSizeInBytes());
+            report.addMetric("effects.cpu.load", mTimer.getEffectsDutyCycle());
+        }
         mResult->setResultCode(resultCode);
 
-        resultMessage << mCpuAnalyzer.dump();
+        if (mSynthesizerSettings.degradationEnabled) {
+            report << mLoadShedController.dump();
+        }
+        report << mCpuAnalyzer.dump();
 
         mResult->setMeasurement(measurement);
-        mResult->appendMessage(resultMessage.str());
+        mResult->appendReport(report);
     }
 
 private:
     double  mFractionOfCpu = 0.0;
+    double  mVoiceLoad = 0.0;
     int32_t mBeatCount = 0;
 };
 
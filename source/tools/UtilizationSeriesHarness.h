@@ -47,7 +47,8 @@ public:
             setNumVoicesHigh((int32_t) maxVoices);
         }
 
-        mResult->appendMessage("voices, utilization\n");
+        ResultReport report;
+        report.beginTable("voices, utilization");
 
         // Iterate over a range of voice counts.
         int32_t numVoicesBegin = getNumVoices();
@@ -62,13 +63,18 @@ public:
                                          numSeconds, numVoices,
                                          &utilization);
             if (err != SYNTHMARK_RESULT_SUCCESS) {
-                return err;
+                break;
             }
+            report.addCell(numVoices, 6);
+            report.addCell(utilization);
+            report.endRow();
             // We are maxing out the CPU so stop the series.
             if (utilization > 0.96) {
                 break;
             }
         }
+        report.endTable();
+        mResult->appendReport(report);
         return err;
     }
 
@@ -77,13 +83,14 @@ public:
                              int32_t numSeconds,
                              double fractionUtilization,
                              int32_t *maxVoicesPtr) {
-        std::stringstream resultMessage;
+        ResultReport report;
         SynthMarkResult result1;
         VoiceMarkHarness *harness = new VoiceMarkHarness(mAudioSink, &result1, mLogTool);
         harness->setTargetCpuLoad(fractionUtilization);
         harness->setInitialVoiceCount(getNumVoices());
         harness->setDelayNoteOnSeconds(mDelayNotesOn);
         harness->setThreadType(mThreadType);
+        harness->setSynthesizerSettings(mSynthesizerSettings);
 
         int32_t err = harness->runTest(sampleRate, framesPerBurst, 15);
         delete harness;
@@ -93,9 +100,9 @@ public:
 
         *maxVoicesPtr = (int32_t) result1.getMeasurement();
 
-        resultMessage << "VoiceMarkMax = " << *maxVoicesPtr << std::endl;
+        report.addMetric("VoiceMarkMax", *maxVoicesPtr);
 
-        mResult->appendMessage(resultMessage.str());
+        mResult->appendReport(report);
         return SYNTHMARK_RESULT_SUCCESS;
     }
 
@@ -104,7 +111,6 @@ public:
                                int32_t numSeconds,
                                int32_t numVoices,
                                double *utilizationPtr) {
-        std::stringstream resultMessage;
         SynthMarkResult result1;
         UtilizationMarkHarness *harness = new UtilizationMarkHarness(mAudioSink,
                                                                      &result1,
@@ -112,6 +118,7 @@ public:
         harness->setNumVoices(numVoices);
         harness->setDelayNoteOnSeconds(mDelayNotesOn);
         harness->setThreadType(mThreadType);
+        harness->setSynthesizerSettings(mSynthesizerSettings);
 
         int32_t err = harness->runTest(sampleRate, framesPerBurst, numSeconds);
         delete harness;
@@ -119,12 +126,7 @@ public:
             return err;
         }
 
-        double utilization = result1.getMeasurement();
-
-        resultMessage << "   " << numVoices << ", " << utilization << std::endl;
-        mResult->appendMessage(resultMessage.str());
-
-        *utilizationPtr = utilization;
+        *utilizationPtr = result1.getMeasurement();
         return SYNTHMARK_RESULT_SUCCESS;
     }
 
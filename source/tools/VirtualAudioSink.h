@@ -19,20 +19,29 @@
 
 #include <cstdint>
 #include <ctime>
+#include <iomanip>
 #include <memory>
+#include <sstream>
 #include <unistd.h>
 
 #include "AudioSinkBase.h"
+#include "BinCounter.h"
+#include "CpuAnalyzer.h"
 #include "HostTools.h"
 #include "HostThreadFactory.h"
 #include "LogTool.h"
+#include "SimulatedDma.h"
 #include "SynthMark.h"
 #include "SynthMarkResult.h"
 #include "UtilClampAudioBehavior.h"
 #include "UtilClampController.h"
+#include "UtilClampFeedForwardBehavior.h"
 #include "AdpfWrapper.h"
 
 constexpr int kMaxBufferCapacityInBursts = 512;
+// Resolution and range of the sleep overshoot histogram.
+constexpr int32_t kSleepOvershootNanosPerBin = 5 * 1000;
+constexpr int32_t kSleepOvershootNumBins = 400;
 
 class VirtualAudioSink : public AudioSinkBase
 {
@@ -47,6 +56,7 @@ public:
 
     virtual int32_t close() override {
         mBurstBuffer.reset();
+        mDma.reset();
         return 0;
     }
 
@@ -68,7 +78,7 @@ public:
 
         int64_t nanosPerBurst = mFramesPerBurst * SYNTHMARK_NANOS_PER_SECOND / mSampleRate;
         mNanosPerBurst = (int32_t) nanosPerBurst;
-        HostCpuManager::getInstance()->setNanosPerBurst(nanosPerBurst);
+        getCpuManager()->setNanosPerBurst(nanosPerBurst);
 
         mBurstBuffer = std::make_unique<float[]>(samplesPerFrame * framesPerBurst);
 
@@ -76,6 +86,23 @@ public:
         mFramesConsumed = 0;
         mStartTimeNanos = 0;
 
+        if (mDmaEnabled) {
+            mDma = std::make_unique<SimulatedDma>();
+            result = mDma->open(samplesPerFrame, framesPerBurst,
+                                mBufferCapacityInFrames, nanosPerBurst);
+            if (result < 0) {
+                mLogTool.log("ERROR in VirtualAudioSink, could not open DMA, %d\n", result);
+                return result;
+            }
+        }
+        mDmaUnderrunsSeen = 0;
+        mDmaReport.clear();
+
+        mSleepOvershootBins = std::make_unique<BinCounter>(kSleepOvershootNumBins);
+        mSleepCount = 0;
+        mTotalSleepOvershootNanos = 0;
+        mMaxSleepOvershootNanos = 0;
+
         return result;
     }
 
@@ -91,10 +118,19 @@ public:
         return (int32_t) (getFramesWritten() - mFramesConsumed);
     }
 
-    virtual void writeBurst(const float * /* buffer */) {
+    virtual void writeBurst(const float *buffer) {
         if (mStartTimeNanos == 0) {
             mStartTimeNanos = HostTools::getNanoTime();
             mNextHardwareReadTimeNanos = mStartTimeNanos;
+            if (mDma) {
+                // The buffer was primed by start() so the DMA can begin reading immediately.
+                int err = mDma->start(mStartTimeNanos, (int32_t) getFramesWritten(),
+                                      isSchedFifoEnabled(), mThreadPriority + 1);
+                if (err != 0) {
+                    mLogTool.log("WARNING DMA thread failed to start, %d\n", err);
+                    mDma.reset();
+                }
+            }
         }
 
         // Update the model so the statistics are more accurate.
@@ -102,7 +138,14 @@ public:
 
         int32_t availableData = getFullFramesAvailable();
         int32_t availableRoom = getEmptyFramesAvailable();
-        if (availableData < 0) {
+        bool underflowed = (availableData < 0);
+        if (mDma) {
+            // The DMA thread saw the missing data directly.
+            int32_t dmaUnderruns = mDma->getUnderrunCount();
+            underflowed = (dmaUnderruns != mDmaUnderrunsSeen);
+            mDmaUnderrunsSeen = dmaUnderruns;
+        }
+        if (underflowed) {
             if (mValidRun) {
                 // Not enough data! Hardware underflowed while we were gone.
                 mUnderrunCount++;
@@ -126,14 +169,28 @@ public:
 
         // If there is not enough room then sleep until the hardware reads another burst.
         if (availableRoom < mFramesPerBurst) {
-            HostCpuManager::getInstance()->sleepAndTuneCPU(mNextHardwareReadTimeNanos);
+            int64_t deadline = mNextHardwareReadTimeNanos;
+            bool willSleep = HostTools::getNanoTime() < deadline;
+            getCpuManager()->sleepAndTuneCPU(deadline);
+            if (willSleep) {
+                recordSleepOvershoot(HostTools::getNanoTime() - deadline);
+            }
             updateHardwareSimulator();
+            // We may wake before the DMA thread has read so wait for it to make room.
+            // Stop waiting if the DMA thread has stopped because it will never read again.
+            while (mDma && mDma->isRunning() && getEmptyFramesAvailable() < mFramesPerBurst) {
+                mDma->waitForRead(mFramesConsumed);
+                updateHardwareSimulator();
+            }
         } else {
             // Just let CPU Manager know that a burst has occurred.
-            HostCpuManager::getInstance()->sleepAndTuneCPU(0);
+            getCpuManager()->sleepAndTuneCPU(0);
         }
 
-        // Simulate writing to a buffer.
+        // Simulate writing to a buffer, or really write it when the DMA is running.
+        if (mDma) {
+            mDma->writeBurst(buffer);
+        }
         setFramesWritten(getFramesWritten() + mFramesPerBurst);
     }
 
@@ -146,6 +203,10 @@ public:
 
     virtual int32_t start() override {
         setFramesWritten(getBufferSizeInFrames());  // start full and primed
+        if (HostTools::isMemoryLocked() && mBurstBuffer) {
+            HostTools::prefaultMemory(mBurstBuffer.get(),
+                                      mSamplesPerFrame * mFramesPerBurst * sizeof(float));
+        }
 
         if (mUseRealThread) {
             mCallbackLoopResult = SYNTHMARK_RESULT_THREAD_FAILURE;
@@ -162,9 +223,82 @@ public:
     }
 
     virtual int32_t stop() override {
+        if (mDma) {
+            mDma->stop();
+            mDmaReport = mDma->dump();
+        }
         return 0;
     }
 
+    std::unique_ptr<AudioSinkBase> createConcurrentCopy(LogTool &logTool,
+                                                        const std::string &tag) override {
+        std::unique_ptr<VirtualAudioSink> copy = std::make_unique<VirtualAudioSink>(logTool);
+        copyVirtualSettingsTo(copy.get());
+        return copy;
+    }
+
+    bool isDmaEnabled() const {
+        return mDmaEnabled;
+    }
+
+    /**
+     * Read the audio with a separate DMA thread instead of
+     * calculating the hardware position from the clock.
+     * Must be called before open().
+     */
+    void setDmaEnabled(bool enabled) {
+        mDmaEnabled = enabled;
+    }
+
+    /**
+     * With the feed forward policy, raise or lower sched_util_min for the new load
+     * before it is rendered instead of waiting for a slow burst.
+     */
+    void setApplicationLoad(int32_t currentWorkUnits, int32_t maxWorkUnits) override {
+        if (!mFeedForwardActive) {
+            return;
+        }
+        int cpu = HostThread::getCpu();
+        int suggestedUtilClamp = mFeedForward.onApplicationLoad(currentWorkUnits, cpu);
+        if (abs(suggestedUtilClamp - mCurrentUtilClamp) >= kUtilClampQuanta) {
+            UtilClampController::setMin(suggestedUtilClamp);
+            mCurrentUtilClamp = UtilClampController::getMin();
+            mPreemptiveClampChanges++;
+            if (isUtilClampLoggingEnabled()) {
+                mLogTool.log("%4d, load = %d, %d\n", mCurrentUtilClamp, currentWorkUnits, cpu);
+            }
+        }
+    }
+
+    int32_t getCurrentUtilClamp() override {
+        return isUtilClampEnabled() ? mCurrentUtilClamp : -1;
+    }
+
+    /**
+     * Add the sleep statistics to the base report when the scheduler is sampled with -q.
+     * The overshoot is how late the sink woke up after its own deadline.
+     * It is caused by the sleep mechanism and timer slack, not by the synthesizer,
+     * so it is kept separate from the wakeup jitter measured by the harness.
+     */
+    ResultReport dump() override {
+        ResultReport report = AudioSinkBase::dump();
+        if (CpuAnalyzer::getDefaultSchedulerSamplePeriod() > 0) {
+            dumpSleepStatistics(report);
+        }
+        if (isUtilClampDynamic()) {
+            report.setMetricLayout(2, 29);
+            report.addMetric("util.clamp.policy", getUtilClampPolicyName(getUtilClampPolicy()));
+            report.addMetric("util.clamp.timed.changes", mTimedClampChanges);
+            if (getUtilClampPolicy() == UTIL_CLAMP_POLICY_FEED_FORWARD) {
+                report.addMetric("util.clamp.preemptive.changes", mPreemptiveClampChanges);
+                report.addMetric("util.clamp.loads.announced", mFeedForward.getAnnouncementCount());
+                report.addMetric("util.clamp.cpus.learned", mFeedForward.getLearnedCpuCount());
+            }
+        }
+        report << mDmaReport;
+        return report;
+    }
+
     HostThreadFactory::ThreadType getThreadType() const override {
         return mThreadType;
     }
@@ -173,6 +307,21 @@ public:
         mThreadType = threadType;
     }
 
+protected:
+    void copyVirtualSettingsTo(VirtualAudioSink *other) const {
+        copySettingsTo(other);
+        other->setDmaEnabled(mDmaEnabled);
+    }
+
+    /**
+     * @return buffer that the next burst will be rendered into and then passed to writeBurst()
+     */
+    virtual float *getBurstBuffer() {
+        return mBurstBuffer.get();
+    }
+
+    LogTool    &mLogTool;
+
 private:
 
 
@@ -230,6 +379,21 @@ private:
 
             mSchedulerUsed = sched_getscheduler(0);
 
+            if (HostTools::isMemoryLocked()) {
+                HostTools::prefaultStack();
+            }
+
+            // Timer slack is per thread so set it on the thread that sleeps.
+            if (getTimerSlackNanos() != kTimerSlackUnspecified) {
+                int err = HostTools::setTimerSlackNanos(getTimerSlackNanos());
+                if (err != 0) {
+                    mLogTool.log("WARNING setTimerSlackNanos() returned %d\n", err);
+                }
+            }
+            mActualTimerSlackNanos = HostTools::getTimerSlackNanos();
+
+            callback->onBeginAudioThread();
+
             // Write in a loop until the callback says we are done.
             IAudioSinkCallback::Result callbackResult
                     = IAudioSinkCallback::Result::Continue;
@@ -238,31 +402,36 @@ private:
             UtilClampAudioBehavior behavior;
             AdpfWrapper adpfWrapper;
             int originalUtilClamp = 0;
-            int currentUtilClamp = 0;
-            constexpr int32_t kUtilClampQuanta = 10;
-            // Restrict the range to save power.
-            constexpr int32_t kUtilClampLow = 40;
-            constexpr int32_t kUtilClampHigh = 300;
             int64_t targetDurationNanos = (mFramesPerBurst * 1e9) / getSampleRate();
+            mFeedForwardActive = false;
+            mPreemptiveClampChanges = 0;
+            mTimedClampChanges = 0;
 
             // init UtilClampBehavior
             if (isUtilClampEnabled()) {
                 if (utilClampController.isSupported()) {
                     originalUtilClamp = utilClampController.getMin();
-                    currentUtilClamp = originalUtilClamp;
+                    mCurrentUtilClamp = originalUtilClamp;
                     mLogTool.log("utilClamp active\n");
                     if (isUtilClampLoggingEnabled()) {
                         mLogTool.log("burst, uclamp_min, load, cpu#\n");
                     }
                     if (isUtilClampDynamic()) {
-                        behavior.setup(kUtilClampLow,
-                                       kUtilClampHigh,
-                                       targetDurationNanos);
+                        if (getUtilClampPolicy() == UTIL_CLAMP_POLICY_FEED_FORWARD) {
+                            mFeedForward.setup(kUtilClampLow,
+                                               kUtilClampHigh,
+                                               targetDurationNanos);
+                            mFeedForwardActive = true;
+                        } else {
+                            behavior.setup(kUtilClampLow,
+                                           kUtilClampHigh,
+                                           targetDurationNanos);
+                        }
                     } else {
                         // Set to fixed level for entire time.
                         utilClampController.setMin(getUtilClampLevel());
-                        currentUtilClamp = utilClampController.getMin();
-                        mLogTool.log("sched_util_min fixed at %d\n", currentUtilClamp);
+                        mCurrentUtilClamp = utilClampController.getMin();
+                        mLogTool.log("sched_util_min fixed at %d\n", mCurrentUtilClamp);
                     }
                 } else {
                     mLogTool.log("WARNING utilClamp not supported\n");
@@ -278,27 +447,35 @@ private:
                 }
             }
 
+            // Do not count the faults from creating and setting up the thread.
+            beginPageFaultCount();
             while (callbackResult == IAudioSinkCallback::Result::Continue
                    && result == SYNTHMARK_RESULT_SUCCESS) {
 
                 int64_t beginCallback = HostTools::getNanoTime();
                 // Call the synthesizer to render the audio data.
-                callbackResult = fireCallback(mBurstBuffer.get(), mFramesPerBurst);
+                float *burstBuffer = getBurstBuffer();
+                callbackResult = fireCallback(burstBuffer, mFramesPerBurst);
                 int64_t endCallback = HostTools::getNanoTime();
                 int64_t actualDurationNanos = endCallback - beginCallback;
                 if (isUtilClampDynamic()) {
                     bool utilClampChanged = false;
                     int cpu = HostThread::getCpu(); // query before changing util_clamp
-                    int suggestedUtilClamp = behavior.processTiming(actualDurationNanos);
-                    if (abs(suggestedUtilClamp - currentUtilClamp) >= kUtilClampQuanta) {
+                    int suggestedUtilClamp = mFeedForwardActive
+                            ? mFeedForward.processTiming(actualDurationNanos, cpu)
+                            : behavior.processTiming(actualDurationNanos);
+                    if (abs(suggestedUtilClamp - mCurrentUtilClamp) >= kUtilClampQuanta) {
                         utilClampController.setMin(suggestedUtilClamp);
                         utilClampChanged = true;
-                        currentUtilClamp = utilClampController.getMin();
+                        mCurrentUtilClamp = utilClampController.getMin();
+                        mTimedClampChanges++;
                     }
                     if (isUtilClampLoggingEnabled() && (utilClampChanged || cpu != lastCpu)) {
-                        double realTime = behavior.calculateFractionRealTime(actualDurationNanos);
+                        double realTime = mFeedForwardActive
+                                ? mFeedForward.calculateFractionRealTime(actualDurationNanos)
+                                : behavior.calculateFractionRealTime(actualDurationNanos);
                         mLogTool.log("%4d, %5.1f, %d\n",
-                                     currentUtilClamp,
+                                     mCurrentUtilClamp,
                                      realTime * 100,
                                      cpu);
                     }
@@ -309,12 +486,14 @@ private:
 
                 if (callbackResult == IAudioSinkCallback::Result::Continue) {
                     // Output the audio using a blocking write.
-                    writeBurst(mBurstBuffer.get());
+                    writeBurst(burstBuffer);
                 } else if (callbackResult != IAudioSinkCallback::Result::Finished) {
                     result = callbackResult;
                 }
             }
+            endPageFaultCount();
             // Restore original value.
+            mFeedForwardActive = false;
             if (isUtilClampEnabled()) {
                 utilClampController.setMin(originalUtilClamp);
             }
@@ -363,10 +542,73 @@ private:
     HostThread *mThread = NULL;
     HostThreadFactory::ThreadType mThreadType = HostThreadFactory::ThreadType::Audio;
 
-    LogTool    &mLogTool;
+    bool    mDmaEnabled = false;
+    std::unique_ptr<SimulatedDma> mDma;
+    int32_t mDmaUnderrunsSeen = 0;
+    ResultReport mDmaReport;
+
+    std::unique_ptr<BinCounter> mSleepOvershootBins;
+    int64_t mSleepCount = 0;
+    int64_t mTotalSleepOvershootNanos = 0;
+    int64_t mMaxSleepOvershootNanos = 0;
+    int64_t mActualTimerSlackNanos = kTimerSlackUnspecified;
+
+    static constexpr int32_t kUtilClampQuanta = 10;
+    // Restrict the range to save power.
+    static constexpr int32_t kUtilClampLow = 40;
+    static constexpr int32_t kUtilClampHigh = 300;
+    UtilClampFeedForwardBehavior mFeedForward;
+    bool    mFeedForwardActive = false; // only touched by the audio thread
+    int32_t mCurrentUtilClamp = 0;
+    int32_t mPreemptiveClampChanges = 0;
+    int32_t mTimedClampChanges = 0;
+
+    void dumpSleepStatistics(ResultReport &report) {
+        report.setMetricLayout(2, 22);
+        report.addMetric("sleep.mode", HostTools::getSleepModeName(HostTools::getSleepMode()));
+        report.addMetric("timer.slack.nanos", mActualTimerSlackNanos);
+        report.addMetric("sleep.count", mSleepCount);
+        if (mSleepCount > 0 && mSleepOvershootBins) {
+            double averageMicros = mTotalSleepOvershootNanos
+                    / (double) (mSleepCount * SYNTHMARK_NANOS_PER_MICROSECOND);
+            double maxMicros = mMaxSleepOvershootNanos / (double) SYNTHMARK_NANOS_PER_MICROSECOND;
+            report.setMetricLayout(2, 30);
+            report.addMetric("sleep.overshoot.average.micros", averageMicros);
+            report.addMetric("sleep.overshoot.max.micros", maxMicros);
+            report.beginTable(" bin#, micros,   sleeps#,  slast");
+            const int32_t *counts = mSleepOvershootBins->getBins();
+            const int32_t *last = mSleepOvershootBins->getLastMarkers();
+            for (int i = 0; i < mSleepOvershootBins->getNumBins(); i++) {
+                if (counts[i] > 0) {
+                    report.addCell(i, 5);
+                    report.addCell(i * kSleepOvershootNanosPerBin / SYNTHMARK_NANOS_PER_MICROSECOND, 6);
+                    report.addCell(counts[i], 9);
+                    report.addCell(last[i], 6);
+                    report.endRow();
+                }
+            }
+            report.endTable();
+        }
+    }
 
-    // Advance mFramesConsumed and mNextHardwareReadTimeNanos based on real-time clock.
+    void recordSleepOvershoot(int64_t overshootNanos) {
+        if (overshootNanos < 0) {
+            overshootNanos = 0;
+        }
+        mSleepCount++;
+        mTotalSleepOvershootNanos += overshootNanos;
+        mMaxSleepOvershootNanos = std::max(mMaxSleepOvershootNanos, overshootNanos);
+        mSleepOvershootBins->increment((int32_t) (overshootNanos / kSleepOvershootNanosPerBin));
+    }
+
+    // Advance mFramesConsumed and mNextHardwareReadTimeNanos based on real-time clock,
+    // or on the position of the DMA thread if it is running.
     void updateHardwareSimulator() {
+        if (mDma) {
+            mFramesConsumed = mDma->getFramesRead();
+            mNextHardwareReadTimeNanos = mDma->getNextReadTimeNanos();
+            return;
+        }
         int64_t lateness = HostTools::getNanoTime() - mNextHardwareReadTimeNanos;
         if (lateness > 0) {
             int64_t numBurstsToAdvance = (lateness + mNanosPerBurst - 1) / mNanosPerBurst;
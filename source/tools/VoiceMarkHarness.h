@@ -51,6 +51,13 @@ public:
     }
 
     virtual void onBeginMeasurement() override {
+        // Oversampled voices are a different workload so give them their own name.
+        int32_t oversampleFactor = mSynthesizerSettings.oversampleFactor;
+        if (oversampleFactor > 1) {
+            std::stringstream testName;
+            testName << "VoiceMark" << oversampleFactor << "x";
+            mTestName = testName.str();
+        }
         mResult->setTestName(mTestName);
         mLogTool.log("---- Starting %s ----\n", mTestName.c_str());
 
@@ -61,6 +68,7 @@ public:
         TestHarnessBase::setNumVoices(mInitialVoiceCount);
         mSumVoicesOn = 0;
         mSumVoicesCount = 0;
+        mSumEffectsLoad = 0.0;
         mBeatCount = 0;
         mStable = false;
     }
@@ -68,7 +76,7 @@ public:
     virtual int32_t onBeforeNoteOn() override {
         if (mBeatCount >= kMinimumNoteOnCount) {
             // Estimate how many voices it would take to use a fraction of the CPU.
-            double cpuLoad = mTimer.getDutyCycle();
+            double cpuLoad = getVoiceDutyCycle();
             int32_t oldNumVoices = getNumVoices();
             double voicesFraction = mFractionOfCpu * oldNumVoices / cpuLoad;
             int32_t newNumVoices = (int32_t)(voicesFraction + 0.5); // round
@@ -88,6 +96,7 @@ public:
                 }
                 if (mStable) {
                     mSumVoicesOn += voicesFraction;
+                    mSumEffectsLoad += mTimer.getEffectsDutyCycle();
                     mSumVoicesCount++;
                     accepted = true;
                 }
@@ -106,31 +115,43 @@ public:
 
         int8_t resultCode = SYNTHMARK_RESULT_SUCCESS;
         double measurement = 0.0;
-        std::stringstream resultMessage;
+        ResultReport report;
 
         if (mSumVoicesCount < kMinimumVoiceCount) {
 
             resultCode = SYNTHMARK_RESULT_TOO_FEW_MEASUREMENTS;
-            resultMessage << "Only " << mSumVoicesCount << " measurements. Minimum is " <<
+            report << "Only " << mSumVoicesCount << " measurements. Minimum is " <<
                     kMinimumVoiceCount << ". Not a valid result!"
                     << std::endl;
 
         } else {
 
             measurement = mSumVoicesOn / mSumVoicesCount;
-            resultMessage << "Underruns = " << mAudioSink->getUnderrunCount() << std::endl;
-            resultMessage << mTestName << "_"
-                << ((int)(mFractionOfCpu * 100)) << " = " << measurement << std::endl;
-            resultMessage << "normalized.voices.100 = "
-                    << (measurement / mFractionOfCpu) << std::endl;
+            report.addMetric("Underruns", mAudioSink->getUnderrunCount());
+            report.addMetric("voice.type", VoiceRegistry::getName(mSynth.getSettings().voiceType));
+            report.addMetric("voice.oversample", mSynth.getSettings().oversampleFactor);
+            report.addMetric(mTestName + "_" + std::to_string((int) (mFractionOfCpu * 100)),
+                             measurement);
+            report.addMetric("normalized.voices.100", measurement / mFractionOfCpu);
+            if (mSynthesizerSettings.pipelineWorkers > 0) {
+                // The audio thread only mixes the buffers of the workers.
+                report.addMetric("audio.thread.load", mTimer.getDutyCycle());
+            }
+            if (mSynth.areEffectsEnabled()) {
+                report.addMetric("effects.size.bytes", mSynth.getEffectsSizeInBytes());
+                report.addMetric("effects.cpu.load", mSumEffectsLoad / mSumVoicesCount);
+            }
         }
 
         mResult->setResultCode(resultCode);
 
-        resultMessage << mCpuAnalyzer.dump();
+        if (mSynthesizerSettings.degradationEnabled) {
+            report << mLoadShedController.dump();
+        }
+        report << mCpuAnalyzer.dump();
 
         mResult->setMeasurement(measurement);
-        mResult->appendMessage(resultMessage.str());
+        mResult->appendReport(report);
     }
 
     /**
@@ -154,6 +175,7 @@ private:
     // These need to be reset before each measurement.
     double  mSumVoicesOn = 0;     // sum of fractional number of voices on
     int32_t mSumVoicesCount = 0;  // number of measurements for taking an average
+    double  mSumEffectsLoad = 0;  // sum of the fraction of CPU used by the effects
     int32_t mBeatCount = 0;
     bool    mStable = false;
 };
@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SYNTHMARK_WAKEUPMARK_HARNESS_H
+#define SYNTHMARK_WAKEUPMARK_HARNESS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+
+#include "AudioSinkBase.h"
+#include "SynthMark.h"
+#include "TestHarnessParameters.h"
+#include "tools/BinCounter.h"
+#include "tools/CpuAnalyzer.h"
+#include "tools/LogTool.h"
+#include "tools/SchedStatReader.h"
+#include "tools/TestHarnessBase.h"
+
+/**
+ * Measure how late the audio thread wakes up, without rendering any voices.
+ *
+ * This is like cyclictest but it uses the same audio sink, burst cadence and thread
+ * setup as the other tests, so SCHED_FIFO, SCHED_DEADLINE, utilClamp and ADPF all apply.
+ * Instead of rendering, each callback writes silence after an optional busy loop
+ * of a fixed length, so the wakeup delay is not mixed with the render workload.
+ *
+ * The delay of each wakeup is split using the schedstat of the audio thread.
+ * The run queue delay is the time the thread was runnable but waiting for a CPU,
+ * which is the increase in schedstat wait time between going to sleep and running.
+ * The rest of the delay is the timer: the late expiry of the sleep plus the
+ * time to leave an idle state.
+ */
+class WakeupMarkHarness : public TestHarnessBase {
+public:
+    // 250 nsec resolution up to 10 msec.
+    static constexpr int32_t kNanosPerBin = 250;
+    static constexpr int32_t kNumBins = 40000;
+
+    WakeupMarkHarness(AudioSinkBase *audioSink, SynthMarkResult *result, LogTool &logTool)
+            : TestHarnessBase(audioSink, result, logTool) {
+        mTestName = "WakeupMark";
+    }
+
+    virtual ~WakeupMarkHarness() = default;
+
+    /**
+     * @param micros length of the busy loop in each callback, 0 for none
+     */
+    void setLoadMicros(int32_t micros) {
+        mLoadNanos = (int64_t) micros * SYNTHMARK_NANOS_PER_MICROSECOND;
+    }
+
+    void onBeginMeasurement() override {
+        mResult->setTestName(mTestName);
+        mLogTool.log("---- Measure wakeup latency ---- load = %d usec\n",
+                     (int) (mLoadNanos / SYNTHMARK_NANOS_PER_MICROSECOND));
+        mTotalBins = std::make_unique<BinCounter>((int32_t) kNumBins);
+        mTimerBins = std::make_unique<BinCounter>((int32_t) kNumBins);
+        mQueueBins = std::make_unique<BinCounter>((int32_t) kNumBins);
+        mTotal = Statistic();
+        mTimerPart = Statistic();
+        mQueuePart = Statistic();
+        mExitNanos = 0;
+        mSleepCount = 0;
+        mSchedStatResult = 0;
+        mHaveSleepStat = false;
+        mSchedStat.close();
+    }
+
+    void onBeginAudioThread() override {
+        TestHarnessBase::onBeginAudioThread();
+        // Open it on the audio thread because schedstat is per thread.
+        mSchedStatResult = mSchedStat.open();
+    }
+
+    IAudioSinkCallback::Result onRenderAudio(float *buffer, int32_t numFrames) override {
+        int64_t wakeNanos = HostTools::getNanoTime();
+        if (mFrameCounter >= mFramesNeeded || isCancelled()) {
+            return IAudioSinkCallback::Result::Finished;
+        }
+        SchedStat stat;
+        bool haveStat = mSchedStat.read(&stat);
+
+        int64_t fullFramePosition = mAudioSink->getFramesWritten()
+                                    - mAudioSink->getBufferSizeInFrames()
+                                    - mFramesPerBurst;
+        int64_t idealNanos = mAudioSink->convertFrameToTime(fullFramePosition);
+        if (mBurstCounter > 0) {
+            // We can't wake up before we go to sleep.
+            int64_t delay = wakeNanos - std::max(mExitNanos, idealNanos);
+            recordDelay(mTotalBins.get(), &mTotal, delay);
+            if (haveStat && mHaveSleepStat) {
+                bool slept = stat.timeslices != mSleepStat.timeslices;
+                int64_t queueDelay = std::min(delay, stat.waitNanos - mSleepStat.waitNanos);
+                if (slept) {
+                    mSleepCount++;
+                }
+                recordDelay(mQueueBins.get(), &mQueuePart, queueDelay);
+                recordDelay(mTimerBins.get(), &mTimerPart, delay - queueDelay);
+            }
+        }
+
+        if (mLoadNanos > 0) {
+            int64_t endLoadNanos = HostTools::getNanoTime() + mLoadNanos;
+            while (HostTools::getNanoTime() < endLoadNanos) {
+            }
+        }
+        memset(buffer, 0, numFrames * mSamplesPerFrame * sizeof(float));
+
+        mCpuAnalyzer.recordCpu();
+        mFrameCounter += numFrames;
+        mBurstCounter++;
+
+        mHaveSleepStat = mSchedStat.read(&mSleepStat);
+        mExitNanos = HostTools::getNanoTime();
+        return IAudioSinkCallback::Result::Continue;
+    }
+
+    void onEndMeasurement() override {
+        mSchedStat.close();
+        double measurement = getMicrosAtFraction(mTotalBins.get(), 0.99);
+        ResultReport report;
+        report.addMetric(mTestName, measurement);
+        report.addMetric("wakeup.load.micros", mLoadNanos / SYNTHMARK_NANOS_PER_MICROSECOND);
+        report.addMetric("wakeup.count", mTotal.count);
+        report.addMetric("wakeup.slept.count", mSleepCount);
+        report.addMetric("wakeup.bin.nanos", kNanosPerBin);
+        report.addMetric("wakeup.schedstat", mQueuePart.count > 0 ? 1 : 0);
+        if (mSchedStatResult < 0) {
+            report << "# schedstat could not be read, error = "
+                   << mSchedStatResult << std::endl;
+        }
+        dumpStatistic(report, "wakeup.total", mTotalBins.get(), mTotal);
+        if (mQueuePart.count > 0) {
+            dumpStatistic(report, "wakeup.timer", mTimerBins.get(), mTimerPart);
+            dumpStatistic(report, "wakeup.queue", mQueueBins.get(), mQueuePart);
+        }
+        report.addMetric("underrun.count", mAudioSink->getUnderrunCount());
+        report.addMetric("max.empty.frames", mAudioSink->getMaxEmptyFrames());
+        report << mCpuAnalyzer.dump();
+        report << dumpHistogram();
+
+        mResult->setMeasurement(measurement);
+        mResult->appendReport(report);
+    }
+
+private:
+    struct Statistic {
+        int64_t count = 0;
+        int64_t sumNanos = 0;
+        int64_t maxNanos = 0;
+    };
+
+    static void recordDelay(BinCounter *bins, Statistic *statistic, int64_t nanos) {
+        nanos = std::max((int64_t) 0, nanos);
+        bins->increment((int32_t) std::min(nanos / kNanosPerBin, (int64_t) (kNumBins - 1)));
+        statistic->count++;
+        statistic->sumNanos += nanos;
+        statistic->maxNanos = std::max(statistic->maxNanos, nanos);
+    }
+
+    static double toMicros(int64_t nanos) {
+        return (double) nanos / SYNTHMARK_NANOS_PER_MICROSECOND;
+    }
+
+    // Upper edge of the bin that holds the fraction of the wakeups.
+    static double getMicrosAtFraction(BinCounter *bins, double fraction) {
+        int32_t binIndex = (bins == nullptr) ? -1 : bins->findPercentileBin(fraction);
+        return (binIndex < 0) ? 0.0 : toMicros((int64_t) (binIndex + 1) * kNanosPerBin);
+    }
+
+    static void dumpStatistic(ResultReport &report, const std::string &prefix,
+                              BinCounter *bins, const Statistic &statistic) {
+        double average = toMicros(statistic.sumNanos) / std::max((int64_t) 1, statistic.count);
+        report.addMetric(prefix + ".average.micros", average);
+        report.addMetric(prefix + ".p50.micros", getMicrosAtFraction(bins, 0.50));
+        report.addMetric(prefix + ".p99.micros", getMicrosAtFraction(bins, 0.99));
+        report.addMetric(prefix + ".p999.micros", getMicrosAtFraction(bins, 0.999));
+        report.addMetric(prefix + ".max.micros", toMicros(statistic.maxNanos));
+    }
+
+    ResultReport dumpHistogram() {
+        ResultReport report;
+        const int32_t *totalCounts = mTotalBins->getBins();
+        const int32_t *timerCounts = mTimerBins->getBins();
+        const int32_t *queueCounts = mQueueBins->getBins();
+        report << std::endl;
+        report.addHeading("Wakeup Delay Histogram");
+        report.beginTable(" bin#,   micros,   wakeup#,    timer#,    queue#");
+        for (int32_t i = 0; i < kNumBins; i++) {
+            if (totalCounts[i] > 0 || timerCounts[i] > 0 || queueCounts[i] > 0) {
+                report.addCell(i, 5);
+                report << std::fixed << std::setprecision(2);
+                report.addCell(toMicros((int64_t) i * kNanosPerBin), 8);
+                report.addCell(totalCounts[i], 9);
+                report.addCell(timerCounts[i], 9);
+                report.addCell(queueCounts[i], 9);
+                report.endRow();
+            }
+        }
+        report.endTable();
+        return report;
+    }
+
+    int64_t         mLoadNanos = 0;
+    int64_t         mExitNanos = 0;
+    int64_t         mSleepCount = 0;
+    int32_t         mSchedStatResult = 0;
+    SchedStatReader mSchedStat;
+    SchedStat       mSleepStat;
+    bool            mHaveSleepStat = false;
+    std::unique_ptr<BinCounter> mTotalBins;
+    std::unique_ptr<BinCounter> mTimerBins;
+    std::unique_ptr<BinCounter> mQueueBins;
+    Statistic       mTotal;
+    Statistic       mTimerPart;
+    Statistic       mQueuePart;
+};
+
+#endif // SYNTHMARK_WAKEUPMARK_HARNESS_H
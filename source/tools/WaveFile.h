@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SYNTHMARK_WAVE_FILE_H
+#define SYNTHMARK_WAVE_FILE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+/**
+ * Minimal support for WAV files containing 32-bit float samples.
+ * An optional application chunk may be placed before the data chunk.
+ * All values are little endian, like the hosts we run on.
+ */
+class WaveFile
+{
+public:
+    static constexpr int32_t kFormatFloat = 3;
+    static constexpr int32_t kMinHeaderSize = 44;
+
+    /**
+     * Build a header that is followed directly by the sample data.
+     *
+     * @param paddedSize if larger than the natural size then a JUNK chunk is
+     *                   added so the data starts at this offset
+     * @param extraId four character ID of an optional chunk, or nullptr
+     */
+    static std::vector<uint8_t> makeFloatHeader(int32_t sampleRate,
+                                                int32_t channels,
+                                                uint32_t dataBytes,
+                                                int32_t paddedSize = 0,
+                                                const char *extraId = nullptr,
+                                                const void *extra = nullptr,
+                                                int32_t extraSize = 0) {
+        int32_t extraChunkSize = (extraId == nullptr) ? 0 : (8 + extraSize + (extraSize & 1));
+        int32_t naturalSize = kMinHeaderSize + extraChunkSize;
+        int32_t padding = 0;
+        if (paddedSize >= naturalSize + 8) {
+            padding = paddedSize - naturalSize;
+        }
+        std::vector<uint8_t> header(naturalSize + padding, 0);
+        uint8_t *p = header.data();
+        int32_t bytesPerFrame = channels * (int32_t) sizeof(float);
+        putTag(p, "RIFF");
+        putValue<uint32_t>(p, (uint32_t) (header.size() - 8) + dataBytes);
+        putTag(p, "WAVE");
+        putTag(p, "fmt ");
+        putValue<uint32_t>(p, 16);
+        putValue<uint16_t>(p, kFormatFloat);
+        putValue<uint16_t>(p, (uint16_t) channels);
+        putValue<uint32_t>(p, (uint32_t) sampleRate);
+        putValue<uint32_t>(p, (uint32_t) (sampleRate * bytesPerFrame));
+        putValue<uint16_t>(p, (uint16_t) bytesPerFrame);
+        putValue<uint16_t>(p, 32);
+        if (extraId != nullptr) {
+            putTag(p, extraId);
+            putValue<uint32_t>(p, (uint32_t) extraSize);
+            memcpy(p, extra, extraSize);
+            p += extraSize + (extraSize & 1); // chunks are word aligned
+        }
+        if (padding > 0) {
+            putTag(p, "JUNK");
+            putValue<uint32_t>(p, (uint32_t) (padding - 8));
+            p += padding - 8;
+        }
+        putTag(p, "data");
+        putValue<uint32_t>(p, dataBytes);
+        return header;
+    }
+
+    struct Info {
+        int32_t formatTag = 0;
+        int32_t channels = 0;
+        int32_t sampleRate = 0;
+        int32_t bitsPerSample = 0;
+        int64_t dataBytes = 0;
+        bool    hasExtra = false;
+    };
+
+    /**
+     * Parse the chunks up to the sample data.
+     * On success the file is positioned at the first sample.
+     *
+     * @param extraId four character ID of an optional chunk to read into extra
+     * @return 0 on success or -1 if this is not a WAV file
+     */
+    static int32_t readHeader(FILE *file, Info *info,
+                              const char *extraId = nullptr,
+                              void *extra = nullptr,
+                              int32_t extraSize = 0) {
+        uint8_t riff[12];
+        if (fread(riff, 1, sizeof(riff), file) != sizeof(riff)
+                || memcmp(riff, "RIFF", 4) != 0 || memcmp(&riff[8], "WAVE", 4) != 0) {
+            return -1;
+        }
+        uint8_t chunkHeader[8];
+        while (fread(chunkHeader, 1, sizeof(chunkHeader), file) == sizeof(chunkHeader)) {
+            uint32_t chunkSize;
+            memcpy(&chunkSize, &chunkHeader[4], sizeof(chunkSize));
+            long next = ftell(file) + (long) chunkSize + (chunkSize & 1);
+            if (memcmp(chunkHeader, "fmt ", 4) == 0 && chunkSize >= 16) {
+                uint8_t format[16];
+                if (fread(format, 1, sizeof(format), file) != sizeof(format)) {
+                    return -1;
+                }
+                const uint8_t *p = format;
+                info->formatTag = getValue<uint16_t>(p);
+                info->channels = getValue<uint16_t>(p);
+                info->sampleRate = (int32_t) getValue<uint32_t>(p);
+                p += 6; // byte rate and block align
+                info->bitsPerSample = getValue<uint16_t>(p);
+            } else if (extraId != nullptr && memcmp(chunkHeader, extraId, 4) == 0) {
+                memset(extra, 0, extraSize);
+                size_t numToRead = std::min((size_t) chunkSize, (size_t) extraSize);
+                if (fread(extra, 1, numToRead, file) != numToRead) {
+                    return -1;
+                }
+                info->hasExtra = true;
+            } else if (memcmp(chunkHeader, "data", 4) == 0) {
+                info->dataBytes = chunkSize;
+                return (info->channels > 0) ? 0 : -1;
+            }
+            if (fseek(file, next, SEEK_SET) != 0) {
+                return -1;
+            }
+        }
+        return -1;
+    }
+
+private:
+    static void putTag(uint8_t *&p, const char *tag) {
+        memcpy(p, tag, 4);
+        p += 4;
+    }
+
+    template <typename T>
+    static void putValue(uint8_t *&p, T value) {
+        memcpy(p, &value, sizeof(value));
+        p += sizeof(value);
+    }
+
+    template <typename T>
+    static T getValue(const uint8_t *&p) {
+        T value;
+        memcpy(&value, p, sizeof(value));
+        p += sizeof(value);
+        return value;
+    }
+};
+
+#endif // SYNTHMARK_WAVE_FILE_H